@@ -0,0 +1,74 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _ACCEL_INCLUDED_           /* switch to read the header file once */
+#define _ACCEL_INCLUDED_           /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Period of the accelerometer samples fed to the gesture detector, activity
+ * classifier, pedometer and capture engine [ms]. It is the period of the RTOS
+ * callback that samples the LIS3DSH in app.c: their time constants are
+ * counted in samples of this period */
+#define ACCEL_SAMPLE_PERIOD_MS			((uint16_t)10)		/* 100 Hz */
+
+
+
+
+/* ----------- Exported inline functions ------------- */
+
+/* Approximate vector magnitude without square root:
+ * max + 11/32 mid + 1/4 min, error within about 8% */
+static inline uint16_t accel_magnitude_approx(int16_t x, int16_t y, int16_t z)
+{
+	uint16_t a = (uint16_t)((x < 0) ? -x : x);
+	uint16_t b = (uint16_t)((y < 0) ? -y : y);
+	uint16_t c = (uint16_t)((z < 0) ? -z : z);
+	uint16_t tmp;
+
+	/* sort so that a >= b >= c */
+	if (a < b) { tmp = a; a = b; b = tmp; }
+	if (b < c) { tmp = b; b = c; c = tmp; }
+	if (a < b) { tmp = a; a = b; b = tmp; }
+
+	return (uint16_t)(a + ((11 * (uint32_t)b) >> 5) + (c >> 2));
+}
+
+
+
+
+#endif
+
+/* End of file */
+
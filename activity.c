@@ -0,0 +1,248 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "accel.h"
+#include "activity.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Magnitude offset removed before quantizing the mean [mg] */
+#define MEAN_OFFSET_MG					((int32_t)1000)
+
+/* Mean quantization step as power of 2 [mg] */
+#define MEAN_QUANT_SHIFT				4
+
+/* Time constant of the DC removal filter as power of 2 [samples] */
+#define DC_FILTER_SHIFT					4
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Samples accumulated in actual window */
+static uint16_t window_samples;
+
+/* Sum and sum of squares of the magnitude */
+static uint32_t magnitude_sum;
+static uint32_t magnitude_sq_sum;
+
+/* Energy of the low and high band of the DC-free magnitude */
+static uint32_t low_band_energy;
+static uint32_t high_band_energy;
+
+/* Zero crossings of the DC-free magnitude */
+static uint16_t zero_crossings;
+
+/* DC level of the magnitude, Q(DC_FILTER_SHIFT) */
+static int32_t dc_level;
+
+/* Previous DC-free magnitude sample */
+static int32_t prev_ac_value;
+
+/* Last classified activity */
+static uint8_t actual_class;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void reset_window(void);
+static void extract_features(int8_t *);
+static inline int8_t log2_quantize(uint32_t);
+static inline int8_t saturate_int8(int32_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init activity classifier */
+void activity_init(void)
+{
+	dc_level = (int32_t)MEAN_OFFSET_MG << DC_FILTER_SHIFT;
+	prev_ac_value = 0;
+	actual_class = ACTIVITY_CFG_KE_STILL;
+	reset_window();
+}
+
+
+/* Process a new sample [mg]. Run inference at the end of each window */
+void activity_process_sample(int16_t x_mg, int16_t y_mg, int16_t z_mg)
+{
+	uint16_t magnitude;
+	int32_t ac_value;
+	int32_t band_value;
+	int8_t features[ACTIVITY_FT_MAX_NUM];
+
+	magnitude = accel_magnitude_approx(x_mg, y_mg, z_mg);
+
+	/* raw moments */
+	magnitude_sum += magnitude;
+	magnitude_sq_sum += (uint32_t)magnitude * magnitude;
+
+	/* DC removal with a first order IIR filter */
+	dc_level += (int32_t)magnitude - (dc_level >> DC_FILTER_SHIFT);
+	ac_value = (int32_t)magnitude - (dc_level >> DC_FILTER_SHIFT);
+
+	/* two bands split: sum (low pass) and difference (high pass) of two samples */
+	band_value = ac_value + prev_ac_value;
+	low_band_energy += (uint32_t)(band_value * band_value) >> 2;
+	band_value = ac_value - prev_ac_value;
+	high_band_energy += (uint32_t)(band_value * band_value) >> 2;
+
+	/* zero crossings */
+	if ((ac_value ^ prev_ac_value) < 0) {
+		zero_crossings++;
+	}
+	prev_ac_value = ac_value;
+
+	window_samples++;
+	if (window_samples >= ACTIVITY_WINDOW_SAMPLES) {
+		extract_features(features);
+		actual_class = activity_classify(features);
+		reset_window();
+	}
+}
+
+
+/* Get last classified activity */
+uint8_t activity_get_class(void)
+{
+	return actual_class;
+}
+
+
+/* Run the forest stored in flash on a features vector. Return the most voted class */
+uint8_t activity_classify(const int8_t *features_ptr)
+{
+	uint8_t votes[ACTIVITY_CFG_KE_CLASS_MAX_NUM] = {0};
+	uint8_t tree_index;
+	uint8_t class_index;
+	uint8_t best_class = 0;
+	const activity_cfg_node_t *node_ptr;
+
+	for (tree_index = 0; tree_index < activity_cfg_trees_num; tree_index++) {
+		node_ptr = &activity_cfg_nodes[activity_cfg_tree_roots[tree_index]];
+		/* descend the tree: the comparison result selects the child */
+		while (node_ptr->feature != ACTIVITY_CFG_LEAF) {
+			node_ptr = &activity_cfg_nodes[node_ptr->child
+							+ (features_ptr[(uint8_t)node_ptr->feature] > node_ptr->threshold)];
+		}
+		votes[(uint8_t)node_ptr->threshold]++;
+	}
+
+	/* in event of a tie the lowest class index wins */
+	for (class_index = 1; class_index < ACTIVITY_CFG_KE_CLASS_MAX_NUM; class_index++) {
+		if (votes[class_index] > votes[best_class]) {
+			best_class = class_index;
+		}
+	}
+
+	return best_class;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Clear window accumulators */
+static void reset_window(void)
+{
+	window_samples = 0;
+	magnitude_sum = 0;
+	magnitude_sq_sum = 0;
+	low_band_energy = 0;
+	high_band_energy = 0;
+	zero_crossings = 0;
+}
+
+
+/* Quantize window statistics into int8 features */
+static void extract_features(int8_t *features_ptr)
+{
+	uint32_t mean;
+	uint32_t mean_sq;
+	uint32_t variance;
+
+	/* window length is a power of 2: no division required */
+	mean = magnitude_sum >> ACTIVITY_WINDOW_SHIFT;
+	mean_sq = magnitude_sq_sum >> ACTIVITY_WINDOW_SHIFT;
+	variance = (mean_sq > (mean * mean)) ? (mean_sq - (mean * mean)) : 0;
+
+	features_ptr[ACTIVITY_FT_MEAN] =
+		saturate_int8(((int32_t)mean - MEAN_OFFSET_MG) >> MEAN_QUANT_SHIFT);
+	features_ptr[ACTIVITY_FT_VARIANCE] = log2_quantize(variance);
+	features_ptr[ACTIVITY_FT_LOW_BAND] = log2_quantize(low_band_energy >> ACTIVITY_WINDOW_SHIFT);
+	features_ptr[ACTIVITY_FT_HIGH_BAND] = log2_quantize(high_band_energy >> ACTIVITY_WINDOW_SHIFT);
+	features_ptr[ACTIVITY_FT_ZERO_CROSS] = saturate_int8(zero_crossings);
+}
+
+
+/* Logarithmic quantization with 4 steps per octave */
+static inline int8_t log2_quantize(uint32_t value)
+{
+	int8_t quant_value;
+	uint8_t msb;
+
+	if (value < 4) {
+		quant_value = (int8_t)value;
+	} else {
+		msb = (uint8_t)(31 - __builtin_clz(value));
+		quant_value = (int8_t)((msb << 2) | ((value >> (msb - 2)) & 0x3));
+	}
+
+	return quant_value;
+}
+
+
+/* Saturate a value into int8 range */
+static inline int8_t saturate_int8(int32_t value)
+{
+	if (value > INT8_MAX) {
+		value = INT8_MAX;
+	} else if (value < INT8_MIN) {
+		value = INT8_MIN;
+	}
+
+	return (int8_t)value;
+}
+
+
+
+
+/* End of file */
+
@@ -0,0 +1,78 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _ACTIVITY_INCLUDED_        /* switch to read the header file once */
+#define _ACTIVITY_INCLUDED_        /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+/* This inclusion is for other modules that include this component */
+#include "activity_cfg.h"
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Number of samples of a feature window as power of 2 */
+#define ACTIVITY_WINDOW_SHIFT			7
+/* Number of samples of a feature window */
+#define ACTIVITY_WINDOW_SAMPLES			((uint16_t)1 << ACTIVITY_WINDOW_SHIFT)	/* 1.28 s at 100 Hz */
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Features enum: this order shall be the same used to train the model */
+enum {
+	ACTIVITY_FT_MEAN,
+	ACTIVITY_FT_VARIANCE,
+	ACTIVITY_FT_LOW_BAND,
+	ACTIVITY_FT_HIGH_BAND,
+	ACTIVITY_FT_ZERO_CROSS,
+	ACTIVITY_FT_MAX_NUM
+};
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void activity_init(void);
+extern void activity_process_sample(int16_t, int16_t, int16_t);
+extern uint8_t activity_get_class(void);
+extern uint8_t activity_classify(const int8_t *);
+
+
+
+
+#endif
+
+/* End of file */
+
@@ -0,0 +1,63 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* This file is generated by tools/activity_export.py: do not edit it by hand */
+
+
+/* ------------- Inclusions ---------------- */
+
+#include <stdint.h>
+#include "activity_cfg.h"
+
+
+
+
+/* ------------ Exported Variables ----------------- */
+
+/* Forest nodes: {feature, threshold or class, first child} */
+const activity_cfg_node_t activity_cfg_nodes[] = {
+	{1, 36, 1},
+	{ACTIVITY_CFG_LEAF, 0, 0},
+	{1, 66, 3},
+	{4, 12, 5},
+	{ACTIVITY_CFG_LEAF, 2, 0},
+	{ACTIVITY_CFG_LEAF, 1, 0},
+	{ACTIVITY_CFG_LEAF, 3, 0}
+};
+
+
+/* Root node of each tree */
+const uint16_t activity_cfg_tree_roots[] = {
+	0
+};
+
+
+/* Number of trees */
+const uint8_t activity_cfg_trees_num = 1;
+
+
+
+
+/* End of file */
+
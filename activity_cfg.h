@@ -0,0 +1,81 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _ACTIVITY_CFG_INCLUDED_    /* switch to read the header file once */
+#define _ACTIVITY_CFG_INCLUDED_    /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported constants ------------- */
+
+/* Activity classes enum: this order shall be the same used to train the model */
+enum {
+	ACTIVITY_CFG_KE_STILL,
+	ACTIVITY_CFG_KE_WALKING,
+	ACTIVITY_CFG_KE_RUNNING,
+	ACTIVITY_CFG_KE_VEHICLE,
+	ACTIVITY_CFG_KE_CLASS_MAX_NUM
+};
+
+/* Value of the feature field of a leaf node */
+#define ACTIVITY_CFG_LEAF				((int8_t)-1)
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Decision tree node. Children of a split node are stored next to each
+ * other: next node is child + (feature value > threshold).
+ * For a leaf node threshold holds the class */
+typedef struct {
+	int8_t feature;
+	int8_t threshold;
+	uint16_t child;
+} activity_cfg_node_t;
+
+
+
+
+/* ----------- Exported variables ------------- */
+
+extern const activity_cfg_node_t activity_cfg_nodes[];
+extern const uint16_t activity_cfg_tree_roots[];
+extern const uint8_t activity_cfg_trees_num;
+
+
+
+
+#endif
+
+/* End of file */
+
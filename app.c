@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/gpio.h>
 
 #include "app.h"
@@ -36,8 +37,20 @@
 #include "rtos.h"
 /* LIS3DSH accelerometer driver */
 #include "lis3dsh.h"
+/* Accelerometer sample period */
+#include "accel.h"
 /* LED module */
 #include "led.h"
+/* Gesture detector */
+#include "gesture.h"
+/* Activity classifier */
+#include "activity.h"
+/* Pedometer */
+#include "pedo.h"
+/* Shock capture engine */
+#include "capture.h"
+/* Accelerometer calibration */
+#include "calib.h"
 
 
 
@@ -46,6 +59,20 @@
 
 #define LED_TH_MG					1000	/* 1000mg */
 
+/* RTOS callback used to sample the accelerometer */
+#define APP_SAMPLE_CB_ID				RTOS_CB_ID_1
+
+/* Magnitude triggering a shock capture [mg] */
+#define SHOCK_TH_MG						1800	/* 1800mg */
+
+/* Time the LEDs show a gesture before the orientation again [ms] */
+#define GESTURE_HOLD_MS					2000	/* 2 s */
+
+/* User button starting a calibration: PA0, high when pressed. Polled by the
+ * main task, whose period is longer than the contact bounces */
+#define USER_BUTTON_PORT				GPIOA
+#define USER_BUTTON_PIN					GPIO0
+
 
 
 
@@ -63,6 +90,36 @@
 #define LED_RED_OFF()					(led_set_channel_status(LED_KE_CHANNEL_3, LED_KE_CH_TURN_OFF))
 #define LED_BLUE_OFF()					(led_set_channel_status(LED_KE_CHANNEL_4, LED_KE_CH_TURN_OFF))
 
+/* Macros for toggling LEDs */
+#define LED_GREEN_TOGGLE()				(led_set_channel_status(LED_KE_CHANNEL_1, LED_KE_CH_TOGGLE))
+#define LED_ORANGE_TOGGLE()				(led_set_channel_status(LED_KE_CHANNEL_2, LED_KE_CH_TOGGLE))
+#define LED_RED_TOGGLE()				(led_set_channel_status(LED_KE_CHANNEL_3, LED_KE_CH_TOGGLE))
+#define LED_BLUE_TOGGLE()				(led_set_channel_status(LED_KE_CHANNEL_4, LED_KE_CH_TOGGLE))
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Last X, Y, Z values [mg] */
+static int16_t last_value_x_mg;
+static int16_t last_value_y_mg;
+static int16_t last_value_z_mg;
+
+/* Main task periods left showing the last gesture: the orientation is not shown meanwhile */
+static uint16_t gesture_hold_periods;
+
+/* User button state at the last poll */
+static bool button_pressed;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void sample_callback(void);
+static void gesture_callback(uint8_t);
+
 
 
 
@@ -80,6 +137,31 @@ void app_init(void)
 	led_set_channel_status(LED_KE_CHANNEL_2, LED_KE_CH_TURN_OFF);
 	led_set_channel_status(LED_KE_CHANNEL_3, LED_KE_CH_TURN_OFF);
 	led_set_channel_status(LED_KE_CHANNEL_4, LED_KE_CH_TURN_OFF);
+
+	/* init user button */
+	rcc_periph_clock_enable(RCC_GPIOA);
+	gpio_mode_setup(USER_BUTTON_PORT, GPIO_MODE_INPUT, GPIO_PUPD_NONE, USER_BUTTON_PIN);
+	button_pressed = false;
+
+	/* init shock capture engine */
+	capture_init();
+	capture_set_trigger(CAPTURE_TRIG_THRESHOLD, SHOCK_TH_MG);
+
+	/* init gesture detector */
+	gesture_init();
+	gesture_set_callback(&gesture_callback);
+
+	/* init activity classifier */
+	activity_init();
+
+	/* init pedometer */
+	pedo_init();
+
+	/* start accelerometer sampling at the period of the sample processing modules */
+	rtos_set_callback(APP_SAMPLE_CB_ID,
+					  RTOS_CB_TYPE_PERIODIC,
+					  ACCEL_SAMPLE_PERIOD_MS,
+					  &sample_callback);
 }
 
 
@@ -87,11 +169,25 @@ void app_init(void)
 void app_main_demo(void)
 {
 	int16_t int_value_x_mg, int_value_y_mg, int_value_z_mg;
+	bool pressed;
 
-	/* get X, Y, Z values */
-	int_value_x_mg = lis3dsh_readAxis(LIS3DSH_AXIS_X);
-	int_value_y_mg = lis3dsh_readAxis(LIS3DSH_AXIS_Y);
-	int_value_z_mg = lis3dsh_readAxis(LIS3DSH_AXIS_Z);
+	/* start a calibration when the user button is pressed */
+	pressed = (gpio_get(USER_BUTTON_PORT, USER_BUTTON_PIN) != 0);
+	if (pressed && !button_pressed) {
+		calib_start();
+	}
+	button_pressed = pressed;
+
+	/* LEDs show the last gesture: leave them as they are */
+	if (gesture_hold_periods > 0) {
+		gesture_hold_periods--;
+		return;
+	}
+
+	/* get last X, Y, Z values */
+	int_value_x_mg = last_value_x_mg;
+	int_value_y_mg = last_value_y_mg;
+	int_value_z_mg = last_value_z_mg;
 
 	/* set X related LEDs according to specified threshold */
 	if (int_value_x_mg >= LED_TH_MG) {
@@ -134,6 +230,83 @@ void app_main_demo(void)
 }
 
 
+/* Process an accelerometer sample [mg]: the main task shows it at next run */
+void app_process_sample(int16_t x_mg, int16_t y_mg, int16_t z_mg)
+{
+	last_value_x_mg = x_mg;
+	last_value_y_mg = y_mg;
+	last_value_z_mg = z_mg;
+
+	/* feed calibration: it does nothing if not running */
+	calib_process_sample(x_mg, y_mg, z_mg);
+
+	/* feed capture engine first: a gesture can trigger a capture on this sample */
+	capture_process_sample(x_mg, y_mg, z_mg);
+
+	/* feed gesture detector */
+	gesture_process_sample(x_mg, y_mg, z_mg);
+
+	/* feed activity classifier */
+	activity_process_sample(x_mg, y_mg, z_mg);
+
+	/* feed pedometer */
+	pedo_process_sample(x_mg, y_mg, z_mg);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Accelerometer sampling callback */
+static void sample_callback(void)
+{
+	int16_t value_x_mg, value_y_mg, value_z_mg;
+
+	/* get X, Y, Z values */
+	value_x_mg = lis3dsh_readAxis(LIS3DSH_AXIS_X);
+	value_y_mg = lis3dsh_readAxis(LIS3DSH_AXIS_Y);
+	value_z_mg = lis3dsh_readAxis(LIS3DSH_AXIS_Z);
+
+	app_process_sample(value_x_mg, value_y_mg, value_z_mg);
+}
+
+
+/* Gesture events callback. The LEDs keep the gesture output for
+ * GESTURE_HOLD_MS before the main task shows the orientation again */
+static void gesture_callback(uint8_t event)
+{
+	gesture_hold_periods = (uint16_t)(GESTURE_HOLD_MS / RTOS_UL_TASKS_PERIOD_MS);
+
+	switch (event) {
+	case GESTURE_EV_TAP:
+	{
+		LED_BLUE_TOGGLE();
+		break;
+	}
+	case GESTURE_EV_DOUBLE_TAP:
+	{
+		LED_RED_TOGGLE();
+		/* record the waveform around the double-tap */
+		capture_trigger();
+		break;
+	}
+	case GESTURE_EV_SHAKE:
+	{
+		LED_GREEN_TOGGLE();
+		LED_ORANGE_TOGGLE();
+		LED_RED_TOGGLE();
+		LED_BLUE_TOGGLE();
+		break;
+	}
+	default:
+	{
+		/* unknown event: do nothing */
+	}
+	}
+}
+
+
 
 
 /* End of file */
@@ -36,6 +36,7 @@
 
 extern void app_init(void);
 extern void app_main_demo(void);
+extern void app_process_sample(int16_t, int16_t, int16_t);
 
 
 
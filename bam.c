@@ -0,0 +1,307 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
+
+#include "bam.h"
+#include "clock.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Maximum timer period [counts] */
+#define TIM_MAX_PERIOD					((uint32_t)0x10000)
+
+/* Compare value of the plane DMA requests: one count after the update event */
+#define PLANE_REQUEST_CCR_VALUE			((uint32_t)1)
+
+
+
+
+/* ----------- Local macros ------------- */
+
+/* BSRR set bit of a pin */
+#define BSRR_SET(pin)					((uint32_t)1 << (pin))
+
+/* BSRR reset bit of a pin */
+#define BSRR_RESET(pin)					((uint32_t)1 << ((pin) + 16))
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* BSRR word of each bit plane of each port, streamed by DMA in circular mode.
+ * Plane k lasts 2^k LSB times */
+static uint32_t planes[BAM_CFG_KE_PORT_MAX_NUM][BAM_CFG_BITS];
+
+/* Auto-reload values streamed by the update DMA. The value written at an
+ * update event is loaded at the following one: entry j is the period of plane j + 2 */
+static uint32_t periods[BAM_CFG_BITS];
+
+/* Level of each channel */
+static uint16_t channels_levels[BAM_CFG_CH_NUM];
+
+/* BAM outputs are running */
+static bool bam_running = false;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void init_planes(void);
+static void init_gpio(void);
+static uint32_t init_periods(void);
+static void init_dma_stream(uint8_t, uint32_t, uint32_t, uint32_t *);
+static void init_timer(uint32_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init BAM outputs: after this no CPU work is required to keep them running.
+ * TIM1 clock changes with the clock speed: bam_update_clock shall be in
+ * clock_cfg_notify_array too */
+void bam_init(void)
+{
+	uint32_t lsb_counts;
+	uint8_t port_index;
+
+	init_planes();
+	init_gpio();
+	lsb_counts = init_periods();
+
+	rcc_periph_clock_enable(RCC_DMA2);
+
+	/* periods stream */
+	init_dma_stream(DMA_STREAM5, DMA_SxCR_CHSEL_6, (uint32_t)&TIM_ARR(TIM1), periods);
+
+	/* one BSRR stream for each port */
+	for (port_index = 0; port_index < BAM_CFG_KE_PORT_MAX_NUM; port_index++) {
+		init_dma_stream(bam_cfg_ports[port_index].dma_stream,
+						bam_cfg_ports[port_index].dma_channel,
+						(uint32_t)&GPIO_BSRR(bam_cfg_ports[port_index].gpio_port),
+						planes[port_index]);
+	}
+
+	init_timer(lsb_counts);
+	bam_running = true;
+}
+
+
+/* Recompute prescaler and periods after a clock speed change. Both are
+ * preloaded and streamed in place: one frame mixes old and new LSB time */
+void bam_update_clock(void)
+{
+	if (bam_running) {
+		(void)init_periods();
+	}
+}
+
+
+/* Set level of a channel: 0 - BAM_MAX_LEVEL. Plane words are updated one
+ * at a time, so a frame can show a mix of old and new level */
+void bam_set_level(uint8_t ch_index, uint16_t level)
+{
+	const bam_cfg_channel_t *ch_ptr;
+	uint32_t *port_planes;
+	uint8_t plane_index;
+
+	if ((ch_index < BAM_CFG_CH_NUM)
+	&& (level <= BAM_MAX_LEVEL)) {
+		ch_ptr = &bam_cfg_channels[ch_index];
+		port_planes = planes[ch_ptr->port];
+		channels_levels[ch_index] = level;
+
+		/* DMA only reads plane words: a read-modify-write is safe */
+		for (plane_index = 0; plane_index < BAM_CFG_BITS; plane_index++) {
+			if ((level & (1 << plane_index)) != 0) {
+				port_planes[plane_index] = (port_planes[plane_index] & ~BSRR_RESET(ch_ptr->pin_number))
+										 | BSRR_SET(ch_ptr->pin_number);
+			} else {
+				port_planes[plane_index] = (port_planes[plane_index] & ~BSRR_SET(ch_ptr->pin_number))
+										 | BSRR_RESET(ch_ptr->pin_number);
+			}
+		}
+	}
+}
+
+
+/* Get level of a channel */
+uint16_t bam_get_level(uint8_t ch_index)
+{
+	uint16_t level = 0;
+
+	if (ch_index < BAM_CFG_CH_NUM) {
+		level = channels_levels[ch_index];
+	}
+
+	return level;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Init all planes with all channels off. Pins not in the table are not touched */
+static void init_planes(void)
+{
+	uint8_t ch_index;
+	uint8_t port_index;
+	uint8_t plane_index;
+
+	for (port_index = 0; port_index < BAM_CFG_KE_PORT_MAX_NUM; port_index++) {
+		for (plane_index = 0; plane_index < BAM_CFG_BITS; plane_index++) {
+			planes[port_index][plane_index] = 0;
+		}
+	}
+
+	for (ch_index = 0; ch_index < BAM_CFG_CH_NUM; ch_index++) {
+		channels_levels[ch_index] = 0;
+		for (plane_index = 0; plane_index < BAM_CFG_BITS; plane_index++) {
+			planes[bam_cfg_channels[ch_index].port][plane_index] |=
+				BSRR_RESET(bam_cfg_channels[ch_index].pin_number);
+		}
+	}
+}
+
+
+/* Init channels pins as outputs */
+static void init_gpio(void)
+{
+	uint8_t ch_index;
+	const bam_cfg_port_t *port_ptr;
+
+	for (ch_index = 0; ch_index < BAM_CFG_CH_NUM; ch_index++) {
+		port_ptr = &bam_cfg_ports[bam_cfg_channels[ch_index].port];
+
+		rcc_periph_clock_enable(port_ptr->gpio_rcc);
+
+		gpio_clear(port_ptr->gpio_port, (uint16_t)(1 << bam_cfg_channels[ch_index].pin_number));
+		gpio_mode_setup(port_ptr->gpio_port,
+						GPIO_MODE_OUTPUT,
+						GPIO_PUPD_NONE,
+						(uint16_t)(1 << bam_cfg_channels[ch_index].pin_number));
+		gpio_set_output_options(port_ptr->gpio_port,
+								GPIO_OTYPE_PP,
+								GPIO_OSPEED_50MHZ,
+								(uint16_t)(1 << bam_cfg_channels[ch_index].pin_number));
+	}
+}
+
+
+/* Compute timer prescaler and LSB time so that the longest plane fits the
+ * 16-bit timer. Fill the periods table. Return the LSB time [counts] */
+static uint32_t init_periods(void)
+{
+	uint32_t timer_clock_hz;
+	uint32_t lsb_counts;
+	uint32_t prescaler;
+	uint8_t plane_index;
+
+	timer_clock_hz = clock_get_timer_frequency(TIM1);
+
+	/* a frame lasts 2^bits - 1 LSB times */
+	lsb_counts = timer_clock_hz / (BAM_CFG_FRAME_FREQ_HZ * (uint32_t)BAM_MAX_LEVEL);
+	prescaler = ((lsb_counts << (BAM_CFG_BITS - 1)) - 1) / TIM_MAX_PERIOD;
+	lsb_counts /= (prescaler + 1);
+
+	timer_set_prescaler(TIM1, prescaler);
+
+	for (plane_index = 0; plane_index < BAM_CFG_BITS; plane_index++) {
+		periods[plane_index] = (lsb_counts << ((plane_index + 2) % BAM_CFG_BITS)) - 1;
+	}
+
+	return lsb_counts;
+}
+
+
+/* Init a DMA2 stream: circular memory to peripheral transfer of a plane table */
+static void init_dma_stream(uint8_t stream, uint32_t channel, uint32_t periph_address, uint32_t *table_ptr)
+{
+	dma_stream_reset(DMA2, stream);
+	dma_channel_select(DMA2, stream, channel);
+	dma_set_priority(DMA2, stream, DMA_SxCR_PL_VERY_HIGH);
+	dma_set_transfer_mode(DMA2, stream, DMA_SxCR_DIR_MEM_TO_PERIPHERAL);
+	dma_set_memory_size(DMA2, stream, DMA_SxCR_MSIZE_32BIT);
+	dma_set_peripheral_size(DMA2, stream, DMA_SxCR_PSIZE_32BIT);
+	dma_enable_memory_increment_mode(DMA2, stream);
+	dma_enable_circular_mode(DMA2, stream);
+	dma_set_peripheral_address(DMA2, stream, periph_address);
+	dma_set_memory_address(DMA2, stream, (uint32_t)table_ptr);
+	dma_set_number_of_data(DMA2, stream, BAM_CFG_BITS);
+	dma_enable_stream(DMA2, stream);
+}
+
+
+/* Init and start TIM1: the update event reloads the period, compare events
+ * one count later write BSRR words */
+static void init_timer(uint32_t lsb_counts)
+{
+	uint8_t port_index;
+	uint32_t dma_requests = TIM_DIER_UDE;
+
+	rcc_periph_clock_enable(RCC_TIM1);
+
+	timer_set_mode(TIM1,
+					TIM_CR1_CKD_CK_INT,
+					TIM_CR1_CMS_EDGE,
+					TIM_CR1_DIR_UP);
+	timer_enable_preload(TIM1);
+	timer_continuous_mode(TIM1);
+
+	for (port_index = 0; port_index < BAM_CFG_KE_PORT_MAX_NUM; port_index++) {
+		timer_set_oc_value(TIM1, bam_cfg_ports[port_index].oc, PLANE_REQUEST_CCR_VALUE);
+		dma_requests |= bam_cfg_ports[port_index].dma_request;
+	}
+
+	/* plane 0 period is loaded now, plane 1 period at first update event */
+	timer_set_period(TIM1, lsb_counts - 1);
+	timer_generate_event(TIM1, TIM_EGR_UG);
+	timer_set_period(TIM1, (lsb_counts << (1 % BAM_CFG_BITS)) - 1);
+
+	/* DMA requests are enabled after the initial update event */
+	timer_enable_irq(TIM1, dma_requests);
+	timer_enable_counter(TIM1);
+}
+
+
+
+
+/* End of file */
+
@@ -0,0 +1,80 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _BAM_INCLUDED_             /* switch to read the header file once */
+#define _BAM_INCLUDED_             /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+/* This inclusion is for other modules that include this component */
+#include "bam_cfg.h"
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Maximum level of a channel */
+#define BAM_MAX_LEVEL					((uint16_t)((1UL << BAM_CFG_BITS) - 1))
+
+
+
+
+/* ----------- Exported macros ------------- */
+
+/* Memory cost model. Each port needs one 32-bit BSRR word per bit plane and
+ * the timer needs one period word per bit plane, whatever the channels number:
+ * memory grows with ceil(channels / 16) and linearly with bit depth.
+ * An equivalent time-sliced output would need 2^bits words per port.
+ *
+ *   channels  bits  ports  BAM bytes  time-sliced bytes
+ *      16       8     1        64           1024
+ *      64       8     4       160           4096
+ *      64      12     4       240          65536
+ *      64      16     4       320        1048576
+ */
+#define BAM_PORTS_NUM(channels)			(((channels) + 15) / 16)
+#define BAM_MEMORY_BYTES(ports, bits)	((uint32_t)(((ports) + 1) * (bits) * sizeof(uint32_t)))
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void bam_init(void);
+extern void bam_update_clock(void);
+extern void bam_set_level(uint8_t, uint16_t);
+extern uint16_t bam_get_level(uint8_t);
+
+
+
+
+#endif
+
+/* End of file */
+
@@ -0,0 +1,74 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stdint.h>
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
+
+#include "bam_cfg.h"
+
+
+
+
+/* ------------ Exported Variables ----------------- */
+
+/* GPIO ports: this order shall be the same of ports enum.
+ * TIM1 DMA2 requests (RM0090 DMA request mapping): UP S5 C6 is used for the
+ * period, CH1 S1 C6, CH2 S2 C6, CH3 S6 C6, CH4 S4 C6.
+ * ATTENTION: only DMA2 can access GPIO ports */
+const bam_cfg_port_t bam_cfg_ports[BAM_CFG_KE_PORT_MAX_NUM] = {
+	{GPIOE, RCC_GPIOE, DMA_STREAM1, DMA_SxCR_CHSEL_6, TIM_OC1, TIM_DIER_CC1DE},
+	{GPIOB, RCC_GPIOB, DMA_STREAM2, DMA_SxCR_CHSEL_6, TIM_OC2, TIM_DIER_CC2DE}
+};
+
+
+/* Channels: free pins of the Discovery board. PE0, PE1 and PE3 are used by LIS3DSH */
+const bam_cfg_channel_t bam_cfg_channels[BAM_CFG_CH_NUM] = {
+	{BAM_CFG_KE_PORT_E, 7},
+	{BAM_CFG_KE_PORT_E, 8},
+	{BAM_CFG_KE_PORT_E, 9},
+	{BAM_CFG_KE_PORT_E, 10},
+	{BAM_CFG_KE_PORT_E, 11},
+	{BAM_CFG_KE_PORT_E, 12},
+	{BAM_CFG_KE_PORT_E, 13},
+	{BAM_CFG_KE_PORT_E, 14},
+	{BAM_CFG_KE_PORT_E, 15},
+	{BAM_CFG_KE_PORT_B, 11},
+	{BAM_CFG_KE_PORT_B, 12},
+	{BAM_CFG_KE_PORT_B, 13},
+	{BAM_CFG_KE_PORT_B, 14},
+	{BAM_CFG_KE_PORT_B, 15}
+};
+
+
+
+
+/* End of file */
+
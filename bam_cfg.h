@@ -0,0 +1,95 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _BAM_CFG_INCLUDED_         /* switch to read the header file once */
+#define _BAM_CFG_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/timer.h>
+
+
+
+
+/* ----------- Exported constants ------------- */
+
+/* GPIO ports enum: each port is written by its own DMA stream, 4 ports at most */
+enum {
+	BAM_CFG_KE_PORT_E,
+	BAM_CFG_KE_PORT_B,
+	BAM_CFG_KE_PORT_MAX_NUM
+};
+
+/* Number of channels */
+#define BAM_CFG_CH_NUM					14
+
+/* Bit depth: number of bit planes of a frame, 16 at most */
+#define BAM_CFG_BITS					8
+
+/* Frame frequency [Hz] */
+#define BAM_CFG_FRAME_FREQ_HZ			200
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* GPIO port descriptor. Its BSRR is written by a DMA2 stream triggered by a
+ * TIM1 compare event at the beginning of each bit plane */
+typedef struct {
+	uint32_t gpio_port;				/* GPIO port */
+	enum rcc_periph_clken gpio_rcc;	/* GPIO port clock enable */
+	uint8_t dma_stream;				/* DMA2 stream of the compare request */
+	uint32_t dma_channel;			/* DMA2 channel selection of the compare request */
+	enum tim_oc_id oc;				/* TIM1 output compare of the request */
+	uint32_t dma_request;			/* TIM1 DIER compare DMA request enable bit */
+} bam_cfg_port_t;
+
+/* Channel descriptor */
+typedef struct {
+	uint8_t port;					/* port index */
+	uint8_t pin_number;				/* pin number: 0 - 15 */
+} bam_cfg_channel_t;
+
+
+
+
+/* ----------- Exported variables ------------- */
+
+extern const bam_cfg_port_t bam_cfg_ports[BAM_CFG_KE_PORT_MAX_NUM];
+extern const bam_cfg_channel_t bam_cfg_channels[BAM_CFG_CH_NUM];
+
+
+
+
+#endif
+
+/* End of file */
+
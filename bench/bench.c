@@ -0,0 +1,281 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bench.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Max length of an output line */
+#define LINE_SIZE						192
+
+/* Reported values are per call in tenths of a tick */
+#define FIXED_SCALE						10
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Measured samples of the actual case [ticks] */
+static uint32_t samples[BENCH_SAMPLES_MAX];
+
+/* Output line under construction */
+static char line[LINE_SIZE];
+static uint8_t line_length;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void empty_call(void);
+static void measure(const bench_case_t *, uint32_t, uint32_t, uint32_t);
+static uint32_t get_overhead(uint32_t, uint32_t);
+static void sort_samples(uint32_t);
+static uint32_t get_percentile(uint32_t, uint32_t);
+static void report(const char *, uint32_t, uint32_t);
+static void append_string(const char *);
+static void append_fixed(uint64_t);
+static void append_uint(uint64_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Run the suite: warm up each case, measure its samples and print one line
+ * of key=value pairs per case. The cost of the measure itself, taken on an
+ * empty call, is removed from each sample */
+void bench_run(const bench_cfg_t *cfg_ptr)
+{
+	const bench_case_t *case_ptr;
+	uint32_t samples_num = cfg_ptr->samples;
+	uint32_t batch_overhead;
+	uint32_t single_overhead;
+	uint32_t batch;
+	uint32_t call;
+	uint8_t case_index;
+
+	if (samples_num > BENCH_SAMPLES_MAX) {
+		samples_num = BENCH_SAMPLES_MAX;
+	}
+
+	bench_port_init();
+	bench_cases_init();
+
+	batch_overhead = get_overhead(cfg_ptr->batch, samples_num);
+	single_overhead = get_overhead(1, samples_num);
+
+	line_length = 0;
+	append_string("bench_unit=");
+	append_string(bench_port_get_unit());
+	append_string(" overhead=");
+	append_fixed(((uint64_t)batch_overhead * FIXED_SCALE) / cfg_ptr->batch);
+	bench_port_print(line);
+
+	for (case_index = 0; case_index < bench_cases_num; case_index++) {
+		case_ptr = &bench_cases[case_index];
+		if ((cfg_ptr->filter != NULL) && (strcmp(cfg_ptr->filter, case_ptr->name) != 0)) {
+			continue;
+		}
+
+		if (case_ptr->setup != NULL) {
+			(*case_ptr->setup)();
+		}
+		for (call = 0; call < cfg_ptr->warmup; call++) {
+			if (case_ptr->prepare != NULL) {
+				(*case_ptr->prepare)();
+			}
+			(*case_ptr->run)();
+		}
+
+		batch = (case_ptr->prepare != NULL) ? 1 : cfg_ptr->batch;
+		measure(case_ptr, batch, samples_num, (batch == 1) ? single_overhead : batch_overhead);
+		report(case_ptr->name, batch, samples_num);
+	}
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Reference call for the measure overhead */
+__attribute__((noinline)) static void empty_call(void)
+{
+	__asm__ volatile("" ::: "memory");
+}
+
+
+/* Measure the samples of a case, less the overhead of the measure */
+static void measure(const bench_case_t *case_ptr, uint32_t batch, uint32_t samples_num, uint32_t overhead)
+{
+	uint32_t sample_index;
+	uint32_t call;
+	uint32_t start_ticks;
+	uint32_t ticks;
+
+	for (sample_index = 0; sample_index < samples_num; sample_index++) {
+		if (case_ptr->prepare != NULL) {
+			(*case_ptr->prepare)();
+		}
+		start_ticks = bench_port_get_ticks();
+		for (call = 0; call < batch; call++) {
+			(*case_ptr->run)();
+		}
+		ticks = bench_port_get_ticks() - start_ticks;
+		samples[sample_index] = (ticks > overhead) ? (ticks - overhead) : 0;
+	}
+
+	sort_samples(samples_num);
+}
+
+
+/* Median cost of a measure of a batch of empty calls */
+static uint32_t get_overhead(uint32_t batch, uint32_t samples_num)
+{
+	const bench_case_t empty_case = {"empty", NULL, NULL, &empty_call};
+
+	measure(&empty_case, batch, samples_num, 0);
+
+	return get_percentile(samples_num, 50);
+}
+
+
+/* Sort the samples in ascending order */
+static void sort_samples(uint32_t samples_num)
+{
+	uint32_t index;
+	uint32_t hole;
+	uint32_t value;
+
+	/* insertion sort: samples are few and mostly ordered already */
+	for (index = 1; index < samples_num; index++) {
+		value = samples[index];
+		for (hole = index; (hole > 0) && (samples[hole - 1] > value); hole--) {
+			samples[hole] = samples[hole - 1];
+		}
+		samples[hole] = value;
+	}
+}
+
+
+/* Nearest rank percentile of the sorted samples */
+static uint32_t get_percentile(uint32_t samples_num, uint32_t percentile)
+{
+	uint32_t rank = ((percentile * samples_num) + 99) / 100;
+
+	return samples[(rank > 0) ? (rank - 1) : 0];
+}
+
+
+/* Print the statistics of a case, per call */
+static void report(const char *name, uint32_t batch, uint32_t samples_num)
+{
+	static const struct {
+		const char *key;
+		uint32_t percentile;
+	} percentiles[] = {
+		{" min=", 0},
+		{" p50=", 50},
+		{" p90=", 90},
+		{" p99=", 99},
+		{" max=", 100}
+	};
+	uint64_t sum = 0;
+	uint32_t index;
+
+	for (index = 0; index < samples_num; index++) {
+		sum += samples[index];
+	}
+
+	line_length = 0;
+	append_string("bench=");
+	append_string(name);
+	append_string(" samples=");
+	append_uint(samples_num);
+	append_string(" batch=");
+	append_uint(batch);
+	for (index = 0; index < (sizeof(percentiles) / sizeof(percentiles[0])); index++) {
+		append_string(percentiles[index].key);
+		append_fixed(((uint64_t)get_percentile(samples_num, percentiles[index].percentile) * FIXED_SCALE) / batch);
+	}
+	append_string(" mean=");
+	append_fixed((samples_num > 0) ? ((sum * FIXED_SCALE) / ((uint64_t)samples_num * batch)) : 0);
+	bench_port_print(line);
+}
+
+
+/* Append a string to the output line */
+static void append_string(const char *string)
+{
+	while ((*string != '\0') && (line_length < (LINE_SIZE - 1))) {
+		line[line_length++] = *string++;
+	}
+	line[line_length] = '\0';
+}
+
+
+/* Append a value in tenths with one decimal */
+static void append_fixed(uint64_t value)
+{
+	char decimal[3] = {'.', '0', '\0'};
+
+	append_uint(value / FIXED_SCALE);
+	decimal[1] = (char)('0' + (value % FIXED_SCALE));
+	append_string(decimal);
+}
+
+
+/* Append an unsigned value: no printf is required on target */
+static void append_uint(uint64_t value)
+{
+	char digits[21];
+	uint8_t index = sizeof(digits) - 1;
+
+	digits[index] = '\0';
+	do {
+		digits[--index] = (char)('0' + (value % 10));
+		value /= 10;
+	} while (value > 0);
+
+	append_string(&digits[index]);
+}
+
+
+
+
+/* End of file */
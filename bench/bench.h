@@ -0,0 +1,107 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Micro-benchmark suite of the drivers and scheduler hot paths. The runner
+ * is shared between host and target; the port provides the time source:
+ * nanoseconds on the host, DWT cycles on target */
+
+#ifndef _BENCH_INCLUDED_           /* switch to read the header file once */
+#define _BENCH_INCLUDED_           /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Max number of measured samples of a case */
+#define BENCH_SAMPLES_MAX				1024
+
+/* Default warm-up calls of a case */
+#define BENCH_DEFAULT_WARMUP			256
+
+/* Default measured samples of a case */
+#define BENCH_DEFAULT_SAMPLES			512
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Benchmark case. The prepare function is called before each measured call
+ * and is not measured: a case with it is measured one call per sample */
+typedef struct {
+	const char *name;
+	void (*setup)(void);				/* once before the case. NULL if none */
+	void (*prepare)(void);				/* before each call. NULL if none */
+	void (*run)(void);					/* measured call */
+} bench_case_t;
+
+/* Suite run configuration */
+typedef struct {
+	uint32_t warmup;					/* calls before the measure */
+	uint32_t samples;					/* measured samples */
+	uint32_t batch;						/* calls per sample of a case without prepare */
+	const char *filter;					/* run only the cases with this name. NULL for all */
+} bench_cfg_t;
+
+
+
+
+/* ----------- Exported variables ------------- */
+
+extern const bench_case_t bench_cases[];
+extern const uint8_t bench_cases_num;
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+/* Runner */
+extern void bench_run(const bench_cfg_t *);
+
+/* Cases */
+extern void bench_cases_init(void);
+
+/* Port: time source and output */
+extern void bench_port_init(void);
+extern uint32_t bench_port_get_ticks(void);
+extern const char *bench_port_get_unit(void);
+extern void bench_port_print(const char *);
+
+
+
+
+#endif
+
+/* End of file */
@@ -0,0 +1,416 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rtos.h"
+#include "rtos_cfg.h"
+#include "lis3dsh.h"
+#include "pwm.h"
+#include "led.h"
+#include "led_gamma.h"
+#include "calib.h"
+#include "app.h"
+#include "activity.h"
+#include "fade.h"
+#include "pattern.h"
+#include "gesture.h"
+#include "pedo.h"
+#include "timebase.h"
+#include "clock.h"
+#include "bench.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Period of the benchmark callbacks: all of them expire at each tick [ms] */
+#define CALLBACK_PERIOD_MS				(RTOS_UL_TICK_PERIOD_US / 1000)
+
+/* Step of the duty cycle between two calls of pwm_set_dc [permille] */
+#define DC_STEP_PERMILLE				((uint16_t)137)
+
+/* Duration of the benchmark fades: the level changes at each tick [ms] */
+#define FADE_DURATION_MS				((uint16_t)1000)
+
+/* Motion fed to the sample processing modules: a triangle wave on each axis,
+ * shifted by a third of the period, slow enough to stay below the tap jerk */
+#define MOTION_AMPLITUDE_MG				((int16_t)1200)
+#define MOTION_STEP_MG					((int16_t)40)
+#define MOTION_SAMPLES					((uint16_t)((4 * MOTION_AMPLITUDE_MG) / MOTION_STEP_MG))
+
+/* Tap spike added on Z once per motion period [mg] */
+#define TAP_SPIKE_MG					((int16_t)1500)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Feature windows of the classifier, one for each path of the forest */
+static const int8_t activity_windows[][ACTIVITY_FT_MAX_NUM] = {
+	{0, 20, 10, 5, 2},
+	{2, 50, 40, 30, 8},
+	{4, 50, 40, 30, 20},
+	{10, 90, 80, 60, 30}
+};
+
+/* Arguments of the next call */
+static uint8_t next_axis;
+static uint8_t next_window;
+static uint8_t next_channel;
+static uint16_t next_dc;
+static bool next_on;
+
+/* Next fade curve and direction */
+static uint8_t next_curve;
+static bool fade_up;
+
+/* Pattern of the pattern engine case: an edge, a level or a fade start at each tick */
+static const uint8_t bench_pattern[] = {
+	PATTERN_LOOP(0),
+		PATTERN_ON,
+		PATTERN_WAIT(10),
+		PATTERN_LEVEL(255),
+		PATTERN_WAIT(10),
+		PATTERN_FADE(0, 20),
+		PATTERN_OFF,
+		PATTERN_WAIT(10),
+	PATTERN_END_LOOP
+};
+
+/* Accelerometer samples fed in turn, X, Y, Z [mg] */
+static int16_t motion_samples[MOTION_SAMPLES][3];
+static uint16_t next_sample;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void empty_callback(void);
+static void setup_callbacks(void);
+static void run_tick(void);
+static void run_execute_task(void);
+static void run_read_axis(void);
+static void run_set_dc(void);
+static void run_set_channel_status(void);
+static void start_blinking(void);
+static void toggle_channel(void);
+static void run_manage_blinking(void);
+static void start_patterns(void);
+static void run_pattern_tick(void);
+static void start_fades(void);
+static void run_fade_tick(void);
+static void setup_motion(void);
+static void setup_tapped_motion(void);
+static void feed_sample(void);
+static void run_app_main_demo(void);
+static void run_gesture_process_sample(void);
+static void run_activity_process_sample(void);
+static void run_pedo_process_sample(void);
+static void run_get_us(void);
+static void run_activity_classify(void);
+
+
+
+
+/* ------------ Exported variables ----------------- */
+
+/* Benchmark cases */
+const bench_case_t bench_cases[] = {
+	{"rtos_tick_timer_callback", &setup_callbacks, NULL, &run_tick},
+	{"rtos_execute_task", &setup_callbacks, &run_tick, &run_execute_task},
+	{"lis3dsh_readAxis", NULL, NULL, &run_read_axis},
+	{"pwm_set_dc", NULL, NULL, &run_set_dc},
+	{"led_set_channel_status", NULL, NULL, &run_set_channel_status},
+	{"led_manage_blinking", &start_blinking, &toggle_channel, &run_manage_blinking},
+	{"pattern_tick", &start_patterns, NULL, &run_pattern_tick},
+	{"fade_tick", &start_fades, &start_fades, &run_fade_tick},
+	{"app_main_demo", &setup_motion, &feed_sample, &run_app_main_demo},
+	{"timebase_get_us", NULL, NULL, &run_get_us},
+	{"gesture_process_sample", &setup_tapped_motion, NULL, &run_gesture_process_sample},
+	{"activity_process_sample", &setup_motion, NULL, &run_activity_process_sample},
+	{"activity_classify", NULL, NULL, &run_activity_classify},
+	{"pedo_process_sample", &setup_motion, NULL, &run_pedo_process_sample}
+};
+
+/* Number of benchmark cases */
+const uint8_t bench_cases_num = (uint8_t)(sizeof(bench_cases) / sizeof(bench_cases[0]));
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init the firmware as the RTOS init state does. The tick timer is stopped:
+ * the scheduler cases drive it */
+void bench_cases_init(void)
+{
+	timebase_setup();
+	rtos_start_operation(RTOS_CFG_KE_NORMAL_STATE);
+	rtos_stop_operation();
+
+	/* the load shall not change the speed the cases are measured at */
+	clock_set_speed(CLOCK_CFG_KE_SPEED_168MHZ);
+
+	led_init();
+	lis3dsh_init();
+	calib_init();
+	app_init();
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Callback with no work: the dispatch only is measured */
+static void empty_callback(void)
+{
+}
+
+
+/* Set all callbacks periodic on each tick: worst case of tick and dispatch */
+static void setup_callbacks(void)
+{
+	uint8_t callback_id;
+
+	for (callback_id = 0; callback_id < RTOS_CB_ID_MAX_NUM; callback_id++) {
+		rtos_set_callback(callback_id, RTOS_CB_TYPE_PERIODIC, CALLBACK_PERIOD_MS, &empty_callback);
+	}
+}
+
+
+/* RTOS tick */
+static void run_tick(void)
+{
+	rtos_tick_timer_callback();
+}
+
+
+/* RTOS dispatch of the callbacks expired at the last tick and of the
+ * state tasks once per tasks period */
+static void run_execute_task(void)
+{
+	rtos_execute_task();
+}
+
+
+/* Accelerometer read of one axis over SPI, each axis in turn */
+static void run_read_axis(void)
+{
+	(void)lis3dsh_readAxis(next_axis);
+	next_axis = (uint8_t)((next_axis + 1) % 3);
+}
+
+
+/* PWM duty cycle update of each channel in turn, with a new value each time */
+static void run_set_dc(void)
+{
+	pwm_set_dc(next_channel, next_dc);
+	next_channel = (uint8_t)((next_channel + 1) % PWM_CFG_KE_CH_MAX_NUM);
+	next_dc = (uint16_t)((next_dc + DC_STEP_PERMILLE) % 1001);
+}
+
+
+/* LED on and off requests of each channel in turn */
+static void run_set_channel_status(void)
+{
+	led_set_channel_status((led_ke_channels)next_channel, next_on ? LED_KE_CH_TURN_ON : LED_KE_CH_TURN_OFF);
+	next_channel = (uint8_t)((next_channel + 1) % LED_KE_CH_CHECK);
+	if (next_channel == 0) {
+		next_on = !next_on;
+	}
+}
+
+
+/* Run the default blinking on the last two LED channels: their pattern
+ * events are pending at each compositor tick */
+static void start_blinking(void)
+{
+	led_set_channel_status(LED_KE_CHANNEL_3, LED_KE_CH_BLINKING);
+	led_set_channel_status(LED_KE_CHANNEL_4, LED_KE_CH_BLINKING);
+}
+
+
+/* Toggle the first two LED channels in turn: the next tick has a dirty frame to compose */
+static void toggle_channel(void)
+{
+	led_set_channel_status(next_on ? LED_KE_CHANNEL_2 : LED_KE_CHANNEL_1, LED_KE_CH_TOGGLE);
+	next_on = !next_on;
+}
+
+
+/* LED compositor tick */
+static void run_manage_blinking(void)
+{
+	led_manage_blinking(1);
+}
+
+
+/* Run the pattern of the case on all LED channels */
+static void start_patterns(void)
+{
+	uint8_t ch_index;
+
+	for (ch_index = 0; ch_index < LED_KE_CH_CHECK; ch_index++) {
+		led_set_pattern((led_ke_channels)ch_index, bench_pattern);
+	}
+}
+
+
+/* Pattern engine tick of all LED channels */
+static void run_pattern_tick(void)
+{
+	(void)pattern_tick(1);
+}
+
+
+/* Start a fade over the whole range on each idle LED channel, each with the
+ * next curve, in the opposite direction of the previous ones */
+static void start_fades(void)
+{
+	uint8_t ch_index;
+
+	for (ch_index = 0; ch_index < LED_KE_CH_CHECK; ch_index++) {
+		if (!fade_is_active(ch_index)) {
+			led_fade_brightness((led_ke_channels)ch_index, fade_up ? (LED_GAMMA_LEVELS - 1) : 0,
+								FADE_DURATION_MS, next_curve);
+			next_curve = (uint8_t)((next_curve + 1) % FADE_KE_CURVE_CHECK);
+			if (ch_index == LED_KE_LAST_CH) {
+				fade_up = !fade_up;
+			}
+		}
+	}
+}
+
+
+/* Fade step of all LED channels, each on a running fade */
+static void run_fade_tick(void)
+{
+	(void)fade_tick(1);
+}
+
+
+/* Fill the motion samples: each axis crosses the LED thresholds of the
+ * application in turn, with no gesture */
+static void setup_motion(void)
+{
+	uint16_t index;
+	uint16_t phase;
+	uint8_t axis;
+	int16_t position;
+
+	for (index = 0; index < MOTION_SAMPLES; index++) {
+		for (axis = 0; axis < 3; axis++) {
+			phase = (uint16_t)((index + ((axis * MOTION_SAMPLES) / 3)) % MOTION_SAMPLES);
+			position = (int16_t)(phase * MOTION_STEP_MG);
+			if (position < (2 * MOTION_AMPLITUDE_MG)) {
+				motion_samples[index][axis] = (int16_t)(position - MOTION_AMPLITUDE_MG);
+			} else {
+				motion_samples[index][axis] = (int16_t)((3 * MOTION_AMPLITUDE_MG) - position);
+			}
+		}
+	}
+	next_sample = 0;
+}
+
+
+/* Fill the motion samples with a tap once per period */
+static void setup_tapped_motion(void)
+{
+	setup_motion();
+	motion_samples[0][2] = (int16_t)(motion_samples[0][2] + TAP_SPIKE_MG);
+}
+
+
+/* Feed the next motion sample to the application as the sampling callback does */
+static void feed_sample(void)
+{
+	app_process_sample(motion_samples[next_sample][0], motion_samples[next_sample][1],
+					   motion_samples[next_sample][2]);
+	next_sample = (uint16_t)((next_sample + 1) % MOTION_SAMPLES);
+}
+
+
+/* Application main task on a new sample */
+static void run_app_main_demo(void)
+{
+	app_main_demo();
+}
+
+
+/* Timestamp read */
+static void run_get_us(void)
+{
+	(void)timebase_get_us();
+}
+
+
+/* Gesture detector on the next motion sample */
+static void run_gesture_process_sample(void)
+{
+	gesture_process_sample(motion_samples[next_sample][0], motion_samples[next_sample][1],
+						   motion_samples[next_sample][2]);
+	next_sample = (uint16_t)((next_sample + 1) % MOTION_SAMPLES);
+}
+
+
+/* Activity feature extraction on the next motion sample: the forest runs once per window */
+static void run_activity_process_sample(void)
+{
+	activity_process_sample(motion_samples[next_sample][0], motion_samples[next_sample][1],
+							motion_samples[next_sample][2]);
+	next_sample = (uint16_t)((next_sample + 1) % MOTION_SAMPLES);
+}
+
+
+/* Activity forest inference of a feature window, each window in turn */
+static void run_activity_classify(void)
+{
+	(void)activity_classify(activity_windows[next_window]);
+	next_window = (uint8_t)((next_window + 1) % (sizeof(activity_windows) / sizeof(activity_windows[0])));
+}
+
+
+/* Pedometer on the next motion sample */
+static void run_pedo_process_sample(void)
+{
+	pedo_process_sample(motion_samples[next_sample][0], motion_samples[next_sample][1],
+						motion_samples[next_sample][2]);
+	next_sample = (uint16_t)((next_sample + 1) % MOTION_SAMPLES);
+}
+
+
+
+
+/* End of file */
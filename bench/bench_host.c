@@ -0,0 +1,123 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Benchmark suite on the host simulation: time in nanoseconds of the host
+ * monotonic clock, results on the standard output */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "clock.h"
+#include "bench.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Default calls per sample: the host clock resolution is tens of ns */
+#define DEFAULT_BATCH					64
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Usage: main_bench [-w warmup] [-n samples] [-b batch] [-c case] */
+int main(int argc, char *argv[])
+{
+	bench_cfg_t cfg = {BENCH_DEFAULT_WARMUP, BENCH_DEFAULT_SAMPLES, DEFAULT_BATCH, NULL};
+	int option;
+
+	while ((option = getopt(argc, argv, "w:n:b:c:")) != -1) {
+		if (option == 'w') {
+			cfg.warmup = (uint32_t)strtoul(optarg, NULL, 0);
+		} else if (option == 'n') {
+			cfg.samples = (uint32_t)strtoul(optarg, NULL, 0);
+		} else if (option == 'b') {
+			cfg.batch = (uint32_t)strtoul(optarg, NULL, 0);
+		} else if (option == 'c') {
+			cfg.filter = optarg;
+		} else {
+			fprintf(stderr, "usage: %s [-w warmup] [-n samples] [-b batch] [-c case]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (cfg.batch == 0) {
+		cfg.batch = 1;
+	}
+
+	sim_init();
+	clock_setup();
+
+	bench_run(&cfg);
+
+	return EXIT_SUCCESS;
+}
+
+
+/* Nothing to init: the monotonic clock is always running */
+void bench_port_init(void)
+{
+}
+
+
+/* Get the monotonic clock [ns]. Only differences are used: wrap is fine */
+uint32_t bench_port_get_ticks(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t)(((uint64_t)now.tv_sec * 1000000000) + (uint64_t)now.tv_nsec);
+}
+
+
+/* Unit of the ticks */
+const char *bench_port_get_unit(void)
+{
+	return "ns";
+}
+
+
+/* Print a result line */
+void bench_port_print(const char *line)
+{
+	puts(line);
+}
+
+
+
+
+/* End of file */
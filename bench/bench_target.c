@@ -0,0 +1,136 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Benchmark suite on target: time in core cycles of the DWT cycle counter.
+ * Results are written to bench_report: read it with the debugger once
+ * bench_done is set (gdb: x/s bench_report) */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <libopencm3/cm3/scs.h>
+#include <libopencm3/cm3/dwt.h>
+
+#include "clock.h"
+#include "bench.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Size of the report buffer */
+#define REPORT_SIZE						2048
+
+
+
+
+/* ------------ Exported variables ----------------- */
+
+/* Report: one line per case */
+char bench_report[REPORT_SIZE];
+
+/* Suite completed */
+volatile bool bench_done = false;
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Length of the report */
+static uint16_t report_length;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Main function: run the suite once, then wait for the debugger */
+int main(void)
+{
+	/* cycles are exact: one call per sample */
+	const bench_cfg_t cfg = {BENCH_DEFAULT_WARMUP, BENCH_DEFAULT_SAMPLES, 1, NULL};
+
+	clock_setup();
+
+	bench_run(&cfg);
+	bench_done = true;
+
+	while (1) {
+	}
+
+	return 0;
+}
+
+
+/* Start the DWT cycle counter */
+void bench_port_init(void)
+{
+	SCS_DEMCR |= SCS_DEMCR_TRCENA;
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+}
+
+
+/* Get the core cycles counter */
+uint32_t bench_port_get_ticks(void)
+{
+	return DWT_CYCCNT;
+}
+
+
+/* Unit of the ticks */
+const char *bench_port_get_unit(void)
+{
+	return "cycles";
+}
+
+
+/* Append a result line to the report. Lines that do not fit are dropped */
+void bench_port_print(const char *line)
+{
+	uint16_t length = 0;
+
+	while (line[length] != '\0') {
+		length++;
+	}
+
+	if ((report_length + length + 1) < REPORT_SIZE) {
+		while (*line != '\0') {
+			bench_report[report_length++] = *line++;
+		}
+		bench_report[report_length++] = '\n';
+		bench_report[report_length] = '\0';
+	}
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,363 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lis3dsh.h"
+#include "nvm.h"
+#include "calib.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Number of axis */
+#define NUM_OF_AXIS						3
+
+/* Number of positions: +1g and -1g on each axis */
+#define NUM_OF_POSITIONS				(NUM_OF_AXIS * 2)
+
+/* Mask of all positions done */
+#define ALL_POSITIONS_MASK				((uint8_t)((1 << NUM_OF_POSITIONS) - 1))
+
+/* Samples averaged in each position as power of 2 */
+#define SAMPLES_PER_POS_SHIFT			6	/* 64 samples */
+
+/* Samples to wait in a new position before averaging */
+#define SETTLE_SAMPLES					((uint16_t)50)
+
+/* Minimum reading of the axis pointing up or down [mg] */
+#define DOMINANT_AXIS_TH_MG				((int16_t)800)
+
+/* Maximum reading of the other axes [mg] */
+#define OTHER_AXIS_TH_MG				((int16_t)250)
+
+/* 1g reference [mg] */
+#define ONE_G_MG						((int64_t)1000)
+
+/* Accepted gain correction range in Q16: 0.8 - 1.2 */
+#define MIN_GAIN_Q16					((int32_t)52429)
+#define MAX_GAIN_Q16					((int32_t)78643)
+
+/* Accepted offset range [mg] in Q16 */
+#define MAX_OFFSET_Q16					((int32_t)300 << 16)
+
+/* Stored record magic value: "CAL1" */
+#define RECORD_MAGIC					((uint32_t)0x314C4143)
+
+/* Position index value for no valid position */
+#define NO_POSITION						((uint8_t)0xFF)
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Calibration record as stored in flash */
+typedef struct {
+	uint32_t magic;
+	int32_t scale_q16[NUM_OF_AXIS];
+	int32_t offset_q16[NUM_OF_AXIS];
+	uint32_t checksum;
+} calib_record_t;
+
+/* Number of words of a record */
+#define RECORD_WORDS					((uint16_t)(sizeof(calib_record_t) / sizeof(uint32_t)))
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Actual calibration status */
+static uint8_t calib_status = CALIB_KE_NOMINAL;
+
+/* Positions done mask: bit (axis * 2) is +1g, bit (axis * 2 + 1) is -1g */
+static uint8_t positions_done;
+
+/* Position of the last samples and samples spent in it */
+static uint8_t actual_position;
+static uint16_t position_samples;
+
+/* Sum of the dominant axis readings for each position [mg] */
+static int32_t position_sums[NUM_OF_POSITIONS];
+
+/* Estimated record waiting to be stored */
+static calib_record_t pending_record;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static uint8_t get_position(int16_t, int16_t, int16_t);
+static bool estimate(calib_record_t *);
+static uint32_t compute_checksum(const calib_record_t *);
+static void apply_record(const calib_record_t *);
+static void apply_nominal(void);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Load stored calibration, if valid. Call after lis3dsh_init */
+void calib_init(void)
+{
+	const calib_record_t *record_ptr = (const calib_record_t *)nvm_get_data();
+
+	if ((RECORD_MAGIC == record_ptr->magic)
+	&& (compute_checksum(record_ptr) == record_ptr->checksum)) {
+		apply_record(record_ptr);
+		calib_status = CALIB_KE_DONE;
+	} else {
+		apply_nominal();
+		calib_status = CALIB_KE_NOMINAL;
+	}
+}
+
+
+/* Start six-position calibration: place the board still with each axis
+ * pointing up and down, in any order */
+void calib_start(void)
+{
+	uint8_t position_index;
+
+	/* estimation works on nominal readings */
+	apply_nominal();
+
+	for (position_index = 0; position_index < NUM_OF_POSITIONS; position_index++) {
+		position_sums[position_index] = 0;
+	}
+	positions_done = 0;
+	actual_position = NO_POSITION;
+	position_samples = 0;
+	calib_status = CALIB_KE_RUNNING;
+}
+
+
+/* Process a new sample [mg] */
+void calib_process_sample(int16_t x_mg, int16_t y_mg, int16_t z_mg)
+{
+	int16_t values[NUM_OF_AXIS];
+	uint8_t position;
+
+	if (CALIB_KE_RUNNING == calib_status) {
+		values[0] = x_mg;
+		values[1] = y_mg;
+		values[2] = z_mg;
+		position = get_position(x_mg, y_mg, z_mg);
+
+		if (position != actual_position) {
+			/* board moved: restart settling */
+			actual_position = position;
+			position_samples = 0;
+			if ((position != NO_POSITION)
+			&& ((positions_done & (1 << position)) == 0)) {
+				position_sums[position] = 0;
+			}
+		} else if ((position != NO_POSITION)
+		&& ((positions_done & (1 << position)) == 0)) {
+			position_samples++;
+			if (position_samples > SETTLE_SAMPLES) {
+				/* dominant axis is position / 2 */
+				position_sums[position] += values[position >> 1];
+				if (position_samples >= (SETTLE_SAMPLES + (1 << SAMPLES_PER_POS_SHIFT))) {
+					positions_done |= (uint8_t)(1 << position);
+				}
+			}
+		} else {
+			/* position already done or not valid: wait */
+		}
+
+		if (ALL_POSITIONS_MASK == positions_done) {
+			/* storage stalls the CPU: it is left to calib_save */
+			if (estimate(&pending_record)) {
+				calib_status = CALIB_KE_SAVE_PENDING;
+			} else {
+				calib_status = CALIB_KE_ERROR;
+			}
+		}
+	}
+}
+
+
+/* Store and apply the estimated calibration, if any. ATTENTION: the CPU
+ * stalls while the flash sector is erased, call it out of normal operation */
+void calib_save(void)
+{
+	if (CALIB_KE_SAVE_PENDING == calib_status) {
+		if (nvm_write((const uint32_t *)&pending_record, RECORD_WORDS)) {
+			apply_record(&pending_record);
+			calib_status = CALIB_KE_DONE;
+		} else {
+			calib_status = CALIB_KE_ERROR;
+		}
+	}
+}
+
+
+/* Get calibration status */
+uint8_t calib_get_status(void)
+{
+	return calib_status;
+}
+
+
+/* Get mask of positions done: bit (axis * 2) is +1g, bit (axis * 2 + 1) is -1g */
+uint8_t calib_get_positions_done(void)
+{
+	return positions_done;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Get position index from a sample, NO_POSITION if not aligned with an axis */
+static uint8_t get_position(int16_t x_mg, int16_t y_mg, int16_t z_mg)
+{
+	int16_t values[NUM_OF_AXIS];
+	uint8_t axis_index;
+	uint8_t dominant_axis = NO_POSITION;
+	uint8_t position = NO_POSITION;
+	bool aligned = true;
+
+	values[0] = x_mg;
+	values[1] = y_mg;
+	values[2] = z_mg;
+
+	for (axis_index = 0; axis_index < NUM_OF_AXIS; axis_index++) {
+		if ((values[axis_index] >= DOMINANT_AXIS_TH_MG)
+		|| (values[axis_index] <= -DOMINANT_AXIS_TH_MG)) {
+			dominant_axis = axis_index;
+		} else if ((values[axis_index] > OTHER_AXIS_TH_MG)
+		|| (values[axis_index] < -OTHER_AXIS_TH_MG)) {
+			aligned = false;
+		}
+	}
+
+	if (aligned && (dominant_axis != NO_POSITION)) {
+		position = (uint8_t)((dominant_axis << 1) | ((values[dominant_axis] < 0) ? 1 : 0));
+	}
+
+	return position;
+}
+
+
+/* Estimate offset and gain of each axis from the position averages.
+ * With P and N the readings at +1g and -1g:
+ * offset = (P + N) / 2, gain = 2g / (P - N), calibrated = (reading - offset) * gain.
+ * Result is folded into the LIS3DSH conversion coefficients */
+static bool estimate(calib_record_t *record_ptr)
+{
+	uint8_t axis_index;
+	int64_t pos_sum;
+	int64_t neg_sum;
+	int32_t gain_q16;
+	int32_t offset_q16;
+	bool result = true;
+
+	for (axis_index = 0; axis_index < NUM_OF_AXIS; axis_index++) {
+		pos_sum = position_sums[axis_index << 1];
+		neg_sum = position_sums[(axis_index << 1) + 1];
+
+		if (pos_sum <= neg_sum) {
+			result = false;
+			break;
+		}
+
+		/* sums hold 2^SAMPLES_PER_POS_SHIFT samples each */
+		gain_q16 = (int32_t)(((2 * ONE_G_MG) << (16 + SAMPLES_PER_POS_SHIFT)) / (pos_sum - neg_sum));
+		offset_q16 = (int32_t)(((pos_sum + neg_sum) << 16) >> (SAMPLES_PER_POS_SHIFT + 1));
+
+		if ((gain_q16 < MIN_GAIN_Q16) || (gain_q16 > MAX_GAIN_Q16)
+		|| (offset_q16 > MAX_OFFSET_Q16) || (offset_q16 < -MAX_OFFSET_Q16)) {
+			result = false;
+			break;
+		}
+
+		record_ptr->scale_q16[axis_index] =
+			(int32_t)(((int64_t)LIS3DSH_SENS_2G_MG_PER_DIGIT_Q16 * gain_q16) >> 16);
+		record_ptr->offset_q16[axis_index] =
+			(int32_t)(-(((int64_t)offset_q16 * gain_q16) >> 16));
+	}
+
+	record_ptr->magic = RECORD_MAGIC;
+	record_ptr->checksum = compute_checksum(record_ptr);
+
+	return result;
+}
+
+
+/* Compute record checksum: complement of the sum of all previous words */
+static uint32_t compute_checksum(const calib_record_t *record_ptr)
+{
+	const uint32_t *word_ptr = (const uint32_t *)record_ptr;
+	uint32_t sum = 0;
+	uint16_t word_index;
+
+	for (word_index = 0; word_index < (RECORD_WORDS - 1); word_index++) {
+		sum += word_ptr[word_index];
+	}
+
+	return ~sum;
+}
+
+
+/* Load record coefficients into the LIS3DSH conversion */
+static void apply_record(const calib_record_t *record_ptr)
+{
+	uint8_t axis_index;
+
+	for (axis_index = 0; axis_index < NUM_OF_AXIS; axis_index++) {
+		lis3dsh_set_calibration(axis_index,
+								record_ptr->scale_q16[axis_index],
+								record_ptr->offset_q16[axis_index]);
+	}
+}
+
+
+/* Load nominal coefficients into the LIS3DSH conversion */
+static void apply_nominal(void)
+{
+	uint8_t axis_index;
+
+	for (axis_index = 0; axis_index < NUM_OF_AXIS; axis_index++) {
+		lis3dsh_set_calibration(axis_index, LIS3DSH_SENS_2G_MG_PER_DIGIT_Q16, 0);
+	}
+}
+
+
+
+
+/* End of file */
+
@@ -0,0 +1,67 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _CALIB_INCLUDED_           /* switch to read the header file once */
+#define _CALIB_INCLUDED_           /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Calibration status enum */
+enum {
+	CALIB_KE_NOMINAL,			/* no valid calibration: nominal sensitivity */
+	CALIB_KE_RUNNING,			/* six-position calibration in progress */
+	CALIB_KE_SAVE_PENDING,		/* estimation done: waiting for calib_save */
+	CALIB_KE_DONE,				/* calibration applied */
+	CALIB_KE_ERROR				/* estimation out of range or storage failure */
+};
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void calib_init(void);
+extern void calib_start(void);
+extern void calib_process_sample(int16_t, int16_t, int16_t);
+extern void calib_save(void);
+extern uint8_t calib_get_status(void);
+extern uint8_t calib_get_positions_done(void);
+
+
+
+
+#endif
+
+/* End of file */
+
@@ -0,0 +1,350 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "accel.h"
+#include "capture.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Index value for no buffer */
+#define NO_BUFFER						((uint8_t)0xFF)
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Buffer state enum */
+enum {
+	KE_BUF_FREE,
+	KE_BUF_ACQUIRING,
+	KE_BUF_POST_TRIGGER,
+	KE_BUF_READY
+};
+
+/* Ring buffer holding a pre-trigger window and, once triggered, the post-trigger data.
+ * The post-trigger samples overwrite only the samples older than the pre-trigger
+ * window, so a trigger never copies data: it only records where the capture starts */
+typedef struct {
+	capture_sample_t samples[CAPTURE_SAMPLES];
+	uint16_t write_index;
+	uint16_t fill_count;
+	uint16_t start_index;
+	uint16_t post_count;
+	uint8_t state;
+} capture_buffer_t;
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Capture buffers, one for each slot */
+static capture_buffer_t buffers[CAPTURE_SLOTS_NUM];
+
+/* Buffer receiving the samples */
+static uint8_t acquiring_buffer;
+
+/* Trigger configuration */
+static uint8_t trigger_type;
+static uint16_t trigger_level;
+
+/* Previous magnitude for slope trigger [mg] */
+static uint16_t prev_magnitude;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static bool check_trigger(int16_t, int16_t, int16_t);
+static void freeze_buffer(capture_buffer_t *);
+static void switch_acquiring_buffer(void);
+static uint8_t get_free_buffer(void);
+static uint8_t slot_to_buffer(uint8_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init capture engine */
+void capture_init(void)
+{
+	uint8_t buffer_index;
+
+	for (buffer_index = 0; buffer_index < CAPTURE_SLOTS_NUM; buffer_index++) {
+		buffers[buffer_index].state = KE_BUF_FREE;
+	}
+
+	trigger_type = CAPTURE_TRIG_EXTERNAL;
+	trigger_level = UINT16_MAX;
+	prev_magnitude = 0;
+
+	acquiring_buffer = NO_BUFFER;
+	switch_acquiring_buffer();
+}
+
+
+/* Configure trigger type and level [mg] */
+void capture_set_trigger(uint8_t type, uint16_t level)
+{
+	if (type < CAPTURE_TRIG_CHECK) {
+		trigger_type = type;
+		trigger_level = level;
+	} else {
+		/* invalid parameters */
+	}
+}
+
+
+/* Process a new sample [mg] */
+void capture_process_sample(int16_t x_mg, int16_t y_mg, int16_t z_mg)
+{
+	capture_buffer_t *buffer_ptr = &buffers[acquiring_buffer];
+	capture_sample_t *sample_ptr = &buffer_ptr->samples[buffer_ptr->write_index];
+
+	/* store sample */
+	sample_ptr->x = x_mg;
+	sample_ptr->y = y_mg;
+	sample_ptr->z = z_mg;
+	buffer_ptr->write_index++;
+	if (buffer_ptr->write_index >= CAPTURE_SAMPLES) {
+		buffer_ptr->write_index = 0;
+	}
+	if (buffer_ptr->fill_count < CAPTURE_SAMPLES) {
+		buffer_ptr->fill_count++;
+	}
+
+	if (KE_BUF_POST_TRIGGER == buffer_ptr->state) {
+		buffer_ptr->post_count++;
+		/* capture complete: keep acquiring in another buffer */
+		if (buffer_ptr->post_count >= (CAPTURE_SAMPLES - CAPTURE_PRE_SAMPLES)) {
+			buffer_ptr->state = KE_BUF_READY;
+			switch_acquiring_buffer();
+		}
+	} else if (check_trigger(x_mg, y_mg, z_mg)) {
+		freeze_buffer(buffer_ptr);
+	} else {
+		/* keep rolling */
+	}
+}
+
+
+/* Trigger a capture on the last processed sample */
+void capture_trigger(void)
+{
+	freeze_buffer(&buffers[acquiring_buffer]);
+}
+
+
+/* Check if a capture slot holds a complete capture */
+bool capture_is_ready(uint8_t slot_index)
+{
+	uint8_t buffer_index = slot_to_buffer(slot_index);
+
+	return (buffer_index != NO_BUFFER);
+}
+
+
+/* Read a sample of a capture. Sample 0 is the oldest pre-trigger one */
+bool capture_read_sample(uint8_t slot_index, uint16_t sample_index, capture_sample_t *sample_ptr)
+{
+	uint8_t buffer_index = slot_to_buffer(slot_index);
+	uint16_t ring_index;
+	bool result = false;
+
+	if ((buffer_index != NO_BUFFER)
+	&& (sample_index < CAPTURE_SAMPLES)
+	&& (sample_ptr != NULL)) {
+		ring_index = buffers[buffer_index].start_index + sample_index;
+		if (ring_index >= CAPTURE_SAMPLES) {
+			ring_index -= CAPTURE_SAMPLES;
+		}
+		*sample_ptr = buffers[buffer_index].samples[ring_index];
+		result = true;
+	}
+
+	return result;
+}
+
+
+/* Free a capture slot */
+void capture_release(uint8_t slot_index)
+{
+	uint8_t buffer_index = slot_to_buffer(slot_index);
+
+	if (buffer_index != NO_BUFFER) {
+		buffers[buffer_index].state = KE_BUF_FREE;
+	}
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Evaluate configured trigger condition */
+static bool check_trigger(int16_t x_mg, int16_t y_mg, int16_t z_mg)
+{
+	uint16_t magnitude = accel_magnitude_approx(x_mg, y_mg, z_mg);
+	uint16_t slope;
+	bool triggered = false;
+
+	switch (trigger_type) {
+	case CAPTURE_TRIG_THRESHOLD:
+	{
+		triggered = (magnitude >= trigger_level);
+		break;
+	}
+	case CAPTURE_TRIG_SLOPE:
+	{
+		slope = (magnitude > prev_magnitude) ? (magnitude - prev_magnitude)
+											 : (prev_magnitude - magnitude);
+		triggered = (slope >= trigger_level);
+		break;
+	}
+	default:
+	{
+		/* external trigger only */
+		break;
+	}
+	}
+
+	prev_magnitude = magnitude;
+
+	return triggered;
+}
+
+
+/* Freeze the pre-trigger window of the acquiring buffer and start post-trigger recording */
+static void freeze_buffer(capture_buffer_t *buffer_ptr)
+{
+	uint16_t trigger_index;
+
+	/* armed only with a full pre-trigger window and a spare buffer to switch to */
+	if ((KE_BUF_ACQUIRING == buffer_ptr->state)
+	&& (buffer_ptr->fill_count > CAPTURE_PRE_SAMPLES)
+	&& (get_free_buffer() != NO_BUFFER)) {
+		/* trigger sample is the last written one */
+		trigger_index = (buffer_ptr->write_index > 0) ? (buffer_ptr->write_index - 1)
+													  : (CAPTURE_SAMPLES - 1);
+		/* capture starts CAPTURE_PRE_SAMPLES before the trigger sample */
+		buffer_ptr->start_index = (trigger_index >= CAPTURE_PRE_SAMPLES)
+								? (trigger_index - CAPTURE_PRE_SAMPLES)
+								: (trigger_index + CAPTURE_SAMPLES - CAPTURE_PRE_SAMPLES);
+		/* trigger sample is the first post-trigger one */
+		buffer_ptr->post_count = 1;
+		buffer_ptr->state = KE_BUF_POST_TRIGGER;
+	}
+}
+
+
+/* Move acquisition to a free buffer, if any. The last pre-trigger window of
+ * samples is carried over, so that a trigger right after a capture has its
+ * full history. This copy is done once per completed capture, never at the trigger */
+static void switch_acquiring_buffer(void)
+{
+	uint8_t buffer_index = get_free_buffer();
+	capture_buffer_t *buffer_ptr;
+	const capture_buffer_t *prev_buffer_ptr;
+	uint16_t read_index;
+	uint16_t carried;
+
+	if (buffer_index != NO_BUFFER) {
+		buffer_ptr = &buffers[buffer_index];
+		buffer_ptr->write_index = 0;
+		buffer_ptr->fill_count = 0;
+		buffer_ptr->post_count = 0;
+
+		if (acquiring_buffer != NO_BUFFER) {
+			prev_buffer_ptr = &buffers[acquiring_buffer];
+			carried = (prev_buffer_ptr->fill_count < CAPTURE_PRE_SAMPLES) ? prev_buffer_ptr->fill_count
+																		  : CAPTURE_PRE_SAMPLES;
+			/* oldest carried sample first */
+			read_index = (prev_buffer_ptr->write_index >= carried)
+					   ? (prev_buffer_ptr->write_index - carried)
+					   : (prev_buffer_ptr->write_index + CAPTURE_SAMPLES - carried);
+			while (buffer_ptr->write_index < carried) {
+				buffer_ptr->samples[buffer_ptr->write_index++] = prev_buffer_ptr->samples[read_index++];
+				if (read_index >= CAPTURE_SAMPLES) {
+					read_index = 0;
+				}
+			}
+			buffer_ptr->fill_count = carried;
+		}
+
+		buffer_ptr->state = KE_BUF_ACQUIRING;
+		acquiring_buffer = buffer_index;
+	} else {
+		/* cannot happen: a trigger is armed only with a free buffer */
+	}
+}
+
+
+/* Find a free buffer */
+static uint8_t get_free_buffer(void)
+{
+	uint8_t buffer_index;
+	uint8_t free_buffer = NO_BUFFER;
+
+	for (buffer_index = 0; buffer_index < CAPTURE_SLOTS_NUM; buffer_index++) {
+		if (KE_BUF_FREE == buffers[buffer_index].state) {
+			free_buffer = buffer_index;
+			break;
+		}
+	}
+
+	return free_buffer;
+}
+
+
+/* Get the buffer of a slot if it holds a complete capture */
+static uint8_t slot_to_buffer(uint8_t slot_index)
+{
+	uint8_t buffer_index = NO_BUFFER;
+
+	if ((slot_index < CAPTURE_SLOTS_NUM)
+	&& (KE_BUF_READY == buffers[slot_index].state)) {
+		buffer_index = slot_index;
+	}
+
+	return buffer_index;
+}
+
+
+
+
+/* End of file */
+
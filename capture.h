@@ -0,0 +1,98 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _CAPTURE_INCLUDED_         /* switch to read the header file once */
+#define _CAPTURE_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+/* This inclusion is for other modules that include this component: sample period */
+#include "accel.h"
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Time recorded before the trigger [ms] */
+#define CAPTURE_PRE_TRIGGER_MS			((uint16_t)200)
+
+/* Time recorded from the trigger on [ms] */
+#define CAPTURE_POST_TRIGGER_MS			((uint16_t)300)
+
+/* Number of samples before the trigger */
+#define CAPTURE_PRE_SAMPLES				(CAPTURE_PRE_TRIGGER_MS / ACCEL_SAMPLE_PERIOD_MS)
+
+/* Number of samples of a capture */
+#define CAPTURE_SAMPLES					((CAPTURE_PRE_TRIGGER_MS + CAPTURE_POST_TRIGGER_MS) / ACCEL_SAMPLE_PERIOD_MS)
+
+/* Number of capture slots. One of them is always acquiring,
+ * so at most CAPTURE_SLOTS_NUM - 1 captures are held */
+#define CAPTURE_SLOTS_NUM				4
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Trigger types enum */
+enum {
+	CAPTURE_TRIG_THRESHOLD,		/* magnitude >= level */
+	CAPTURE_TRIG_SLOPE,			/* magnitude change between samples >= level */
+	CAPTURE_TRIG_EXTERNAL,		/* capture_trigger() only, e.g. from a gesture */
+	CAPTURE_TRIG_CHECK
+};
+
+/* Captured sample [mg] */
+typedef struct {
+	int16_t x;
+	int16_t y;
+	int16_t z;
+} capture_sample_t;
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void capture_init(void);
+extern void capture_set_trigger(uint8_t, uint16_t);
+extern void capture_process_sample(int16_t, int16_t, int16_t);
+extern void capture_trigger(void);
+extern bool capture_is_ready(uint8_t);
+extern bool capture_read_sample(uint8_t, uint16_t, capture_sample_t *);
+extern void capture_release(uint8_t);
+
+
+
+
+#endif
+
+/* End of file */
+
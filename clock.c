@@ -0,0 +1,241 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* Dynamic voltage and frequency scaling. The core runs at one of the speeds
+ * of clock_cfg.c: a change of speed switches the system clock source and
+ * the bus prescalers, while the PLL keeps the configuration of the setup.
+ * A speed is either fixed, e.g. by the RTOS state, or chosen by the load:
+ * one step faster when the load exceeds LOAD_UP_PERMILLE, one step slower
+ * when the load expected there stays below LOAD_DOWN_PERMILLE.
+ * At each change the drivers of clock_cfg_notify_array recompute their
+ * prescalers with the interrupts masked, so that the tick period, the
+ * timebase, the PWM frequency and the SPI clock do not change.
+ * To be called from the main loop only: no SPI transfer shall be in progress */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/flash.h>
+
+#include "clock.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Load above which the next faster speed is chosen [per mille] */
+#define LOAD_UP_PERMILLE				((uint32_t)700)
+
+/* Load expected at the next slower speed below which it is chosen [per mille].
+ * Lower than LOAD_UP_PERMILLE: the new speed is kept */
+#define LOAD_DOWN_PERMILLE				((uint32_t)500)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Actual speed */
+static uint8_t actual_speed = CLOCK_CFG_KE_SPEED_168MHZ;
+
+/* Speed is chosen by the load */
+static bool load_governed;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void switch_speed(uint8_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Run the core at the first speed: 168MHz from the PLL on HSE. The PLL is
+ * the one of all speeds */
+void clock_setup(void)
+{
+	const clock_cfg_speed_t *speed_ptr = &clock_cfg_speeds[CLOCK_CFG_KE_SPEED_168MHZ];
+
+	rcc_clock_setup_hse_3v3(&hse_8mhz_3v3[CLOCK_3V3_168MHZ]);
+
+	rcc_ahb_frequency = speed_ptr->ahb_frequency;
+	rcc_apb1_frequency = speed_ptr->apb1_frequency;
+	rcc_apb2_frequency = speed_ptr->apb2_frequency;
+	actual_speed = CLOCK_CFG_KE_SPEED_168MHZ;
+	load_governed = false;
+}
+
+
+/* Set a fixed speed, or CLOCK_SPEED_AUTO to let the load choose it */
+void clock_set_speed(uint8_t speed)
+{
+	if (speed < CLOCK_CFG_KE_SPEED_MAX_NUM) {
+		load_governed = false;
+		switch_speed(speed);
+	} else if (speed == CLOCK_SPEED_AUTO) {
+		load_governed = true;
+	} else {
+		/* invalid parameter */
+	}
+}
+
+
+/* Get the actual speed */
+uint8_t clock_get_speed(void)
+{
+	return actual_speed;
+}
+
+
+/* Choose the speed by the load of the last period [per mille of the time
+ * spent busy], if not fixed. The load is expected to scale with the AHB clock */
+void clock_manage_load(uint16_t load_permille)
+{
+	uint8_t slower_speed = actual_speed + 1;
+
+	if (!load_governed) {
+		/* fixed speed */
+	} else if ((load_permille > LOAD_UP_PERMILLE)
+			&& (actual_speed > CLOCK_CFG_KE_SPEED_168MHZ)) {
+		switch_speed(actual_speed - 1);
+	} else if ((slower_speed < CLOCK_CFG_KE_SPEED_MAX_NUM)
+			&& ((((uint64_t)load_permille * clock_cfg_speeds[actual_speed].ahb_frequency)
+				 / clock_cfg_speeds[slower_speed].ahb_frequency) < LOAD_DOWN_PERMILLE)) {
+		switch_speed(slower_speed);
+	} else {
+		/* keep the actual speed */
+	}
+}
+
+
+/* Get the counter clock of a timer [Hz]: twice the APB clock if the APB is
+ * divided, else the APB clock */
+uint32_t clock_get_timer_frequency(uint32_t timer)
+{
+	const clock_cfg_speed_t *speed_ptr = &clock_cfg_speeds[actual_speed];
+	uint32_t frequency;
+
+	if (timer >= PERIPH_BASE_APB2) {
+		frequency = (speed_ptr->ppre2 == RCC_CFGR_PPRE_DIV_NONE) ?
+					rcc_apb2_frequency : (rcc_apb2_frequency * 2);
+	} else {
+		frequency = (speed_ptr->ppre1 == RCC_CFGR_PPRE_DIV_NONE) ?
+					rcc_apb1_frequency : (rcc_apb1_frequency * 2);
+	}
+
+	return frequency;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Switch to a speed. The oscillators start with the interrupts enabled: the
+ * peripherals keep running at the actual speed meanwhile */
+static void switch_speed(uint8_t speed)
+{
+	const clock_cfg_speed_t *speed_ptr = &clock_cfg_speeds[speed];
+	bool faster = (speed_ptr->ahb_frequency > clock_cfg_speeds[actual_speed].ahb_frequency);
+	bool pll_source = (speed_ptr->sysclk_source == RCC_CFGR_SW_PLL);
+	uint32_t prev_mask;
+	uint8_t notify_index;
+
+	if (speed != actual_speed) {
+		/* the new system clock source shall be ready */
+		if (pll_source) {
+			rcc_osc_on(RCC_HSE);
+			rcc_wait_for_osc_ready(RCC_HSE);
+			rcc_osc_on(RCC_PLL);
+			rcc_wait_for_osc_ready(RCC_PLL);
+		} else {
+			rcc_osc_on(RCC_HSI);
+			rcc_wait_for_osc_ready(RCC_HSI);
+		}
+
+		/* more flash wait states before a faster AHB clock */
+		if (faster) {
+			flash_set_ws(speed_ptr->flash_config);
+		}
+
+		/* no interrupt until the drivers follow the new clocks */
+		prev_mask = cm_mask_interrupts(1);
+
+		/* buses are never clocked above their max: APB prescalers are
+		 * raised before the AHB clock, and lowered after it */
+		if (faster) {
+			rcc_set_ppre1(speed_ptr->ppre1);
+			rcc_set_ppre2(speed_ptr->ppre2);
+			rcc_set_hpre(speed_ptr->hpre);
+			rcc_set_sysclk_source(speed_ptr->sysclk_source);
+		} else {
+			rcc_set_sysclk_source(speed_ptr->sysclk_source);
+			rcc_set_hpre(speed_ptr->hpre);
+			rcc_set_ppre1(speed_ptr->ppre1);
+			rcc_set_ppre2(speed_ptr->ppre2);
+		}
+		rcc_wait_for_sysclk_status(pll_source ? RCC_PLL : RCC_HSI);
+
+		rcc_ahb_frequency = speed_ptr->ahb_frequency;
+		rcc_apb1_frequency = speed_ptr->apb1_frequency;
+		rcc_apb2_frequency = speed_ptr->apb2_frequency;
+		actual_speed = speed;
+
+		for (notify_index = 0; clock_cfg_notify_array[notify_index] != NULL; notify_index++) {
+			(*clock_cfg_notify_array[notify_index])();
+		}
+
+		(void)cm_mask_interrupts(prev_mask);
+
+		/* less flash wait states after a slower AHB clock */
+		if (!faster) {
+			flash_set_ws(speed_ptr->flash_config);
+		}
+
+		/* stop the oscillators not in use */
+		if (pll_source) {
+			rcc_osc_off(RCC_HSI);
+		} else {
+			rcc_osc_off(RCC_PLL);
+			rcc_osc_off(RCC_HSE);
+		}
+	}
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,62 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#ifndef _CLOCK_INCLUDED_           /* switch to read the header file once */
+#define _CLOCK_INCLUDED_           /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+/* This inclusion is for other modules that include this component */
+#include "clock_cfg.h"
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Speed chosen by the load instead of a fixed one */
+#define CLOCK_SPEED_AUTO				CLOCK_CFG_KE_SPEED_MAX_NUM
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void clock_setup(void);
+extern void clock_set_speed(uint8_t);
+extern uint8_t clock_get_speed(void);
+extern void clock_manage_load(uint16_t);
+extern uint32_t clock_get_timer_frequency(uint32_t);
+
+
+
+
+#endif
+
+/* End of file */
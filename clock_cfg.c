@@ -0,0 +1,99 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/flash.h>
+
+#include "clock_cfg.h"
+#include "timebase.h"
+#include "tmr.h"
+#include "pwm.h"
+#include "lis3dsh.h"
+
+
+
+
+/* ------------ Exported Variables ----------------- */
+
+/* Clock speeds: this order shall be the same of speeds enum.
+ * Timer clocks are twice the APB clock if the APB is divided, else equal
+ * to it. The 84MHz speed divides the AHB of the 168MHz one: APB1 timers
+ * (TIM2-5) keep 84MHz and SPI1 keeps its 84MHz APB2 clock.
+ * Flash wait states at 2.7-3.6V: one each 30MHz of AHB clock */
+const clock_cfg_speed_t clock_cfg_speeds[CLOCK_CFG_KE_SPEED_MAX_NUM] = {
+	{ /* 168MHz: PLL on HSE */
+		.sysclk_source = RCC_CFGR_SW_PLL,
+		.hpre = RCC_CFGR_HPRE_DIV_NONE,
+		.ppre1 = RCC_CFGR_PPRE_DIV_4,
+		.ppre2 = RCC_CFGR_PPRE_DIV_2,
+		.flash_config = FLASH_ACR_ICE | FLASH_ACR_DCE | FLASH_ACR_LATENCY_5WS,
+		.ahb_frequency = 168000000,
+		.apb1_frequency = 42000000,
+		.apb2_frequency = 84000000
+	},
+	{ /* 84MHz: PLL on HSE, AHB divided */
+		.sysclk_source = RCC_CFGR_SW_PLL,
+		.hpre = RCC_CFGR_HPRE_DIV_2,
+		.ppre1 = RCC_CFGR_PPRE_DIV_2,
+		.ppre2 = RCC_CFGR_PPRE_DIV_NONE,
+		.flash_config = FLASH_ACR_ICE | FLASH_ACR_DCE | FLASH_ACR_LATENCY_2WS,
+		.ahb_frequency = 84000000,
+		.apb1_frequency = 42000000,
+		.apb2_frequency = 84000000
+	},
+	{ /* 16MHz: HSI, PLL and HSE off */
+		.sysclk_source = RCC_CFGR_SW_HSI,
+		.hpre = RCC_CFGR_HPRE_DIV_NONE,
+		.ppre1 = RCC_CFGR_PPRE_DIV_NONE,
+		.ppre2 = RCC_CFGR_PPRE_DIV_NONE,
+		.flash_config = FLASH_ACR_ICE | FLASH_ACR_DCE | FLASH_ACR_LATENCY_0WS,
+		.ahb_frequency = 16000000,
+		.apb1_frequency = 16000000,
+		.apb2_frequency = 16000000
+	}
+};
+
+
+/* Drivers to notify of a clock change, in this order: they recompute their
+ * prescalers so that their timings do not change. NULL terminated.
+ * An application with BAM outputs (bam_init) adds bam_update_clock here */
+const clock_cfg_notify_t clock_cfg_notify_array[] = {
+	&timebase_update_clock,
+	&timer_update_clock,
+	&pwm_update_clock,
+	&lis3dsh_update_clock,
+	NULL
+};
+
+
+
+
+/* End of file */
@@ -0,0 +1,84 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#ifndef _CLOCK_CFG_INCLUDED_       /* switch to read the header file once */
+#define _CLOCK_CFG_INCLUDED_       /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported constants ------------- */
+
+/* Clock speeds enum: from the fastest to the slowest, this order shall be the
+ * same of clock_cfg_speeds. The first one is the speed at setup */
+enum {
+	CLOCK_CFG_KE_SPEED_168MHZ,
+	CLOCK_CFG_KE_SPEED_84MHZ,
+	CLOCK_CFG_KE_SPEED_16MHZ,
+	CLOCK_CFG_KE_SPEED_MAX_NUM
+};
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Clock tree of a speed. The PLL is always the one set at setup: a speed
+ * changes the system clock source and the bus prescalers only */
+typedef struct {
+	uint32_t sysclk_source;			/* RCC_CFGR_SW_PLL or RCC_CFGR_SW_HSI */
+	uint32_t hpre;					/* AHB prescaler */
+	uint32_t ppre1;					/* APB1 prescaler */
+	uint32_t ppre2;					/* APB2 prescaler */
+	uint32_t flash_config;			/* flash wait states and caches */
+	uint32_t ahb_frequency;			/* resulting bus clocks [Hz] */
+	uint32_t apb1_frequency;
+	uint32_t apb2_frequency;
+} clock_cfg_speed_t;
+
+/* Function to follow a clock change */
+typedef void (*clock_cfg_notify_t)(void);
+
+
+
+
+/* ----------- Exported variables ------------- */
+
+extern const clock_cfg_speed_t clock_cfg_speeds[CLOCK_CFG_KE_SPEED_MAX_NUM];
+extern const clock_cfg_notify_t clock_cfg_notify_array[];
+
+
+
+
+#endif
+
+/* End of file */
@@ -0,0 +1,337 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libopencm3/cm3/cortex.h>
+
+#include "fade.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Fixed point fractional bits of positions */
+#define POS_SHIFT						16
+
+/* Exponential fade: time constant is about this fraction of the duration, as power of 2 */
+#define EXP_TAU_FRACTION_SHIFT			2
+
+
+
+
+/* ----------- Local macros ------------- */
+
+/* Channel mask bit */
+#define CH_MASK(ch)						((uint32_t)1 << (ch))
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Channel fade state. Each tick costs additions and shifts only:
+ * divisions are done once in fade_start() */
+typedef struct {
+	int32_t position;		/* actual level, Q16 */
+	int32_t velocity;		/* level change per tick, Q16 */
+	int32_t acceleration;	/* velocity change per tick, Q16 */
+	uint16_t ticks_left;	/* ticks to the end of the fade */
+	uint16_t half_ticks;	/* ease in-out: ticks left when deceleration starts */
+	uint16_t target;		/* final level */
+	uint16_t output;		/* last output level */
+	uint8_t curve;			/* fade curve */
+	uint8_t exp_shift;		/* exponential fade: approach rate as power of 2 */
+} fade_channel_t;
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Output function pointer */
+static fade_output_t output_function_ptr = NULL;
+
+/* Channels state */
+static fade_channel_t channels[FADE_CHANNELS_NUM];
+
+/* Active channels mask: bit set as last operation of a start, so that
+ * the tick interrupt never sees a partially configured channel. The tick
+ * clears bits at fade end: other contexts update it with interrupts masked */
+static volatile uint32_t active_mask;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static bool step_channel(fade_channel_t *);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init fade engine */
+void fade_init(fade_output_t output_ptr)
+{
+	uint8_t ch_index;
+
+	active_mask = 0;
+	for (ch_index = 0; ch_index < FADE_CHANNELS_NUM; ch_index++) {
+		channels[ch_index].position = 0;
+		channels[ch_index].output = 0;
+	}
+	output_function_ptr = output_ptr;
+}
+
+
+/* Start a fade from actual level to target level in the given number of ticks */
+void fade_start(uint8_t ch_index, uint16_t target, uint16_t ticks, uint8_t curve)
+{
+	fade_channel_t *ch_ptr;
+	int32_t delta;
+	int32_t half;
+	uint32_t tau;
+	uint32_t primask;
+
+	if ((ch_index < FADE_CHANNELS_NUM)
+	&& (target <= FADE_MAX_LEVEL)
+	&& (curve < FADE_KE_CURVE_CHECK)) {
+		ch_ptr = &channels[ch_index];
+
+		/* stop the channel first: the tick skips it while it is configured */
+		primask = cm_mask_interrupts(1);
+		active_mask &= ~CH_MASK(ch_index);
+		(void)cm_mask_interrupts(primask);
+
+		ch_ptr->position = (int32_t)ch_ptr->output << POS_SHIFT;
+		ch_ptr->target = target;
+		ch_ptr->curve = curve;
+		ch_ptr->ticks_left = (ticks > 0) ? ticks : 1;
+		ch_ptr->velocity = 0;
+		ch_ptr->acceleration = 0;
+		ch_ptr->half_ticks = 0;
+		ch_ptr->exp_shift = 0;
+
+		delta = ((int32_t)target << POS_SHIFT) - ch_ptr->position;
+
+		switch (curve) {
+		case FADE_KE_EASE_IN:
+		{
+			/* constant acceleration from 0: delta = acc * n * (n + 1) / 2 */
+			ch_ptr->acceleration = (int32_t)((2 * (int64_t)delta)
+									/ ((int64_t)ch_ptr->ticks_left * (ch_ptr->ticks_left + 1)));
+			break;
+		}
+		case FADE_KE_EASE_OUT:
+		{
+			/* constant deceleration down to 0, same total as ease in */
+			ch_ptr->acceleration = (int32_t)((2 * (int64_t)delta)
+									/ ((int64_t)ch_ptr->ticks_left * (ch_ptr->ticks_left + 1)));
+			ch_ptr->velocity = ch_ptr->acceleration * ch_ptr->ticks_left;
+			break;
+		}
+		case FADE_KE_EASE_IN_OUT:
+		{
+			/* accelerate for half of the ticks and decelerate for the other half:
+			 * delta = acc * h * (h + 1) */
+			half = (ch_ptr->ticks_left >> 1) + (ch_ptr->ticks_left & 1);
+			ch_ptr->acceleration = (int32_t)((int64_t)delta / ((int64_t)half * (half + 1)));
+			ch_ptr->half_ticks = ch_ptr->ticks_left - half;
+			break;
+		}
+		case FADE_KE_EXPONENTIAL:
+		{
+			/* first order approach with a time constant of a fraction of the
+			 * duration: position += (target - position) >> shift */
+			tau = (uint32_t)ch_ptr->ticks_left >> EXP_TAU_FRACTION_SHIFT;
+			while ((tau >>= 1) != 0) {
+				ch_ptr->exp_shift++;
+			}
+			break;
+		}
+		case FADE_KE_LINEAR:
+		default:
+		{
+			ch_ptr->velocity = delta / ch_ptr->ticks_left;
+			break;
+		}
+		}
+
+		/* start fade as last operation */
+		primask = cm_mask_interrupts(1);
+		active_mask |= CH_MASK(ch_index);
+		(void)cm_mask_interrupts(primask);
+	} else {
+		/* invalid parameters */
+	}
+}
+
+
+/* Stop any fade and set a level without calling the output function */
+void fade_set_level(uint8_t ch_index, uint16_t level)
+{
+	uint32_t primask;
+
+	if ((ch_index < FADE_CHANNELS_NUM)
+	&& (level <= FADE_MAX_LEVEL)) {
+		primask = cm_mask_interrupts(1);
+		active_mask &= ~CH_MASK(ch_index);
+		(void)cm_mask_interrupts(primask);
+		channels[ch_index].output = level;
+	}
+}
+
+
+/* Get actual level of a channel */
+uint16_t fade_get_level(uint8_t ch_index)
+{
+	uint16_t level = 0;
+
+	if (ch_index < FADE_CHANNELS_NUM) {
+		level = channels[ch_index].output;
+	}
+
+	return level;
+}
+
+
+/* Check if a fade is running on a channel */
+bool fade_is_active(uint8_t ch_index)
+{
+	return ((ch_index < FADE_CHANNELS_NUM)
+		 && ((active_mask & CH_MASK(ch_index)) != 0));
+}
+
+
+/* Fade tick: advance all active channels by the elapsed ticks. Idle channels
+ * cost nothing, each step of many costs additions only: the output is called
+ * once. Return true if a fade is still running: next tick is due */
+bool fade_tick(uint8_t elapsed_ticks)
+{
+	uint32_t pending_mask = active_mask;
+	uint8_t ch_index;
+	uint8_t step;
+	fade_channel_t *ch_ptr;
+	uint16_t new_level;
+
+	while (pending_mask != 0) {
+		ch_index = (uint8_t)__builtin_ctz(pending_mask);
+		pending_mask &= ~CH_MASK(ch_index);
+		ch_ptr = &channels[ch_index];
+
+		/* advance position and check for fade end */
+		for (step = 0; step < elapsed_ticks; step++) {
+			if (step_channel(ch_ptr)) {
+				active_mask &= ~CH_MASK(ch_index);
+				break;
+			}
+		}
+
+		/* call output only if output level has changed */
+		new_level = (uint16_t)(ch_ptr->position >> POS_SHIFT);
+		if (new_level != ch_ptr->output) {
+			ch_ptr->output = new_level;
+			if (output_function_ptr != NULL) {
+				(*output_function_ptr)(ch_index, new_level);
+			}
+		}
+	}
+
+	return (active_mask != 0);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Advance a channel by one tick. Return true at fade end */
+static bool step_channel(fade_channel_t *ch_ptr)
+{
+	bool fade_end = false;
+
+	switch (ch_ptr->curve) {
+	case FADE_KE_EASE_IN:
+	{
+		ch_ptr->velocity += ch_ptr->acceleration;
+		ch_ptr->position += ch_ptr->velocity;
+		break;
+	}
+	case FADE_KE_EASE_OUT:
+	{
+		ch_ptr->position += ch_ptr->velocity;
+		ch_ptr->velocity -= ch_ptr->acceleration;
+		break;
+	}
+	case FADE_KE_EASE_IN_OUT:
+	{
+		if (ch_ptr->ticks_left > ch_ptr->half_ticks) {
+			ch_ptr->velocity += ch_ptr->acceleration;
+			ch_ptr->position += ch_ptr->velocity;
+		} else {
+			ch_ptr->position += ch_ptr->velocity;
+			ch_ptr->velocity -= ch_ptr->acceleration;
+		}
+		break;
+	}
+	case FADE_KE_EXPONENTIAL:
+	{
+		ch_ptr->position += (((int32_t)ch_ptr->target << POS_SHIFT) - ch_ptr->position)
+							>> ch_ptr->exp_shift;
+		break;
+	}
+	case FADE_KE_LINEAR:
+	default:
+	{
+		ch_ptr->position += ch_ptr->velocity;
+		break;
+	}
+	}
+
+	/* a channel without ticks left ends at once: the count never wraps */
+	if (ch_ptr->ticks_left > 0) {
+		ch_ptr->ticks_left--;
+	}
+	if (0 == ch_ptr->ticks_left) {
+		/* remove rounding errors: end exactly on target */
+		ch_ptr->position = (int32_t)ch_ptr->target << POS_SHIFT;
+		fade_end = true;
+	}
+
+	return fade_end;
+}
+
+
+
+
+/* End of file */
+
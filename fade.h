@@ -0,0 +1,83 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _FADE_INCLUDED_            /* switch to read the header file once */
+#define _FADE_INCLUDED_            /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Number of fade channels: 32 at most. Shall cover all LED channels */
+#define FADE_CHANNELS_NUM				4
+
+/* Maximum level value */
+#define FADE_MAX_LEVEL					((uint16_t)0x7FFF)
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Fade curves enum */
+enum {
+	FADE_KE_LINEAR,
+	FADE_KE_EASE_IN,
+	FADE_KE_EASE_OUT,
+	FADE_KE_EASE_IN_OUT,
+	FADE_KE_EXPONENTIAL,
+	FADE_KE_CURVE_CHECK
+};
+
+/* Pointer to output function: called with channel index and new level */
+typedef void (*fade_output_t)(uint8_t, uint16_t);
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void fade_init(fade_output_t);
+extern void fade_start(uint8_t, uint16_t, uint16_t, uint8_t);
+extern void fade_set_level(uint8_t, uint16_t);
+extern uint16_t fade_get_level(uint8_t);
+extern bool fade_is_active(uint8_t);
+extern bool fade_tick(uint8_t);
+
+
+
+
+#endif
+
+/* End of file */
+
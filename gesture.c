@@ -0,0 +1,323 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gesture.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Convert a time in ms into a number of samples */
+#define MS_TO_SAMPLES(ms)				((uint16_t)((ms) / ACCEL_SAMPLE_PERIOD_MS))
+
+/* Jerk (sum of absolute axis deltas between two samples) to start a tap [mg] */
+#define TAP_JERK_TH_MG					((uint16_t)800)
+
+/* Jerk below which the signal is considered quiet [mg] */
+#define QUIET_JERK_TH_MG				((uint16_t)150)
+
+/* Jerk peak level counted for shake detection [mg] */
+#define SHAKE_JERK_TH_MG				((uint16_t)500)
+
+/* Maximum duration of a tap spike [samples] */
+#define TAP_MAX_DURATION				MS_TO_SAMPLES(30)
+
+/* Quiet time required after a spike to confirm a tap [samples] */
+#define TAP_QUIET_TIME					MS_TO_SAMPLES(50)
+
+/* Window after a confirmed tap in which a second tap makes a double-tap [samples] */
+#define DOUBLE_TAP_LATENCY				MS_TO_SAMPLES(300)
+
+/* Window in which shake peaks are counted [samples] */
+#define SHAKE_WINDOW					MS_TO_SAMPLES(800)
+
+/* Number of jerk peaks inside the window to detect a shake */
+#define SHAKE_MIN_PEAKS					((uint8_t)5)
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Tap detector state enum */
+enum {
+	KE_STATE_IDLE,
+	KE_STATE_SPIKE,
+	KE_STATE_QUIET,
+	KE_STATE_LATENCY,
+	KE_STATE_REJECT
+};
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Event callback function pointer */
+static gesture_cb_t event_callback_ptr = NULL;
+
+/* Previous sample of each axis [mg] */
+static int16_t prev_sample[3];
+
+/* Previous sample is valid */
+static bool prev_sample_valid;
+
+/* Tap detector state */
+static uint8_t tap_state;
+
+/* Samples spent in actual tap detector state */
+static uint16_t tap_state_timer;
+
+/* A first tap is waiting for a possible second one */
+static bool tap_pending;
+
+/* Shake jerk peaks counter */
+static uint8_t shake_peaks_counter;
+
+/* Samples elapsed since first shake peak */
+static uint16_t shake_window_timer;
+
+/* Jerk is above shake threshold */
+static bool shake_jerk_above;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void emit_event(uint8_t);
+static void set_tap_state(uint8_t);
+static void manage_tap(uint16_t);
+static bool manage_shake(uint16_t);
+static inline uint16_t abs_diff(int16_t, int16_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init gesture detector */
+void gesture_init(void)
+{
+	prev_sample_valid = false;
+	tap_pending = false;
+	shake_peaks_counter = 0;
+	shake_window_timer = 0;
+	shake_jerk_above = false;
+	set_tap_state(KE_STATE_IDLE);
+}
+
+
+/* Set the function called at each detected event */
+void gesture_set_callback(gesture_cb_t callback_ptr)
+{
+	event_callback_ptr = callback_ptr;
+}
+
+
+/* Process a new sample [mg]. Constant time and memory */
+void gesture_process_sample(int16_t x_mg, int16_t y_mg, int16_t z_mg)
+{
+	uint32_t jerk;
+
+	if (prev_sample_valid) {
+		/* jerk as L1 norm of the derivative: no multiplications required */
+		jerk = (uint32_t)abs_diff(x_mg, prev_sample[0])
+			 + (uint32_t)abs_diff(y_mg, prev_sample[1])
+			 + (uint32_t)abs_diff(z_mg, prev_sample[2]);
+		if (jerk > UINT16_MAX) {
+			jerk = UINT16_MAX;
+		}
+
+		/* shake has priority: a detected shake discards any pending tap */
+		if (manage_shake((uint16_t)jerk)) {
+			tap_pending = false;
+			set_tap_state(KE_STATE_REJECT);
+		} else {
+			manage_tap((uint16_t)jerk);
+		}
+	} else {
+		/* first sample: only store it */
+		prev_sample_valid = true;
+	}
+
+	prev_sample[0] = x_mg;
+	prev_sample[1] = y_mg;
+	prev_sample[2] = z_mg;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Call event callback if valid */
+static void emit_event(uint8_t event)
+{
+	if (event_callback_ptr != NULL) {
+		(*event_callback_ptr)(event);
+	} else {
+		/* no callback: discard event */
+	}
+}
+
+
+/* Enter a new tap detector state */
+static void set_tap_state(uint8_t new_state)
+{
+	tap_state = new_state;
+	tap_state_timer = 0;
+}
+
+
+/* Tap and double-tap state machine */
+static void manage_tap(uint16_t jerk)
+{
+	tap_state_timer++;
+
+	switch (tap_state) {
+	case KE_STATE_IDLE:
+	{
+		if (jerk >= TAP_JERK_TH_MG) {
+			set_tap_state(KE_STATE_SPIKE);
+		}
+		break;
+	}
+	case KE_STATE_SPIKE:
+	{
+		if (jerk < QUIET_JERK_TH_MG) {
+			/* spike is over: wait for quiet time */
+			set_tap_state(KE_STATE_QUIET);
+		} else if (tap_state_timer > TAP_MAX_DURATION) {
+			/* too long for a tap */
+			set_tap_state(KE_STATE_REJECT);
+		}
+		break;
+	}
+	case KE_STATE_QUIET:
+	{
+		if (jerk >= QUIET_JERK_TH_MG) {
+			/* ringing or movement: not a clean tap */
+			set_tap_state(KE_STATE_REJECT);
+		} else if (tap_state_timer >= TAP_QUIET_TIME) {
+			if (tap_pending) {
+				/* second tap inside latency window */
+				tap_pending = false;
+				emit_event(GESTURE_EV_DOUBLE_TAP);
+				set_tap_state(KE_STATE_IDLE);
+			} else {
+				/* first tap: wait for a possible second one */
+				tap_pending = true;
+				set_tap_state(KE_STATE_LATENCY);
+			}
+		}
+		break;
+	}
+	case KE_STATE_LATENCY:
+	{
+		if (jerk >= TAP_JERK_TH_MG) {
+			set_tap_state(KE_STATE_SPIKE);
+		} else if (tap_state_timer >= DOUBLE_TAP_LATENCY) {
+			/* no second tap: it was a single tap */
+			tap_pending = false;
+			emit_event(GESTURE_EV_TAP);
+			set_tap_state(KE_STATE_IDLE);
+		}
+		break;
+	}
+	case KE_STATE_REJECT:
+	default:
+	{
+		/* a pending first tap is still valid */
+		if (tap_pending) {
+			tap_pending = false;
+			emit_event(GESTURE_EV_TAP);
+		}
+		/* wait for quiet signal before arming again */
+		if (jerk >= QUIET_JERK_TH_MG) {
+			tap_state_timer = 0;
+		} else if (tap_state_timer >= TAP_QUIET_TIME) {
+			set_tap_state(KE_STATE_IDLE);
+		}
+		break;
+	}
+	}
+}
+
+
+/* Count jerk peaks inside the shake window. Return true if a shake is detected */
+static bool manage_shake(uint16_t jerk)
+{
+	bool shake_detected = false;
+
+	/* count rising edges only */
+	if (jerk >= SHAKE_JERK_TH_MG) {
+		if (!shake_jerk_above) {
+			shake_jerk_above = true;
+			if (shake_peaks_counter == 0) {
+				shake_window_timer = 0;
+			}
+			shake_peaks_counter++;
+		}
+	} else {
+		shake_jerk_above = false;
+	}
+
+	if (shake_peaks_counter > 0) {
+		shake_window_timer++;
+		if (shake_peaks_counter >= SHAKE_MIN_PEAKS) {
+			shake_detected = true;
+			shake_peaks_counter = 0;
+			emit_event(GESTURE_EV_SHAKE);
+		} else if (shake_window_timer >= SHAKE_WINDOW) {
+			/* window elapsed: restart counting */
+			shake_peaks_counter = 0;
+		}
+	}
+
+	return shake_detected;
+}
+
+
+/* Absolute difference between two values */
+static inline uint16_t abs_diff(int16_t a, int16_t b)
+{
+	int32_t diff = (int32_t)a - (int32_t)b;
+
+	return (uint16_t)((diff < 0) ? -diff : diff);
+}
+
+
+
+
+/* End of file */
+
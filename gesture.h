@@ -0,0 +1,68 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _GESTURE_INCLUDED_         /* switch to read the header file once */
+#define _GESTURE_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+/* This inclusion is for other modules that include this component: sample period */
+#include "accel.h"
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Gesture events enum */
+enum {
+	GESTURE_EV_TAP,
+	GESTURE_EV_DOUBLE_TAP,
+	GESTURE_EV_SHAKE,
+	GESTURE_EV_CHECK
+};
+
+/* Pointer to gesture event callback function */
+typedef void (*gesture_cb_t)(uint8_t);
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void gesture_init(void);
+extern void gesture_set_callback(gesture_cb_t);
+extern void gesture_process_sample(int16_t, int16_t, int16_t);
+
+
+
+
+#endif
+
+/* End of file */
+
@@ -0,0 +1,197 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* Log-linear histogram (HDR style) for on-device percentile statistics.
+ * Values up to 2 * HISTOGRAM_SUB_BINS_NUM have a bin each. Above, every
+ * power of 2 is split into HISTOGRAM_SUB_BINS_NUM bins of equal width, so
+ * the bin width is always below 1 / HISTOGRAM_SUB_BINS_NUM of its values.
+ * Recording is O(1) without loops: the bin index comes from the position of
+ * the most significant bit (one CLZ instruction on Cortex-M4).
+ * Histograms of the same kind can be merged, and a snapshot is a plain copy:
+ * a reader preempted by the recording interrupt may see the last sample
+ * partially counted */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "histogram.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Per mille of all samples */
+#define PERMILLE_ALL					((uint32_t)1000)
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static inline uint32_t get_bin(uint32_t);
+static inline uint32_t get_bin_upper_value(uint32_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Clear a histogram */
+void histogram_reset(histogram_t *histogram_ptr)
+{
+	memset(histogram_ptr, 0, sizeof(*histogram_ptr));
+	histogram_ptr->min = UINT32_MAX;
+}
+
+
+/* Record a value. Suitable for interrupt service routines */
+void histogram_record(histogram_t *histogram_ptr, uint32_t value)
+{
+	histogram_ptr->bins[get_bin(value)]++;
+	histogram_ptr->samples++;
+	histogram_ptr->sum += value;
+	histogram_ptr->min = (value < histogram_ptr->min) ? value : histogram_ptr->min;
+	histogram_ptr->max = (value > histogram_ptr->max) ? value : histogram_ptr->max;
+}
+
+
+/* Add the samples of a histogram to another one */
+void histogram_merge(histogram_t *dest_ptr, const histogram_t *src_ptr)
+{
+	uint32_t bin;
+
+	for (bin = 0; bin < HISTOGRAM_BINS_NUM; bin++) {
+		dest_ptr->bins[bin] += src_ptr->bins[bin];
+	}
+	dest_ptr->samples += src_ptr->samples;
+	dest_ptr->sum += src_ptr->sum;
+	dest_ptr->min = (src_ptr->min < dest_ptr->min) ? src_ptr->min : dest_ptr->min;
+	dest_ptr->max = (src_ptr->max > dest_ptr->max) ? src_ptr->max : dest_ptr->max;
+}
+
+
+/* Get the number of recorded values */
+uint32_t histogram_get_samples(const histogram_t *histogram_ptr)
+{
+	return histogram_ptr->samples;
+}
+
+
+/* Get the exact min. 0 if empty */
+uint32_t histogram_get_min(const histogram_t *histogram_ptr)
+{
+	return (histogram_ptr->samples > 0) ? histogram_ptr->min : 0;
+}
+
+
+/* Get the exact max. 0 if empty */
+uint32_t histogram_get_max(const histogram_t *histogram_ptr)
+{
+	return histogram_ptr->max;
+}
+
+
+/* Get the exact mean, rounded down. 0 if empty */
+uint32_t histogram_get_mean(const histogram_t *histogram_ptr)
+{
+	return (histogram_ptr->samples > 0) ? (uint32_t)(histogram_ptr->sum / histogram_ptr->samples) : 0;
+}
+
+
+/* Get a percentile [per mille] with the nearest rank method. The result is
+ * the upper value of the bin holding the exact percentile, never above the
+ * max: it is never below the exact percentile and less than
+ * 1 / HISTOGRAM_SUB_BINS_NUM above it. 0 if empty */
+uint32_t histogram_get_percentile(const histogram_t *histogram_ptr, uint32_t permille)
+{
+	uint32_t rank;
+	uint32_t cumulative = 0;
+	uint32_t bin = 0;
+	uint32_t value;
+
+	if (histogram_ptr->samples == 0) {
+		return 0;
+	}
+
+	/* nearest rank, at least 1 */
+	rank = (uint32_t)((((uint64_t)histogram_ptr->samples * permille) + PERMILLE_ALL - 1) / PERMILLE_ALL);
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	/* the last bin ends the search also if a sample is partially counted */
+	while ((bin < (HISTOGRAM_BINS_NUM - 1)) && ((cumulative + histogram_ptr->bins[bin]) < rank)) {
+		cumulative += histogram_ptr->bins[bin];
+		bin++;
+	}
+
+	value = get_bin_upper_value(bin);
+
+	return (value < histogram_ptr->max) ? value : histogram_ptr->max;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Get the bin of a value. The OR gives the first 2 * HISTOGRAM_SUB_BINS_NUM
+ * values the exponent 0: no branch for the linear part */
+static inline uint32_t get_bin(uint32_t value)
+{
+	uint32_t exponent = (uint32_t)(31 - __builtin_clz(value | HISTOGRAM_SUB_BINS_NUM)) - HISTOGRAM_SUB_BITS;
+
+	return (exponent << HISTOGRAM_SUB_BITS) + (value >> exponent);
+}
+
+
+/* Get the greatest value of a bin */
+static inline uint32_t get_bin_upper_value(uint32_t bin)
+{
+	uint32_t exponent;
+	uint32_t mantissa;
+
+	if (bin < (2 * HISTOGRAM_SUB_BINS_NUM)) {
+		return bin;
+	}
+
+	exponent = (bin >> HISTOGRAM_SUB_BITS) - 1;
+	mantissa = bin - (exponent << HISTOGRAM_SUB_BITS);
+
+	/* on 64 bit: the last bin ends at UINT32_MAX */
+	return (uint32_t)(((uint64_t)(mantissa + 1) << exponent) - 1);
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,86 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#ifndef _HISTOGRAM_INCLUDED_       /* switch to read the header file once */
+#define _HISTOGRAM_INCLUDED_       /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Bins per power of 2 as power of 2. A value of the bin is at most
+ * 1 / 2^HISTOGRAM_SUB_BITS (6.25 %) away from any other value of the same bin */
+#define HISTOGRAM_SUB_BITS				4
+
+/* Bins per power of 2 */
+#define HISTOGRAM_SUB_BINS_NUM			((uint32_t)1 << HISTOGRAM_SUB_BITS)
+
+/* Number of bins covering the whole uint32 range: 2 * HISTOGRAM_SUB_BINS_NUM
+ * exact values, then HISTOGRAM_SUB_BINS_NUM bins for each next power of 2 */
+#define HISTOGRAM_BINS_NUM				((32 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BINS_NUM)
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Log-linear histogram of uint32 values. Memory does not depend on the
+ * number of samples. Clear it with histogram_reset() before use */
+typedef struct {
+	uint32_t bins[HISTOGRAM_BINS_NUM];
+	uint32_t samples;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+} histogram_t;
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void histogram_reset(histogram_t *);
+extern void histogram_record(histogram_t *, uint32_t);
+extern void histogram_merge(histogram_t *, const histogram_t *);
+extern uint32_t histogram_get_samples(const histogram_t *);
+extern uint32_t histogram_get_min(const histogram_t *);
+extern uint32_t histogram_get_max(const histogram_t *);
+extern uint32_t histogram_get_mean(const histogram_t *);
+extern uint32_t histogram_get_percentile(const histogram_t *, uint32_t);
+
+
+
+
+#endif
+
+/* End of file */
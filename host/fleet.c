@@ -0,0 +1,402 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Fleet simulation harness. The parent process keeps up to a number of
+ * workers busy: as soon as a board completes, the next one is started in a
+ * new process on a fresh firmware state. Results are written to a shared
+ * memory table and aggregated once all boards completed */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/f4/nvic.h>
+
+#include "activity.h"
+#include "pedo.h"
+#include "rtos.h"
+#include "sim.h"
+#include "fleet.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Number of LED channels on TIM4 */
+#define LED_CHANNELS_NUM				4
+
+/* Exit status of a board that cannot load its recording */
+#define EXIT_MOTION_ERROR				2
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Result of a board */
+typedef struct {
+	bool done;							/* run completed */
+	int32_t drift_ppm;					/* crystal drift */
+	uint32_t motion;					/* recording index */
+	double host_s;						/* CPU time of the run */
+	double virtual_s;					/* virtual time of the run */
+	uint64_t tick_irqs;					/* TIM2 interrupts */
+	uint64_t overruns;					/* callback expiries while pending, all callbacks */
+	double lateness_max_us;				/* worst callback lateness */
+	double tick_drift_ppm;				/* mean period drift of the most frequent callback */
+	uint32_t steps;						/* pedometer steps */
+	uint8_t activity;					/* last classified activity */
+	uint8_t leds;						/* LEDs on at the end, one bit per channel */
+	uint64_t trace_hash;				/* hash of the callbacks trace */
+} board_result_t;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void run_board(const fleet_cfg_t *, uint32_t, board_result_t *);
+static int32_t get_board_drift(const fleet_cfg_t *, uint32_t);
+static double get_time_s(clockid_t);
+static void print_board(uint32_t, const board_result_t *);
+static void print_summary(const fleet_cfg_t *, const board_result_t *, double);
+static double get_percentile(double *, uint32_t, uint32_t);
+static int compare_double(const void *, const void *);
+static int compare_uint64(const void *, const void *);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Run the fleet and print the summary. False if a board failed */
+bool fleet_run(const fleet_cfg_t *cfg_ptr)
+{
+	board_result_t *results;
+	size_t results_size = (size_t)cfg_ptr->boards * sizeof(board_result_t);
+	uint32_t next_board = 0;
+	uint32_t running = 0;
+	uint32_t failed = 0;
+	uint32_t board;
+	double wall_start_s;
+	pid_t pid;
+	int status;
+
+	/* shared with the board processes, zeroed: no board done */
+	results = mmap(NULL, results_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (results == MAP_FAILED) {
+		perror("fleet: mmap");
+		return false;
+	}
+
+	/* children inherit the stdio buffers */
+	fflush(stdout);
+	fflush(stderr);
+
+	wall_start_s = get_time_s(CLOCK_MONOTONIC);
+	while ((next_board < cfg_ptr->boards) || (running > 0)) {
+		/* keep all workers busy */
+		while ((running < cfg_ptr->workers) && (next_board < cfg_ptr->boards)) {
+			pid = fork();
+			if (pid == 0) {
+				run_board(cfg_ptr, next_board, &results[next_board]);
+			} else if (pid < 0) {
+				perror("fleet: fork");
+				break;
+			}
+			running++;
+			next_board++;
+		}
+		if (running == 0) {
+			/* fork failed with no board left to wait for */
+			break;
+		}
+
+		pid = wait(&status);
+		if (pid > 0) {
+			running--;
+			if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS)) {
+				failed++;
+			}
+		}
+	}
+
+	for (board = 0; (board < cfg_ptr->boards) && cfg_ptr->verbose; board++) {
+		print_board(board, &results[board]);
+	}
+	print_summary(cfg_ptr, results, get_time_s(CLOCK_MONOTONIC) - wall_start_s);
+
+	munmap(results, results_size);
+
+	return (failed == 0) && (next_board == cfg_ptr->boards);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Board process: run the firmware and store its result. Never returns */
+static void run_board(const fleet_cfg_t *cfg_ptr, uint32_t board, board_result_t *result_ptr)
+{
+	const sim_trace_cb_t *trace_ptr;
+	const sim_trace_cb_t *most_runs_ptr = NULL;
+	board_result_t result = {0};
+	double host_start_s;
+	uint8_t callback_id;
+	uint8_t channel;
+
+	result.drift_ppm = get_board_drift(cfg_ptr, board);
+	result.motion = (cfg_ptr->motions_num > 0) ? (board % cfg_ptr->motions_num) : 0;
+
+	sim_init();
+	sim_set_clock_drift(result.drift_ppm);
+	if (cfg_ptr->motions_num > 0) {
+		if (!sim_motion_load(cfg_ptr->motion_paths[result.motion])) {
+			fprintf(stderr, "fleet: cannot load %s\n", cfg_ptr->motion_paths[result.motion]);
+			_exit(EXIT_MOTION_ERROR);
+		}
+		sim_lis3dsh_set_motion(&sim_motion_play);
+	}
+
+	host_start_s = get_time_s(CLOCK_PROCESS_CPUTIME_ID);
+	sim_run(cfg_ptr->run_ps, cfg_ptr->fast_forward);
+	result.host_s = get_time_s(CLOCK_PROCESS_CPUTIME_ID) - host_start_s;
+	result.virtual_s = (double)sim_get_time_ps() / SIM_PS_PER_S;
+	result.tick_irqs = sim_get_stats()->irq_calls[NVIC_TIM2_IRQ];
+
+	for (callback_id = 0; callback_id < RTOS_CB_ID_MAX_NUM; callback_id++) {
+		trace_ptr = sim_trace_get_callback(callback_id);
+		if (trace_ptr->runs > 0) {
+			result.overruns += trace_ptr->overruns;
+			if (((double)trace_ptr->lateness_max_ps / SIM_PS_PER_US) > result.lateness_max_us) {
+				result.lateness_max_us = (double)trace_ptr->lateness_max_ps / SIM_PS_PER_US;
+			}
+			if ((most_runs_ptr == NULL) || (trace_ptr->runs > most_runs_ptr->runs)) {
+				most_runs_ptr = trace_ptr;
+			}
+		}
+	}
+	if ((most_runs_ptr != NULL) && (most_runs_ptr->runs > 1) && (most_runs_ptr->period_ps > 0)) {
+		result.tick_drift_ppm = (((double)(most_runs_ptr->last_run_ps - most_runs_ptr->first_run_ps)
+								  / ((double)(most_runs_ptr->runs - 1) * (double)most_runs_ptr->period_ps))
+								 - 1.0) * 1e6;
+	}
+
+	result.steps = pedo_get_steps();
+	result.activity = activity_get_class();
+	for (channel = 0; channel < LED_CHANNELS_NUM; channel++) {
+		if (MMIO32(TIM4 + 0x34 + (channel * sizeof(uint32_t))) != 0) {
+			result.leds |= (uint8_t)(1 << channel);
+		}
+	}
+	result.trace_hash = sim_trace_get_hash();
+	result.done = true;
+
+	*result_ptr = result;
+	_exit(EXIT_SUCCESS);
+}
+
+
+/* Crystal drift of a board: uniform in +/- max_drift_ppm, reproducible from the seed */
+static int32_t get_board_drift(const fleet_cfg_t *cfg_ptr, uint32_t board)
+{
+	/* splitmix64 of the seed and the board index */
+	uint64_t value = cfg_ptr->seed + (((uint64_t)board + 1) * 0x9E3779B97F4A7C15ULL);
+
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+	value ^= value >> 31;
+
+	return (int32_t)(value % (((uint64_t)cfg_ptr->max_drift_ppm * 2) + 1)) - cfg_ptr->max_drift_ppm;
+}
+
+
+/* Get the time of a clock [s] */
+static double get_time_s(clockid_t clock_id)
+{
+	struct timespec now;
+
+	clock_gettime(clock_id, &now);
+
+	return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+
+/* Print the result of a board on one line */
+static void print_board(uint32_t board, const board_result_t *result_ptr)
+{
+	printf("board=%u done=%d drift_ppm=%d motion=%u host_s=%.3f tick_irqs=%llu overruns=%llu"
+		   " lateness_max_us=%.3f tick_drift_ppm=%.1f steps=%u activity=%u leds=0x%x trace_hash=%016llx\n",
+		   board, result_ptr->done, result_ptr->drift_ppm, result_ptr->motion, result_ptr->host_s,
+		   (unsigned long long)result_ptr->tick_irqs, (unsigned long long)result_ptr->overruns,
+		   result_ptr->lateness_max_us, result_ptr->tick_drift_ppm, result_ptr->steps,
+		   result_ptr->activity, result_ptr->leds, (unsigned long long)result_ptr->trace_hash);
+}
+
+
+/* Print throughput and behaviour of the whole fleet */
+static void print_summary(const fleet_cfg_t *cfg_ptr, const board_result_t *results, double wall_s)
+{
+	double *host_s = calloc(cfg_ptr->boards, sizeof(double));
+	double *lateness_us = calloc(cfg_ptr->boards, sizeof(double));
+	double *tick_drift_ppm = calloc(cfg_ptr->boards, sizeof(double));
+	uint64_t *hashes = calloc(cfg_ptr->boards, sizeof(uint64_t));
+	uint32_t activities[ACTIVITY_CFG_KE_CLASS_MAX_NUM] = {0};
+	uint32_t done = 0;
+	uint32_t board;
+	uint32_t distinct_hashes = 0;
+	uint32_t steps_min = UINT32_MAX;
+	uint32_t steps_max = 0;
+	uint64_t steps_sum = 0;
+	uint64_t overruns = 0;
+	double cpu_s = 0.0;
+	double virtual_s = 0.0;
+	uint8_t activity;
+
+	if ((host_s == NULL) || (lateness_us == NULL) || (tick_drift_ppm == NULL) || (hashes == NULL)) {
+		fprintf(stderr, "fleet: out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (board = 0; board < cfg_ptr->boards; board++) {
+		if (!results[board].done) {
+			continue;
+		}
+		host_s[done] = results[board].host_s;
+		lateness_us[done] = results[board].lateness_max_us;
+		tick_drift_ppm[done] = results[board].tick_drift_ppm;
+		hashes[done] = results[board].trace_hash;
+		cpu_s += results[board].host_s;
+		virtual_s += results[board].virtual_s;
+		overruns += results[board].overruns;
+		steps_sum += results[board].steps;
+		if (results[board].steps < steps_min) {
+			steps_min = results[board].steps;
+		}
+		if (results[board].steps > steps_max) {
+			steps_max = results[board].steps;
+		}
+		if (results[board].activity < ACTIVITY_CFG_KE_CLASS_MAX_NUM) {
+			activities[results[board].activity]++;
+		}
+		done++;
+	}
+
+	/* boards with the same inputs shall give the same trace */
+	qsort(hashes, done, sizeof(uint64_t), &compare_uint64);
+	for (board = 0; board < done; board++) {
+		if ((board == 0) || (hashes[board] != hashes[board - 1])) {
+			distinct_hashes++;
+		}
+	}
+
+	/* throughput */
+	printf("fleet_boards=%u\n", cfg_ptr->boards);
+	printf("fleet_failed=%u\n", cfg_ptr->boards - done);
+	printf("fleet_workers=%u\n", cfg_ptr->workers);
+	printf("fleet_wall_s=%.3f\n", wall_s);
+	printf("fleet_cpu_s=%.3f\n", cpu_s);
+	printf("fleet_virtual_s=%.3f\n", virtual_s);
+	printf("fleet_boards_per_s=%.2f\n", (wall_s > 0.0) ? (done / wall_s) : 0.0);
+	printf("fleet_speedup=%.1f\n", (wall_s > 0.0) ? (virtual_s / wall_s) : 0.0);
+	printf("fleet_parallel_efficiency=%.3f\n",
+		   (wall_s > 0.0) ? (cpu_s / (wall_s * cfg_ptr->workers)) : 0.0);
+	printf("board_host_s_p50=%.3f\n", get_percentile(host_s, done, 50));
+	printf("board_host_s_p99=%.3f\n", get_percentile(host_s, done, 99));
+	printf("board_host_s_max=%.3f\n", get_percentile(host_s, done, 100));
+
+	/* behaviour */
+	printf("steps_min=%u\n", (done > 0) ? steps_min : 0);
+	printf("steps_mean=%.1f\n", (done > 0) ? ((double)steps_sum / done) : 0.0);
+	printf("steps_max=%u\n", steps_max);
+	printf("activity_boards=");
+	for (activity = 0; activity < ACTIVITY_CFG_KE_CLASS_MAX_NUM; activity++) {
+		printf("%s%u", (activity > 0) ? "," : "", activities[activity]);
+	}
+	printf("\n");
+	printf("overruns=%llu\n", (unsigned long long)overruns);
+	printf("lateness_max_us_p50=%.3f\n", get_percentile(lateness_us, done, 50));
+	printf("lateness_max_us_max=%.3f\n", get_percentile(lateness_us, done, 100));
+	printf("tick_drift_ppm_min=%.1f\n", get_percentile(tick_drift_ppm, done, 0));
+	printf("tick_drift_ppm_max=%.1f\n", get_percentile(tick_drift_ppm, done, 100));
+	printf("distinct_traces=%u\n", distinct_hashes);
+
+	free(host_s);
+	free(lateness_us);
+	free(tick_drift_ppm);
+	free(hashes);
+}
+
+
+/* Nearest rank percentile of a set of values. The values are sorted */
+static double get_percentile(double *values, uint32_t values_num, uint32_t percentile)
+{
+	uint32_t rank;
+
+	if (values_num == 0) {
+		return 0.0;
+	}
+
+	qsort(values, values_num, sizeof(double), &compare_double);
+	rank = (uint32_t)(((uint64_t)percentile * values_num + 99) / 100);
+
+	return values[(rank > 0) ? (rank - 1) : 0];
+}
+
+
+/* qsort comparison of two doubles */
+static int compare_double(const void *a_ptr, const void *b_ptr)
+{
+	double a = *(const double *)a_ptr;
+	double b = *(const double *)b_ptr;
+
+	return (a > b) - (a < b);
+}
+
+
+/* qsort comparison of two 64-bit values */
+static int compare_uint64(const void *a_ptr, const void *b_ptr)
+{
+	uint64_t a = *(const uint64_t *)a_ptr;
+	uint64_t b = *(const uint64_t *)b_ptr;
+
+	return (a > b) - (a < b);
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,73 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Fleet simulation: many boards, each with its own motion recording and
+ * crystal drift, run in parallel on the host cores.
+ * Each board runs in its own process, so the whole firmware state (module
+ * variables, simulated registers and flash) is private to the board with no
+ * change to the firmware sources */
+
+#ifndef _FLEET_INCLUDED_           /* switch to read the header file once */
+#define _FLEET_INCLUDED_           /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Fleet run configuration */
+typedef struct {
+	uint32_t boards;					/* number of simulated boards */
+	uint32_t workers;					/* boards run at the same time */
+	uint64_t run_ps;					/* virtual run time of each board */
+	bool fast_forward;					/* idle main loop jumps to the next event */
+	int32_t max_drift_ppm;				/* crystal drift spread: +/- this value */
+	uint64_t seed;						/* seed of the drift of each board */
+	char *const *motion_paths;			/* recordings assigned in turn. NULL: default motion */
+	uint32_t motions_num;
+	bool verbose;						/* print the result of each board */
+} fleet_cfg_t;
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern bool fleet_run(const fleet_cfg_t *);
+
+
+
+
+#endif
+
+/* End of file */
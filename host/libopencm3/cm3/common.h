@@ -0,0 +1,68 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host shim of the libopencm3 common definitions. Peripheral registers are
+ * words of a simulated memory map, addressed by their real bus address */
+
+#ifndef _SIM_CM3_COMMON_INCLUDED_  /* switch to read the header file once */
+#define _SIM_CM3_COMMON_INCLUDED_  /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Register access: the simulated bus maps the address to its backing word */
+#define MMIO32(addr)				(*sim_bus_reg((uint32_t)(addr)))
+
+/* Peripheral memory map */
+#define PERIPH_BASE					((uint32_t)0x40000000)
+#define PERIPH_BASE_APB1			(PERIPH_BASE + 0x00000)
+#define PERIPH_BASE_APB2			(PERIPH_BASE + 0x10000)
+#define PERIPH_BASE_AHB1			(PERIPH_BASE + 0x20000)
+
+/* Size of the simulated peripheral memory map [bytes] */
+#define SIM_BUS_SIZE_BYTES			((uint32_t)0x28000)
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern volatile uint32_t *sim_bus_reg(uint32_t);
+
+
+
+
+#endif
+
+/* End of file */
@@ -0,0 +1,53 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Host shim of the libopencm3 Cortex-M core functions: the interrupt mask
+ * (PRIMASK) holds the firmware interrupts of the simulation */
+
+#ifndef _SIM_CM3_CORTEX_INCLUDED_  /* switch to read the header file once */
+#define _SIM_CM3_CORTEX_INCLUDED_  /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <libopencm3/cm3/common.h>
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void cm_enable_interrupts(void);
+extern void cm_disable_interrupts(void);
+extern uint32_t cm_mask_interrupts(uint32_t);
+
+
+
+
+#endif
+
+/* End of file */
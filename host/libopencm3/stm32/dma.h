@@ -0,0 +1,126 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host shim of the libopencm3 DMA API: only the subset used by the firmware */
+
+#ifndef _SIM_DMA_INCLUDED_         /* switch to read the header file once */
+#define _SIM_DMA_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <libopencm3/cm3/common.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Controllers */
+#define DMA1						(PERIPH_BASE_AHB1 + 0x6000)
+#define DMA2						(PERIPH_BASE_AHB1 + 0x6400)
+
+/* Streams */
+#define DMA_STREAM0					0
+#define DMA_STREAM1					1
+#define DMA_STREAM2					2
+#define DMA_STREAM3					3
+#define DMA_STREAM4					4
+#define DMA_STREAM5					5
+#define DMA_STREAM6					6
+#define DMA_STREAM7					7
+
+/* Registers */
+#define DMA_LISR(dma)				MMIO32((dma) + 0x00)
+#define DMA_HISR(dma)				MMIO32((dma) + 0x04)
+#define DMA_LIFCR(dma)				MMIO32((dma) + 0x08)
+#define DMA_HIFCR(dma)				MMIO32((dma) + 0x0C)
+#define DMA_STREAM(dma, s)			((dma) + 0x10 + (0x18 * (s)))
+#define DMA_SCR(dma, s)				MMIO32(DMA_STREAM(dma, s) + 0x00)
+#define DMA_SNDTR(dma, s)			MMIO32(DMA_STREAM(dma, s) + 0x04)
+#define DMA_SPAR(dma, s)			MMIO32(DMA_STREAM(dma, s) + 0x08)
+#define DMA_SM0AR(dma, s)			MMIO32(DMA_STREAM(dma, s) + 0x0C)
+
+/* SxCR */
+#define DMA_SxCR_EN					(1 << 0)
+#define DMA_SxCR_DIR_MEM_TO_PERIPHERAL	(1 << 6)
+#define DMA_SxCR_CIRC				(1 << 8)
+#define DMA_SxCR_PINC				(1 << 9)
+#define DMA_SxCR_MINC				(1 << 10)
+#define DMA_SxCR_PSIZE_32BIT		(2 << 11)
+#define DMA_SxCR_MSIZE_32BIT		(2 << 13)
+#define DMA_SxCR_PL_LOW				(0 << 16)
+#define DMA_SxCR_PL_MEDIUM			(1 << 16)
+#define DMA_SxCR_PL_HIGH			(2 << 16)
+#define DMA_SxCR_PL_VERY_HIGH		(3 << 16)
+#define DMA_SxCR_PL_MASK			(3 << 16)
+#define DMA_SxCR_CHSEL_SHIFT		25
+#define DMA_SxCR_CHSEL_MASK			(7 << DMA_SxCR_CHSEL_SHIFT)
+#define DMA_SxCR_CHSEL_0			(0 << DMA_SxCR_CHSEL_SHIFT)
+#define DMA_SxCR_CHSEL_1			(1 << DMA_SxCR_CHSEL_SHIFT)
+#define DMA_SxCR_CHSEL_2			(2 << DMA_SxCR_CHSEL_SHIFT)
+#define DMA_SxCR_CHSEL_3			(3 << DMA_SxCR_CHSEL_SHIFT)
+#define DMA_SxCR_CHSEL_4			(4 << DMA_SxCR_CHSEL_SHIFT)
+#define DMA_SxCR_CHSEL_5			(5 << DMA_SxCR_CHSEL_SHIFT)
+#define DMA_SxCR_CHSEL_6			(6 << DMA_SxCR_CHSEL_SHIFT)
+#define DMA_SxCR_CHSEL_7			(7 << DMA_SxCR_CHSEL_SHIFT)
+
+/* Stream interrupt flags, before the per stream shift */
+#define DMA_FEIF					(1 << 0)
+#define DMA_DMEIF					(1 << 2)
+#define DMA_TEIF					(1 << 3)
+#define DMA_HTIF					(1 << 4)
+#define DMA_TCIF					(1 << 5)
+#define DMA_ISR_MASK(s)				(0x3D << DMA_ISR_OFFSET(s))
+#define DMA_ISR_OFFSET(s)			(((s) & 1) * 6 + (((s) >> 1) & 1) * 16)
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void dma_stream_reset(uint32_t, uint8_t);
+extern void dma_channel_select(uint32_t, uint8_t, uint32_t);
+extern void dma_set_priority(uint32_t, uint8_t, uint32_t);
+extern void dma_set_transfer_mode(uint32_t, uint8_t, uint32_t);
+extern void dma_set_memory_size(uint32_t, uint8_t, uint32_t);
+extern void dma_set_peripheral_size(uint32_t, uint8_t, uint32_t);
+extern void dma_enable_memory_increment_mode(uint32_t, uint8_t);
+extern void dma_enable_circular_mode(uint32_t, uint8_t);
+extern void dma_set_peripheral_address(uint32_t, uint8_t, uint32_t);
+extern void dma_set_memory_address(uint32_t, uint8_t, uint32_t);
+extern void dma_set_number_of_data(uint32_t, uint8_t, uint16_t);
+extern void dma_enable_stream(uint32_t, uint8_t);
+extern void dma_disable_stream(uint32_t, uint8_t);
+extern void dma_clear_interrupt_flags(uint32_t, uint8_t, uint32_t);
+extern bool dma_get_interrupt_flag(uint32_t, uint8_t, uint32_t);
+
+
+
+
+#endif
+
+/* End of file */
@@ -0,0 +1,74 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host shim of the libopencm3 STM32F4 NVIC definitions: interrupt numbers
+ * and service routines used by the firmware */
+
+#ifndef _SIM_NVIC_INCLUDED_        /* switch to read the header file once */
+#define _SIM_NVIC_INCLUDED_        /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <libopencm3/cm3/common.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+#define NVIC_TIM1_UP_TIM10_IRQ		25
+#define NVIC_TIM1_CC_IRQ			27
+#define NVIC_TIM2_IRQ				28
+#define NVIC_TIM3_IRQ				29
+#define NVIC_TIM4_IRQ				30
+#define NVIC_SPI1_IRQ				35
+#define NVIC_TIM5_IRQ				50
+
+/* Number of interrupts */
+#define NVIC_IRQ_COUNT				91
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void nvic_enable_irq(uint8_t);
+extern void nvic_disable_irq(uint8_t);
+
+extern void tim1_up_tim10_isr(void);
+extern void tim1_cc_isr(void);
+extern void tim2_isr(void);
+extern void tim3_isr(void);
+extern void tim4_isr(void);
+extern void tim5_isr(void);
+
+
+
+
+#endif
+
+/* End of file */
@@ -0,0 +1,69 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host shim of the libopencm3 flash API: only the subset used by the firmware */
+
+#ifndef _SIM_FLASH_INCLUDED_       /* switch to read the header file once */
+#define _SIM_FLASH_INCLUDED_       /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <libopencm3/cm3/common.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+#define FLASH_ACR					MMIO32(PERIPH_BASE_AHB1 + 0x3C00)
+
+/* Wait states field of ACR */
+#define FLASH_ACR_LATENCY_MASK		0x7
+
+/* Program parallelism */
+#define FLASH_CR_PROGRAM_X8			(0 << 8)
+#define FLASH_CR_PROGRAM_X16		(1 << 8)
+#define FLASH_CR_PROGRAM_X32		(2 << 8)
+#define FLASH_CR_PROGRAM_X64		(3 << 8)
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void flash_set_ws(uint32_t);
+extern void flash_unlock(void);
+extern void flash_lock(void);
+extern void flash_erase_sector(uint8_t, uint32_t);
+extern void flash_program_word(uint32_t, uint32_t);
+
+
+
+
+#endif
+
+/* End of file */
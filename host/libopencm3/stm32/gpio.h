@@ -0,0 +1,129 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host shim of the libopencm3 GPIO API: only the subset used by the firmware */
+
+#ifndef _SIM_GPIO_INCLUDED_        /* switch to read the header file once */
+#define _SIM_GPIO_INCLUDED_        /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <libopencm3/cm3/common.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Ports */
+#define GPIO_PORT_A_BASE			(PERIPH_BASE_AHB1 + 0x0000)
+#define GPIO_PORT_B_BASE			(PERIPH_BASE_AHB1 + 0x0400)
+#define GPIO_PORT_C_BASE			(PERIPH_BASE_AHB1 + 0x0800)
+#define GPIO_PORT_D_BASE			(PERIPH_BASE_AHB1 + 0x0C00)
+#define GPIO_PORT_E_BASE			(PERIPH_BASE_AHB1 + 0x1000)
+#define GPIOA						GPIO_PORT_A_BASE
+#define GPIOB						GPIO_PORT_B_BASE
+#define GPIOC						GPIO_PORT_C_BASE
+#define GPIOD						GPIO_PORT_D_BASE
+#define GPIOE						GPIO_PORT_E_BASE
+
+/* Registers */
+#define GPIO_MODER(port)			MMIO32((port) + 0x00)
+#define GPIO_OTYPER(port)			MMIO32((port) + 0x04)
+#define GPIO_OSPEEDR(port)			MMIO32((port) + 0x08)
+#define GPIO_PUPDR(port)			MMIO32((port) + 0x0C)
+#define GPIO_IDR(port)				MMIO32((port) + 0x10)
+#define GPIO_ODR(port)				MMIO32((port) + 0x14)
+#define GPIO_BSRR(port)				MMIO32((port) + 0x18)
+#define GPIO_AFRL(port)				MMIO32((port) + 0x20)
+#define GPIO_AFRH(port)				MMIO32((port) + 0x24)
+
+/* Pins */
+#define GPIO0						(1 << 0)
+#define GPIO1						(1 << 1)
+#define GPIO2						(1 << 2)
+#define GPIO3						(1 << 3)
+#define GPIO4						(1 << 4)
+#define GPIO5						(1 << 5)
+#define GPIO6						(1 << 6)
+#define GPIO7						(1 << 7)
+#define GPIO8						(1 << 8)
+#define GPIO9						(1 << 9)
+#define GPIO10						(1 << 10)
+#define GPIO11						(1 << 11)
+#define GPIO12						(1 << 12)
+#define GPIO13						(1 << 13)
+#define GPIO14						(1 << 14)
+#define GPIO15						(1 << 15)
+#define GPIO_ALL					0xFFFF
+
+/* Mode, pull, output type and speed */
+#define GPIO_MODE_INPUT				0x0
+#define GPIO_MODE_OUTPUT			0x1
+#define GPIO_MODE_AF				0x2
+#define GPIO_MODE_ANALOG			0x3
+#define GPIO_PUPD_NONE				0x0
+#define GPIO_PUPD_PULLUP			0x1
+#define GPIO_PUPD_PULLDOWN			0x2
+#define GPIO_OTYPE_PP				0x0
+#define GPIO_OTYPE_OD				0x1
+#define GPIO_OSPEED_2MHZ			0x0
+#define GPIO_OSPEED_25MHZ			0x1
+#define GPIO_OSPEED_50MHZ			0x2
+#define GPIO_OSPEED_100MHZ			0x3
+
+/* Alternate functions */
+#define GPIO_AF0					0x0
+#define GPIO_AF1					0x1
+#define GPIO_AF2					0x2
+#define GPIO_AF3					0x3
+#define GPIO_AF4					0x4
+#define GPIO_AF5					0x5
+#define GPIO_AF6					0x6
+#define GPIO_AF7					0x7
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void gpio_mode_setup(uint32_t, uint8_t, uint8_t, uint16_t);
+extern void gpio_set_output_options(uint32_t, uint8_t, uint8_t, uint16_t);
+extern void gpio_set_af(uint32_t, uint8_t, uint16_t);
+extern void gpio_set(uint32_t, uint16_t);
+extern void gpio_clear(uint32_t, uint16_t);
+extern void gpio_toggle(uint32_t, uint16_t);
+extern uint16_t gpio_get(uint32_t, uint16_t);
+extern uint16_t gpio_port_read(uint32_t);
+extern void gpio_port_write(uint32_t, uint16_t);
+
+
+
+
+#endif
+
+/* End of file */
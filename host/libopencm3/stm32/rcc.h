@@ -0,0 +1,195 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host shim of the libopencm3 RCC API: only the subset used by the firmware */
+
+#ifndef _SIM_RCC_INCLUDED_         /* switch to read the header file once */
+#define _SIM_RCC_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <libopencm3/cm3/common.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+#define RCC_BASE					(PERIPH_BASE_AHB1 + 0x3800)
+
+#define RCC_CR						MMIO32(RCC_BASE + 0x00)
+#define RCC_PLLCFGR					MMIO32(RCC_BASE + 0x04)
+#define RCC_CFGR					MMIO32(RCC_BASE + 0x08)
+#define RCC_AHB1ENR					MMIO32(RCC_BASE + 0x30)
+#define RCC_APB1ENR					MMIO32(RCC_BASE + 0x40)
+#define RCC_APB2ENR					MMIO32(RCC_BASE + 0x44)
+
+/* Oscillators enable and ready bits of CR */
+#define RCC_CR_PLLRDY				(1 << 25)
+#define RCC_CR_PLLON				(1 << 24)
+#define RCC_CR_HSERDY				(1 << 17)
+#define RCC_CR_HSEON				(1 << 16)
+#define RCC_CR_HSIRDY				(1 << 1)
+#define RCC_CR_HSION				(1 << 0)
+
+/* Main PLL fields of PLLCFGR: P is 2 * (field + 1) */
+#define RCC_PLLCFGR_PLLM_SHIFT		0
+#define RCC_PLLCFGR_PLLM_MASK		0x3F
+#define RCC_PLLCFGR_PLLN_SHIFT		6
+#define RCC_PLLCFGR_PLLN_MASK		0x1FF
+#define RCC_PLLCFGR_PLLP_SHIFT		16
+#define RCC_PLLCFGR_PLLP_MASK		0x3
+#define RCC_PLLCFGR_PLLSRC			(1 << 22)
+#define RCC_PLLCFGR_PLLQ_SHIFT		24
+#define RCC_PLLCFGR_PLLQ_MASK		0xF
+
+/* System clock switch and status fields of CFGR */
+#define RCC_CFGR_SW_SHIFT			0
+#define RCC_CFGR_SWS_SHIFT			2
+#define RCC_CFGR_SW_MASK			0x3
+#define RCC_CFGR_SW_HSI				0x0
+#define RCC_CFGR_SW_HSE				0x1
+#define RCC_CFGR_SW_PLL				0x2
+
+/* AHB prescaler field of CFGR */
+#define RCC_CFGR_HPRE_SHIFT			4
+#define RCC_CFGR_HPRE_MASK			0xF
+
+/* AHB prescaler values */
+#define RCC_CFGR_HPRE_DIV_NONE		0x0
+#define RCC_CFGR_HPRE_DIV_2			0x8
+#define RCC_CFGR_HPRE_DIV_4			0x9
+
+/* APB prescaler values */
+#define RCC_CFGR_PPRE_DIV_NONE		0x0
+#define RCC_CFGR_PPRE_DIV_2			0x4
+#define RCC_CFGR_PPRE_DIV_4			0x5
+#define RCC_CFGR_PPRE_DIV_8			0x6
+
+/* APB prescaler fields of CFGR */
+#define RCC_CFGR_PPRE1_SHIFT		10
+#define RCC_CFGR_PPRE2_SHIFT		13
+#define RCC_CFGR_PPRE_MASK			0x7
+
+/* Flash wait states */
+#define FLASH_ACR_LATENCY_0WS		0x00
+#define FLASH_ACR_LATENCY_1WS		0x01
+#define FLASH_ACR_LATENCY_2WS		0x02
+#define FLASH_ACR_LATENCY_3WS		0x03
+#define FLASH_ACR_LATENCY_5WS		0x05
+#define FLASH_ACR_ICE				(1 << 9)
+#define FLASH_ACR_DCE				(1 << 10)
+
+/* Peripheral clock enable: enable register offset and bit */
+#define _REG_BIT(base, bit)			(((base) << 5) + (bit))
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+enum rcc_periph_clken {
+	RCC_GPIOA = _REG_BIT(0x30, 0),
+	RCC_GPIOB = _REG_BIT(0x30, 1),
+	RCC_GPIOC = _REG_BIT(0x30, 2),
+	RCC_GPIOD = _REG_BIT(0x30, 3),
+	RCC_GPIOE = _REG_BIT(0x30, 4),
+	RCC_DMA1 = _REG_BIT(0x30, 21),
+	RCC_DMA2 = _REG_BIT(0x30, 22),
+	RCC_TIM2 = _REG_BIT(0x40, 0),
+	RCC_TIM3 = _REG_BIT(0x40, 1),
+	RCC_TIM4 = _REG_BIT(0x40, 2),
+	RCC_TIM5 = _REG_BIT(0x40, 3),
+	RCC_TIM1 = _REG_BIT(0x44, 0),
+	RCC_SPI1 = _REG_BIT(0x44, 12)
+};
+
+enum rcc_osc {
+	RCC_PLL,
+	RCC_HSE,
+	RCC_HSI,
+	RCC_LSE,
+	RCC_LSI
+};
+
+/* Clock tree configurations from an 8 MHz HSE */
+enum clock_3v3 {
+	CLOCK_3V3_48MHZ,
+	CLOCK_3V3_120MHZ,
+	CLOCK_3V3_168MHZ,
+	CLOCK_3V3_END
+};
+
+typedef struct {
+	uint8_t pllm;
+	uint16_t plln;
+	uint8_t pllp;
+	uint8_t pllq;
+	uint32_t flash_config;
+	uint8_t hpre;
+	uint8_t ppre1;
+	uint8_t ppre2;
+	uint8_t power_save;
+	uint32_t apb1_frequency;
+	uint32_t apb2_frequency;
+} clock_scale_t;
+
+
+
+
+/* ----------- Exported variables ------------- */
+
+extern const clock_scale_t hse_8mhz_3v3[CLOCK_3V3_END];
+
+extern uint32_t rcc_ahb_frequency;
+extern uint32_t rcc_apb1_frequency;
+extern uint32_t rcc_apb2_frequency;
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void rcc_clock_setup_hse_3v3(const clock_scale_t *);
+extern void rcc_osc_on(enum rcc_osc);
+extern void rcc_osc_off(enum rcc_osc);
+extern void rcc_wait_for_osc_ready(enum rcc_osc);
+extern void rcc_set_sysclk_source(uint32_t);
+extern void rcc_wait_for_sysclk_status(enum rcc_osc);
+extern void rcc_set_hpre(uint32_t);
+extern void rcc_set_ppre1(uint32_t);
+extern void rcc_set_ppre2(uint32_t);
+extern void rcc_set_main_pll_hse(uint32_t, uint32_t, uint32_t, uint32_t);
+extern void rcc_periph_clock_enable(enum rcc_periph_clken);
+extern void rcc_periph_clock_disable(enum rcc_periph_clken);
+
+
+
+
+#endif
+
+/* End of file */
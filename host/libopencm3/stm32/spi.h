@@ -0,0 +1,89 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host shim of the libopencm3 SPI API: only the subset used by the firmware */
+
+#ifndef _SIM_SPI_INCLUDED_         /* switch to read the header file once */
+#define _SIM_SPI_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <libopencm3/cm3/common.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+#define SPI1						(PERIPH_BASE_APB2 + 0x3000)
+
+/* Registers */
+#define SPI_CR1(spi)				MMIO32((spi) + 0x00)
+#define SPI_CR2(spi)				MMIO32((spi) + 0x04)
+#define SPI_SR(spi)					MMIO32((spi) + 0x08)
+#define SPI_DR(spi)					MMIO32((spi) + 0x0C)
+
+/* CR1 */
+#define SPI_CR1_CPHA_CLK_TRANSITION_1	(0 << 0)
+#define SPI_CR1_CPHA_CLK_TRANSITION_2	(1 << 0)
+#define SPI_CR1_CPOL_CLK_TO_0_WHEN_IDLE	(0 << 1)
+#define SPI_CR1_CPOL_CLK_TO_1_WHEN_IDLE	(1 << 1)
+#define SPI_CR1_MSTR				(1 << 2)
+#define SPI_CR1_BAUDRATE_SHIFT		3
+#define SPI_CR1_BAUDRATE_MASK		(7 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_BAUDRATE_FPCLK_DIV_2	(0 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_BAUDRATE_FPCLK_DIV_4	(1 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_BAUDRATE_FPCLK_DIV_8	(2 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_BAUDRATE_FPCLK_DIV_16	(3 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_BAUDRATE_FPCLK_DIV_32	(4 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_BAUDRATE_FPCLK_DIV_64	(5 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_BAUDRATE_FPCLK_DIV_128	(6 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_BAUDRATE_FPCLK_DIV_256	(7 << SPI_CR1_BAUDRATE_SHIFT)
+#define SPI_CR1_SPE					(1 << 6)
+#define SPI_CR1_MSBFIRST			(0 << 7)
+#define SPI_CR1_LSBFIRST			(1 << 7)
+#define SPI_CR1_DFF_8BIT			(0 << 11)
+#define SPI_CR1_DFF_16BIT			(1 << 11)
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void spi_reset(uint32_t);
+extern int spi_init_master(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+extern void spi_enable(uint32_t);
+extern void spi_disable(uint32_t);
+extern int spi_set_baudrate_prescaler(uint32_t, uint8_t);
+extern uint16_t spi_xfer(uint32_t, uint16_t);
+
+
+
+
+#endif
+
+/* End of file */
@@ -0,0 +1,171 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host shim of the libopencm3 timer API: only the subset used by the firmware */
+
+#ifndef _SIM_TIMER_INCLUDED_       /* switch to read the header file once */
+#define _SIM_TIMER_INCLUDED_       /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <libopencm3/cm3/common.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Timers */
+#define TIM2						(PERIPH_BASE_APB1 + 0x0000)
+#define TIM3						(PERIPH_BASE_APB1 + 0x0400)
+#define TIM4						(PERIPH_BASE_APB1 + 0x0800)
+#define TIM5						(PERIPH_BASE_APB1 + 0x0C00)
+#define TIM1						(PERIPH_BASE_APB2 + 0x0000)
+
+/* Registers */
+#define TIM_CR1(tim)				MMIO32((tim) + 0x00)
+#define TIM_CR2(tim)				MMIO32((tim) + 0x04)
+#define TIM_DIER(tim)				MMIO32((tim) + 0x0C)
+#define TIM_SR(tim)					MMIO32((tim) + 0x10)
+#define TIM_EGR(tim)				MMIO32((tim) + 0x14)
+#define TIM_CCMR1(tim)				MMIO32((tim) + 0x18)
+#define TIM_CCMR2(tim)				MMIO32((tim) + 0x1C)
+#define TIM_CCER(tim)				MMIO32((tim) + 0x20)
+#define TIM_CNT(tim)				MMIO32((tim) + 0x24)
+#define TIM_PSC(tim)				MMIO32((tim) + 0x28)
+#define TIM_ARR(tim)				MMIO32((tim) + 0x2C)
+#define TIM_RCR(tim)				MMIO32((tim) + 0x30)
+#define TIM_CCR1(tim)				MMIO32((tim) + 0x34)
+#define TIM_CCR2(tim)				MMIO32((tim) + 0x38)
+#define TIM_CCR3(tim)				MMIO32((tim) + 0x3C)
+#define TIM_CCR4(tim)				MMIO32((tim) + 0x40)
+#define TIM_BDTR(tim)				MMIO32((tim) + 0x44)
+#define TIM_DCR(tim)				MMIO32((tim) + 0x48)
+#define TIM_DMAR(tim)				MMIO32((tim) + 0x4C)
+
+/* CR1 */
+#define TIM_CR1_CEN					(1 << 0)
+#define TIM_CR1_URS					(1 << 2)
+#define TIM_CR1_OPM					(1 << 3)
+#define TIM_CR1_DIR_UP				(0 << 4)
+#define TIM_CR1_DIR_DOWN			(1 << 4)
+#define TIM_CR1_CMS_EDGE			(0 << 5)
+#define TIM_CR1_ARPE				(1 << 7)
+#define TIM_CR1_CKD_CK_INT			(0 << 8)
+
+/* DIER */
+#define TIM_DIER_UIE				(1 << 0)
+#define TIM_DIER_CC1IE				(1 << 1)
+#define TIM_DIER_CC2IE				(1 << 2)
+#define TIM_DIER_CC3IE				(1 << 3)
+#define TIM_DIER_CC4IE				(1 << 4)
+#define TIM_DIER_UDE				(1 << 8)
+#define TIM_DIER_CC1DE				(1 << 9)
+#define TIM_DIER_CC2DE				(1 << 10)
+#define TIM_DIER_CC3DE				(1 << 11)
+#define TIM_DIER_CC4DE				(1 << 12)
+
+/* SR */
+#define TIM_SR_UIF					(1 << 0)
+#define TIM_SR_CC1IF				(1 << 1)
+#define TIM_SR_CC2IF				(1 << 2)
+#define TIM_SR_CC3IF				(1 << 3)
+#define TIM_SR_CC4IF				(1 << 4)
+
+/* EGR */
+#define TIM_EGR_UG					(1 << 0)
+#define TIM_EGR_CC1G				(1 << 1)
+#define TIM_EGR_CC2G				(1 << 2)
+#define TIM_EGR_CC3G				(1 << 3)
+#define TIM_EGR_CC4G				(1 << 4)
+
+/* BDTR */
+#define TIM_BDTR_MOE				(1 << 15)
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+enum tim_oc_id {
+	TIM_OC1 = 0,
+	TIM_OC1N,
+	TIM_OC2,
+	TIM_OC2N,
+	TIM_OC3,
+	TIM_OC3N,
+	TIM_OC4
+};
+
+enum tim_oc_mode {
+	TIM_OCM_FROZEN,
+	TIM_OCM_ACTIVE,
+	TIM_OCM_INACTIVE,
+	TIM_OCM_TOGGLE,
+	TIM_OCM_FORCE_LOW,
+	TIM_OCM_FORCE_HIGH,
+	TIM_OCM_PWM1,
+	TIM_OCM_PWM2
+};
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void timer_reset(uint32_t);
+extern void timer_set_mode(uint32_t, uint32_t, uint32_t, uint32_t);
+extern void timer_set_prescaler(uint32_t, uint32_t);
+extern void timer_set_period(uint32_t, uint32_t);
+extern void timer_set_repetition_counter(uint32_t, uint32_t);
+extern void timer_enable_preload(uint32_t);
+extern void timer_disable_preload(uint32_t);
+extern void timer_continuous_mode(uint32_t);
+extern void timer_one_shot_mode(uint32_t);
+extern void timer_enable_counter(uint32_t);
+extern void timer_disable_counter(uint32_t);
+extern void timer_enable_irq(uint32_t, uint32_t);
+extern void timer_disable_irq(uint32_t, uint32_t);
+extern bool timer_get_flag(uint32_t, uint32_t);
+extern void timer_clear_flag(uint32_t, uint32_t);
+extern void timer_generate_event(uint32_t, uint32_t);
+extern uint32_t timer_get_counter(uint32_t);
+extern void timer_set_counter(uint32_t, uint32_t);
+extern void timer_update_on_overflow(uint32_t);
+extern void timer_set_oc_mode(uint32_t, enum tim_oc_id, enum tim_oc_mode);
+extern void timer_enable_oc_preload(uint32_t, enum tim_oc_id);
+extern void timer_enable_oc_output(uint32_t, enum tim_oc_id);
+extern void timer_disable_oc_output(uint32_t, enum tim_oc_id);
+extern void timer_set_oc_value(uint32_t, enum tim_oc_id, uint32_t);
+extern void timer_enable_break_main_output(uint32_t);
+
+
+
+
+#endif
+
+/* End of file */
@@ -0,0 +1,367 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host entry point: run the firmware on the simulated board for a virtual
+ * time and print run statistics as key=value lines */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/spi.h>
+#include <libopencm3/stm32/f4/nvic.h>
+
+#include "rtos.h"
+#include "pwm.h"
+#include "led.h"
+#include "latency.h"
+#include "timebase.h"
+#include "sim.h"
+#include "fleet.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Default virtual run time [s] */
+#define DEFAULT_RUN_TIME_S				10
+
+/* Default crystal drift spread of a fleet: +/- this value [ppm] */
+#define DEFAULT_MAX_DRIFT_PPM			50
+
+/* Number of LED channels on TIM4 */
+#define LED_CHANNELS_NUM				4
+
+/* Number of reported percentiles of the one-shot timers lateness */
+#define HRTIMER_PERCENTILES_NUM			4
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Interrupt reported in statistics */
+typedef struct {
+	uint8_t irq;
+	const char *name;
+} irq_name_t;
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+static const irq_name_t irq_names[] = {
+	{NVIC_TIM1_UP_TIM10_IRQ, "tim1_up"},
+	{NVIC_TIM1_CC_IRQ, "tim1_cc"},
+	{NVIC_TIM2_IRQ, "tim2"},
+	{NVIC_TIM3_IRQ, "tim3"},
+	{NVIC_TIM4_IRQ, "tim4"},
+	{NVIC_TIM5_IRQ, "tim5"}
+};
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static double get_cpu_time_s(void);
+static void print_report(double, double);
+static void print_clocks(void);
+static void print_callbacks(void);
+static void print_latency(void);
+static void print_hrtimers(void);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Usage: main_host [-t seconds] [-f] [-l interval_us:busy_us] [-u max_us]
+ *                  [-r period_us:period_us] [-w max_cycles] [-s seed]
+ *                  [-n boards [-j workers] [-d drift_ppm] [-v]] [motion.csv ...]
+ * With -f the idle loop jumps to the next event. With -l a competing
+ * interrupt keeps the core busy up to busy_us every interval_us on average.
+ * With -u all one-shot timers run with random delays up to max_us.
+ * With -r the tick period switches between the two values at random times.
+ * With -w each callback run works up to max_cycles core cycles, changing at
+ * random times: the clock speed follows the load.
+ * With -n a fleet of boards is simulated, each with a drift in
+ * +/- drift_ppm and the motion recordings assigned in turn */
+int main(int argc, char *argv[])
+{
+	unsigned long run_time_s = DEFAULT_RUN_TIME_S;
+	bool fast_forward = false;
+	fleet_cfg_t fleet_cfg = {0};
+	unsigned long load_interval_us = 0;
+	unsigned long load_busy_us = 0;
+	unsigned long hrtimer_max_us = 0;
+	unsigned long tick_period_a_us = 0;
+	unsigned long tick_period_b_us = 0;
+	unsigned long work_max_cycles = 0;
+	char *end_ptr;
+	double host_start_s;
+	int option;
+
+	fleet_cfg.workers = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	fleet_cfg.max_drift_ppm = DEFAULT_MAX_DRIFT_PPM;
+
+	while ((option = getopt(argc, argv, "t:fl:u:r:w:n:j:d:s:v")) != -1) {
+		if (option == 't') {
+			run_time_s = strtoul(optarg, NULL, 0);
+		} else if (option == 'f') {
+			fast_forward = true;
+		} else if (option == 'l') {
+			load_interval_us = strtoul(optarg, &end_ptr, 0);
+			load_busy_us = (*end_ptr == ':') ? strtoul(end_ptr + 1, NULL, 0) : 0;
+		} else if (option == 'u') {
+			hrtimer_max_us = strtoul(optarg, NULL, 0);
+		} else if (option == 'r') {
+			tick_period_a_us = strtoul(optarg, &end_ptr, 0);
+			tick_period_b_us = (*end_ptr == ':') ? strtoul(end_ptr + 1, NULL, 0) : 0;
+		} else if (option == 'w') {
+			work_max_cycles = strtoul(optarg, NULL, 0);
+		} else if (option == 'n') {
+			fleet_cfg.boards = (uint32_t)strtoul(optarg, NULL, 0);
+		} else if (option == 'j') {
+			fleet_cfg.workers = (uint32_t)strtoul(optarg, NULL, 0);
+		} else if (option == 'd') {
+			fleet_cfg.max_drift_ppm = (int32_t)strtol(optarg, NULL, 0);
+		} else if (option == 's') {
+			fleet_cfg.seed = strtoull(optarg, NULL, 0);
+		} else if (option == 'v') {
+			fleet_cfg.verbose = true;
+		} else {
+			fprintf(stderr, "usage: %s [-t seconds] [-f] [-l interval_us:busy_us] [-u max_us]"
+					" [-r period_us:period_us] [-w max_cycles] [-s seed]"
+					" [-n boards [-j workers] [-d drift_ppm] [-v]] [motion.csv ...]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	fleet_cfg.motion_paths = &argv[optind];
+	fleet_cfg.motions_num = (uint32_t)(argc - optind);
+
+	if (fleet_cfg.boards > 0) {
+		fleet_cfg.run_ps = (uint64_t)run_time_s * SIM_PS_PER_S;
+		fleet_cfg.fast_forward = fast_forward;
+		if (fleet_cfg.workers == 0) {
+			fleet_cfg.workers = 1;
+		}
+		return fleet_run(&fleet_cfg) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	sim_init();
+	if (fleet_cfg.motions_num > 0) {
+		/* single board: first recording */
+		if (!sim_motion_load(fleet_cfg.motion_paths[0])) {
+			fprintf(stderr, "cannot load %s\n", fleet_cfg.motion_paths[0]);
+			return EXIT_FAILURE;
+		}
+		sim_lis3dsh_set_motion(&sim_motion_play);
+	}
+	sim_load_set((uint32_t)load_interval_us, (uint32_t)load_busy_us, fleet_cfg.seed);
+	sim_hrtimer_set((uint32_t)hrtimer_max_us, fleet_cfg.seed);
+	sim_tick_set((uint32_t)tick_period_a_us, (uint32_t)tick_period_b_us, fleet_cfg.seed);
+	sim_work_set((uint32_t)work_max_cycles, fleet_cfg.seed);
+
+	host_start_s = get_cpu_time_s();
+	sim_run((uint64_t)run_time_s * SIM_PS_PER_S, fast_forward);
+	print_report((double)sim_get_time_ps() / SIM_PS_PER_S, get_cpu_time_s() - host_start_s);
+	print_clocks();
+	print_callbacks();
+	print_latency();
+	if (hrtimer_max_us > 0) {
+		print_hrtimers();
+	}
+
+	return EXIT_SUCCESS;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Get the process CPU time [s] */
+static double get_cpu_time_s(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+
+	return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+
+/* Print run statistics */
+static void print_report(double virtual_s, double host_s)
+{
+	const sim_stats_t *stats_ptr = sim_get_stats();
+	pwm_stats_t pwm_stats;
+	uint8_t index;
+
+	printf("virtual_time_s=%.6f\n", virtual_s);
+	printf("timebase_s=%.6f\n", (double)timebase_get_us() / TIMEBASE_FREQUENCY_HZ);
+	printf("host_time_s=%.6f\n", host_s);
+	printf("speedup=%.1f\n", (host_s > 0.0) ? (virtual_s / host_s) : 0.0);
+	printf("idle_loops=%llu\n", (unsigned long long)stats_ptr->idle_loops);
+	printf("events_fired=%llu\n", (unsigned long long)sim_event_get_fired());
+	for (index = 0; index < (sizeof(irq_names) / sizeof(irq_names[0])); index++) {
+		printf("irq_%s=%llu\n", irq_names[index].name,
+			   (unsigned long long)stats_ptr->irq_calls[irq_names[index].irq]);
+	}
+	printf("irq_lost=%llu\n", (unsigned long long)stats_ptr->irq_lost);
+	printf("spi_bytes=%llu\n", (unsigned long long)stats_ptr->spi_bytes);
+	printf("dma_transfers=%llu\n", (unsigned long long)stats_ptr->dma_transfers);
+	pwm_get_stats(&pwm_stats);
+	printf("pwm_writes=%lu\n", (unsigned long)pwm_stats.written);
+	printf("pwm_writes_suppressed=%lu\n", (unsigned long)pwm_stats.suppressed);
+	/* LED ticks that did some work: an idle LED tick returns early */
+	printf("led_refreshes=%lu\n", (unsigned long)led_get_refresh_count());
+	printf("led_refreshes_per_s=%.1f\n", (virtual_s > 0.0) ? ((double)led_get_refresh_count() / virtual_s) : 0.0);
+	printf("flash_stall_s=%.6f\n", (double)stats_ptr->flash_stall_ps / SIM_PS_PER_S);
+	printf("sensor_samples=%llu\n", (unsigned long long)sim_lis3dsh_get_samples());
+	printf("busy_irqs=%llu\n", (unsigned long long)stats_ptr->busy_irqs);
+	printf("busy_s=%.6f\n", (double)stats_ptr->busy_ps / SIM_PS_PER_S);
+	printf("tick_switches=%llu\n", (unsigned long long)sim_tick_get_switches());
+
+	/* LED duty cycles from the TIM4 compare registers */
+	printf("led_duty_permille=");
+	for (index = 0; index < LED_CHANNELS_NUM; index++) {
+		printf("%s%llu", (index > 0) ? "," : "",
+			   (unsigned long long)((uint64_t)MMIO32(TIM4 + 0x34 + (index * sizeof(uint32_t))) * 1000
+									/ ((uint64_t)TIM_ARR(TIM4) + 1)));
+	}
+	printf("\n");
+}
+
+
+/* Print the clock speed changes and the peripheral clocks that shall not follow them */
+static void print_clocks(void)
+{
+	const sim_clock_stats_t *stats_ptr = sim_clock_get_stats();
+	uint8_t index;
+
+	printf("clock_switches=%llu\n", (unsigned long long)stats_ptr->switches);
+	printf("clock_errors=%llu\n", (unsigned long long)stats_ptr->errors);
+
+	/* time at each AHB clock [MHz:permille] */
+	printf("clock_residency_permille=");
+	for (index = 0; (index < SIM_CLOCK_SPEEDS_MAX) && (stats_ptr->hclk_hz[index] != 0); index++) {
+		printf("%s%u:%llu", (index > 0) ? "," : "", stats_ptr->hclk_hz[index] / 1000000,
+			   (unsigned long long)((stats_ptr->residency_ps[index] * 1000) / sim_get_time_ps()));
+	}
+	printf("\n");
+
+	printf("pwm_frequency_hz=%.3f\n", (double)sim_get_timer_clock(TIM4)
+		   / (((double)TIM_PSC(TIM4) + 1) * ((double)TIM_ARR(TIM4) + 1)));
+	printf("spi_clock_hz=%u\n", sim_clock_get_pclk(true)
+		   >> (((SPI_CR1(SPI1) & SPI_CR1_BAUDRATE_MASK) >> SPI_CR1_BAUDRATE_SHIFT) + 1));
+}
+
+
+/* Print the timing of each RTOS callback that run and the hash of the whole trace */
+static void print_callbacks(void)
+{
+	const sim_trace_cb_t *trace_ptr;
+	double drift_ppm;
+	uint8_t callback_id;
+
+	for (callback_id = 0; callback_id < RTOS_CB_ID_MAX_NUM; callback_id++) {
+		trace_ptr = sim_trace_get_callback(callback_id);
+		if (trace_ptr->runs == 0) {
+			continue;
+		}
+		/* mean period between first and last run against the nominal one */
+		drift_ppm = 0.0;
+		if ((trace_ptr->runs > 1) && (trace_ptr->period_ps > 0)) {
+			drift_ppm = (((double)(trace_ptr->last_run_ps - trace_ptr->first_run_ps)
+						  / ((double)(trace_ptr->runs - 1) * (double)trace_ptr->period_ps)) - 1.0) * 1e6;
+		}
+		printf("cb%u_runs=%llu\n", callback_id, (unsigned long long)trace_ptr->runs);
+		printf("cb%u_overruns=%llu\n", callback_id, (unsigned long long)trace_ptr->overruns);
+		printf("cb%u_latency_us=%.3f,%.3f,%.3f\n", callback_id,
+			   (double)trace_ptr->latency_min_ps / SIM_PS_PER_US,
+			   (double)trace_ptr->latency_sum_ps / (double)trace_ptr->runs / SIM_PS_PER_US,
+			   (double)trace_ptr->latency_max_ps / SIM_PS_PER_US);
+		printf("cb%u_lateness_us=%.3f,%.3f\n", callback_id,
+			   (double)trace_ptr->lateness_min_ps / SIM_PS_PER_US,
+			   (double)trace_ptr->lateness_max_ps / SIM_PS_PER_US);
+		printf("cb%u_drift_ppm=%.1f\n", callback_id, drift_ppm);
+	}
+	printf("trace_hash=%016llx\n", (unsigned long long)sim_trace_get_hash());
+}
+
+
+
+/* Print the latency and jitter percentiles of the tick interrupt */
+static void print_latency(void)
+{
+	latency_report_t report;
+	uint8_t stat;
+
+	latency_get_report(&report);
+	printf("tick_latency_samples=%u\n", report.samples);
+	printf("tick_latency_ns=");
+	for (stat = 0; stat < LATENCY_ST_MAX_NUM; stat++) {
+		printf("%s%u", (stat > 0) ? "," : "", report.latency_ns[stat]);
+	}
+	printf("\ntick_jitter_ns=");
+	for (stat = 0; stat < LATENCY_ST_MAX_NUM; stat++) {
+		printf("%s%u", (stat > 0) ? "," : "", report.jitter_ns[stat]);
+	}
+	printf("\n");
+}
+
+
+
+/* Print the expiries of the one-shot timers load */
+static void print_hrtimers(void)
+{
+	static const uint32_t permilles[HRTIMER_PERCENTILES_NUM] = {500, 900, 990, 999};
+	const sim_hrtimer_stats_t *stats_ptr = sim_hrtimer_get_stats();
+	const histogram_t *lateness_ptr = sim_hrtimer_get_lateness();
+	uint8_t index;
+
+	printf("hrtimer_expiries=%llu\n", (unsigned long long)stats_ptr->expiries);
+	printf("hrtimer_order_errors=%llu\n", (unsigned long long)stats_ptr->order_errors);
+	printf("hrtimer_early=%llu\n", (unsigned long long)stats_ptr->early_expiries);
+	printf("hrtimer_lateness_ns=");
+	for (index = 0; index < HRTIMER_PERCENTILES_NUM; index++) {
+		printf("%u,", histogram_get_percentile(lateness_ptr, permilles[index]));
+	}
+	printf("%u\n", histogram_get_max(lateness_ptr));
+}
+
+
+
+/* End of file */
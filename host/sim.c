@@ -0,0 +1,1013 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/spi.h>
+#include <libopencm3/stm32/f4/nvic.h>
+
+#include "port.h"
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Number of words of the simulated peripheral memory map */
+#define BUS_WORDS						(SIM_BUS_SIZE_BYTES / sizeof(uint32_t))
+
+/* Number of simulated timers */
+#define TIMERS_NUM						5
+
+/* Number of compare channels of a timer */
+#define TIMER_CC_NUM					4
+
+/* Flash memory map */
+#define FLASH_BASE_ADDRESS				((uint32_t)0x08000000)
+#define FLASH_SIZE_BYTES				((uint32_t)0x100000)	/* 1MB */
+
+/* Offset of the DMA burst register of a timer */
+#define TIM_DMAR_OFFSET					((uint32_t)0x4C)
+
+/* Burst length and base address fields of TIM_DCR */
+#define TIM_DCR_DBL(dcr)				((((dcr) >> 8) & 0x1F) + 1)
+#define TIM_DCR_DBA(dcr)				(((dcr) & 0x1F) * sizeof(uint32_t))
+
+/* Offset of the bit set/reset register of a GPIO port */
+#define GPIO_BSRR_OFFSET				((uint32_t)0x18)
+
+/* Span of the GPIO ports in the memory map */
+#define GPIO_PORT_SPAN					((uint32_t)0x400)
+#define GPIO_PORTS_NUM					9
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Timer model */
+typedef struct {
+	sim_event_t event;					/* next update or compare event */
+	int8_t next_event;					/* -1 for an update, else the compare channel */
+	uint32_t timer;						/* timer peripheral */
+	uint8_t up_irq;						/* update interrupt */
+	uint8_t cc_irq;						/* compare interrupt */
+	bool running;						/* counter is enabled */
+	uint32_t prescaler;					/* prescaler of the actual period */
+	uint32_t clock_hz;					/* counter clock of the actual period */
+	uint64_t update_ps;					/* time of the last update event */
+	uint64_t period_ps;					/* length of the actual period */
+	uint8_t cc_done;					/* compare events already fired in this period */
+	bool arr_loaded;					/* an update event loaded the auto-reload while stopped */
+	uint32_t loaded_arr;				/* auto-reload value it loaded */
+	bool overflowing;					/* counter beyond an auto-reload written at once: it counts up to its top */
+} timer_model_t;
+
+/* DMA request line: a timer event wired to a DMA stream and channel */
+typedef struct {
+	uint32_t timer;
+	uint32_t request;					/* TIM_DIER DMA request enable bit */
+	uint32_t dma;
+	uint8_t stream;
+	uint32_t channel;
+} dma_request_t;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void timer_event_handler(sim_event_t *);
+static timer_model_t *get_timer_model(uint32_t);
+static uint64_t get_counts_ps(const timer_model_t *, uint64_t);
+static uint32_t get_elapsed_counts(const timer_model_t *);
+static uint32_t get_counter_top(uint32_t);
+static void schedule_timer(timer_model_t *);
+static bool is_update_quiet(const timer_model_t *);
+static void catch_up_timer(timer_model_t *);
+static void fire_update(timer_model_t *);
+static void fire_compare(timer_model_t *, uint8_t);
+static void dma_request(uint32_t, uint32_t);
+static void dma_transfer(uint32_t, uint8_t);
+static void drain_irqs(void);
+static void hold_core(uint64_t);
+static uint64_t get_cycles_ps(uint32_t);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Peripheral memory map */
+static volatile uint32_t bus_memory[BUS_WORDS];
+
+/* Flash memory, mapped at its bus address */
+static uint8_t *flash_memory;
+
+/* Virtual clock [ps] */
+static uint64_t time_ps;
+
+/* End of the actual run [ps] */
+static uint64_t end_ps;
+
+/* Return point of the actual run */
+static jmp_buf run_exit;
+
+/* Idle main loop jumps to the next event */
+static bool fast_forward;
+
+/* Interrupts are held while an ISR runs or the core is stalled */
+static uint32_t irq_hold_depth;
+
+/* Interrupt mask of the core (PRIMASK) */
+static bool irq_masked;
+
+/* Interrupt enable and pending flags */
+static bool irq_enabled[SIM_IRQ_NUM];
+static bool irq_pending[SIM_IRQ_NUM];
+static uint8_t irq_pending_num;
+
+/* Initial items of each DMA stream, for circular mode */
+static uint16_t dma_items[2][8];
+
+/* Pins of each GPIO port driven from outside, and their levels */
+static uint16_t gpio_input_pins[GPIO_PORTS_NUM];
+static uint16_t gpio_input_levels[GPIO_PORTS_NUM];
+
+/* Run statistics */
+static sim_stats_t stats;
+
+/* Timer models */
+static timer_model_t timers[TIMERS_NUM] = {
+	{{0, 0, &timer_event_handler, 0}, -1, TIM1, NVIC_TIM1_UP_TIM10_IRQ, NVIC_TIM1_CC_IRQ, false, 0, 0, 0, 0, 0, false, 0, false},
+	{{0, 0, &timer_event_handler, 0}, -1, TIM2, NVIC_TIM2_IRQ, NVIC_TIM2_IRQ, false, 0, 0, 0, 0, 0, false, 0, false},
+	{{0, 0, &timer_event_handler, 0}, -1, TIM3, NVIC_TIM3_IRQ, NVIC_TIM3_IRQ, false, 0, 0, 0, 0, 0, false, 0, false},
+	{{0, 0, &timer_event_handler, 0}, -1, TIM4, NVIC_TIM4_IRQ, NVIC_TIM4_IRQ, false, 0, 0, 0, 0, 0, false, 0, false},
+	{{0, 0, &timer_event_handler, 0}, -1, TIM5, NVIC_TIM5_IRQ, NVIC_TIM5_IRQ, false, 0, 0, 0, 0, 0, false, 0, false}
+};
+
+/* Interrupt service routines */
+static void (*const isr_table[SIM_IRQ_NUM])(void) = {
+	[NVIC_TIM1_UP_TIM10_IRQ] = &tim1_up_tim10_isr,
+	[NVIC_TIM1_CC_IRQ] = &tim1_cc_isr,
+	[NVIC_TIM2_IRQ] = &tim2_isr,
+	[NVIC_TIM3_IRQ] = &tim3_isr,
+	[NVIC_TIM4_IRQ] = &tim4_isr,
+	[NVIC_TIM5_IRQ] = &tim5_isr
+};
+
+/* DMA request mapping of the reference manual used by the firmware */
+static const dma_request_t dma_requests[] = {
+	{TIM4, TIM_DIER_UDE, DMA1, DMA_STREAM6, DMA_SxCR_CHSEL_2},
+	{TIM1, TIM_DIER_UDE, DMA2, DMA_STREAM5, DMA_SxCR_CHSEL_6},
+	{TIM1, TIM_DIER_CC1DE, DMA2, DMA_STREAM1, DMA_SxCR_CHSEL_6},
+	{TIM1, TIM_DIER_CC2DE, DMA2, DMA_STREAM2, DMA_SxCR_CHSEL_6}
+};
+
+
+
+
+/* ------------- Default interrupt service routines --------------- */
+
+/* Interrupts not served by the firmware */
+__attribute__((weak)) void tim1_up_tim10_isr(void) {}
+__attribute__((weak)) void tim1_cc_isr(void) {}
+__attribute__((weak)) void tim2_isr(void) {}
+__attribute__((weak)) void tim3_isr(void) {}
+__attribute__((weak)) void tim4_isr(void) {}
+__attribute__((weak)) void tim5_isr(void) {}
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init the simulated board: registers at reset value and erased flash */
+void sim_init(void)
+{
+	uint8_t timer_index;
+
+	/* firmware stores addresses in 32-bit words: data shall live below 4GB */
+	if ((uintptr_t)bus_memory > UINT32_MAX) {
+		fprintf(stderr, "sim: build with -no-pie\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (flash_memory == NULL) {
+		flash_memory = mmap((void *)(uintptr_t)FLASH_BASE_ADDRESS, FLASH_SIZE_BYTES,
+							PROT_READ | PROT_WRITE,
+							MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+		if (flash_memory != (uint8_t *)(uintptr_t)FLASH_BASE_ADDRESS) {
+			fprintf(stderr, "sim: cannot map flash memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memset(flash_memory, 0xFF, FLASH_SIZE_BYTES);
+
+	memset((void *)bus_memory, 0, sizeof(bus_memory));
+	memset(&stats, 0, sizeof(stats));
+	memset(gpio_input_pins, 0, sizeof(gpio_input_pins));
+	memset(gpio_input_levels, 0, sizeof(gpio_input_levels));
+	sim_event_reset();
+	for (timer_index = 0; timer_index < TIMERS_NUM; timer_index++) {
+		timers[timer_index].running = false;
+		timers[timer_index].arr_loaded = false;
+		timers[timer_index].overflowing = false;
+	}
+	memset(irq_enabled, 0, sizeof(irq_enabled));
+	memset(irq_pending, 0, sizeof(irq_pending));
+	irq_pending_num = 0;
+	irq_hold_depth = 0;
+	irq_masked = false;
+	time_ps = 0;
+
+	sim_clock_reset();
+	for (timer_index = 0; timer_index < TIMERS_NUM; timer_index++) {
+		timers[timer_index].clock_hz = sim_get_timer_clock(timers[timer_index].timer);
+	}
+	sim_trace_reset();
+	sim_lis3dsh_reset();
+	sim_load_reset();
+	sim_hrtimer_reset();
+	sim_tick_reset();
+	sim_work_reset();
+}
+
+
+/* Run the firmware for a virtual time [ps]. In fast forward mode the idle
+ * main loop jumps to the next event instead of polling */
+void sim_run(uint64_t run_ps, bool fast)
+{
+	end_ps = time_ps + run_ps;
+	fast_forward = fast;
+	if (setjmp(run_exit) == 0) {
+		(void)firmware_main();
+	}
+}
+
+
+/* Get run statistics */
+const sim_stats_t *sim_get_stats(void)
+{
+	return &stats;
+}
+
+
+/* Main loop turn with nothing to do: let the virtual clock run */
+void port_idle(void)
+{
+	uint64_t next_ps = end_ps;
+
+	stats.idle_loops++;
+	if (fast_forward) {
+		/* nothing can change before the next event */
+		if (sim_event_peek(&next_ps) && (next_ps > end_ps)) {
+			next_ps = end_ps;
+		}
+		sim_advance((next_ps > time_ps) ? (next_ps - time_ps) : 0);
+	} else {
+		sim_advance(get_cycles_ps(SIM_IDLE_LOOP_CYCLES));
+	}
+
+	if (time_ps >= end_ps) {
+		longjmp(run_exit, 1);
+	}
+}
+
+
+/* Get the virtual time [ps] */
+uint64_t sim_get_time_ps(void)
+{
+	return time_ps;
+}
+
+
+/* Advance the virtual clock, firing due peripheral events in time order */
+void sim_advance(uint64_t delta_ps)
+{
+	uint64_t target_ps = time_ps + delta_ps;
+	uint64_t event_ps;
+
+	while (sim_event_peek(&event_ps) && (event_ps <= target_ps)) {
+		time_ps = event_ps;
+		sim_event_fire();
+	}
+
+	/* an ISR can take longer than the requested delta */
+	if (time_ps < target_ps) {
+		time_ps = target_ps;
+	}
+}
+
+
+/* Advance the virtual clock with the core stalled: interrupts wait */
+void sim_stall(uint64_t delta_ps)
+{
+	hold_core(delta_ps);
+	stats.flash_stall_ps += delta_ps;
+
+	drain_irqs();
+}
+
+
+/* Serve an interrupt of higher priority than the firmware ones for a time:
+ * the firmware interrupts raised meanwhile wait */
+void sim_irq_busy(uint64_t delta_ps)
+{
+	hold_core(delta_ps);
+	stats.busy_irqs++;
+	stats.busy_ps += delta_ps;
+
+	drain_irqs();
+}
+
+
+/* Get the counter clock of a timer [Hz]: twice the APB clock if the APB is divided */
+uint32_t sim_get_timer_clock(uint32_t timer)
+{
+	bool apb2 = (timer >= PERIPH_BASE_APB2);
+	uint32_t ppre = (RCC_CFGR >> (apb2 ? RCC_CFGR_PPRE2_SHIFT : RCC_CFGR_PPRE1_SHIFT)) & RCC_CFGR_PPRE_MASK;
+	uint32_t apb_frequency = sim_clock_get_pclk(apb2);
+
+	return (ppre < RCC_CFGR_PPRE_DIV_2) ? apb_frequency : (apb_frequency * 2);
+}
+
+
+/* Move the running timers to the new counter clocks: the counter keeps its
+ * value, the time left to the next events scales with the clock */
+void sim_timers_follow_clock(void)
+{
+	uint8_t timer_index;
+	timer_model_t *model_ptr;
+	uint32_t clock_hz;
+
+	for (timer_index = 0; timer_index < TIMERS_NUM; timer_index++) {
+		model_ptr = &timers[timer_index];
+		clock_hz = sim_get_timer_clock(model_ptr->timer);
+		if (model_ptr->running && (clock_hz != model_ptr->clock_hz)) {
+			catch_up_timer(model_ptr);
+			model_ptr->update_ps = time_ps - (uint64_t)(((unsigned __int128)(time_ps - model_ptr->update_ps)
+														 * model_ptr->clock_hz) / clock_hz);
+			model_ptr->period_ps = (uint64_t)(((unsigned __int128)model_ptr->period_ps * model_ptr->clock_hz)
+											  / clock_hz);
+			model_ptr->clock_hz = clock_hz;
+			schedule_timer(model_ptr);
+		} else {
+			/* a stopped timer takes the clock at once */
+			model_ptr->clock_hz = clock_hz;
+		}
+	}
+}
+
+
+/* Align a timer model to its registers after a CPU write */
+void sim_timer_sync(uint32_t timer)
+{
+	timer_model_t *model_ptr = get_timer_model(timer);
+	uint32_t counter;
+	uint8_t cc_index;
+
+	if (model_ptr != NULL) {
+		catch_up_timer(model_ptr);
+	}
+
+	if (model_ptr == NULL) {
+		/* not simulated */
+	} else if ((TIM_CR1(timer) & TIM_CR1_CEN) && !model_ptr->running) {
+		/* counter enabled: count from the actual counter value */
+		counter = TIM_CNT(timer);
+		model_ptr->running = true;
+		model_ptr->prescaler = TIM_PSC(timer);
+		model_ptr->clock_hz = sim_get_timer_clock(timer);
+		model_ptr->update_ps = time_ps - get_counts_ps(model_ptr, counter);
+		/* a buffered auto-reload written after the last update event waits for the next one */
+		model_ptr->period_ps = get_counts_ps(model_ptr, (uint64_t)(((TIM_CR1(timer) & TIM_CR1_ARPE) && model_ptr->arr_loaded)
+																	? model_ptr->loaded_arr : TIM_ARR(timer)) + 1);
+		model_ptr->arr_loaded = false;
+		model_ptr->cc_done = 0;
+		for (cc_index = 0; cc_index < TIMER_CC_NUM; cc_index++) {
+			if (MMIO32(timer + 0x34 + (cc_index * sizeof(uint32_t))) < counter) {
+				model_ptr->cc_done |= (uint8_t)(1 << cc_index);
+			}
+		}
+	} else if (!(TIM_CR1(timer) & TIM_CR1_CEN) && model_ptr->running) {
+		/* counter disabled: freeze the counter value */
+		TIM_CNT(timer) = sim_timer_get_counter(timer);
+		model_ptr->running = false;
+	} else if (model_ptr->running && !(TIM_CR1(timer) & TIM_CR1_ARPE)) {
+		/* auto-reload not buffered: new period applies at once. A counter
+		 * already beyond it counts up to its top value, then overflows */
+		model_ptr->overflowing = (get_elapsed_counts(model_ptr) > TIM_ARR(timer));
+		model_ptr->period_ps = get_counts_ps(model_ptr, (uint64_t)(model_ptr->overflowing ? get_counter_top(timer)
+																						 : TIM_ARR(timer)) + 1);
+	}
+
+	if (model_ptr != NULL) {
+		schedule_timer(model_ptr);
+	}
+}
+
+
+/* Software update event. With URS set it reloads the registers only: no
+ * flag, interrupt or DMA request */
+void sim_timer_update(uint32_t timer)
+{
+	timer_model_t *model_ptr = get_timer_model(timer);
+
+	TIM_CNT(timer) = 0;
+	if (model_ptr == NULL) {
+		/* not simulated */
+	} else if (TIM_CR1(timer) & TIM_CR1_URS) {
+		model_ptr->prescaler = TIM_PSC(timer);
+		model_ptr->update_ps = time_ps;
+		model_ptr->period_ps = get_counts_ps(model_ptr, (uint64_t)TIM_ARR(timer) + 1);
+		model_ptr->cc_done = 0;
+		model_ptr->overflowing = false;
+		if (!model_ptr->running) {
+			model_ptr->arr_loaded = true;
+			model_ptr->loaded_arr = TIM_ARR(timer);
+		}
+		schedule_timer(model_ptr);
+	} else {
+		fire_update(model_ptr);
+		schedule_timer(model_ptr);
+	}
+}
+
+
+/* The counter was written: the period restarts from the new value */
+void sim_timer_set_counter(uint32_t timer)
+{
+	timer_model_t *model_ptr = get_timer_model(timer);
+	uint32_t counter = TIM_CNT(timer);
+	uint8_t cc_index;
+
+	if ((model_ptr != NULL) && model_ptr->running) {
+		catch_up_timer(model_ptr);
+		model_ptr->update_ps = time_ps - get_counts_ps(model_ptr, counter);
+		if (!(TIM_CR1(timer) & TIM_CR1_ARPE)) {
+			/* a value beyond the auto-reload counts up to the top value */
+			model_ptr->overflowing = (counter > TIM_ARR(timer));
+			model_ptr->period_ps = get_counts_ps(model_ptr, (uint64_t)(model_ptr->overflowing ? get_counter_top(timer)
+																							 : TIM_ARR(timer)) + 1);
+		}
+		model_ptr->cc_done = 0;
+		for (cc_index = 0; cc_index < TIMER_CC_NUM; cc_index++) {
+			if (MMIO32(timer + 0x34 + (cc_index * sizeof(uint32_t))) < counter) {
+				model_ptr->cc_done |= (uint8_t)(1 << cc_index);
+			}
+		}
+		schedule_timer(model_ptr);
+	}
+}
+
+
+/* A compare value was written: it matches again in this period if the
+ * counter did not reach it yet */
+void sim_timer_set_compare(uint32_t timer, uint8_t cc_index)
+{
+	timer_model_t *model_ptr = get_timer_model(timer);
+
+	if ((model_ptr != NULL) && model_ptr->running && (cc_index < TIMER_CC_NUM)) {
+		if (MMIO32(timer + 0x34 + (cc_index * sizeof(uint32_t))) < sim_timer_get_counter(timer)) {
+			model_ptr->cc_done |= (uint8_t)(1 << cc_index);
+		} else {
+			model_ptr->cc_done &= (uint8_t)~(1 << cc_index);
+		}
+	}
+
+	sim_timer_sync(timer);
+}
+
+
+/* Software compare event of a channel: flag and requests as a match, the
+ * match of the compare value in this period is not affected */
+void sim_timer_compare(uint32_t timer, uint8_t cc_index)
+{
+	timer_model_t *model_ptr = get_timer_model(timer);
+
+	if ((model_ptr != NULL) && (cc_index < TIMER_CC_NUM)) {
+		TIM_SR(timer) |= (TIM_SR_CC1IF << cc_index);
+		if (TIM_DIER(timer) & (TIM_DIER_CC1DE << cc_index)) {
+			dma_request(timer, TIM_DIER_CC1DE << cc_index);
+		}
+		if (TIM_DIER(timer) & (TIM_DIER_CC1IE << cc_index)) {
+			sim_irq_raise(model_ptr->cc_irq);
+		}
+	}
+}
+
+
+/* Get the actual counter value of a timer */
+uint32_t sim_timer_get_counter(uint32_t timer)
+{
+	timer_model_t *model_ptr = get_timer_model(timer);
+	uint32_t counter = TIM_CNT(timer);
+
+	if ((model_ptr != NULL) && model_ptr->running) {
+		catch_up_timer(model_ptr);
+		counter = get_elapsed_counts(model_ptr);
+		if (model_ptr->overflowing) {
+			/* counts up to the top value */
+		} else if (counter > TIM_ARR(timer)) {
+			counter = TIM_ARR(timer);
+		}
+		TIM_CNT(timer) = counter;
+	}
+
+	return counter;
+}
+
+
+/* Set or clear the interrupt mask of the core. The interrupts raised while
+ * masked are served once cleared. Return the previous mask */
+bool sim_irq_mask(bool mask)
+{
+	bool prev_mask = irq_masked;
+
+	irq_masked = mask;
+	drain_irqs();
+
+	return prev_mask;
+}
+
+
+/* Enable or disable an interrupt */
+void sim_irq_enable(uint8_t irq, bool enable)
+{
+	if (irq < SIM_IRQ_NUM) {
+		irq_enabled[irq] = enable;
+	}
+}
+
+
+/* Raise an interrupt request: serve it at once unless interrupts are held */
+void sim_irq_raise(uint8_t irq)
+{
+	if ((irq < SIM_IRQ_NUM) && irq_enabled[irq]) {
+		if (irq_pending[irq]) {
+			/* a request is already pending: this one is lost */
+			stats.irq_lost++;
+		} else {
+			irq_pending[irq] = true;
+			irq_pending_num++;
+		}
+		drain_irqs();
+	}
+}
+
+
+/* Exchange a frame on a SPI bus: the transfer takes its bit times */
+uint16_t sim_spi_xfer(uint32_t spi, uint16_t data)
+{
+	uint32_t baudrate_div;
+	uint16_t rx_data = 0;
+
+	if ((spi == SPI1) && (SPI_CR1(spi) & SPI_CR1_SPE)) {
+		baudrate_div = (uint32_t)2 << ((SPI_CR1(spi) & SPI_CR1_BAUDRATE_MASK) >> SPI_CR1_BAUDRATE_SHIFT);
+		sim_advance(((uint64_t)8 * baudrate_div * SIM_PS_PER_S) / sim_clock_get_pclk(true));
+		stats.spi_bytes++;
+		rx_data = sim_lis3dsh_xfer((uint8_t)data);
+	}
+
+	return rx_data;
+}
+
+
+/* Get the bus address of a register from its host address. 0 if not a register */
+uint32_t sim_bus_address(uint32_t host_address)
+{
+	uint32_t offset = host_address - (uint32_t)(uintptr_t)bus_memory;
+
+	return (offset < SIM_BUS_SIZE_BYTES) ? (PERIPH_BASE + offset) : 0;
+}
+
+
+/* Get the backing word of a register */
+volatile uint32_t *sim_bus_reg(uint32_t address)
+{
+	uint32_t offset = address - PERIPH_BASE;
+
+	if (offset >= SIM_BUS_SIZE_BYTES) {
+		fprintf(stderr, "sim: access to unmapped address 0x%08X\n", (unsigned int)address);
+		abort();
+	}
+
+	return &bus_memory[offset / sizeof(uint32_t)];
+}
+
+
+/* Write a register from a bus master with its side effects */
+void sim_bus_write(uint32_t address, uint32_t value)
+{
+	uint32_t port = address & ~(GPIO_PORT_SPAN - 1);
+	uint16_t odr;
+
+	if ((port >= GPIOA) && (port < (GPIOA + (GPIO_PORTS_NUM * GPIO_PORT_SPAN)))
+	&& ((address - port) == GPIO_BSRR_OFFSET)) {
+		/* set has priority over reset */
+		odr = (uint16_t)((GPIO_ODR(port) & ~(value >> 16)) | (value & 0xFFFF));
+		sim_gpio_write(port, odr);
+	} else {
+		*sim_bus_reg(address) = value;
+		/* a timer register can move the timer events */
+		if (get_timer_model(address & ~(GPIO_PORT_SPAN - 1)) != NULL) {
+			sim_timer_sync(address & ~(GPIO_PORT_SPAN - 1));
+		}
+	}
+}
+
+
+/* Latch the number of items of a DMA stream when it is enabled. The timer
+ * events wired to the stream are no longer quiet */
+void sim_dma_enable(uint32_t dma, uint8_t stream)
+{
+	uint8_t request_index;
+	timer_model_t *model_ptr;
+
+	dma_items[dma == DMA2][stream & 0x7] = (uint16_t)DMA_SNDTR(dma, stream);
+
+	for (request_index = 0; request_index < (sizeof(dma_requests) / sizeof(dma_requests[0])); request_index++) {
+		if ((dma_requests[request_index].dma == dma) && (dma_requests[request_index].stream == stream)) {
+			model_ptr = get_timer_model(dma_requests[request_index].timer);
+			catch_up_timer(model_ptr);
+			schedule_timer(model_ptr);
+		}
+	}
+}
+
+
+/* Drive the output register of a GPIO port. The input register reads it
+ * back, but on the pins driven from outside */
+void sim_gpio_write(uint32_t port, uint16_t odr)
+{
+	uint16_t changed = (uint16_t)(GPIO_ODR(port) ^ odr);
+	uint8_t port_index = (uint8_t)((port - GPIOA) / GPIO_PORT_SPAN);
+
+	GPIO_ODR(port) = odr;
+	GPIO_IDR(port) = (odr & ~gpio_input_pins[port_index]) | gpio_input_levels[port_index];
+
+	/* LIS3DSH chip select: PE3 active low */
+	if ((port == GPIOE) && (changed & GPIO3)) {
+		sim_lis3dsh_select((odr & GPIO3) == 0);
+	}
+}
+
+
+/* Drive some pins of a GPIO port from outside, e.g. a button. Their levels
+ * are the bits of levels */
+void sim_gpio_set_input(uint32_t port, uint16_t pins, uint16_t levels)
+{
+	uint8_t port_index = (uint8_t)((port - GPIOA) / GPIO_PORT_SPAN);
+
+	gpio_input_pins[port_index] |= pins;
+	gpio_input_levels[port_index] = (gpio_input_levels[port_index] & ~pins) | (levels & pins);
+	GPIO_IDR(port) = (GPIO_ODR(port) & ~gpio_input_pins[port_index]) | gpio_input_levels[port_index];
+}
+
+
+/* Get the host pointer of a flash address. NULL if out of flash */
+uint8_t *sim_flash_ptr(uint32_t address)
+{
+	uint32_t offset = address - FLASH_BASE_ADDRESS;
+
+	return (offset < FLASH_SIZE_BYTES) ? (flash_memory + offset) : NULL;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Get the model of a timer. NULL if not simulated */
+static timer_model_t *get_timer_model(uint32_t timer)
+{
+	uint8_t timer_index;
+	timer_model_t *model_ptr = NULL;
+
+	for (timer_index = 0; timer_index < TIMERS_NUM; timer_index++) {
+		if (timers[timer_index].timer == timer) {
+			model_ptr = &timers[timer_index];
+		}
+	}
+
+	return model_ptr;
+}
+
+
+/* Duration of a number of counts of a timer [ps] */
+static uint64_t get_counts_ps(const timer_model_t *model_ptr, uint64_t counts)
+{
+	return (uint64_t)(((unsigned __int128)counts * (model_ptr->prescaler + 1) * SIM_PS_PER_S)
+					  / model_ptr->clock_hz);
+}
+
+
+/* Get the counts elapsed since the last update event of a running timer */
+static uint32_t get_elapsed_counts(const timer_model_t *model_ptr)
+{
+	return (uint32_t)(((unsigned __int128)(time_ps - model_ptr->update_ps) * model_ptr->clock_hz)
+					  / ((uint64_t)(model_ptr->prescaler + 1) * SIM_PS_PER_S));
+}
+
+
+/* Get the top value of a timer counter: TIM2 and TIM5 are 32-bit */
+static uint32_t get_counter_top(uint32_t timer)
+{
+	return ((timer == TIM2) || (timer == TIM5)) ? 0xFFFFFFFF : 0xFFFF;
+}
+
+
+/* Timer event: fire it and queue the next one */
+static void timer_event_handler(sim_event_t *event_ptr)
+{
+	timer_model_t *model_ptr = (timer_model_t *)((uint8_t *)event_ptr - offsetof(timer_model_t, event));
+
+	if (model_ptr->next_event < 0) {
+		fire_update(model_ptr);
+	} else {
+		fire_compare(model_ptr, (uint8_t)model_ptr->next_event);
+	}
+
+	schedule_timer(model_ptr);
+}
+
+
+/* Queue the next event of a timer: the update or the first compare event
+ * with an enabled interrupt or DMA request. A timer without any of them
+ * queues nothing: its updates are caught up when it is accessed */
+static void schedule_timer(timer_model_t *model_ptr)
+{
+	uint32_t timer = model_ptr->timer;
+	uint8_t cc_index;
+	uint32_t cc_value;
+	uint32_t cc_enable;
+	uint64_t event_ps;
+	uint64_t candidate_ps;
+
+	if (!model_ptr->running) {
+		sim_event_cancel(&model_ptr->event);
+		return;
+	}
+
+	event_ps = model_ptr->update_ps + model_ptr->period_ps;
+	model_ptr->next_event = -1;
+
+	cc_enable = ((TIM_DIER(timer) >> 1) | (TIM_DIER(timer) >> 9)) & ((1 << TIMER_CC_NUM) - 1);
+	if ((cc_enable == 0) && is_update_quiet(model_ptr)) {
+		sim_event_cancel(&model_ptr->event);
+		return;
+	}
+
+	for (cc_index = 0; cc_index < TIMER_CC_NUM; cc_index++) {
+		cc_value = MMIO32(timer + 0x34 + (cc_index * sizeof(uint32_t)));
+		if ((cc_enable & (1 << cc_index))
+		&& !(model_ptr->cc_done & (1 << cc_index))
+		&& (cc_value <= TIM_ARR(timer))) {
+			candidate_ps = model_ptr->update_ps + get_counts_ps(model_ptr, cc_value);
+			/* a value written below the counter matches in the next period */
+			if ((candidate_ps >= time_ps) && (candidate_ps < event_ps)) {
+				event_ps = candidate_ps;
+				model_ptr->next_event = (int8_t)cc_index;
+			}
+		}
+	}
+
+	/* keep the queue order of an unchanged event */
+	if (!sim_event_is_queued(&model_ptr->event) || (model_ptr->event.time_ps != event_ps)) {
+		sim_event_schedule(&model_ptr->event, event_ps);
+	}
+}
+
+
+/* An update is quiet if it requests no interrupt and no DMA transfer and
+ * does not stop the counter */
+static bool is_update_quiet(const timer_model_t *model_ptr)
+{
+	uint32_t timer = model_ptr->timer;
+	uint8_t request_index;
+	const dma_request_t *request_ptr;
+	bool quiet = !(TIM_DIER(timer) & TIM_DIER_UIE) && !(TIM_CR1(timer) & TIM_CR1_OPM);
+
+	if (quiet && (TIM_DIER(timer) & TIM_DIER_UDE)) {
+		for (request_index = 0; request_index < (sizeof(dma_requests) / sizeof(dma_requests[0])); request_index++) {
+			request_ptr = &dma_requests[request_index];
+			if ((request_ptr->timer == timer)
+			&& (request_ptr->request == TIM_DIER_UDE)
+			&& (DMA_SCR(request_ptr->dma, request_ptr->stream) & DMA_SxCR_EN)) {
+				quiet = false;
+			}
+		}
+	}
+
+	return quiet;
+}
+
+
+/* Apply the quiet updates elapsed while no event was queued: the first one
+ * reloads prescaler and period, the others only move the period start */
+static void catch_up_timer(timer_model_t *model_ptr)
+{
+	uint32_t timer = model_ptr->timer;
+
+	if (model_ptr->running
+	&& !sim_event_is_queued(&model_ptr->event)
+	&& (time_ps >= (model_ptr->update_ps + model_ptr->period_ps))) {
+		model_ptr->update_ps += model_ptr->period_ps;
+		model_ptr->prescaler = TIM_PSC(timer);
+		model_ptr->period_ps = get_counts_ps(model_ptr, (uint64_t)TIM_ARR(timer) + 1);
+		model_ptr->update_ps += ((time_ps - model_ptr->update_ps) / model_ptr->period_ps) * model_ptr->period_ps;
+		model_ptr->cc_done = 0;
+		model_ptr->overflowing = false;
+		TIM_SR(timer) |= TIM_SR_UIF;
+	}
+}
+
+
+/* Update event: reload prescaler and period, then request DMA and interrupt */
+static void fire_update(timer_model_t *model_ptr)
+{
+	uint32_t timer = model_ptr->timer;
+
+	model_ptr->prescaler = TIM_PSC(timer);
+	model_ptr->update_ps = time_ps;
+	model_ptr->period_ps = get_counts_ps(model_ptr, (uint64_t)TIM_ARR(timer) + 1);
+	model_ptr->cc_done = 0;
+	model_ptr->overflowing = false;
+	if (!model_ptr->running) {
+		model_ptr->arr_loaded = true;
+		model_ptr->loaded_arr = TIM_ARR(timer);
+	}
+
+	TIM_SR(timer) |= TIM_SR_UIF;
+	if (TIM_DIER(timer) & TIM_DIER_UDE) {
+		dma_request(timer, TIM_DIER_UDE);
+	}
+	if (TIM_CR1(timer) & TIM_CR1_OPM) {
+		TIM_CR1(timer) &= ~TIM_CR1_CEN;
+		model_ptr->running = false;
+	}
+	if (TIM_DIER(timer) & TIM_DIER_UIE) {
+		sim_irq_raise(model_ptr->up_irq);
+	}
+}
+
+
+/* Compare event of a channel */
+static void fire_compare(timer_model_t *model_ptr, uint8_t cc_index)
+{
+	uint32_t timer = model_ptr->timer;
+
+	model_ptr->cc_done |= (uint8_t)(1 << cc_index);
+
+	TIM_SR(timer) |= (TIM_SR_CC1IF << cc_index);
+	if (TIM_DIER(timer) & (TIM_DIER_CC1DE << cc_index)) {
+		dma_request(timer, TIM_DIER_CC1DE << cc_index);
+	}
+	if (TIM_DIER(timer) & (TIM_DIER_CC1IE << cc_index)) {
+		sim_irq_raise(model_ptr->cc_irq);
+	}
+}
+
+
+/* Serve a timer DMA request on the stream wired to it */
+static void dma_request(uint32_t timer, uint32_t request)
+{
+	uint8_t request_index;
+	const dma_request_t *request_ptr;
+
+	for (request_index = 0; request_index < (sizeof(dma_requests) / sizeof(dma_requests[0])); request_index++) {
+		request_ptr = &dma_requests[request_index];
+		if ((request_ptr->timer == timer)
+		&& (request_ptr->request == request)
+		&& (DMA_SCR(request_ptr->dma, request_ptr->stream) & DMA_SxCR_EN)
+		&& ((DMA_SCR(request_ptr->dma, request_ptr->stream) & DMA_SxCR_CHSEL_MASK) == request_ptr->channel)) {
+			dma_transfer(request_ptr->dma, request_ptr->stream);
+		}
+	}
+}
+
+
+/* Move the items of one request. A write to the timer DMA burst register
+ * moves the whole burst */
+static void dma_transfer(uint32_t dma, uint8_t stream)
+{
+	uint32_t peripheral = sim_bus_address(DMA_SPAR(dma, stream));
+	const uint32_t *memory_ptr = (const uint32_t *)(uintptr_t)DMA_SM0AR(dma, stream);
+	uint16_t items = dma_items[dma == DMA2][stream];
+	uint32_t burst_length = 1;
+	uint32_t burst_index;
+	uint32_t item_index;
+	uint32_t timer;
+
+	/* timer DMA burst: redirect to the registers selected by TIM_DCR */
+	timer = peripheral - TIM_DMAR_OFFSET;
+	if ((peripheral != 0) && (get_timer_model(timer) != NULL)) {
+		burst_length = TIM_DCR_DBL(TIM_DCR(timer));
+		peripheral = timer + TIM_DCR_DBA(TIM_DCR(timer));
+	}
+
+	for (burst_index = 0;
+		(burst_index < burst_length) && (DMA_SCR(dma, stream) & DMA_SxCR_EN);
+		burst_index++) {
+		item_index = (DMA_SCR(dma, stream) & DMA_SxCR_MINC) ? (uint32_t)(items - DMA_SNDTR(dma, stream)) : 0;
+		if (peripheral != 0) {
+			sim_bus_write(peripheral + ((burst_length > 1) ? (burst_index * sizeof(uint32_t)) : 0),
+						  memory_ptr[item_index]);
+		}
+		stats.dma_transfers++;
+
+		DMA_SNDTR(dma, stream)--;
+		if (DMA_SNDTR(dma, stream) == 0) {
+			if (DMA_SCR(dma, stream) & DMA_SxCR_CIRC) {
+				DMA_SNDTR(dma, stream) = items;
+			} else {
+				DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+			}
+			if (stream < DMA_STREAM4) {
+				DMA_LISR(dma) |= DMA_TCIF << DMA_ISR_OFFSET(stream);
+			} else {
+				DMA_HISR(dma) |= DMA_TCIF << DMA_ISR_OFFSET(stream);
+			}
+		}
+	}
+}
+
+
+/* Serve pending interrupts, lowest number first, unless they are held or masked */
+static void drain_irqs(void)
+{
+	uint8_t irq;
+
+	while ((irq_hold_depth == 0) && !irq_masked && (irq_pending_num > 0)) {
+		for (irq = 0; !irq_pending[irq]; irq++) {
+		}
+		irq_pending[irq] = false;
+		irq_pending_num--;
+		stats.irq_calls[irq]++;
+
+		irq_hold_depth++;
+		/* exception entry: stacking and vector fetch */
+		sim_advance(get_cycles_ps(SIM_IRQ_ENTRY_CYCLES));
+		if (isr_table[irq] != NULL) {
+			(*isr_table[irq])();
+		}
+		irq_hold_depth--;
+	}
+}
+
+
+/* Advance the virtual clock with the firmware interrupts held */
+static void hold_core(uint64_t delta_ps)
+{
+	irq_hold_depth++;
+	sim_advance(delta_ps);
+	irq_hold_depth--;
+}
+
+
+/* Duration of a number of core cycles [ps] */
+static uint64_t get_cycles_ps(uint32_t cycles)
+{
+	return ((uint64_t)cycles * SIM_PS_PER_S) / sim_clock_get_hclk();
+}
+
+
+
+
+/* End of file */
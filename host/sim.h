@@ -0,0 +1,242 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Host simulation of the STM32F407 Discovery: virtual clock, peripheral
+ * models and run control. The firmware is built unchanged against the
+ * libopencm3 shims of this directory.
+ * Peripheral models are driven by a discrete event kernel: each model keeps
+ * its next event in a queue ordered by virtual time. Registers that move a
+ * timer event (CR1, DIER, ARR, CCRx) shall be written through the library
+ * functions, which notify the model */
+
+#ifndef _SIM_INCLUDED_             /* switch to read the header file once */
+#define _SIM_INCLUDED_             /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "histogram.h"
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Virtual clock unit conversions */
+#define SIM_PS_PER_NS				((uint64_t)1000)
+#define SIM_PS_PER_US				((uint64_t)1000000)
+#define SIM_PS_PER_S				((uint64_t)1000000000000)
+
+/* Cost of a main loop turn with nothing to do [core cycles] */
+#define SIM_IDLE_LOOP_CYCLES		((uint32_t)64)
+
+/* Exception entry latency of the core [core cycles] */
+#define SIM_IRQ_ENTRY_CYCLES		((uint32_t)12)
+
+/* Number of simulated interrupts */
+#define SIM_IRQ_NUM					91
+
+/* Size of the event queue */
+#define SIM_EVENTS_MAX				32
+
+/* Number of AHB clocks with a residency statistic */
+#define SIM_CLOCK_SPEEDS_MAX		4
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Accelerometer motion source: acceleration [mg] of each axis at a time [ns] */
+typedef void (*sim_motion_t)(uint64_t, int16_t *);
+
+/* Event of the simulation kernel, embedded in the model that schedules it */
+typedef struct sim_event {
+	uint64_t time_ps;					/* virtual time of the event */
+	uint64_t sequence;					/* scheduling order, breaks ties */
+	void (*handler)(struct sim_event *);	/* called when the event fires */
+	uint16_t heap_pos;					/* position in the queue. 0 if not queued */
+} sim_event_t;
+
+/* Trace of a RTOS callback */
+typedef struct {
+	uint64_t period_ps;					/* nominal period */
+	uint64_t set_ps;					/* time the callback was set */
+	uint64_t expired_ps;				/* time of the last expiry */
+	bool pending;						/* expired and not run yet */
+	uint64_t activations;				/* expiries since set */
+	uint64_t runs;						/* calls */
+	uint64_t overruns;					/* expiries while still pending */
+	uint64_t latency_min_ps;			/* dispatch latency from the expiring tick */
+	uint64_t latency_max_ps;
+	uint64_t latency_sum_ps;
+	int64_t lateness_min_ps;			/* run time against the nominal schedule */
+	int64_t lateness_max_ps;
+	uint64_t first_run_ps;
+	uint64_t last_run_ps;
+} sim_trace_cb_t;
+
+/* Run statistics */
+typedef struct {
+	uint64_t idle_loops;				/* main loop turns */
+	uint64_t irq_calls[SIM_IRQ_NUM];	/* service routine calls per interrupt */
+	uint64_t irq_lost;					/* requests merged into a pending one */
+	uint64_t spi_bytes;					/* SPI frames exchanged */
+	uint64_t dma_transfers;				/* DMA items moved */
+	uint64_t flash_stall_ps;			/* time the core was stalled by flash */
+	uint64_t busy_irqs;					/* competing interrupts served */
+	uint64_t busy_ps;					/* time spent in competing interrupts */
+} sim_stats_t;
+
+/* Clock tree statistics */
+typedef struct {
+	uint64_t switches;					/* AHB clock changes */
+	uint64_t errors;					/* configurations out of the limits */
+	uint32_t hclk_hz[SIM_CLOCK_SPEEDS_MAX];	/* AHB clocks run at, in order of use. 0 if unused */
+	uint64_t residency_ps[SIM_CLOCK_SPEEDS_MAX];	/* time at each of them */
+} sim_clock_stats_t;
+
+/* One-shot timers load statistics */
+typedef struct {
+	uint64_t expiries;					/* callbacks called */
+	uint64_t order_errors;				/* expiries after a later deadline */
+	uint64_t early_expiries;			/* expiries before the requested time */
+} sim_hrtimer_stats_t;
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+/* Firmware entry point: main() of main.c renamed by the host build */
+extern int firmware_main(void);
+
+/* Run control */
+extern void sim_init(void);
+extern void sim_run(uint64_t, bool);
+extern const sim_stats_t *sim_get_stats(void);
+extern void sim_set_clock_drift(int32_t);
+
+/* Event queue */
+extern void sim_event_reset(void);
+extern void sim_event_schedule(sim_event_t *, uint64_t);
+extern void sim_event_cancel(sim_event_t *);
+extern bool sim_event_is_queued(const sim_event_t *);
+extern bool sim_event_peek(uint64_t *);
+extern void sim_event_fire(void);
+extern uint64_t sim_event_get_fired(void);
+
+/* RTOS callbacks trace */
+extern void sim_trace_reset(void);
+extern const sim_trace_cb_t *sim_trace_get_callback(uint8_t);
+extern uint64_t sim_trace_get_hash(void);
+
+/* Virtual clock */
+extern uint64_t sim_get_time_ps(void);
+extern void sim_advance(uint64_t);
+extern void sim_stall(uint64_t);
+extern void sim_irq_busy(uint64_t);
+
+/* Clock tree */
+extern void sim_clock_reset(void);
+extern void sim_clock_update(void);
+extern void sim_clock_wait_ready(uint8_t);
+extern void sim_clock_wait_sysclk(uint32_t);
+extern void sim_clock_pll_config(void);
+extern uint32_t sim_clock_get_hclk(void);
+extern uint32_t sim_clock_get_pclk(bool);
+extern const sim_clock_stats_t *sim_clock_get_stats(void);
+extern uint32_t sim_get_timer_clock(uint32_t);
+extern void sim_timers_follow_clock(void);
+
+/* Timer model */
+extern void sim_timer_sync(uint32_t);
+extern void sim_timer_update(uint32_t);
+extern void sim_timer_set_counter(uint32_t);
+extern uint32_t sim_timer_get_counter(uint32_t);
+extern void sim_timer_set_compare(uint32_t, uint8_t);
+extern void sim_timer_compare(uint32_t, uint8_t);
+
+/* Interrupt controller model */
+extern void sim_irq_enable(uint8_t, bool);
+extern void sim_irq_raise(uint8_t);
+extern bool sim_irq_mask(bool);
+
+/* SPI model */
+extern uint16_t sim_spi_xfer(uint32_t, uint16_t);
+
+/* Bus and DMA model */
+extern uint32_t sim_bus_address(uint32_t);
+extern void sim_bus_write(uint32_t, uint32_t);
+extern void sim_dma_enable(uint32_t, uint8_t);
+
+/* GPIO model */
+extern void sim_gpio_write(uint32_t, uint16_t);
+extern void sim_gpio_set_input(uint32_t, uint16_t, uint16_t);
+
+/* Flash model */
+extern uint8_t *sim_flash_ptr(uint32_t);
+
+/* LIS3DSH model on SPI1 */
+extern void sim_lis3dsh_reset(void);
+extern void sim_lis3dsh_select(bool);
+extern uint8_t sim_lis3dsh_xfer(uint8_t);
+extern void sim_lis3dsh_set_motion(sim_motion_t);
+extern uint64_t sim_lis3dsh_get_samples(void);
+
+/* Competing interrupt load */
+extern void sim_load_reset(void);
+extern void sim_load_set(uint32_t, uint32_t, uint64_t);
+
+/* Tick rate switching */
+extern void sim_tick_reset(void);
+extern void sim_tick_set(uint32_t, uint32_t, uint64_t);
+extern uint64_t sim_tick_get_switches(void);
+
+/* Callbacks work load */
+extern void sim_work_reset(void);
+extern void sim_work_set(uint32_t, uint64_t);
+extern void sim_work_run(void);
+
+/* One-shot timers load */
+extern void sim_hrtimer_reset(void);
+extern void sim_hrtimer_set(uint32_t, uint64_t);
+extern const sim_hrtimer_stats_t *sim_hrtimer_get_stats(void);
+extern const histogram_t *sim_hrtimer_get_lateness(void);
+
+/* Recorded motion source */
+extern bool sim_motion_load(const char *);
+extern void sim_motion_play(uint64_t, int16_t *);
+
+
+
+
+#endif
+
+/* End of file */
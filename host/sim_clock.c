@@ -0,0 +1,396 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* Clock tree model: the system and bus clocks are decoded from the RCC
+ * registers, so the firmware runs at the clocks it actually programs.
+ * Oscillators take their startup time to get ready. The clocks out of the
+ * limits of the datasheet at 3.3V are counted as errors: a bus above its
+ * max frequency, too few flash wait states, a switch to a source not ready,
+ * an oscillator stopped while in use. The crystal frequency error applies
+ * to HSE and to the PLL on HSE */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/flash.h>
+
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Oscillators frequency [Hz] */
+#define HSI_FREQUENCY_HZ				((uint32_t)16000000)
+#define HSE_FREQUENCY_HZ				((uint32_t)8000000)
+
+/* Oscillators startup time, typical values of the datasheet [ps] */
+#define HSI_STARTUP_PS					(2 * SIM_PS_PER_US)
+#define HSE_STARTUP_PS					(2000 * SIM_PS_PER_US)
+#define PLL_STARTUP_PS					(100 * SIM_PS_PER_US)
+
+/* Max bus clocks [Hz] */
+#define AHB_MAX_HZ						((uint32_t)168000000)
+#define APB1_MAX_HZ						((uint32_t)42000000)
+#define APB2_MAX_HZ						((uint32_t)84000000)
+
+/* AHB clock for each flash wait state at 2.7-3.6V [Hz] */
+#define FLASH_WS_STEP_HZ				((uint32_t)30000000)
+
+/* Decoded clocks: AHB, APB1 and APB2 */
+#define BUS_CLOCKS_NUM					3
+
+/* PLLCFGR reset value */
+#define RCC_PLLCFGR_RESET_VALUE			((uint32_t)0x24003010)
+
+/* Number of oscillators with a startup time */
+#define OSCS_NUM						3
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Oscillator: enable and ready bits of CR, startup time */
+typedef struct {
+	uint32_t on_bit;
+	uint32_t ready_bit;
+	uint64_t startup_ps;
+} osc_t;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static uint32_t get_used_oscs(uint32_t);
+static void decode_clocks(uint32_t, int32_t, uint32_t *);
+static uint32_t get_drifted_frequency(uint32_t, int32_t);
+static uint32_t get_ahb_divider(uint32_t);
+static uint32_t get_apb_divider(uint32_t);
+static void check_limits(uint32_t);
+static void account_residency(void);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Oscillators, in order of enum rcc_osc */
+static const osc_t oscs[OSCS_NUM] = {
+	{RCC_CR_PLLON, RCC_CR_PLLRDY, PLL_STARTUP_PS},
+	{RCC_CR_HSEON, RCC_CR_HSERDY, HSE_STARTUP_PS},
+	{RCC_CR_HSION, RCC_CR_HSIRDY, HSI_STARTUP_PS}
+};
+
+/* Time each oscillator gets ready, if enabled and not ready yet [ps] */
+static uint64_t osc_ready_ps[OSCS_NUM];
+
+/* Frequency error of the HSE crystal [ppm] */
+static int32_t clock_drift_ppm;
+
+/* Decoded clocks: AHB, APB1 and APB2 [Hz] */
+static uint32_t clocks_hz[BUS_CLOCKS_NUM];
+
+/* Time of the last AHB clock change [ps] */
+static uint64_t hclk_change_ps;
+
+/* Clock statistics */
+static sim_clock_stats_t stats;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Registers at reset value: the core runs from HSI */
+void sim_clock_reset(void)
+{
+	RCC_CR = RCC_CR_HSION | RCC_CR_HSIRDY;
+	RCC_PLLCFGR = RCC_PLLCFGR_RESET_VALUE;
+	RCC_CFGR = 0;
+	FLASH_ACR = 0;
+
+	memset(osc_ready_ps, 0, sizeof(osc_ready_ps));
+	memset(&stats, 0, sizeof(stats));
+	clock_drift_ppm = 0;
+	clocks_hz[0] = HSI_FREQUENCY_HZ;
+	clocks_hz[1] = HSI_FREQUENCY_HZ;
+	clocks_hz[2] = HSI_FREQUENCY_HZ;
+	hclk_change_ps = 0;
+}
+
+
+/* Set the frequency error of the HSE crystal [ppm]. The clocks on HSE follow it */
+void sim_set_clock_drift(int32_t drift_ppm)
+{
+	clock_drift_ppm = drift_ppm;
+	sim_clock_update();
+}
+
+
+/* Decode the clocks after a write to the RCC or flash registers */
+void sim_clock_update(void)
+{
+	uint32_t switch_field = (RCC_CFGR >> RCC_CFGR_SW_SHIFT) & RCC_CFGR_SW_MASK;
+	uint32_t status_field = (RCC_CFGR >> RCC_CFGR_SWS_SHIFT) & RCC_CFGR_SW_MASK;
+	uint32_t new_clocks_hz[BUS_CLOCKS_NUM];
+	uint32_t used_oscs;
+	uint8_t osc_index;
+
+	/* an oscillator in use cannot be stopped */
+	used_oscs = get_used_oscs(status_field);
+	if ((RCC_CR & used_oscs) != used_oscs) {
+		stats.errors++;
+		RCC_CR |= used_oscs;
+	}
+
+	/* start the oscillators just enabled, stop the disabled ones */
+	for (osc_index = 0; osc_index < OSCS_NUM; osc_index++) {
+		if (!(RCC_CR & oscs[osc_index].on_bit)) {
+			RCC_CR &= ~oscs[osc_index].ready_bit;
+			osc_ready_ps[osc_index] = 0;
+		} else if (!(RCC_CR & oscs[osc_index].ready_bit) && (osc_ready_ps[osc_index] == 0)) {
+			osc_ready_ps[osc_index] = sim_get_time_ps() + oscs[osc_index].startup_ps;
+		} else {
+			/* running or starting */
+		}
+	}
+
+	/* the system clock switches to a ready source only */
+	if (switch_field != status_field) {
+		if (((switch_field == RCC_CFGR_SW_HSI) && (RCC_CR & RCC_CR_HSIRDY))
+		|| ((switch_field == RCC_CFGR_SW_HSE) && (RCC_CR & RCC_CR_HSERDY))
+		|| ((switch_field == RCC_CFGR_SW_PLL) && (RCC_CR & RCC_CR_PLLRDY))) {
+			RCC_CFGR = (RCC_CFGR & ~((uint32_t)RCC_CFGR_SW_MASK << RCC_CFGR_SWS_SHIFT))
+					 | (switch_field << RCC_CFGR_SWS_SHIFT);
+			status_field = switch_field;
+		} else {
+			stats.errors++;
+		}
+	}
+
+	decode_clocks(status_field, clock_drift_ppm, new_clocks_hz);
+	check_limits(status_field);
+
+	/* the clocks set on the way to a new speed take no time: not a switch */
+	if ((new_clocks_hz[0] != clocks_hz[0]) && (sim_get_time_ps() > hclk_change_ps)) {
+		account_residency();
+		stats.switches++;
+	}
+
+	if (memcmp(new_clocks_hz, clocks_hz, sizeof(clocks_hz)) != 0) {
+		memcpy(clocks_hz, new_clocks_hz, sizeof(clocks_hz));
+		sim_timers_follow_clock();
+	}
+}
+
+
+/* Busy wait of the core until an oscillator is ready */
+void sim_clock_wait_ready(uint8_t osc_index)
+{
+	if (osc_index >= OSCS_NUM) {
+		/* no startup time */
+	} else if (!(RCC_CR & oscs[osc_index].on_bit)) {
+		/* the firmware would wait forever */
+		stats.errors++;
+	} else if (!(RCC_CR & oscs[osc_index].ready_bit)) {
+		/* the PLL input shall be ready */
+		if ((osc_index == RCC_PLL)
+		&& !(RCC_CR & ((RCC_PLLCFGR & RCC_PLLCFGR_PLLSRC) ? RCC_CR_HSERDY : RCC_CR_HSIRDY))) {
+			stats.errors++;
+		}
+		if (osc_ready_ps[osc_index] > sim_get_time_ps()) {
+			sim_advance(osc_ready_ps[osc_index] - sim_get_time_ps());
+		}
+		RCC_CR |= oscs[osc_index].ready_bit;
+		osc_ready_ps[osc_index] = 0;
+	} else {
+		/* already ready */
+	}
+}
+
+
+/* Busy wait of the core until the system clock runs on a source */
+void sim_clock_wait_sysclk(uint32_t source)
+{
+	if (((RCC_CFGR >> RCC_CFGR_SWS_SHIFT) & RCC_CFGR_SW_MASK) != source) {
+		/* the firmware would wait forever */
+		stats.errors++;
+	}
+}
+
+
+/* A PLL configuration write: the PLL shall be off */
+void sim_clock_pll_config(void)
+{
+	if (RCC_CR & RCC_CR_PLLON) {
+		stats.errors++;
+	}
+}
+
+
+/* Get the AHB clock [Hz] */
+uint32_t sim_clock_get_hclk(void)
+{
+	return clocks_hz[0];
+}
+
+
+/* Get the APB1 or APB2 clock [Hz] */
+uint32_t sim_clock_get_pclk(bool apb2)
+{
+	return apb2 ? clocks_hz[2] : clocks_hz[1];
+}
+
+
+/* Get clock statistics: residency is accounted up to now */
+const sim_clock_stats_t *sim_clock_get_stats(void)
+{
+	account_residency();
+
+	return &stats;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Enable bits of the oscillators a system clock source runs on */
+static uint32_t get_used_oscs(uint32_t source)
+{
+	uint32_t used_oscs;
+
+	if (source == RCC_CFGR_SW_HSE) {
+		used_oscs = RCC_CR_HSEON;
+	} else if (source == RCC_CFGR_SW_PLL) {
+		used_oscs = RCC_CR_PLLON | ((RCC_PLLCFGR & RCC_PLLCFGR_PLLSRC) ? RCC_CR_HSEON : RCC_CR_HSION);
+	} else {
+		used_oscs = RCC_CR_HSION;
+	}
+
+	return used_oscs;
+}
+
+
+/* Decode AHB, APB1 and APB2 clocks of a system clock source [Hz] */
+static void decode_clocks(uint32_t source, int32_t drift_ppm, uint32_t *bus_clocks_hz)
+{
+	uint32_t pllcfgr = RCC_PLLCFGR;
+	uint32_t cfgr = RCC_CFGR;
+	uint64_t input_hz;
+	uint32_t pllm;
+	uint32_t sysclk_hz;
+
+	if (source == RCC_CFGR_SW_HSE) {
+		sysclk_hz = get_drifted_frequency(HSE_FREQUENCY_HZ, drift_ppm);
+	} else if (source == RCC_CFGR_SW_PLL) {
+		input_hz = (pllcfgr & RCC_PLLCFGR_PLLSRC) ? get_drifted_frequency(HSE_FREQUENCY_HZ, drift_ppm)
+												  : HSI_FREQUENCY_HZ;
+		pllm = (pllcfgr >> RCC_PLLCFGR_PLLM_SHIFT) & RCC_PLLCFGR_PLLM_MASK;
+		sysclk_hz = (uint32_t)((input_hz * ((pllcfgr >> RCC_PLLCFGR_PLLN_SHIFT) & RCC_PLLCFGR_PLLN_MASK))
+							   / ((uint64_t)((pllm > 0) ? pllm : 1)
+								  * (2 * (((pllcfgr >> RCC_PLLCFGR_PLLP_SHIFT) & RCC_PLLCFGR_PLLP_MASK) + 1))));
+	} else {
+		sysclk_hz = HSI_FREQUENCY_HZ;
+	}
+
+	bus_clocks_hz[0] = sysclk_hz / get_ahb_divider((cfgr >> RCC_CFGR_HPRE_SHIFT) & RCC_CFGR_HPRE_MASK);
+	bus_clocks_hz[1] = bus_clocks_hz[0] / get_apb_divider((cfgr >> RCC_CFGR_PPRE1_SHIFT) & RCC_CFGR_PPRE_MASK);
+	bus_clocks_hz[2] = bus_clocks_hz[0] / get_apb_divider((cfgr >> RCC_CFGR_PPRE2_SHIFT) & RCC_CFGR_PPRE_MASK);
+}
+
+
+/* Apply the crystal frequency error to a nominal clock frequency */
+static uint32_t get_drifted_frequency(uint32_t frequency, int32_t drift_ppm)
+{
+	return (uint32_t)(((int64_t)frequency * (1000000 + drift_ppm)) / 1000000);
+}
+
+
+/* Divider of a HPRE value: 1, then 2 to 512 skipping 32 */
+static uint32_t get_ahb_divider(uint32_t hpre)
+{
+	static const uint16_t dividers[8] = {2, 4, 8, 16, 64, 128, 256, 512};
+
+	return (hpre < RCC_CFGR_HPRE_DIV_2) ? 1 : dividers[hpre - RCC_CFGR_HPRE_DIV_2];
+}
+
+
+/* Divider of a PPRE value: 1, then 2 to 16 */
+static uint32_t get_apb_divider(uint32_t ppre)
+{
+	return (ppre < RCC_CFGR_PPRE_DIV_2) ? 1 : ((uint32_t)2 << (ppre - RCC_CFGR_PPRE_DIV_2));
+}
+
+
+/* Count a clock configuration out of the limits: the nominal clocks are
+ * checked, the crystal drift is tolerated */
+static void check_limits(uint32_t source)
+{
+	uint32_t nominal_hz[BUS_CLOCKS_NUM];
+	uint32_t required_ws;
+
+	decode_clocks(source, 0, nominal_hz);
+	required_ws = (nominal_hz[0] > 0) ? ((nominal_hz[0] - 1) / FLASH_WS_STEP_HZ) : 0;
+
+	if ((nominal_hz[0] > AHB_MAX_HZ)
+	|| (nominal_hz[1] > APB1_MAX_HZ)
+	|| (nominal_hz[2] > APB2_MAX_HZ)
+	|| ((FLASH_ACR & FLASH_ACR_LATENCY_MASK) < required_ws)) {
+		stats.errors++;
+	}
+}
+
+
+/* Add the time since the last change to the residency of the actual AHB clock */
+static void account_residency(void)
+{
+	uint64_t now_ps = sim_get_time_ps();
+	uint8_t index;
+
+	for (index = 0; (index < SIM_CLOCK_SPEEDS_MAX)
+				 && (stats.hclk_hz[index] != 0)
+				 && (stats.hclk_hz[index] != clocks_hz[0]); index++) {
+	}
+	if (index < SIM_CLOCK_SPEEDS_MAX) {
+		stats.hclk_hz[index] = clocks_hz[0];
+		stats.residency_ps[index] += now_ps - hclk_change_ps;
+	}
+	hclk_change_ps = now_ps;
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,244 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Event queue of the simulation kernel: a binary min-heap of events ordered
+ * by virtual time. Events at the same time fire in scheduling order, so runs
+ * are deterministic */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Heap position of an event not in the queue */
+#define NOT_QUEUED						((uint16_t)0)
+
+/* Heap navigation. Positions start from 1 */
+#define PARENT(pos)						((pos) >> 1)
+#define LEFT_CHILD(pos)					((pos) << 1)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Heap of queued events. Position 0 is not used */
+static sim_event_t *heap[SIM_EVENTS_MAX + 1];
+
+/* Number of queued events */
+static uint16_t heap_size;
+
+/* Scheduling order of the next event */
+static uint64_t next_sequence;
+
+/* Fired events */
+static uint64_t fired_events;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static inline bool is_before(const sim_event_t *, const sim_event_t *);
+static void place(sim_event_t *, uint16_t);
+static void sift_up(uint16_t);
+static void sift_down(uint16_t);
+static void remove_at(uint16_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Empty the queue */
+void sim_event_reset(void)
+{
+	uint16_t pos;
+
+	for (pos = 1; pos <= heap_size; pos++) {
+		heap[pos]->heap_pos = NOT_QUEUED;
+	}
+	heap_size = 0;
+	next_sequence = 0;
+	fired_events = 0;
+}
+
+
+/* Queue an event at a time, or move it if already queued */
+void sim_event_schedule(sim_event_t *event_ptr, uint64_t event_ps)
+{
+	if (event_ptr->heap_pos != NOT_QUEUED) {
+		remove_at(event_ptr->heap_pos);
+	}
+
+	if (heap_size >= SIM_EVENTS_MAX) {
+		fprintf(stderr, "sim: event queue full\n");
+		abort();
+	}
+
+	event_ptr->time_ps = event_ps;
+	event_ptr->sequence = next_sequence++;
+	heap_size++;
+	place(event_ptr, heap_size);
+	sift_up(heap_size);
+}
+
+
+/* Remove an event from the queue */
+void sim_event_cancel(sim_event_t *event_ptr)
+{
+	if (event_ptr->heap_pos != NOT_QUEUED) {
+		remove_at(event_ptr->heap_pos);
+	}
+}
+
+
+/* Check if an event is queued */
+bool sim_event_is_queued(const sim_event_t *event_ptr)
+{
+	return event_ptr->heap_pos != NOT_QUEUED;
+}
+
+
+/* Get the time of the earliest event. False if the queue is empty */
+bool sim_event_peek(uint64_t *event_ps_ptr)
+{
+	bool queued = (heap_size > 0);
+
+	if (queued) {
+		*event_ps_ptr = heap[1]->time_ps;
+	}
+
+	return queued;
+}
+
+
+/* Dequeue the earliest event and call its handler */
+void sim_event_fire(void)
+{
+	sim_event_t *event_ptr;
+
+	if (heap_size > 0) {
+		event_ptr = heap[1];
+		remove_at(1);
+		fired_events++;
+		(*event_ptr->handler)(event_ptr);
+	}
+}
+
+
+/* Get the number of fired events */
+uint64_t sim_event_get_fired(void)
+{
+	return fired_events;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Order of two events: time first, then scheduling order */
+static inline bool is_before(const sim_event_t *a_ptr, const sim_event_t *b_ptr)
+{
+	return (a_ptr->time_ps < b_ptr->time_ps)
+		|| ((a_ptr->time_ps == b_ptr->time_ps) && (a_ptr->sequence < b_ptr->sequence));
+}
+
+
+/* Store an event at a heap position */
+static void place(sim_event_t *event_ptr, uint16_t pos)
+{
+	heap[pos] = event_ptr;
+	event_ptr->heap_pos = pos;
+}
+
+
+/* Move an event up to its place */
+static void sift_up(uint16_t pos)
+{
+	sim_event_t *event_ptr = heap[pos];
+
+	while ((pos > 1) && is_before(event_ptr, heap[PARENT(pos)])) {
+		place(heap[PARENT(pos)], pos);
+		pos = PARENT(pos);
+	}
+	place(event_ptr, pos);
+}
+
+
+/* Move an event down to its place */
+static void sift_down(uint16_t pos)
+{
+	sim_event_t *event_ptr = heap[pos];
+	uint16_t child;
+
+	while ((child = LEFT_CHILD(pos)) <= heap_size) {
+		if ((child < heap_size) && is_before(heap[child + 1], heap[child])) {
+			child++;
+		}
+		if (!is_before(heap[child], event_ptr)) {
+			break;
+		}
+		place(heap[child], pos);
+		pos = child;
+	}
+	place(event_ptr, pos);
+}
+
+
+/* Remove the event at a heap position */
+static void remove_at(uint16_t pos)
+{
+	sim_event_t *last_ptr = heap[heap_size];
+
+	heap[pos]->heap_pos = NOT_QUEUED;
+	heap_size--;
+
+	if (pos <= heap_size) {
+		/* fill the hole with the last event */
+		place(last_ptr, pos);
+		if ((pos > 1) && is_before(last_ptr, heap[PARENT(pos)])) {
+			sift_up(pos);
+		} else {
+			sift_down(pos);
+		}
+	}
+}
+
+
+
+
+/* End of file */
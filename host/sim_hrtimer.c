@@ -0,0 +1,204 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* One-shot timers load: every firmware one-shot timer is started with a
+ * random delay and started again by its callback, so all of them are
+ * always queued. Each expiry is checked against the virtual clock:
+ * lateness from the requested time and order of the deadlines.
+ * The timers are first started before the firmware boots: the deadlines
+ * count from the timebase start */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hrtimer.h"
+#include "timebase.h"
+#include "histogram.h"
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* The timebase truncates to the us: a deadline can precede the requested time by up to 1 us */
+#define DEADLINE_TOLERANCE_PS			SIM_PS_PER_US
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void start_timer(uint8_t);
+static void timer_callback(uint8_t);
+static uint64_t get_random(uint64_t);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Max delay [us]. 0 if no load */
+static uint32_t delay_max_us;
+
+/* Requested expiry time of each timer [ps] */
+static uint64_t requested_ps[HRTIMER_ID_MAX_NUM];
+
+/* Requested times count from the boot, not yet from the timebase start */
+static bool boot_pending;
+
+/* Requested time of the last expiry [ps] */
+static uint64_t last_requested_ps;
+
+/* Expiries statistics */
+static sim_hrtimer_stats_t stats;
+
+/* Lateness of the expiries [ns] */
+static histogram_t lateness_histogram;
+
+/* Random generator state */
+static uint64_t random_state;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* No load */
+void sim_hrtimer_reset(void)
+{
+	delay_max_us = 0;
+	boot_pending = false;
+	last_requested_ps = 0;
+	stats.expiries = 0;
+	stats.order_errors = 0;
+	stats.early_expiries = 0;
+	histogram_reset(&lateness_histogram);
+}
+
+
+/* Start all timers with delays in [1, max] [us] */
+void sim_hrtimer_set(uint32_t max_us, uint64_t seed)
+{
+	uint8_t timer_id;
+
+	delay_max_us = max_us;
+	/* xorshift state shall not be 0 */
+	random_state = seed | 1;
+
+	if (delay_max_us > 0) {
+		for (timer_id = 0; timer_id < HRTIMER_ID_MAX_NUM; timer_id++) {
+			start_timer(timer_id);
+		}
+		boot_pending = true;
+	}
+}
+
+
+/* Get expiries statistics */
+const sim_hrtimer_stats_t *sim_hrtimer_get_stats(void)
+{
+	return &stats;
+}
+
+
+/* Get the histogram of the lateness [ns] */
+const histogram_t *sim_hrtimer_get_lateness(void)
+{
+	return &lateness_histogram;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Start a timer with a random delay */
+static void start_timer(uint8_t timer_id)
+{
+	uint32_t delay_us = 1 + (uint32_t)get_random(delay_max_us - 1);
+
+	requested_ps[timer_id] = sim_get_time_ps() + ((uint64_t)delay_us * SIM_PS_PER_US);
+	hrtimer_start(timer_id, delay_us, &timer_callback);
+}
+
+
+/* Expiry: check it against the requested time, then start the timer again */
+static void timer_callback(uint8_t timer_id)
+{
+	uint64_t now_ps = sim_get_time_ps();
+	uint64_t lateness_ns;
+	uint64_t timebase_start_ps;
+	uint8_t index;
+
+	stats.expiries++;
+
+	/* the boot takes the clock startup time: move the first requests to
+	 * the timebase start, to 1 us */
+	if (boot_pending) {
+		boot_pending = false;
+		timebase_start_ps = now_ps - (timebase_get_us() * SIM_PS_PER_US);
+		for (index = 0; index < HRTIMER_ID_MAX_NUM; index++) {
+			requested_ps[index] += timebase_start_ps;
+		}
+	}
+
+	/* an earlier deadline shall not expire after a later one */
+	if ((requested_ps[timer_id] + DEADLINE_TOLERANCE_PS) < last_requested_ps) {
+		stats.order_errors++;
+	}
+	last_requested_ps = requested_ps[timer_id];
+
+	if ((now_ps + DEADLINE_TOLERANCE_PS) < requested_ps[timer_id]) {
+		stats.early_expiries++;
+	} else {
+		lateness_ns = (now_ps > requested_ps[timer_id]) ? ((now_ps - requested_ps[timer_id]) / SIM_PS_PER_NS) : 0;
+		histogram_record(&lateness_histogram, (lateness_ns < UINT32_MAX) ? (uint32_t)lateness_ns : UINT32_MAX);
+	}
+
+	start_timer(timer_id);
+}
+
+
+/* Random value in [0, max] */
+static uint64_t get_random(uint64_t max)
+{
+	/* xorshift64* */
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return ((random_state * 0x2545F4914F6CDD1DULL) >> 11) % (max + 1);
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,287 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* LIS3DSH accelerometer model on SPI1. A new sample of the motion source is
+ * latched at the configured output data rate: by a data ready event if the
+ * data ready signal is routed to INT1, else when the outputs are read */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lis3dsh.h"
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Registers */
+#define REGS_NUM						0x40
+#define ADD_REG_WHO_AM_I				0x0F
+#define ADD_REG_CTRL_4					0x20
+#define ADD_REG_CTRL_3					0x23
+#define ADD_REG_OUT_X_L					0x28
+#define ADD_REG_OUT_Z_H					0x2D
+
+/* Reset values */
+#define WHO_AM_I_VALUE					0x3F
+#define CTRL_4_RESET_VALUE				0x07
+
+/* CTRL_3 data ready signal to INT1 enable bit */
+#define CTRL_3_DR_EN					0x80
+
+/* Read bit and address field of the command byte */
+#define CMD_READ_BIT					0x80
+#define CMD_ADDRESS_MASK				0x3F
+
+/* Orientation step period of the default motion [ns] */
+#define DEFAULT_MOTION_STEP_NS			((uint64_t)2000000000)	/* 2 s */
+
+/* Turn time of the default motion from a side to the next one [ns]: slow
+ * enough not to be taken for a tap */
+#define DEFAULT_MOTION_TURN_NS			((uint64_t)200000000)	/* 200 ms */
+
+/* Gravity [mg] */
+#define GRAVITY_MG						1000
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void data_ready_handler(sim_event_t *);
+static void latch_samples(uint64_t);
+static void schedule_data_ready(bool);
+static void default_motion(uint64_t, int16_t *);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Output data rate periods selected by CTRL_4 bits 7:4 [us]. 0 = power down */
+static const uint32_t odr_periods_us[16] = {
+	0, 320000, 160000, 80000, 40000, 20000, 10000, 2500, 1250, 625
+};
+
+/* Orientations of the default motion: the board is turned on each side */
+static const int16_t default_orientations[][3] = {
+	{GRAVITY_MG, 0, 0},
+	{0, GRAVITY_MG, 0},
+	{-GRAVITY_MG, 0, 0},
+	{0, -GRAVITY_MG, 0},
+	{0, 0, GRAVITY_MG},
+	{0, 0, -GRAVITY_MG}
+};
+
+/* Register map */
+static uint8_t registers[REGS_NUM];
+
+/* Chip is selected */
+static bool selected;
+
+/* Bytes exchanged in the actual frame */
+static uint8_t frame_bytes;
+
+/* Command of the actual frame */
+static uint8_t command;
+
+/* Data ready event */
+static sim_event_t data_ready_event = {0, 0, &data_ready_handler, 0};
+
+/* Output data rate period [ps]. 0 in power down */
+static uint64_t data_ready_period_ps;
+
+/* Time of the next sample [ps] */
+static uint64_t next_sample_ps;
+
+/* Latched samples */
+static uint64_t samples;
+
+/* Motion source. NULL selects the default motion */
+static sim_motion_t motion_ptr = NULL;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Power on reset */
+void sim_lis3dsh_reset(void)
+{
+	memset(registers, 0, sizeof(registers));
+	registers[ADD_REG_WHO_AM_I] = WHO_AM_I_VALUE;
+	registers[ADD_REG_CTRL_4] = CTRL_4_RESET_VALUE;
+	selected = false;
+	frame_bytes = 0;
+	samples = 0;
+	schedule_data_ready(true);
+}
+
+
+/* Chip select edge: a new frame starts */
+void sim_lis3dsh_select(bool select)
+{
+	selected = select;
+	frame_bytes = 0;
+}
+
+
+/* Exchange a byte: command first, then data */
+uint8_t sim_lis3dsh_xfer(uint8_t mosi)
+{
+	uint8_t miso = 0xFF;
+	uint8_t address;
+
+	if (selected) {
+		if (frame_bytes == 0) {
+			command = mosi;
+		} else {
+			address = command & CMD_ADDRESS_MASK;
+			if (command & CMD_READ_BIT) {
+				if ((address >= ADD_REG_OUT_X_L) && (address <= ADD_REG_OUT_Z_H)) {
+					latch_samples(sim_get_time_ps());
+				}
+				miso = registers[address];
+			} else if (address != ADD_REG_WHO_AM_I) {
+				/* samples of the old configuration first */
+				latch_samples(sim_get_time_ps());
+				registers[address] = mosi;
+				if ((address == ADD_REG_CTRL_4) || (address == ADD_REG_CTRL_3)) {
+					schedule_data_ready(address == ADD_REG_CTRL_4);
+				}
+			}
+		}
+		frame_bytes++;
+	}
+
+	return miso;
+}
+
+
+/* Set the motion source. NULL restores the default one */
+void sim_lis3dsh_set_motion(sim_motion_t new_motion_ptr)
+{
+	motion_ptr = new_motion_ptr;
+}
+
+
+/* Get the number of latched samples */
+uint64_t sim_lis3dsh_get_samples(void)
+{
+	latch_samples(sim_get_time_ps());
+
+	return samples;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Data ready event */
+static void data_ready_handler(sim_event_t *event_ptr)
+{
+	latch_samples(event_ptr->time_ps);
+	sim_event_schedule(&data_ready_event, next_sample_ps);
+}
+
+
+/* Latch the last sample due up to a time: the skipped ones were never read */
+static void latch_samples(uint64_t time_ps)
+{
+	sim_motion_t motion = (motion_ptr != NULL) ? motion_ptr : &default_motion;
+	int16_t values_mg[3];
+	int32_t digits;
+	uint64_t skipped;
+	uint8_t axis;
+
+	if ((data_ready_period_ps == 0) || (time_ps < next_sample_ps)) {
+		return;
+	}
+
+	skipped = (time_ps - next_sample_ps) / data_ready_period_ps;
+	(*motion)((next_sample_ps + (skipped * data_ready_period_ps)) / SIM_PS_PER_NS, values_mg);
+	for (axis = 0; axis < 3; axis++) {
+		digits = ((int32_t)values_mg[axis] << 16) / LIS3DSH_SENS_2G_MG_PER_DIGIT_Q16;
+		if (digits > INT16_MAX) {
+			digits = INT16_MAX;
+		} else if (digits < INT16_MIN) {
+			digits = INT16_MIN;
+		}
+		registers[ADD_REG_OUT_X_L + (2 * axis)] = (uint8_t)digits;
+		registers[ADD_REG_OUT_X_L + (2 * axis) + 1] = (uint8_t)((uint16_t)digits >> 8);
+	}
+	samples += skipped + 1;
+	next_sample_ps += (skipped + 1) * data_ready_period_ps;
+}
+
+
+/* Apply the configuration: restart the sampling on an output data rate
+ * change and queue the data ready events only if they are routed to INT1 */
+static void schedule_data_ready(bool restart)
+{
+	if (restart) {
+		data_ready_period_ps = (uint64_t)odr_periods_us[registers[ADD_REG_CTRL_4] >> 4] * SIM_PS_PER_US;
+		next_sample_ps = sim_get_time_ps() + data_ready_period_ps;
+	}
+
+	if ((data_ready_period_ps > 0) && (registers[ADD_REG_CTRL_3] & CTRL_3_DR_EN)) {
+		sim_event_schedule(&data_ready_event, next_sample_ps);
+	} else {
+		sim_event_cancel(&data_ready_event);
+	}
+}
+
+
+/* Default motion: the board is turned on each side in turn */
+static void default_motion(uint64_t time_ns, int16_t *values_mg)
+{
+	const uint64_t orientations_num = sizeof(default_orientations) / sizeof(default_orientations[0]);
+	uint64_t step = time_ns / DEFAULT_MOTION_STEP_NS;
+	uint64_t turn_ns = time_ns % DEFAULT_MOTION_STEP_NS;
+	const int16_t *orientation = default_orientations[step % orientations_num];
+	const int16_t *previous = default_orientations[(step + orientations_num - 1) % orientations_num];
+	uint8_t axis;
+
+	/* linear turn from the previous side, except at start */
+	if ((step == 0) || (turn_ns >= DEFAULT_MOTION_TURN_NS)) {
+		turn_ns = DEFAULT_MOTION_TURN_NS;
+	}
+	for (axis = 0; axis < 3; axis++) {
+		values_mg[axis] = (int16_t)(previous[axis] + (((int64_t)(orientation[axis] - previous[axis])
+									* (int64_t)turn_ns) / (int64_t)DEFAULT_MOTION_TURN_NS));
+	}
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,122 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Competing interrupt load model: an interrupt of higher priority than the
+ * firmware ones keeps the core busy for a random time at random intervals.
+ * The firmware interrupts raised meanwhile wait, as on a loaded system.
+ * Intervals and busy times are uniform and reproducible from a seed */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void load_handler(sim_event_t *);
+static uint64_t get_random(uint64_t);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Competing interrupt event */
+static sim_event_t load_event = {0, 0, &load_handler, 0};
+
+/* Mean interval between two interrupts [ps]. 0 if no load */
+static uint64_t interval_mean_ps;
+
+/* Max busy time of an interrupt [ps] */
+static uint64_t busy_max_ps;
+
+/* Random generator state */
+static uint64_t random_state;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* No load */
+void sim_load_reset(void)
+{
+	interval_mean_ps = 0;
+	sim_event_cancel(&load_event);
+}
+
+
+/* Start a load: intervals in [0, 2 * mean] and busy times in [0, max] [us] */
+void sim_load_set(uint32_t interval_mean_us, uint32_t busy_max_us, uint64_t seed)
+{
+	interval_mean_ps = (uint64_t)interval_mean_us * SIM_PS_PER_US;
+	busy_max_ps = (uint64_t)busy_max_us * SIM_PS_PER_US;
+	/* xorshift state shall not be 0 */
+	random_state = seed | 1;
+
+	if (interval_mean_ps > 0) {
+		sim_event_schedule(&load_event, sim_get_time_ps() + get_random(2 * interval_mean_ps));
+	} else {
+		sim_event_cancel(&load_event);
+	}
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Competing interrupt: keep the core busy, then queue the next one */
+static void load_handler(sim_event_t *event_ptr)
+{
+	(void)event_ptr;
+
+	sim_irq_busy(get_random(busy_max_ps));
+	sim_event_schedule(&load_event, sim_get_time_ps() + get_random(2 * interval_mean_ps));
+}
+
+
+/* Random value in [0, max] */
+static uint64_t get_random(uint64_t max)
+{
+	/* xorshift64* */
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return ((random_state * 0x2545F4914F6CDD1DULL) >> 11) % (max + 1);
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,159 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Recorded motion source: a CSV recording of accelerometer samples played
+ * in a loop. A line holds time [ms], X, Y and Z acceleration [mg]; lines
+ * starting with '#' are comments. Each sample holds until the next one */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Initial capacity of the recording [samples] */
+#define INITIAL_CAPACITY				1024
+
+/* Nanoseconds in a millisecond */
+#define NS_PER_MS						((uint64_t)1000000)
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Recorded sample */
+typedef struct {
+	uint64_t time_ns;
+	int16_t values_mg[3];
+} motion_sample_t;
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Recording */
+static motion_sample_t *samples;
+static size_t samples_num;
+
+/* Length of a loop of the recording [ns] */
+static uint64_t loop_ns;
+
+/* Sample played last: the model asks for increasing times */
+static size_t cursor;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Load a recording. False if the file cannot be read or holds no sample */
+bool sim_motion_load(const char *path)
+{
+	FILE *file_ptr = fopen(path, "r");
+	char line[128];
+	motion_sample_t *new_samples;
+	size_t capacity = 0;
+	unsigned long long time_ms;
+	int values_mg[3];
+
+	if (file_ptr == NULL) {
+		return false;
+	}
+
+	samples_num = 0;
+	cursor = 0;
+	while (fgets(line, sizeof(line), file_ptr) != NULL) {
+		if ((line[0] == '#')
+		|| (sscanf(line, "%llu,%d,%d,%d", &time_ms, &values_mg[0], &values_mg[1], &values_mg[2]) != 4)) {
+			/* comment, header or blank line */
+			continue;
+		}
+		if (samples_num == capacity) {
+			capacity = (capacity == 0) ? INITIAL_CAPACITY : (capacity * 2);
+			new_samples = realloc(samples, capacity * sizeof(motion_sample_t));
+			if (new_samples == NULL) {
+				fclose(file_ptr);
+				samples_num = 0;
+				return false;
+			}
+			samples = new_samples;
+		}
+		samples[samples_num].time_ns = (uint64_t)time_ms * NS_PER_MS;
+		samples[samples_num].values_mg[0] = (int16_t)values_mg[0];
+		samples[samples_num].values_mg[1] = (int16_t)values_mg[1];
+		samples[samples_num].values_mg[2] = (int16_t)values_mg[2];
+		samples_num++;
+	}
+	fclose(file_ptr);
+
+	if (samples_num == 0) {
+		return false;
+	}
+
+	/* the last sample lasts as the one before it */
+	loop_ns = samples[samples_num - 1].time_ns + 1;
+	if (samples_num > 1) {
+		loop_ns = (2 * samples[samples_num - 1].time_ns) - samples[samples_num - 2].time_ns;
+	}
+
+	return true;
+}
+
+
+/* Play the recording: acceleration [mg] of each axis at a time [ns] */
+void sim_motion_play(uint64_t time_ns, int16_t *values_mg)
+{
+	uint64_t loop_time_ns = time_ns % loop_ns;
+
+	/* the loop restarted */
+	if (loop_time_ns < samples[cursor].time_ns) {
+		cursor = 0;
+	}
+	while (((cursor + 1) < samples_num) && (samples[cursor + 1].time_ns <= loop_time_ns)) {
+		cursor++;
+	}
+
+	values_mg[0] = samples[cursor].values_mg[0];
+	values_mg[1] = samples[cursor].values_mg[1];
+	values_mg[2] = samples[cursor].values_mg[2];
+}
+
+
+
+
+/* End of file */
+
@@ -0,0 +1,904 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* libopencm3 API on the simulated registers. Functions work on the register
+ * map as the library does and notify the peripheral models of the writes
+ * with a side effect */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/spi.h>
+#include <libopencm3/stm32/flash.h>
+#include <libopencm3/stm32/f4/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* HSE oscillator frequency of the Discovery board [Hz] */
+#define HSE_FREQUENCY_HZ				((uint32_t)8000000)
+
+/* Timer registers block size [bytes] */
+#define TIM_REGS_SIZE					((uint32_t)0x50)
+
+/* SPI registers block size [bytes] */
+#define SPI_REGS_SIZE					((uint32_t)0x24)
+
+/* DMA stream registers block size [bytes] */
+#define DMA_STREAM_REGS_SIZE			((uint32_t)0x18)
+
+/* Flash sectors layout */
+#define FLASH_BASE_ADDRESS				((uint32_t)0x08000000)
+#define FLASH_SMALL_SECTORS_NUM			4
+#define FLASH_SMALL_SECTOR_BYTES		((uint32_t)0x4000)		/* 16KB */
+#define FLASH_MEDIUM_SECTOR_BYTES		((uint32_t)0x10000)		/* 64KB */
+#define FLASH_LARGE_SECTOR_BYTES		((uint32_t)0x20000)		/* 128KB */
+#define FLASH_MAX_SECTOR				11
+
+/* Flash timings at x32 parallelism, typical values of the datasheet [us] */
+#define FLASH_ERASE_SMALL_US			((uint64_t)250000)
+#define FLASH_ERASE_MEDIUM_US			((uint64_t)550000)
+#define FLASH_ERASE_LARGE_US			((uint64_t)1000000)
+#define FLASH_PROGRAM_WORD_US			((uint64_t)16)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Flash control register is unlocked */
+static bool flash_unlocked;
+
+
+
+
+/* ------------- Exported variables --------------- */
+
+/* Clock tree frequencies [Hz]: HSI after reset */
+uint32_t rcc_ahb_frequency = 16000000;
+uint32_t rcc_apb1_frequency = 16000000;
+uint32_t rcc_apb2_frequency = 16000000;
+
+/* Clock tree configurations from an 8 MHz HSE */
+const clock_scale_t hse_8mhz_3v3[CLOCK_3V3_END] = {
+	{ /* 48MHz */
+		.pllm = 8,
+		.plln = 96,
+		.pllp = 2,
+		.pllq = 2,
+		.hpre = RCC_CFGR_HPRE_DIV_NONE,
+		.ppre1 = RCC_CFGR_PPRE_DIV_4,
+		.ppre2 = RCC_CFGR_PPRE_DIV_2,
+		.power_save = 1,
+		.flash_config = FLASH_ACR_ICE | FLASH_ACR_DCE | FLASH_ACR_LATENCY_1WS,
+		.apb1_frequency = 12000000,
+		.apb2_frequency = 24000000,
+	},
+	{ /* 120MHz */
+		.pllm = 8,
+		.plln = 240,
+		.pllp = 2,
+		.pllq = 5,
+		.hpre = RCC_CFGR_HPRE_DIV_NONE,
+		.ppre1 = RCC_CFGR_PPRE_DIV_4,
+		.ppre2 = RCC_CFGR_PPRE_DIV_2,
+		.power_save = 1,
+		.flash_config = FLASH_ACR_ICE | FLASH_ACR_DCE | FLASH_ACR_LATENCY_3WS,
+		.apb1_frequency = 30000000,
+		.apb2_frequency = 60000000,
+	},
+	{ /* 168MHz */
+		.pllm = 8,
+		.plln = 336,
+		.pllp = 2,
+		.pllq = 7,
+		.hpre = RCC_CFGR_HPRE_DIV_NONE,
+		.ppre1 = RCC_CFGR_PPRE_DIV_4,
+		.ppre2 = RCC_CFGR_PPRE_DIV_2,
+		.power_save = 1,
+		.flash_config = FLASH_ACR_ICE | FLASH_ACR_DCE | FLASH_ACR_LATENCY_5WS,
+		.apb1_frequency = 42000000,
+		.apb2_frequency = 84000000,
+	},
+};
+
+
+
+
+/* ------------- RCC --------------- */
+
+/* Run the core from the PLL on HSE: the sequence of the library, HSI is
+ * stopped at the end */
+void rcc_clock_setup_hse_3v3(const clock_scale_t *clock)
+{
+	rcc_osc_on(RCC_HSI);
+	rcc_wait_for_osc_ready(RCC_HSI);
+	rcc_set_sysclk_source(RCC_CFGR_SW_HSI);
+
+	rcc_osc_on(RCC_HSE);
+	rcc_wait_for_osc_ready(RCC_HSE);
+
+	rcc_set_hpre(clock->hpre);
+	rcc_set_ppre1(clock->ppre1);
+	rcc_set_ppre2(clock->ppre2);
+	rcc_set_main_pll_hse(clock->pllm, clock->plln, clock->pllp, clock->pllq);
+
+	rcc_osc_on(RCC_PLL);
+	rcc_wait_for_osc_ready(RCC_PLL);
+
+	flash_set_ws(clock->flash_config);
+
+	rcc_set_sysclk_source(RCC_CFGR_SW_PLL);
+	rcc_wait_for_sysclk_status(RCC_PLL);
+
+	rcc_ahb_frequency = ((HSE_FREQUENCY_HZ / clock->pllm) * clock->plln) / clock->pllp;
+	rcc_apb1_frequency = clock->apb1_frequency;
+	rcc_apb2_frequency = clock->apb2_frequency;
+
+	rcc_osc_off(RCC_HSI);
+}
+
+
+/* Turn an oscillator on: it gets ready after its startup time */
+void rcc_osc_on(enum rcc_osc osc)
+{
+	if (osc == RCC_PLL) {
+		RCC_CR |= RCC_CR_PLLON;
+	} else if (osc == RCC_HSE) {
+		RCC_CR |= RCC_CR_HSEON;
+	} else if (osc == RCC_HSI) {
+		RCC_CR |= RCC_CR_HSION;
+	} else {
+		/* low speed oscillators not simulated */
+	}
+	sim_clock_update();
+}
+
+
+/* Turn an oscillator off */
+void rcc_osc_off(enum rcc_osc osc)
+{
+	if (osc == RCC_PLL) {
+		RCC_CR &= ~(uint32_t)RCC_CR_PLLON;
+	} else if (osc == RCC_HSE) {
+		RCC_CR &= ~(uint32_t)RCC_CR_HSEON;
+	} else if (osc == RCC_HSI) {
+		RCC_CR &= ~(uint32_t)RCC_CR_HSION;
+	} else {
+		/* low speed oscillators not simulated */
+	}
+	sim_clock_update();
+}
+
+
+/* Wait for an oscillator to be ready */
+void rcc_wait_for_osc_ready(enum rcc_osc osc)
+{
+	sim_clock_wait_ready((uint8_t)osc);
+}
+
+
+/* Select the system clock source */
+void rcc_set_sysclk_source(uint32_t clk)
+{
+	RCC_CFGR = (RCC_CFGR & ~((uint32_t)RCC_CFGR_SW_MASK << RCC_CFGR_SW_SHIFT)) | (clk << RCC_CFGR_SW_SHIFT);
+	sim_clock_update();
+}
+
+
+/* Wait for the system clock to run on an oscillator */
+void rcc_wait_for_sysclk_status(enum rcc_osc osc)
+{
+	if (osc == RCC_PLL) {
+		sim_clock_wait_sysclk(RCC_CFGR_SW_PLL);
+	} else if (osc == RCC_HSE) {
+		sim_clock_wait_sysclk(RCC_CFGR_SW_HSE);
+	} else {
+		sim_clock_wait_sysclk(RCC_CFGR_SW_HSI);
+	}
+}
+
+
+/* Set the AHB prescaler */
+void rcc_set_hpre(uint32_t hpre)
+{
+	RCC_CFGR = (RCC_CFGR & ~((uint32_t)RCC_CFGR_HPRE_MASK << RCC_CFGR_HPRE_SHIFT)) | (hpre << RCC_CFGR_HPRE_SHIFT);
+	sim_clock_update();
+}
+
+
+/* Set the APB1 prescaler */
+void rcc_set_ppre1(uint32_t ppre1)
+{
+	RCC_CFGR = (RCC_CFGR & ~((uint32_t)RCC_CFGR_PPRE_MASK << RCC_CFGR_PPRE1_SHIFT)) | (ppre1 << RCC_CFGR_PPRE1_SHIFT);
+	sim_clock_update();
+}
+
+
+/* Set the APB2 prescaler */
+void rcc_set_ppre2(uint32_t ppre2)
+{
+	RCC_CFGR = (RCC_CFGR & ~((uint32_t)RCC_CFGR_PPRE_MASK << RCC_CFGR_PPRE2_SHIFT)) | (ppre2 << RCC_CFGR_PPRE2_SHIFT);
+	sim_clock_update();
+}
+
+
+/* Configure the main PLL on HSE. The PLL shall be off */
+void rcc_set_main_pll_hse(uint32_t pllm, uint32_t plln, uint32_t pllp, uint32_t pllq)
+{
+	sim_clock_pll_config();
+	RCC_PLLCFGR = (pllm << RCC_PLLCFGR_PLLM_SHIFT)
+				| (plln << RCC_PLLCFGR_PLLN_SHIFT)
+				| (((pllp >> 1) - 1) << RCC_PLLCFGR_PLLP_SHIFT)
+				| RCC_PLLCFGR_PLLSRC
+				| (pllq << RCC_PLLCFGR_PLLQ_SHIFT);
+	sim_clock_update();
+}
+
+
+/* Enable a peripheral clock */
+void rcc_periph_clock_enable(enum rcc_periph_clken clken)
+{
+	MMIO32(RCC_BASE + (clken >> 5)) |= (uint32_t)1 << (clken & 0x1F);
+}
+
+
+/* Disable a peripheral clock */
+void rcc_periph_clock_disable(enum rcc_periph_clken clken)
+{
+	MMIO32(RCC_BASE + (clken >> 5)) &= ~((uint32_t)1 << (clken & 0x1F));
+}
+
+
+
+
+/* ------------- GPIO --------------- */
+
+/* Set mode and pull of some pins */
+void gpio_mode_setup(uint32_t gpioport, uint8_t mode, uint8_t pull_up_down, uint16_t gpios)
+{
+	uint8_t pin;
+
+	for (pin = 0; pin < 16; pin++) {
+		if (gpios & (1 << pin)) {
+			GPIO_MODER(gpioport) = (GPIO_MODER(gpioport) & ~((uint32_t)0x3 << (2 * pin)))
+								 | ((uint32_t)mode << (2 * pin));
+			GPIO_PUPDR(gpioport) = (GPIO_PUPDR(gpioport) & ~((uint32_t)0x3 << (2 * pin)))
+								 | ((uint32_t)pull_up_down << (2 * pin));
+		}
+	}
+}
+
+
+/* Set output type and speed of some pins */
+void gpio_set_output_options(uint32_t gpioport, uint8_t otype, uint8_t speed, uint16_t gpios)
+{
+	uint8_t pin;
+
+	if (otype == GPIO_OTYPE_OD) {
+		GPIO_OTYPER(gpioport) |= gpios;
+	} else {
+		GPIO_OTYPER(gpioport) &= ~(uint32_t)gpios;
+	}
+
+	for (pin = 0; pin < 16; pin++) {
+		if (gpios & (1 << pin)) {
+			GPIO_OSPEEDR(gpioport) = (GPIO_OSPEEDR(gpioport) & ~((uint32_t)0x3 << (2 * pin)))
+								   | ((uint32_t)speed << (2 * pin));
+		}
+	}
+}
+
+
+/* Set the alternate function of some pins */
+void gpio_set_af(uint32_t gpioport, uint8_t alt_func_num, uint16_t gpios)
+{
+	uint8_t pin;
+
+	for (pin = 0; pin < 16; pin++) {
+		if (gpios & (1 << pin)) {
+			if (pin < 8) {
+				GPIO_AFRL(gpioport) = (GPIO_AFRL(gpioport) & ~((uint32_t)0xF << (4 * pin)))
+									| ((uint32_t)alt_func_num << (4 * pin));
+			} else {
+				GPIO_AFRH(gpioport) = (GPIO_AFRH(gpioport) & ~((uint32_t)0xF << (4 * (pin - 8))))
+									| ((uint32_t)alt_func_num << (4 * (pin - 8)));
+			}
+		}
+	}
+}
+
+
+/* Set some pins */
+void gpio_set(uint32_t gpioport, uint16_t gpios)
+{
+	sim_gpio_write(gpioport, (uint16_t)(GPIO_ODR(gpioport) | gpios));
+}
+
+
+/* Clear some pins */
+void gpio_clear(uint32_t gpioport, uint16_t gpios)
+{
+	sim_gpio_write(gpioport, (uint16_t)(GPIO_ODR(gpioport) & ~gpios));
+}
+
+
+/* Toggle some pins */
+void gpio_toggle(uint32_t gpioport, uint16_t gpios)
+{
+	sim_gpio_write(gpioport, (uint16_t)(GPIO_ODR(gpioport) ^ gpios));
+}
+
+
+/* Read some pins */
+uint16_t gpio_get(uint32_t gpioport, uint16_t gpios)
+{
+	return (uint16_t)(GPIO_IDR(gpioport) & gpios);
+}
+
+
+/* Read a port */
+uint16_t gpio_port_read(uint32_t gpioport)
+{
+	return (uint16_t)GPIO_IDR(gpioport);
+}
+
+
+/* Write a port */
+void gpio_port_write(uint32_t gpioport, uint16_t data)
+{
+	sim_gpio_write(gpioport, data);
+}
+
+
+
+
+/* ------------- Timers --------------- */
+
+/* Reset a timer: registers back to reset value */
+void timer_reset(uint32_t timer_peripheral)
+{
+	uint32_t offset;
+
+	for (offset = 0; offset < TIM_REGS_SIZE; offset += sizeof(uint32_t)) {
+		MMIO32(timer_peripheral + offset) = 0;
+	}
+	TIM_ARR(timer_peripheral) = (timer_peripheral == TIM2) || (timer_peripheral == TIM5) ?
+								0xFFFFFFFF : 0xFFFF;
+	sim_timer_sync(timer_peripheral);
+}
+
+
+/* Set clock division, alignment and direction */
+void timer_set_mode(uint32_t timer_peripheral, uint32_t clock_div, uint32_t alignment, uint32_t direction)
+{
+	TIM_CR1(timer_peripheral) = (TIM_CR1(timer_peripheral) & ~((uint32_t)0x3 << 8 | (uint32_t)0x3 << 5 | TIM_CR1_DIR_DOWN))
+							  | clock_div | alignment | direction;
+}
+
+
+/* Set the prescaler: applied at next update event */
+void timer_set_prescaler(uint32_t timer_peripheral, uint32_t value)
+{
+	TIM_PSC(timer_peripheral) = value;
+}
+
+
+/* Set the auto-reload value */
+void timer_set_period(uint32_t timer_peripheral, uint32_t period)
+{
+	TIM_ARR(timer_peripheral) = period;
+	sim_timer_sync(timer_peripheral);
+}
+
+
+/* Set the repetition counter */
+void timer_set_repetition_counter(uint32_t timer_peripheral, uint32_t value)
+{
+	TIM_RCR(timer_peripheral) = value;
+}
+
+
+/* Buffer the auto-reload value */
+void timer_enable_preload(uint32_t timer_peripheral)
+{
+	TIM_CR1(timer_peripheral) |= TIM_CR1_ARPE;
+}
+
+
+/* Apply the auto-reload value at once */
+void timer_disable_preload(uint32_t timer_peripheral)
+{
+	TIM_CR1(timer_peripheral) &= ~TIM_CR1_ARPE;
+}
+
+
+/* Keep counting at update event */
+void timer_continuous_mode(uint32_t timer_peripheral)
+{
+	TIM_CR1(timer_peripheral) &= ~TIM_CR1_OPM;
+}
+
+
+/* Stop counting at update event */
+void timer_one_shot_mode(uint32_t timer_peripheral)
+{
+	TIM_CR1(timer_peripheral) |= TIM_CR1_OPM;
+}
+
+
+/* Start counting */
+void timer_enable_counter(uint32_t timer_peripheral)
+{
+	TIM_CR1(timer_peripheral) |= TIM_CR1_CEN;
+	sim_timer_sync(timer_peripheral);
+}
+
+
+/* Stop counting */
+void timer_disable_counter(uint32_t timer_peripheral)
+{
+	TIM_CR1(timer_peripheral) &= ~TIM_CR1_CEN;
+	sim_timer_sync(timer_peripheral);
+}
+
+
+/* Enable interrupt and DMA requests */
+void timer_enable_irq(uint32_t timer_peripheral, uint32_t irq)
+{
+	TIM_DIER(timer_peripheral) |= irq;
+	sim_timer_sync(timer_peripheral);
+}
+
+
+/* Disable interrupt and DMA requests */
+void timer_disable_irq(uint32_t timer_peripheral, uint32_t irq)
+{
+	TIM_DIER(timer_peripheral) &= ~irq;
+	sim_timer_sync(timer_peripheral);
+}
+
+
+/* Get a status flag */
+bool timer_get_flag(uint32_t timer_peripheral, uint32_t flag)
+{
+	/* apply the updates elapsed without an event */
+	sim_timer_sync(timer_peripheral);
+
+	return (TIM_SR(timer_peripheral) & flag) != 0;
+}
+
+
+/* Clear a status flag */
+void timer_clear_flag(uint32_t timer_peripheral, uint32_t flag)
+{
+	TIM_SR(timer_peripheral) &= ~flag;
+}
+
+
+/* Generate an event by software */
+void timer_generate_event(uint32_t timer_peripheral, uint32_t event)
+{
+	uint8_t cc_index;
+
+	if (event & TIM_EGR_UG) {
+		sim_timer_update(timer_peripheral);
+	}
+	for (cc_index = 0; cc_index < 4; cc_index++) {
+		if (event & (TIM_EGR_CC1G << cc_index)) {
+			sim_timer_compare(timer_peripheral, cc_index);
+		}
+	}
+}
+
+
+/* Read the counter */
+uint32_t timer_get_counter(uint32_t timer_peripheral)
+{
+	return sim_timer_get_counter(timer_peripheral);
+}
+
+
+/* Write the counter */
+void timer_set_counter(uint32_t timer_peripheral, uint32_t count)
+{
+	TIM_CNT(timer_peripheral) = count;
+	sim_timer_set_counter(timer_peripheral);
+}
+
+
+/* Only an overflow sets the update flag and requests interrupt and DMA */
+void timer_update_on_overflow(uint32_t timer_peripheral)
+{
+	TIM_CR1(timer_peripheral) |= TIM_CR1_URS;
+}
+
+
+/* Set the mode of an output compare */
+void timer_set_oc_mode(uint32_t timer_peripheral, enum tim_oc_id oc_id, enum tim_oc_mode oc_mode)
+{
+	uint8_t channel = (uint8_t)oc_id >> 1;
+	uint32_t shift = ((channel & 1) * 8) + 4;
+
+	if (channel < 2) {
+		TIM_CCMR1(timer_peripheral) = (TIM_CCMR1(timer_peripheral) & ~((uint32_t)0x7 << shift))
+									| ((uint32_t)oc_mode << shift);
+	} else {
+		TIM_CCMR2(timer_peripheral) = (TIM_CCMR2(timer_peripheral) & ~((uint32_t)0x7 << shift))
+									| ((uint32_t)oc_mode << shift);
+	}
+}
+
+
+/* Buffer the value of an output compare */
+void timer_enable_oc_preload(uint32_t timer_peripheral, enum tim_oc_id oc_id)
+{
+	uint8_t channel = (uint8_t)oc_id >> 1;
+	uint32_t mask = (uint32_t)1 << (((channel & 1) * 8) + 3);
+
+	if (channel < 2) {
+		TIM_CCMR1(timer_peripheral) |= mask;
+	} else {
+		TIM_CCMR2(timer_peripheral) |= mask;
+	}
+}
+
+
+/* Enable an output compare pin */
+void timer_enable_oc_output(uint32_t timer_peripheral, enum tim_oc_id oc_id)
+{
+	TIM_CCER(timer_peripheral) |= (uint32_t)1 << ((((uint8_t)oc_id >> 1) * 4) + (((uint8_t)oc_id & 1) * 2));
+}
+
+
+/* Disable an output compare pin */
+void timer_disable_oc_output(uint32_t timer_peripheral, enum tim_oc_id oc_id)
+{
+	TIM_CCER(timer_peripheral) &= ~((uint32_t)1 << ((((uint8_t)oc_id >> 1) * 4) + (((uint8_t)oc_id & 1) * 2)));
+}
+
+
+/* Set the value of an output compare */
+void timer_set_oc_value(uint32_t timer_peripheral, enum tim_oc_id oc_id, uint32_t value)
+{
+	MMIO32(timer_peripheral + 0x34 + (((uint8_t)oc_id >> 1) * sizeof(uint32_t))) = value;
+	sim_timer_set_compare(timer_peripheral, (uint8_t)oc_id >> 1);
+}
+
+
+/* Enable the outputs of an advanced timer */
+void timer_enable_break_main_output(uint32_t timer_peripheral)
+{
+	TIM_BDTR(timer_peripheral) |= TIM_BDTR_MOE;
+}
+
+
+
+
+/* ------------- DMA --------------- */
+
+/* Disable a stream and clear its configuration and flags */
+void dma_stream_reset(uint32_t dma, uint8_t stream)
+{
+	uint32_t offset;
+
+	for (offset = 0; offset < DMA_STREAM_REGS_SIZE; offset += sizeof(uint32_t)) {
+		MMIO32(DMA_STREAM(dma, stream) + offset) = 0;
+	}
+	dma_clear_interrupt_flags(dma, stream, DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF | DMA_FEIF);
+}
+
+
+/* Select the request channel of a stream */
+void dma_channel_select(uint32_t dma, uint8_t stream, uint32_t channel)
+{
+	DMA_SCR(dma, stream) = (DMA_SCR(dma, stream) & ~(uint32_t)DMA_SxCR_CHSEL_MASK) | channel;
+}
+
+
+/* Set the priority of a stream */
+void dma_set_priority(uint32_t dma, uint8_t stream, uint32_t prio)
+{
+	DMA_SCR(dma, stream) = (DMA_SCR(dma, stream) & ~(uint32_t)DMA_SxCR_PL_MASK) | prio;
+}
+
+
+/* Set the direction of a stream */
+void dma_set_transfer_mode(uint32_t dma, uint8_t stream, uint32_t direction)
+{
+	DMA_SCR(dma, stream) = (DMA_SCR(dma, stream) & ~((uint32_t)0x3 << 6)) | direction;
+}
+
+
+/* Set the memory item size of a stream */
+void dma_set_memory_size(uint32_t dma, uint8_t stream, uint32_t mem_size)
+{
+	DMA_SCR(dma, stream) = (DMA_SCR(dma, stream) & ~((uint32_t)0x3 << 13)) | mem_size;
+}
+
+
+/* Set the peripheral item size of a stream */
+void dma_set_peripheral_size(uint32_t dma, uint8_t stream, uint32_t peripheral_size)
+{
+	DMA_SCR(dma, stream) = (DMA_SCR(dma, stream) & ~((uint32_t)0x3 << 11)) | peripheral_size;
+}
+
+
+/* Increment the memory address after each item */
+void dma_enable_memory_increment_mode(uint32_t dma, uint8_t stream)
+{
+	DMA_SCR(dma, stream) |= DMA_SxCR_MINC;
+}
+
+
+/* Restart from the first item after the last one */
+void dma_enable_circular_mode(uint32_t dma, uint8_t stream)
+{
+	DMA_SCR(dma, stream) |= DMA_SxCR_CIRC;
+}
+
+
+/* Set the peripheral address of a stream */
+void dma_set_peripheral_address(uint32_t dma, uint8_t stream, uint32_t address)
+{
+	DMA_SPAR(dma, stream) = address;
+}
+
+
+/* Set the memory address of a stream */
+void dma_set_memory_address(uint32_t dma, uint8_t stream, uint32_t address)
+{
+	DMA_SM0AR(dma, stream) = address;
+}
+
+
+/* Set the number of items of a stream */
+void dma_set_number_of_data(uint32_t dma, uint8_t stream, uint16_t number)
+{
+	DMA_SNDTR(dma, stream) = number;
+}
+
+
+/* Enable a stream */
+void dma_enable_stream(uint32_t dma, uint8_t stream)
+{
+	DMA_SCR(dma, stream) |= DMA_SxCR_EN;
+	sim_dma_enable(dma, stream);
+}
+
+
+/* Disable a stream */
+void dma_disable_stream(uint32_t dma, uint8_t stream)
+{
+	DMA_SCR(dma, stream) &= ~(uint32_t)DMA_SxCR_EN;
+}
+
+
+/* Clear interrupt flags of a stream */
+void dma_clear_interrupt_flags(uint32_t dma, uint8_t stream, uint32_t interrupts)
+{
+	if (stream < DMA_STREAM4) {
+		DMA_LISR(dma) &= ~(interrupts << DMA_ISR_OFFSET(stream));
+	} else {
+		DMA_HISR(dma) &= ~(interrupts << DMA_ISR_OFFSET(stream));
+	}
+}
+
+
+/* Get an interrupt flag of a stream */
+bool dma_get_interrupt_flag(uint32_t dma, uint8_t stream, uint32_t interrupt)
+{
+	uint32_t isr = (stream < DMA_STREAM4) ? DMA_LISR(dma) : DMA_HISR(dma);
+
+	return (isr & (interrupt << DMA_ISR_OFFSET(stream))) != 0;
+}
+
+
+
+
+/* ------------- SPI --------------- */
+
+/* Reset a SPI: registers back to reset value */
+void spi_reset(uint32_t spi_peripheral)
+{
+	uint32_t offset;
+
+	for (offset = 0; offset < SPI_REGS_SIZE; offset += sizeof(uint32_t)) {
+		MMIO32(spi_peripheral + offset) = 0;
+	}
+}
+
+
+/* Configure a SPI as master */
+int spi_init_master(uint32_t spi, uint32_t br, uint32_t cpol, uint32_t cpha, uint32_t dff, uint32_t lsbfirst)
+{
+	SPI_CR1(spi) = SPI_CR1_MSTR | br | cpol | cpha | dff | lsbfirst;
+
+	return 0;
+}
+
+
+/* Enable a SPI */
+void spi_enable(uint32_t spi)
+{
+	SPI_CR1(spi) |= SPI_CR1_SPE;
+}
+
+
+/* Disable a SPI */
+void spi_disable(uint32_t spi)
+{
+	SPI_CR1(spi) &= ~(uint32_t)SPI_CR1_SPE;
+}
+
+
+/* Set the baud rate prescaler: clock divided by 2^(baudrate + 1) */
+int spi_set_baudrate_prescaler(uint32_t spi, uint8_t baudrate)
+{
+	if (baudrate > 7) {
+		return 1;
+	}
+
+	SPI_CR1(spi) = (SPI_CR1(spi) & ~(uint32_t)SPI_CR1_BAUDRATE_MASK) | ((uint32_t)baudrate << SPI_CR1_BAUDRATE_SHIFT);
+
+	return 0;
+}
+
+
+/* Send a frame and return the received one */
+uint16_t spi_xfer(uint32_t spi, uint16_t data)
+{
+	return sim_spi_xfer(spi, data);
+}
+
+
+
+
+/* ------------- Flash --------------- */
+
+/* Set wait states and caches of the flash */
+void flash_set_ws(uint32_t ws)
+{
+	FLASH_ACR = (FLASH_ACR & ~(uint32_t)FLASH_ACR_LATENCY_MASK) | ws;
+	sim_clock_update();
+}
+
+
+/* Unlock the flash control register */
+void flash_unlock(void)
+{
+	flash_unlocked = true;
+}
+
+
+/* Lock the flash control register */
+void flash_lock(void)
+{
+	flash_unlocked = false;
+}
+
+
+/* Erase a sector. The core stalls for the erase time */
+void flash_erase_sector(uint8_t sector, uint32_t program_size)
+{
+	uint32_t address;
+	uint32_t size;
+	uint64_t erase_us;
+
+	(void)program_size;
+
+	if (flash_unlocked && (sector <= FLASH_MAX_SECTOR)) {
+		if (sector < FLASH_SMALL_SECTORS_NUM) {
+			address = sector * FLASH_SMALL_SECTOR_BYTES;
+			size = FLASH_SMALL_SECTOR_BYTES;
+			erase_us = FLASH_ERASE_SMALL_US;
+		} else if (sector == FLASH_SMALL_SECTORS_NUM) {
+			address = FLASH_SMALL_SECTORS_NUM * FLASH_SMALL_SECTOR_BYTES;
+			size = FLASH_MEDIUM_SECTOR_BYTES;
+			erase_us = FLASH_ERASE_MEDIUM_US;
+		} else {
+			address = (uint32_t)(sector - FLASH_SMALL_SECTORS_NUM) * FLASH_LARGE_SECTOR_BYTES;
+			size = FLASH_LARGE_SECTOR_BYTES;
+			erase_us = FLASH_ERASE_LARGE_US;
+		}
+		memset(sim_flash_ptr(FLASH_BASE_ADDRESS + address), 0xFF, size);
+		sim_stall(erase_us * SIM_PS_PER_US);
+	}
+}
+
+
+/* Program a word: bits can only be cleared. The core stalls for the program time */
+void flash_program_word(uint32_t address, uint32_t data)
+{
+	uint32_t word;
+	uint8_t *flash_ptr = sim_flash_ptr(address);
+
+	if (flash_unlocked && (flash_ptr != NULL)) {
+		memcpy(&word, flash_ptr, sizeof(word));
+		word &= data;
+		memcpy(flash_ptr, &word, sizeof(word));
+		sim_stall(FLASH_PROGRAM_WORD_US * SIM_PS_PER_US);
+	}
+}
+
+
+
+
+/* ------------- NVIC --------------- */
+
+/* Enable an interrupt */
+void nvic_enable_irq(uint8_t irqn)
+{
+	sim_irq_enable(irqn, true);
+}
+
+
+/* Disable an interrupt */
+void nvic_disable_irq(uint8_t irqn)
+{
+	sim_irq_enable(irqn, false);
+}
+
+
+
+
+/* ------------- Core --------------- */
+
+/* Clear the interrupt mask */
+void cm_enable_interrupts(void)
+{
+	(void)sim_irq_mask(false);
+}
+
+
+/* Set the interrupt mask */
+void cm_disable_interrupts(void)
+{
+	(void)sim_irq_mask(true);
+}
+
+
+/* Set the interrupt mask to a value. Return the previous one */
+uint32_t cm_mask_interrupts(uint32_t mask)
+{
+	return sim_irq_mask(mask != 0) ? 1 : 0;
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,146 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* Tick rate switching: the RTOS tick period is switched between two values
+ * at random intervals, as an application would between active and idle.
+ * The callbacks lateness traced meanwhile shows that no deadline drifts.
+ * Intervals are uniform and reproducible from a seed */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rtos.h"
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Mean interval between two switches [ps] */
+#define SWITCH_INTERVAL_MEAN_PS			(200 * SIM_PS_PER_US * 1000)	/* 200 ms */
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void switch_handler(sim_event_t *);
+static uint64_t get_random(uint64_t);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Switch event */
+static sim_event_t switch_event = {0, 0, &switch_handler, 0};
+
+/* Tick periods to switch between [us] */
+static uint32_t tick_periods_us[2];
+
+/* Index of the actual tick period */
+static uint8_t period_index;
+
+/* Number of switches */
+static uint64_t switches;
+
+/* Random generator state */
+static uint64_t random_state;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* No switch */
+void sim_tick_reset(void)
+{
+	switches = 0;
+	sim_event_cancel(&switch_event);
+}
+
+
+/* Start switching between two tick periods [us] */
+void sim_tick_set(uint32_t period_a_us, uint32_t period_b_us, uint64_t seed)
+{
+	tick_periods_us[0] = period_a_us;
+	tick_periods_us[1] = period_b_us;
+	period_index = 1;
+	/* xorshift state shall not be 0 */
+	random_state = seed | 1;
+
+	if ((period_a_us > 0) && (period_b_us > 0)) {
+		sim_event_schedule(&switch_event, sim_get_time_ps() + get_random(2 * SWITCH_INTERVAL_MEAN_PS));
+	} else {
+		sim_event_cancel(&switch_event);
+	}
+}
+
+
+/* Get the number of switches */
+uint64_t sim_tick_get_switches(void)
+{
+	return switches;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Switch to the other tick period, then queue the next switch */
+static void switch_handler(sim_event_t *event_ptr)
+{
+	(void)event_ptr;
+
+	period_index ^= 1;
+	rtos_set_tick_period(tick_periods_us[period_index]);
+	switches++;
+
+	sim_event_schedule(&switch_event, sim_get_time_ps() + get_random(2 * SWITCH_INTERVAL_MEAN_PS));
+}
+
+
+/* Random value in [0, max] */
+static uint64_t get_random(uint64_t max)
+{
+	/* xorshift64* */
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return ((random_state * 0x2545F4914F6CDD1DULL) >> 11) % (max + 1);
+}
+
+
+
+
+/* End of file */
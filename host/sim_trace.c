@@ -0,0 +1,191 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* Trace of the RTOS callbacks schedule: dispatch latency from the expiring
+ * tick, lateness against the nominal schedule and a hash of the run order */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "port.h"
+#include "rtos.h"
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* FNV-1a 64-bit parameters */
+#define FNV_OFFSET_BASIS				((uint64_t)0xCBF29CE484222325)
+#define FNV_PRIME						((uint64_t)0x100000001B3)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Trace of each callback */
+static sim_trace_cb_t callbacks[RTOS_CB_ID_MAX_NUM];
+
+/* Hash of the callbacks run order and times */
+static uint64_t run_hash = FNV_OFFSET_BASIS;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void hash_word(uint64_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Clear the trace */
+void sim_trace_reset(void)
+{
+	memset(callbacks, 0, sizeof(callbacks));
+	run_hash = FNV_OFFSET_BASIS;
+}
+
+
+/* Get the trace of a callback. NULL if invalid */
+const sim_trace_cb_t *sim_trace_get_callback(uint8_t callback_id)
+{
+	return (callback_id < RTOS_CB_ID_MAX_NUM) ? &callbacks[callback_id] : NULL;
+}
+
+
+/* Get the hash of the callbacks run order and times */
+uint64_t sim_trace_get_hash(void)
+{
+	return run_hash;
+}
+
+
+/* A callback is scheduled: restart its nominal schedule */
+void port_trace_callback_set(uint8_t callback_id, uint32_t period_ms)
+{
+	sim_trace_cb_t *cb_ptr;
+
+	if (callback_id < RTOS_CB_ID_MAX_NUM) {
+		cb_ptr = &callbacks[callback_id];
+		cb_ptr->period_ps = (uint64_t)period_ms * SIM_PS_PER_US * 1000;
+		cb_ptr->set_ps = sim_get_time_ps();
+		cb_ptr->pending = false;
+		cb_ptr->activations = 0;
+	}
+}
+
+
+/* A callback expired in the tick interrupt */
+void port_trace_callback_expired(uint8_t callback_id)
+{
+	sim_trace_cb_t *cb_ptr;
+
+	if (callback_id < RTOS_CB_ID_MAX_NUM) {
+		cb_ptr = &callbacks[callback_id];
+		if (cb_ptr->pending) {
+			/* the previous expiry was not served yet */
+			cb_ptr->overruns++;
+		}
+		cb_ptr->pending = true;
+		cb_ptr->expired_ps = sim_get_time_ps();
+		cb_ptr->activations++;
+	}
+}
+
+
+/* A callback is called by the main loop */
+void port_trace_callback_run(uint8_t callback_id)
+{
+	sim_trace_cb_t *cb_ptr;
+	uint64_t now_ps = sim_get_time_ps();
+	uint64_t latency_ps;
+	int64_t lateness_ps;
+
+	if (callback_id < RTOS_CB_ID_MAX_NUM) {
+		cb_ptr = &callbacks[callback_id];
+		cb_ptr->pending = false;
+
+		/* dispatch latency from the expiring tick */
+		latency_ps = now_ps - cb_ptr->expired_ps;
+		if ((cb_ptr->runs == 0) || (latency_ps < cb_ptr->latency_min_ps)) {
+			cb_ptr->latency_min_ps = latency_ps;
+		}
+		if (latency_ps > cb_ptr->latency_max_ps) {
+			cb_ptr->latency_max_ps = latency_ps;
+		}
+		cb_ptr->latency_sum_ps += latency_ps;
+
+		/* lateness against the nominal schedule */
+		lateness_ps = (int64_t)(now_ps - (cb_ptr->set_ps + (cb_ptr->activations * cb_ptr->period_ps)));
+		if ((cb_ptr->runs == 0) || (lateness_ps < cb_ptr->lateness_min_ps)) {
+			cb_ptr->lateness_min_ps = lateness_ps;
+		}
+		if ((cb_ptr->runs == 0) || (lateness_ps > cb_ptr->lateness_max_ps)) {
+			cb_ptr->lateness_max_ps = lateness_ps;
+		}
+
+		if (cb_ptr->runs == 0) {
+			cb_ptr->first_run_ps = now_ps;
+		}
+		cb_ptr->last_run_ps = now_ps;
+		cb_ptr->runs++;
+
+		hash_word(now_ps);
+		hash_word(callback_id);
+
+		/* the work of the callback */
+		sim_work_run();
+	}
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Add a word to the run hash */
+static void hash_word(uint64_t word)
+{
+	uint8_t byte_index;
+
+	for (byte_index = 0; byte_index < sizeof(word); byte_index++) {
+		run_hash ^= (uint8_t)(word >> (8 * byte_index));
+		run_hash *= FNV_PRIME;
+	}
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,143 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* Callbacks work load: each RTOS callback run keeps the core busy for a
+ * number of core cycles, so its duration scales with the AHB clock. The
+ * number of cycles changes at random intervals, as the work of an
+ * application changes with its phases, and lets the clock speed governor
+ * move. Phases are uniform and reproducible from a seed */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Mean duration of a phase [ps] */
+#define PHASE_MEAN_PS					(500 * SIM_PS_PER_US * 1000)	/* 500 ms */
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void phase_handler(sim_event_t *);
+static uint64_t get_random(uint64_t);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Phase change event */
+static sim_event_t phase_event = {0, 0, &phase_handler, 0};
+
+/* Max work of a callback run [core cycles]. 0 if no work */
+static uint32_t max_cycles;
+
+/* Work of a callback run in the actual phase [core cycles] */
+static uint32_t phase_cycles;
+
+/* Random generator state */
+static uint64_t random_state;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* No work */
+void sim_work_reset(void)
+{
+	max_cycles = 0;
+	phase_cycles = 0;
+	sim_event_cancel(&phase_event);
+}
+
+
+/* Start a work load: each phase works in [0, max] cycles per callback run */
+void sim_work_set(uint32_t max_cycles_per_run, uint64_t seed)
+{
+	max_cycles = max_cycles_per_run;
+	/* xorshift state shall not be 0 */
+	random_state = seed | 1;
+
+	if (max_cycles > 0) {
+		phase_handler(&phase_event);
+	} else {
+		phase_cycles = 0;
+		sim_event_cancel(&phase_event);
+	}
+}
+
+
+/* Work of a callback run: the interrupts are served meanwhile */
+void sim_work_run(void)
+{
+	if (phase_cycles > 0) {
+		sim_advance(((uint64_t)phase_cycles * SIM_PS_PER_S) / sim_clock_get_hclk());
+	}
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Start a new phase, then queue the next one */
+static void phase_handler(sim_event_t *event_ptr)
+{
+	(void)event_ptr;
+
+	phase_cycles = (uint32_t)get_random(max_cycles);
+
+	sim_event_schedule(&phase_event, sim_get_time_ps() + get_random(2 * PHASE_MEAN_PS));
+}
+
+
+/* Random value in [0, max] */
+static uint64_t get_random(uint64_t max)
+{
+	/* xorshift64* */
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return ((random_state * 0x2545F4914F6CDD1DULL) >> 11) % (max + 1);
+}
+
+
+
+
+/* End of file */
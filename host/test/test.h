@@ -0,0 +1,118 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Host test suite of the firmware modules. Each case runs in its own
+ * process on a fresh simulated board, as the fleet boards do, so no module
+ * state leaks from a case to the next one. A case reports each failed check
+ * and may print measured values as key=value lines */
+
+#ifndef _TEST_INCLUDED_            /* switch to read the header file once */
+#define _TEST_INCLUDED_            /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported macros ------------- */
+
+/* Check a condition: a false one fails the case, which goes on running */
+#define TEST_CHECK(cond)				test_check((cond), #cond, __FILE__, __LINE__)
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Test case */
+typedef struct {
+	const char *name;
+	void (*run)(void);
+} test_case_t;
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+/* Runner */
+extern void test_check(bool, const char *, const char *, int);
+extern void test_report(const char *, double);
+
+/* Cases: BAM outputs */
+extern void test_bam_planes(void);
+extern void test_bam_periods(void);
+extern void test_bam_on_time(void);
+
+/* Cases: calibration */
+extern void test_calib_six_positions(void);
+
+/* Cases: capture engine */
+extern void test_capture_back_to_back(void);
+
+/* Cases: clock speed changes */
+extern void test_clock_states(void);
+extern void test_clock_notify_rates(void);
+
+/* Cases: gesture detector */
+extern void test_gesture_replay(void);
+
+/* Cases: histogram */
+extern void test_histogram_percentiles(void);
+extern void test_histogram_extremes(void);
+
+/* Cases: pattern sequencer */
+extern void test_pattern_start_in_batch(void);
+
+/* Cases: pedometer */
+extern void test_pedo_walks(void);
+extern void test_pedo_keep_count(void);
+
+/* Cases: PWM driver */
+extern void test_pwm_burst(void);
+extern void test_pwm_redundant_writes(void);
+extern void test_pwm_init_table(void);
+extern void test_pwm_full_scale(void);
+extern void test_pwm_dithering(void);
+
+/* Cases: tick period changes */
+extern void test_tick_switch_deadlines(void);
+extern void test_tick_led_catch_up(void);
+
+/* Cases: timebase */
+extern void test_timebase_wrap(void);
+
+
+
+
+#endif
+
+/* End of file */
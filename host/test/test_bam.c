@@ -0,0 +1,265 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+
+/* BAM outputs on the simulated TIM1, DMA2 and GPIO ports. The bit planes
+ * and periods streamed by DMA are read through the stream registers, and
+ * the time each pin is on over a frame is sampled on the port */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
+
+#include "clock.h"
+#include "bam.h"
+#include "sim.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* DMA2 stream of the periods: TIM1 update request */
+#define PERIODS_STREAM					DMA_STREAM5
+
+/* Number of LSB times of a frame */
+#define FRAME_LSBS						((uint32_t)BAM_MAX_LEVEL)
+
+/* Accepted error of the frame frequency [permille] */
+#define MAX_FREQ_ERROR_PERMILLE			10
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void set_levels(void);
+static uint32_t get_lsb_counts(void);
+static uint32_t get_frame_mhz(void);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Level of each channel: zero, full scale, single bits and mixed bits */
+static const uint16_t levels[BAM_CFG_CH_NUM] = {
+	0, BAM_MAX_LEVEL, 1, 2, 0x80, 0xA5, 0x5A, 0x7F, 0x81, 0x33, 0xCC, 0x0F, 0xF0, 100
+};
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Each plane word of a port sets the pins of the channels with the plane
+ * bit, resets the others and leaves the pins out of the table alone */
+void test_bam_planes(void)
+{
+	const bam_cfg_channel_t *ch_ptr;
+	const uint32_t *planes_ptr;
+	uint32_t table_pins[BAM_CFG_KE_PORT_MAX_NUM] = {0};
+	uint32_t set_mask;
+	uint32_t reset_mask;
+	uint8_t port_index;
+	uint8_t plane_index;
+	uint8_t ch_index;
+	uint16_t bad_words = 0;
+
+	clock_setup();
+	bam_init();
+	set_levels();
+
+	for (ch_index = 0; ch_index < BAM_CFG_CH_NUM; ch_index++) {
+		TEST_CHECK(bam_get_level(ch_index) == levels[ch_index]);
+		table_pins[bam_cfg_channels[ch_index].port] |= (uint32_t)1 << bam_cfg_channels[ch_index].pin_number;
+	}
+
+	for (port_index = 0; port_index < BAM_CFG_KE_PORT_MAX_NUM; port_index++) {
+		planes_ptr = (const uint32_t *)(uintptr_t)DMA_SM0AR(DMA2, bam_cfg_ports[port_index].dma_stream);
+		for (plane_index = 0; plane_index < BAM_CFG_BITS; plane_index++) {
+			set_mask = 0;
+			reset_mask = 0;
+			for (ch_index = 0; ch_index < BAM_CFG_CH_NUM; ch_index++) {
+				ch_ptr = &bam_cfg_channels[ch_index];
+				if (ch_ptr->port == port_index) {
+					if ((levels[ch_index] & (1 << plane_index)) != 0) {
+						set_mask |= (uint32_t)1 << ch_ptr->pin_number;
+					} else {
+						reset_mask |= (uint32_t)1 << ch_ptr->pin_number;
+					}
+				}
+			}
+			if (planes_ptr[plane_index] != (set_mask | (reset_mask << 16))) {
+				bad_words++;
+			}
+		}
+		/* streamed to the port set/reset register, a plane per update */
+		TEST_CHECK(DMA_SPAR(DMA2, bam_cfg_ports[port_index].dma_stream)
+				   == (uint32_t)(uintptr_t)&GPIO_BSRR(bam_cfg_ports[port_index].gpio_port));
+		TEST_CHECK(DMA_SNDTR(DMA2, bam_cfg_ports[port_index].dma_stream) <= BAM_CFG_BITS);
+	}
+	TEST_CHECK(0 == bad_words);
+	test_report("bad_plane_words", bad_words);
+}
+
+
+/* Plane k lasts 2^k LSB times: the periods stream is ahead of two planes,
+ * as a period is loaded at the update event after the one it is written at.
+ * The frame frequency holds across a clock speed change */
+void test_bam_periods(void)
+{
+	const uint32_t *periods_ptr;
+	uint32_t lsb_counts;
+	uint32_t frame_mhz;
+	uint8_t plane_index;
+	uint8_t speed_index;
+
+	clock_setup();
+	bam_init();
+
+	for (speed_index = 0; speed_index < CLOCK_CFG_KE_SPEED_MAX_NUM; speed_index++) {
+		clock_set_speed(speed_index);
+		bam_update_clock();
+
+		periods_ptr = (const uint32_t *)(uintptr_t)DMA_SM0AR(DMA2, PERIODS_STREAM);
+		lsb_counts = get_lsb_counts();
+		for (plane_index = 0; plane_index < BAM_CFG_BITS; plane_index++) {
+			TEST_CHECK((periods_ptr[(plane_index + BAM_CFG_BITS - 2) % BAM_CFG_BITS] + 1) == (lsb_counts << plane_index));
+		}
+		TEST_CHECK(DMA_SPAR(DMA2, PERIODS_STREAM) == (uint32_t)(uintptr_t)&TIM_ARR(TIM1));
+
+		/* the longest plane fits the 16-bit timer */
+		TEST_CHECK((lsb_counts << (BAM_CFG_BITS - 1)) <= 0x10000);
+		frame_mhz = get_frame_mhz();
+		TEST_CHECK((frame_mhz * 1000) <= (BAM_CFG_FRAME_FREQ_HZ * 1000 * (1000 + MAX_FREQ_ERROR_PERMILLE)));
+		TEST_CHECK((frame_mhz * 1000) >= (BAM_CFG_FRAME_FREQ_HZ * 1000 * (1000 - MAX_FREQ_ERROR_PERMILLE)));
+		test_report((speed_index == 0) ? "frame_hz_168mhz" : ((speed_index == 1) ? "frame_hz_84mhz" : "frame_hz_16mhz"),
+					(double)frame_mhz / 1000.0);
+	}
+}
+
+
+/* Sampled at the middle of each LSB time of the first frame, each pin is on
+ * for as many LSB times as its level */
+void test_bam_on_time(void)
+{
+	const bam_cfg_channel_t *ch_ptr;
+	uint64_t start_ps;
+	uint64_t lsb_ps_x2;
+	uint32_t on_lsbs[BAM_CFG_CH_NUM] = {0};
+	uint32_t lsb_index;
+	uint16_t odr;
+	uint8_t ch_index;
+	uint16_t bad_channels = 0;
+
+	clock_setup();
+	bam_init();
+	set_levels();
+	/* counter starts at init */
+	start_ps = sim_get_time_ps();
+	lsb_ps_x2 = ((uint64_t)get_lsb_counts() * (TIM_PSC(TIM1) + 1) * SIM_PS_PER_S * 2)
+			  / sim_get_timer_clock(TIM1);
+
+	for (lsb_index = 0; lsb_index < FRAME_LSBS; lsb_index++) {
+		sim_advance(start_ps + ((((2 * (uint64_t)lsb_index) + 1) * lsb_ps_x2) / 4) - sim_get_time_ps());
+		for (ch_index = 0; ch_index < BAM_CFG_CH_NUM; ch_index++) {
+			ch_ptr = &bam_cfg_channels[ch_index];
+			odr = (uint16_t)GPIO_ODR(bam_cfg_ports[ch_ptr->port].gpio_port);
+			if ((odr & (1 << ch_ptr->pin_number)) != 0) {
+				on_lsbs[ch_index]++;
+			}
+		}
+	}
+
+	for (ch_index = 0; ch_index < BAM_CFG_CH_NUM; ch_index++) {
+		if (on_lsbs[ch_index] != levels[ch_index]) {
+			bad_channels++;
+		}
+	}
+	TEST_CHECK(0 == bad_channels);
+	test_report("bad_channels", bad_channels);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Set the level of each channel */
+static void set_levels(void)
+{
+	uint8_t ch_index;
+
+	for (ch_index = 0; ch_index < BAM_CFG_CH_NUM; ch_index++) {
+		bam_set_level(ch_index, levels[ch_index]);
+	}
+}
+
+
+/* Get the LSB time [counts]: the shortest period streamed */
+static uint32_t get_lsb_counts(void)
+{
+	const uint32_t *periods_ptr = (const uint32_t *)(uintptr_t)DMA_SM0AR(DMA2, PERIODS_STREAM);
+	uint32_t lsb_counts = UINT32_MAX;
+	uint8_t plane_index;
+
+	for (plane_index = 0; plane_index < BAM_CFG_BITS; plane_index++) {
+		if ((periods_ptr[plane_index] + 1) < lsb_counts) {
+			lsb_counts = periods_ptr[plane_index] + 1;
+		}
+	}
+
+	return lsb_counts;
+}
+
+
+/* Get the frame frequency [mHz] from the periods and the timer clock */
+static uint32_t get_frame_mhz(void)
+{
+	const uint32_t *periods_ptr = (const uint32_t *)(uintptr_t)DMA_SM0AR(DMA2, PERIODS_STREAM);
+	uint64_t frame_counts = 0;
+	uint8_t plane_index;
+
+	for (plane_index = 0; plane_index < BAM_CFG_BITS; plane_index++) {
+		frame_counts += (uint64_t)periods_ptr[plane_index] + 1;
+	}
+	frame_counts *= (uint64_t)TIM_PSC(TIM1) + 1;
+
+	return (uint32_t)(((uint64_t)sim_get_timer_clock(TIM1) * 1000) / frame_counts);
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,206 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+
+/* Six-position calibration on the simulated board. The sensor has a known
+ * gain and offset error on each axis; the user button starts a calibration
+ * and the board is then placed with each axis up and down. The estimated
+ * correction shall be stored, survive a reload and cancel the errors */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <libopencm3/stm32/gpio.h>
+
+#include "lis3dsh.h"
+#include "calib.h"
+#include "sim.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Number of axis */
+#define NUM_OF_AXIS						3
+
+/* Button press: time and length [ps] */
+#define PRESS_PS						((uint64_t)1000 * SIM_PS_PER_US * 1000)	/* 1 s */
+#define PRESS_LENGTH_PS					((uint64_t)200 * SIM_PS_PER_US * 1000)	/* 200 ms */
+
+/* Positions: start and time held in each one [ns] */
+#define POSITIONS_START_NS				((uint64_t)2000 * 1000000)	/* 2 s */
+#define POSITION_NS						((uint64_t)2000 * 1000000)	/* 2 s */
+
+/* Number of positions */
+#define POSITIONS_NUM					(NUM_OF_AXIS * 2)
+
+/* Virtual run time: all the positions and the storage [ps] */
+#define RUN_PS							((uint64_t)20 * SIM_PS_PER_S)
+
+/* Sensor noise of each axis: +/- this value [mg] */
+#define NOISE_MG						4
+
+/* Accepted error of a calibrated reading [mg] */
+#define MAX_ERROR_MG					10
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void button_handler(sim_event_t *);
+static void six_positions(uint64_t, int16_t *);
+static int32_t get_random(int32_t, int32_t);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Sensor errors of each axis: reading = true * gain + offset */
+static const int32_t gains_permille[NUM_OF_AXIS] = {1060, 950, 1030};
+static const int32_t offsets_mg[NUM_OF_AXIS] = {45, -30, 60};
+
+/* Board positions in turn: gravity [mg] */
+static const int16_t positions_mg[POSITIONS_NUM][NUM_OF_AXIS] = {
+	{1000, 0, 0},
+	{-1000, 0, 0},
+	{0, 1000, 0},
+	{0, -1000, 0},
+	{0, 0, 1000},
+	{0, 0, -1000}
+};
+
+/* Button press and release event */
+static sim_event_t button_event = {0, 0, &button_handler, 0};
+
+/* Button level */
+static bool button_pressed;
+
+/* Random generator state */
+static uint64_t random_state = 1;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Run the calibration from the button, then check the corrected readings */
+void test_calib_six_positions(void)
+{
+	const int16_t *last_position_ptr = positions_mg[POSITIONS_NUM - 1];
+	const sim_stats_t *stats_ptr;
+	uint8_t axis_index;
+	int32_t error_mg;
+	int32_t max_error_mg = 0;
+
+	sim_lis3dsh_set_motion(&six_positions);
+	button_pressed = false;
+	sim_event_schedule(&button_event, PRESS_PS);
+	sim_run(RUN_PS, true);
+	stats_ptr = sim_get_stats();
+
+	TEST_CHECK(CALIB_KE_DONE == calib_get_status());
+	/* the sector was erased */
+	TEST_CHECK(stats_ptr->flash_stall_ps > 0);
+
+	/* the stored record is loaded again */
+	calib_init();
+	TEST_CHECK(CALIB_KE_DONE == calib_get_status());
+
+	/* board is left in the last position */
+	for (axis_index = 0; axis_index < NUM_OF_AXIS; axis_index++) {
+		error_mg = (int32_t)lis3dsh_readAxis(axis_index) - last_position_ptr[axis_index];
+		error_mg = (error_mg < 0) ? -error_mg : error_mg;
+		if (error_mg > max_error_mg) {
+			max_error_mg = error_mg;
+		}
+	}
+	TEST_CHECK(max_error_mg <= MAX_ERROR_MG);
+
+	test_report("max_error_mg", (double)max_error_mg);
+	test_report("flash_stall_s", (double)stats_ptr->flash_stall_ps / SIM_PS_PER_S);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Press the user button, then release it */
+static void button_handler(sim_event_t *event_ptr)
+{
+	(void)event_ptr;
+
+	button_pressed = !button_pressed;
+	sim_gpio_set_input(GPIOA, GPIO0, button_pressed ? GPIO0 : 0);
+	if (button_pressed) {
+		sim_event_schedule(&button_event, sim_get_time_ps() + PRESS_LENGTH_PS);
+	}
+}
+
+
+/* Board at rest on the last position before the calibration, then in each
+ * position in turn, as read by a sensor with gain and offset errors */
+static void six_positions(uint64_t time_ns, int16_t *values_mg)
+{
+	uint64_t position_index = POSITIONS_NUM - 1;
+	uint8_t axis_index;
+
+	if (time_ns >= POSITIONS_START_NS) {
+		position_index = (time_ns - POSITIONS_START_NS) / POSITION_NS;
+		if (position_index >= POSITIONS_NUM) {
+			position_index = POSITIONS_NUM - 1;
+		}
+	}
+
+	for (axis_index = 0; axis_index < NUM_OF_AXIS; axis_index++) {
+		values_mg[axis_index] = (int16_t)(((positions_mg[position_index][axis_index] * gains_permille[axis_index]) / 1000)
+										  + offsets_mg[axis_index] + get_random(-NOISE_MG, NOISE_MG));
+	}
+}
+
+
+/* Random value in [min, max] */
+static int32_t get_random(int32_t min, int32_t max)
+{
+	/* xorshift64* */
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return min + (int32_t)(((random_state * 0x2545F4914F6CDD1DULL) >> 11) % (uint64_t)(max - min + 1));
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,131 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+
+/* Capture engine on triggers closer than a capture length. Each sample is
+ * tagged with its running index, so a capture is checked sample by sample:
+ * it must hold the full pre-trigger window and no gap */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "capture.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Back-to-back captures: all the slots but the acquiring one */
+#define CAPTURES_NUM					(CAPTURE_SLOTS_NUM - 1)
+
+/* First trigger: sample index */
+#define FIRST_TRIGGER_INDEX				((int16_t)(CAPTURE_PRE_SAMPLES + 5))
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Running index of the next sample */
+static int16_t sample_counter;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void feed(void);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Trigger again on the first sample after each capture, then check each one */
+void test_capture_back_to_back(void)
+{
+	int16_t trigger_index[CAPTURES_NUM];
+	uint8_t capture_index;
+	uint8_t slot_index;
+	uint16_t sample_index;
+	uint16_t bad_samples;
+	capture_sample_t sample;
+
+	capture_init();
+	sample_counter = 0;
+
+	while (sample_counter < FIRST_TRIGGER_INDEX) {
+		feed();
+	}
+	for (capture_index = 0; capture_index < CAPTURES_NUM; capture_index++) {
+		feed();
+		trigger_index[capture_index] = sample_counter - 1;
+		capture_trigger();
+		/* a rejected trigger never completes */
+		for (sample_index = 0; (sample_index < CAPTURE_SAMPLES) && !capture_is_ready(capture_index); sample_index++) {
+			feed();
+		}
+	}
+
+	/* buffers are taken in order, so slot i holds capture i */
+	for (slot_index = 0; slot_index < CAPTURES_NUM; slot_index++) {
+		TEST_CHECK(capture_is_ready(slot_index));
+		bad_samples = 0;
+		for (sample_index = 0; sample_index < CAPTURE_SAMPLES; sample_index++) {
+			if (!capture_read_sample(slot_index, sample_index, &sample)
+			|| (sample.x != (trigger_index[slot_index] - CAPTURE_PRE_SAMPLES + (int16_t)sample_index))) {
+				bad_samples++;
+			}
+		}
+		TEST_CHECK(0 == bad_samples);
+	}
+
+	test_report("captures", CAPTURES_NUM);
+	test_report("trigger_gap_samples", (double)(trigger_index[1] - trigger_index[0]));
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Feed the next tagged sample */
+static void feed(void)
+{
+	capture_process_sample(sample_counter, 0, 1000);
+	sample_counter++;
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,237 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Clock speed changes on the simulated clock tree. Each speed of each RTOS
+ * state, reached from each other speed, shall program legal PLL, bus and
+ * flash wait states values. After each change the drivers of
+ * clock_cfg_notify_array shall run at their nominal rates: timebase, tick,
+ * PWM and SPI clock */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/flash.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/spi.h>
+#include <libopencm3/stm32/f4/nvic.h>
+
+#include "clock.h"
+#include "timebase.h"
+#include "rtos.h"
+#include "rtos_cfg.h"
+#include "led.h"
+#include "lis3dsh.h"
+#include "sim.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Limits of the datasheet at 3.3V [Hz] */
+#define HSE_HZ							((uint32_t)8000000)
+#define VCO_INPUT_MIN_HZ				((uint32_t)1000000)
+#define VCO_INPUT_MAX_HZ				((uint32_t)2000000)
+#define VCO_OUTPUT_MIN_HZ				((uint32_t)100000000)
+#define VCO_OUTPUT_MAX_HZ				((uint32_t)432000000)
+#define PLL48_MAX_HZ					((uint32_t)48000000)
+#define AHB_MAX_HZ						((uint32_t)168000000)
+#define APB1_MAX_HZ						((uint32_t)42000000)
+#define APB2_MAX_HZ						((uint32_t)84000000)
+
+/* AHB clock for each flash wait state at 2.7-3.6V [Hz] */
+#define FLASH_WS_STEP_HZ				((uint32_t)30000000)
+
+/* Nominal rates of the notified drivers */
+#define PWM_FREQ_HZ						1000.0
+#define PWM_FREQ_TOLERANCE_HZ			0.5
+#define SPI_MAX_CLOCK_HZ				((uint32_t)1312500)
+
+/* Time each speed is measured [ps] */
+#define MEASURE_PS						(100 * SIM_PS_PER_US * 1000)	/* 100 ms */
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void check_clock_tree(uint8_t);
+static void check_driver_rates(void);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Reach the speed of each RTOS state from each speed: all of them for a
+ * state governed by the load */
+void test_clock_states(void)
+{
+	uint8_t state;
+	uint8_t speed;
+	uint8_t prev_speed;
+
+	clock_setup();
+	check_clock_tree(CLOCK_CFG_KE_SPEED_168MHZ);
+
+	for (state = 0; state < RTOS_CFG_KE_STATE_MAX_NUM; state++) {
+		TEST_CHECK((rtos_cfg_states_speed_array[state] < CLOCK_CFG_KE_SPEED_MAX_NUM)
+				|| (rtos_cfg_states_speed_array[state] == CLOCK_SPEED_AUTO));
+		for (speed = 0; speed < CLOCK_CFG_KE_SPEED_MAX_NUM; speed++) {
+			if ((rtos_cfg_states_speed_array[state] != CLOCK_SPEED_AUTO)
+			&& (rtos_cfg_states_speed_array[state] != speed)) {
+				continue;
+			}
+			for (prev_speed = 0; prev_speed < CLOCK_CFG_KE_SPEED_MAX_NUM; prev_speed++) {
+				clock_set_speed(prev_speed);
+				clock_set_speed(speed);
+				check_clock_tree(speed);
+			}
+		}
+	}
+
+	/* no configuration out of the limits, also in the middle of a switch */
+	TEST_CHECK(sim_clock_get_stats()->errors == 0);
+	test_report("switches", (double)sim_clock_get_stats()->switches);
+}
+
+
+/* Change speed with the clocked drivers running: each of them shall keep its rate */
+void test_clock_notify_rates(void)
+{
+	uint8_t speed;
+	uint8_t prev_speed;
+
+	clock_setup();
+	timebase_setup();
+	led_init();
+	lis3dsh_init();
+	rtos_start_operation(RTOS_CFG_KE_NORMAL_STATE);
+
+	for (prev_speed = 0; prev_speed < CLOCK_CFG_KE_SPEED_MAX_NUM; prev_speed++) {
+		for (speed = 0; speed < CLOCK_CFG_KE_SPEED_MAX_NUM; speed++) {
+			clock_set_speed(prev_speed);
+			sim_advance(MEASURE_PS);
+			clock_set_speed(speed);
+			check_driver_rates();
+		}
+	}
+
+	TEST_CHECK(sim_clock_get_stats()->errors == 0);
+	test_report("switches", (double)sim_clock_get_stats()->switches);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Check the clock tree programmed for a speed against its configuration and the limits */
+static void check_clock_tree(uint8_t speed)
+{
+	const clock_cfg_speed_t *speed_ptr = &clock_cfg_speeds[speed];
+	uint32_t pllcfgr = RCC_PLLCFGR;
+	uint32_t pllm = (pllcfgr >> RCC_PLLCFGR_PLLM_SHIFT) & RCC_PLLCFGR_PLLM_MASK;
+	uint32_t plln = (pllcfgr >> RCC_PLLCFGR_PLLN_SHIFT) & RCC_PLLCFGR_PLLN_MASK;
+	uint32_t pllp = 2 * (((pllcfgr >> RCC_PLLCFGR_PLLP_SHIFT) & RCC_PLLCFGR_PLLP_MASK) + 1);
+	uint32_t pllq = (pllcfgr >> RCC_PLLCFGR_PLLQ_SHIFT) & RCC_PLLCFGR_PLLQ_MASK;
+	uint32_t wait_states = FLASH_ACR & FLASH_ACR_LATENCY_MASK;
+	uint32_t hclk_hz = sim_clock_get_hclk();
+	uint64_t vco_in_hz;
+	uint64_t vco_out_hz;
+
+	/* the PLL keeps the setup configuration at all speeds: it shall be legal */
+	TEST_CHECK(pllcfgr & RCC_PLLCFGR_PLLSRC);
+	TEST_CHECK((pllm >= 2) && (pllq >= 2));
+	if ((pllm >= 2) && (pllq >= 2)) {
+		vco_in_hz = HSE_HZ / pllm;
+		vco_out_hz = vco_in_hz * plln;
+		TEST_CHECK((vco_in_hz >= VCO_INPUT_MIN_HZ) && (vco_in_hz <= VCO_INPUT_MAX_HZ));
+		TEST_CHECK((vco_out_hz >= VCO_OUTPUT_MIN_HZ) && (vco_out_hz <= VCO_OUTPUT_MAX_HZ));
+		TEST_CHECK((vco_out_hz / pllp) <= AHB_MAX_HZ);
+		TEST_CHECK((vco_out_hz / pllq) <= PLL48_MAX_HZ);
+	}
+
+	/* the PLL runs only when it clocks the core */
+	TEST_CHECK(((RCC_CR & RCC_CR_PLLON) != 0) == (speed_ptr->sysclk_source == RCC_CFGR_SW_PLL));
+
+	/* bus clocks decoded from the registers */
+	TEST_CHECK(hclk_hz == speed_ptr->ahb_frequency);
+	TEST_CHECK(sim_clock_get_pclk(false) == speed_ptr->apb1_frequency);
+	TEST_CHECK(sim_clock_get_pclk(true) == speed_ptr->apb2_frequency);
+	TEST_CHECK(hclk_hz <= AHB_MAX_HZ);
+	TEST_CHECK(sim_clock_get_pclk(false) <= APB1_MAX_HZ);
+	TEST_CHECK(sim_clock_get_pclk(true) <= APB2_MAX_HZ);
+	TEST_CHECK(rcc_ahb_frequency == hclk_hz);
+
+	/* enough flash wait states, and no more */
+	TEST_CHECK(hclk_hz <= ((wait_states + 1) * FLASH_WS_STEP_HZ));
+	TEST_CHECK((wait_states == 0) || (hclk_hz > (wait_states * FLASH_WS_STEP_HZ)));
+	TEST_CHECK((FLASH_ACR & (FLASH_ACR_ICE | FLASH_ACR_DCE)) == (FLASH_ACR_ICE | FLASH_ACR_DCE));
+}
+
+
+/* Check the rates of the drivers of clock_cfg_notify_array, measured over a while */
+static void check_driver_rates(void)
+{
+	const sim_stats_t *stats_ptr = sim_get_stats();
+	uint64_t start_us = timebase_get_us();
+	uint64_t start_ticks = stats_ptr->irq_calls[NVIC_TIM2_IRQ];
+	uint32_t spi_clock_hz;
+	uint32_t tick_counts;
+	double pwm_freq_hz;
+
+	/* timebase: 1 MHz */
+	TEST_CHECK((sim_get_timer_clock(TIM5) / (TIM_PSC(TIM5) + 1)) == TIMEBASE_FREQUENCY_HZ);
+
+	/* tick: the period of the RTOS */
+	tick_counts = (uint32_t)(((uint64_t)sim_get_timer_clock(TIM2) * rtos_get_tick_period()) / 1000000);
+	TEST_CHECK((TIM_ARR(TIM2) + 1) == tick_counts);
+
+	/* PWM: its frequency */
+	pwm_freq_hz = (double)sim_get_timer_clock(TIM4) / (((double)TIM_PSC(TIM4) + 1) * ((double)TIM_ARR(TIM4) + 1));
+	TEST_CHECK((pwm_freq_hz > (PWM_FREQ_HZ - PWM_FREQ_TOLERANCE_HZ)) && (pwm_freq_hz < (PWM_FREQ_HZ + PWM_FREQ_TOLERANCE_HZ)));
+
+	/* SPI: the fastest clock up to the max of the sensor link */
+	spi_clock_hz = sim_clock_get_pclk(true) >> (((SPI_CR1(SPI1) & SPI_CR1_BAUDRATE_MASK) >> SPI_CR1_BAUDRATE_SHIFT) + 1);
+	TEST_CHECK(spi_clock_hz <= SPI_MAX_CLOCK_HZ);
+	TEST_CHECK(((SPI_CR1(SPI1) & SPI_CR1_BAUDRATE_MASK) == 0) || ((2 * spi_clock_hz) > SPI_MAX_CLOCK_HZ));
+
+	/* timebase and tick measured against the virtual time */
+	sim_advance(MEASURE_PS);
+	TEST_CHECK((timebase_get_us() - start_us) == (MEASURE_PS / SIM_PS_PER_US));
+	TEST_CHECK((stats_ptr->irq_calls[NVIC_TIM2_IRQ] - start_ticks)
+			   == ((MEASURE_PS / SIM_PS_PER_US) / rtos_get_tick_period()));
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,263 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Gesture detector replay: a labelled recording is synthesized with taps,
+ * double-taps and shakes at known samples over a noisy board at rest in
+ * several orientations, turned slowly between the events, and replayed through the detector. Each labelled
+ * event shall be matched by a detected event of the same type in a short
+ * window after it: precision and recall are reported with the host time
+ * per sample */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "gesture.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Labelled events of the recording */
+#define EVENTS_NUM						300
+
+/* Samples between two labelled events */
+#define EVENT_SPACING					((uint32_t)(2000 / ACCEL_SAMPLE_PERIOD_MS))
+
+/* Window after a labelled event in which its detection is expected [samples] */
+#define MATCH_WINDOW					((uint32_t)(600 / ACCEL_SAMPLE_PERIOD_MS))
+
+/* Slow turn of the board to the next orientation, after the event [samples] */
+#define TURN_START						((uint32_t)(1000 / ACCEL_SAMPLE_PERIOD_MS))
+#define TURN_LENGTH						((uint32_t)(500 / ACCEL_SAMPLE_PERIOD_MS))
+
+/* Max detected events */
+#define DETECTIONS_MAX					(2 * EVENTS_NUM)
+
+/* Sensor noise of each axis: +/- this value [mg] */
+#define NOISE_MG						8
+
+/* Tap amplitude range on one axis [mg] */
+#define TAP_MIN_MG						850
+#define TAP_MAX_MG						1500
+
+/* Delay of the second tap of a double-tap [samples] */
+#define DOUBLE_TAP_DELAY				((uint32_t)(150 / ACCEL_SAMPLE_PERIOD_MS))
+
+/* Shake: swings between +/- amplitude, each held for some samples */
+#define SHAKE_SWINGS					6
+#define SHAKE_HOLD						4
+#define SHAKE_MG						700
+
+/* Required precision and recall [permille] */
+#define MIN_PRECISION_PERMILLE			950
+#define MIN_RECALL_PERMILLE				950
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Event at a sample */
+typedef struct {
+	uint32_t sample;
+	uint8_t event;
+} labelled_event_t;
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Orientations of the board at rest [mg] */
+static const int16_t orientations[][3] = {
+	{0, 0, 1000},
+	{0, 0, -1000},
+	{1000, 0, 0},
+	{0, -1000, 0},
+	{600, 0, 800}
+};
+
+/* Labelled and detected events */
+static labelled_event_t labels[EVENTS_NUM];
+static labelled_event_t detections[DETECTIONS_MAX];
+static uint32_t detections_num;
+
+/* Sample being fed */
+static uint32_t actual_sample;
+
+/* Random generator state */
+static uint64_t random_state = 1;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void store_detection(uint8_t);
+static void get_sample(uint32_t, int16_t *);
+static int32_t get_random(int32_t, int32_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Replay a labelled recording and check precision and recall */
+void test_gesture_replay(void)
+{
+	uint32_t samples_num = (EVENTS_NUM + 1) * EVENT_SPACING;
+	uint32_t label_index;
+	uint32_t detection_index;
+	uint32_t matched = 0;
+	int16_t values_mg[3];
+	struct timespec start;
+	struct timespec end;
+	double host_ns;
+
+	for (label_index = 0; label_index < EVENTS_NUM; label_index++) {
+		labels[label_index].sample = (label_index + 1) * EVENT_SPACING;
+		labels[label_index].event = (uint8_t)get_random(GESTURE_EV_TAP, GESTURE_EV_SHAKE);
+	}
+
+	gesture_init();
+	gesture_set_callback(&store_detection);
+	detections_num = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (actual_sample = 0; actual_sample < samples_num; actual_sample++) {
+		get_sample(actual_sample, values_mg);
+		gesture_process_sample(values_mg[0], values_mg[1], values_mg[2]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	host_ns = ((double)(end.tv_sec - start.tv_sec) * 1e9) + (double)(end.tv_nsec - start.tv_nsec);
+
+	/* a detection matches at most one label */
+	for (label_index = 0; label_index < EVENTS_NUM; label_index++) {
+		for (detection_index = 0; detection_index < detections_num; detection_index++) {
+			if ((detections[detection_index].event == labels[label_index].event)
+			&& (detections[detection_index].sample >= labels[label_index].sample)
+			&& (detections[detection_index].sample < (labels[label_index].sample + MATCH_WINDOW))) {
+				matched++;
+				break;
+			}
+		}
+	}
+
+	test_report("labels", EVENTS_NUM);
+	test_report("detections", detections_num);
+	test_report("precision", (detections_num > 0) ? ((double)matched / detections_num) : 0.0);
+	test_report("recall", (double)matched / EVENTS_NUM);
+	test_report("ns_per_sample", host_ns / samples_num);
+
+	TEST_CHECK((matched * 1000) >= (detections_num * MIN_PRECISION_PERMILLE));
+	TEST_CHECK((matched * 1000) >= (EVENTS_NUM * MIN_RECALL_PERMILLE));
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Gesture callback: store the event with its sample */
+static void store_detection(uint8_t event)
+{
+	if (detections_num < DETECTIONS_MAX) {
+		detections[detections_num].sample = actual_sample;
+		detections[detections_num].event = event;
+		detections_num++;
+	}
+}
+
+
+/* Sample of the recording: rest orientation, noise and the motion of the
+ * labelled event in progress, if any */
+static void get_sample(uint32_t sample, int16_t *values_mg)
+{
+	static int32_t tap_mg;
+	static uint8_t tap_axis;
+	uint32_t label_index = sample / EVENT_SPACING;
+	uint32_t offset = sample % EVENT_SPACING;
+	const uint32_t orientations_num = sizeof(orientations) / sizeof(orientations[0]);
+	const int16_t *rest_ptr = orientations[label_index % orientations_num];
+	const int16_t *next_ptr = orientations[(label_index + 1) % orientations_num];
+	int32_t turned;
+	uint8_t event;
+	uint8_t axis;
+
+	/* linear turn between the two orientations */
+	turned = (offset < TURN_START) ? 0
+			 : ((offset >= (TURN_START + TURN_LENGTH)) ? (int32_t)TURN_LENGTH : (int32_t)(offset - TURN_START));
+	for (axis = 0; axis < 3; axis++) {
+		values_mg[axis] = (int16_t)(rest_ptr[axis] + (((next_ptr[axis] - rest_ptr[axis]) * turned) / (int32_t)TURN_LENGTH)
+									+ get_random(-NOISE_MG, NOISE_MG));
+	}
+
+	if ((label_index == 0) || (label_index > EVENTS_NUM)) {
+		return;
+	}
+	event = labels[label_index - 1].event;
+
+	/* a new amplitude and axis for each labelled event */
+	if (offset == 0) {
+		tap_mg = get_random(TAP_MIN_MG, TAP_MAX_MG) * ((get_random(0, 1) != 0) ? 1 : -1);
+		tap_axis = (uint8_t)get_random(0, 2);
+	}
+
+	if ((event == GESTURE_EV_TAP) || (event == GESTURE_EV_DOUBLE_TAP)) {
+		/* a tap is a one sample spike */
+		if ((offset == 0)
+		|| ((event == GESTURE_EV_DOUBLE_TAP) && (offset == DOUBLE_TAP_DELAY))) {
+			values_mg[tap_axis] = (int16_t)(values_mg[tap_axis] + tap_mg);
+		}
+	} else if (offset < (SHAKE_SWINGS * SHAKE_HOLD)) {
+		/* a shake swings the board back and forth */
+		values_mg[tap_axis] = (int16_t)(values_mg[tap_axis]
+							+ ((((offset / SHAKE_HOLD) & 1) == 0) ? SHAKE_MG : -SHAKE_MG));
+	}
+}
+
+
+/* Random value in [min, max] */
+static int32_t get_random(int32_t min, int32_t max)
+{
+	/* xorshift64* */
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return min + (int32_t)(((random_state * 0x2545F4914F6CDD1DULL) >> 11) % (uint64_t)(max - min + 1));
+}
+
+
+
+
+/* End of file */
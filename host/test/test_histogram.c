@@ -0,0 +1,252 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Histogram percentiles against the exact ones of the sorted values. Each
+ * distribution is split over two histograms that are merged, as the latency
+ * snapshots are: every per mille percentile shall be at or above the exact
+ * one by less than 1 / HISTOGRAM_SUB_BINS_NUM of it, min, max and mean exact */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "histogram.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Values of each distribution */
+#define VALUES_NUM						20000
+
+/* Per mille of all values */
+#define PERMILLE_ALL					1000
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Distribution of the recorded values */
+enum {
+	KE_DIST_UNIFORM,					/* uniform up to 100000 */
+	KE_DIST_LOG_UNIFORM,				/* same number of values in each power of 2 */
+	KE_DIST_FULL_RANGE,					/* uniform over the whole uint32 range */
+	KE_DIST_BIMODAL,					/* two narrow modes far apart */
+	KE_DIST_CHECK
+};
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Distribution names */
+static const char * const dist_names[KE_DIST_CHECK] = {
+	"uniform",
+	"log_uniform",
+	"full_range",
+	"bimodal"
+};
+
+/* Recorded values, sorted for the exact percentiles */
+static uint32_t values[VALUES_NUM];
+
+/* Histograms of the even and odd values, then merged */
+static histogram_t histograms[2];
+
+/* Random generator state */
+static uint64_t random_state = 1;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static uint32_t get_value(uint8_t);
+static int compare_values(const void *, const void *);
+static uint32_t get_random(void);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Record each distribution and check every per mille percentile */
+void test_histogram_percentiles(void)
+{
+	uint8_t dist;
+	uint32_t index;
+	uint32_t permille;
+	uint32_t rank;
+	uint32_t exact;
+	uint32_t estimate;
+	uint64_t sum;
+	double error;
+	double max_error;
+	char key[48];
+
+	for (dist = 0; dist < KE_DIST_CHECK; dist++) {
+		histogram_reset(&histograms[0]);
+		histogram_reset(&histograms[1]);
+		sum = 0;
+		for (index = 0; index < VALUES_NUM; index++) {
+			values[index] = get_value(dist);
+			histogram_record(&histograms[index % 2], values[index]);
+			sum += values[index];
+		}
+		histogram_merge(&histograms[0], &histograms[1]);
+		qsort(values, VALUES_NUM, sizeof(values[0]), &compare_values);
+
+		TEST_CHECK(histogram_get_samples(&histograms[0]) == VALUES_NUM);
+		TEST_CHECK(histogram_get_min(&histograms[0]) == values[0]);
+		TEST_CHECK(histogram_get_max(&histograms[0]) == values[VALUES_NUM - 1]);
+		TEST_CHECK(histogram_get_mean(&histograms[0]) == (uint32_t)(sum / VALUES_NUM));
+
+		max_error = 0.0;
+		for (permille = 0; permille <= PERMILLE_ALL; permille++) {
+			/* nearest rank, at least 1 */
+			rank = (uint32_t)((((uint64_t)VALUES_NUM * permille) + PERMILLE_ALL - 1) / PERMILLE_ALL);
+			if (rank == 0) {
+				rank = 1;
+			}
+			exact = values[rank - 1];
+			estimate = histogram_get_percentile(&histograms[0], permille);
+
+			TEST_CHECK(estimate >= exact);
+			TEST_CHECK(((uint64_t)(estimate - exact) * HISTOGRAM_SUB_BINS_NUM) <= exact);
+			if (exact > 0) {
+				error = (double)(estimate - exact) / exact;
+				if (error > max_error) {
+					max_error = error;
+				}
+			}
+		}
+
+		snprintf(key, sizeof(key), "%s_max_error_percent", dist_names[dist]);
+		test_report(key, max_error * 100.0);
+	}
+	test_report("error_bound_percent", 100.0 / HISTOGRAM_SUB_BINS_NUM);
+}
+
+
+/* Empty histogram, exact small values and the ends of the uint32 range */
+void test_histogram_extremes(void)
+{
+	uint32_t value;
+
+	histogram_reset(&histograms[0]);
+	TEST_CHECK(histogram_get_samples(&histograms[0]) == 0);
+	TEST_CHECK(histogram_get_min(&histograms[0]) == 0);
+	TEST_CHECK(histogram_get_max(&histograms[0]) == 0);
+	TEST_CHECK(histogram_get_mean(&histograms[0]) == 0);
+	TEST_CHECK(histogram_get_percentile(&histograms[0], 500) == 0);
+
+	/* each value below 2 * HISTOGRAM_SUB_BINS_NUM has its own bin */
+	for (value = 0; value < (2 * HISTOGRAM_SUB_BINS_NUM); value++) {
+		histogram_reset(&histograms[0]);
+		histogram_record(&histograms[0], value);
+		histogram_record(&histograms[0], UINT32_MAX);
+		TEST_CHECK(histogram_get_percentile(&histograms[0], 500) == value);
+		TEST_CHECK(histogram_get_percentile(&histograms[0], PERMILLE_ALL) == UINT32_MAX);
+	}
+
+	/* the top bin ends at UINT32_MAX: the result is clamped to the max */
+	histogram_reset(&histograms[0]);
+	histogram_record(&histograms[0], UINT32_MAX - 1);
+	TEST_CHECK(histogram_get_percentile(&histograms[0], 0) == (UINT32_MAX - 1));
+	TEST_CHECK(histogram_get_percentile(&histograms[0], PERMILLE_ALL) == (UINT32_MAX - 1));
+	TEST_CHECK(histogram_get_mean(&histograms[0]) == (UINT32_MAX - 1));
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Get a value of a distribution */
+static uint32_t get_value(uint8_t dist)
+{
+	uint32_t value;
+
+	switch (dist) {
+	case KE_DIST_UNIFORM:
+	{
+		value = get_random() % 100001;
+		break;
+	}
+	case KE_DIST_LOG_UNIFORM:
+	{
+		/* a random power of 2, then a random value inside it */
+		value = get_random() >> (get_random() % 32);
+		break;
+	}
+	case KE_DIST_BIMODAL:
+	{
+		value = ((get_random() % 4) == 0) ? (2000000 + (get_random() % 50000)) : (150 + (get_random() % 20));
+		break;
+	}
+	default:
+	{
+		value = get_random();
+		break;
+	}
+	}
+
+	return value;
+}
+
+
+/* qsort comparison of two uint32 values */
+static int compare_values(const void *a_ptr, const void *b_ptr)
+{
+	uint32_t a = *(const uint32_t *)a_ptr;
+	uint32_t b = *(const uint32_t *)b_ptr;
+
+	return (a > b) - (a < b);
+}
+
+
+/* Get a uint32 random value: xorshift64*, upper bits */
+static uint32_t get_random(void)
+{
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return (uint32_t)((random_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+
+
+
+/* End of file */
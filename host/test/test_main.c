@@ -0,0 +1,181 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Host test runner: main_test [-c case] runs all cases, or only the named
+ * one, and prints a test=name result=pass|fail line for each of them.
+ * The exit status is a failure if any case failed */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "sim.h"
+#include "test.h"
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Test cases */
+static const test_case_t test_cases[] = {
+	{"bam_planes", &test_bam_planes},
+	{"bam_periods", &test_bam_periods},
+	{"bam_on_time", &test_bam_on_time},
+	{"calib_six_positions", &test_calib_six_positions},
+	{"capture_back_to_back", &test_capture_back_to_back},
+	{"clock_states", &test_clock_states},
+	{"clock_notify_rates", &test_clock_notify_rates},
+	{"gesture_replay", &test_gesture_replay},
+	{"histogram_percentiles", &test_histogram_percentiles},
+	{"histogram_extremes", &test_histogram_extremes},
+	{"pattern_start_in_batch", &test_pattern_start_in_batch},
+	{"pedo_walks", &test_pedo_walks},
+	{"pedo_keep_count", &test_pedo_keep_count},
+	{"pwm_burst", &test_pwm_burst},
+	{"pwm_redundant_writes", &test_pwm_redundant_writes},
+	{"pwm_init_table", &test_pwm_init_table},
+	{"pwm_full_scale", &test_pwm_full_scale},
+	{"pwm_dithering", &test_pwm_dithering},
+	{"tick_switch_deadlines", &test_tick_switch_deadlines},
+	{"tick_led_catch_up", &test_tick_led_catch_up},
+	{"timebase_wrap", &test_timebase_wrap}
+};
+
+/* Case running in this process */
+static const test_case_t *actual_case_ptr;
+
+/* Failed checks of the case running in this process */
+static uint32_t failed_checks;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static bool run_case(const test_case_t *);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Usage: main_test [-c case] */
+int main(int argc, char *argv[])
+{
+	const char *filter = NULL;
+	uint32_t failed_cases = 0;
+	uint32_t run_cases = 0;
+	uint8_t case_index;
+	int option;
+
+	while ((option = getopt(argc, argv, "c:")) != -1) {
+		if (option == 'c') {
+			filter = optarg;
+		} else {
+			fprintf(stderr, "usage: %s [-c case]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (case_index = 0; case_index < (sizeof(test_cases) / sizeof(test_cases[0])); case_index++) {
+		if ((filter != NULL) && (strcmp(filter, test_cases[case_index].name) != 0)) {
+			continue;
+		}
+		run_cases++;
+		if (!run_case(&test_cases[case_index])) {
+			failed_cases++;
+		}
+	}
+
+	printf("tests_run=%u\n", run_cases);
+	printf("tests_failed=%u\n", failed_cases);
+
+	return ((failed_cases == 0) && (run_cases > 0)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/* Record a check of the running case */
+void test_check(bool result, const char *condition, const char *file, int line)
+{
+	if (!result) {
+		failed_checks++;
+		printf("%s:%d: %s: check failed: %s\n", file, line, actual_case_ptr->name, condition);
+	}
+}
+
+
+/* Print a value measured by the running case */
+void test_report(const char *key, double value)
+{
+	printf("%s_%s=%g\n", actual_case_ptr->name, key, value);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Run a case in a child process on a fresh simulated board. Return true if it passed */
+static bool run_case(const test_case_t *case_ptr)
+{
+	pid_t pid;
+	int status = 0;
+	bool passed = false;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0) {
+		actual_case_ptr = case_ptr;
+		failed_checks = 0;
+		sim_init();
+		(*case_ptr->run)();
+		fflush(stdout);
+		_exit((failed_checks == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+	} else if (pid > 0) {
+		if (waitpid(pid, &status, 0) == pid) {
+			passed = WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS);
+		}
+	} else {
+		perror("fork");
+	}
+
+	printf("test=%s result=%s\n", case_ptr->name, passed ? "pass" : "fail");
+
+	return passed;
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,175 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Pattern sequencer driven as the LED driver does: one call with the ticks
+ * elapsed since the previous one. A pattern started in the middle of a call
+ * of many ticks shall keep its waits, while a channel already running
+ * catches up the ticks it is late */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pattern.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Channels under test */
+#define RUNNING_CH						((uint8_t)0)
+#define STARTED_CH						((uint8_t)1)
+
+/* Waits of the patterns [ticks] */
+#define RUNNING_ON_TICKS				((uint8_t)6)
+#define RUNNING_OFF_TICKS				((uint8_t)60)
+#define BLINK_TICKS						((uint8_t)25)
+
+/* Ticks of the batch call: the running channel is due in the middle of it */
+#define BATCH_TICKS						((uint8_t)20)
+
+/* Ticks run one at a time after the batch */
+#define SINGLE_TICKS					((uint32_t)100)
+
+/* No edge recorded */
+#define NO_EDGE							UINT32_MAX
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void record_output(uint8_t, uint8_t, uint8_t, uint8_t);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Pattern with a short first on time and a long off time */
+static const uint8_t running_pattern[] = {
+	PATTERN_OP_LOOP, 0,
+	PATTERN_OP_ON,
+	PATTERN_OP_WAIT, RUNNING_ON_TICKS,
+	PATTERN_OP_OFF,
+	PATTERN_OP_WAIT, RUNNING_OFF_TICKS,
+	PATTERN_OP_END_LOOP,
+	PATTERN_OP_END
+};
+
+/* Blink with the same on and off times */
+static const uint8_t blink_pattern[] = {
+	PATTERN_OP_LOOP, 0,
+	PATTERN_OP_ON,
+	PATTERN_OP_WAIT, BLINK_TICKS,
+	PATTERN_OP_OFF,
+	PATTERN_OP_WAIT, BLINK_TICKS,
+	PATTERN_OP_END_LOOP,
+	PATTERN_OP_END
+};
+
+/* Actual tick */
+static uint32_t now_ticks;
+
+/* Ticks of the first on and off edges of each channel after the batch */
+static uint32_t on_edge_ticks[PATTERN_CHANNELS_NUM];
+static uint32_t off_edge_ticks[PATTERN_CHANNELS_NUM];
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Start a blink one tick before the end of a batch of ticks in which a
+ * running channel was due: the blink starts at the batch and keeps its
+ * first on time, the running channel keeps its phase */
+void test_pattern_start_in_batch(void)
+{
+	uint8_t ch_index;
+	uint32_t tick_index;
+
+	for (ch_index = 0; ch_index < PATTERN_CHANNELS_NUM; ch_index++) {
+		on_edge_ticks[ch_index] = NO_EDGE;
+		off_edge_ticks[ch_index] = NO_EDGE;
+	}
+	pattern_init(&record_output);
+
+	/* running channel: on at tick 1, due for its off edge at tick 1 + RUNNING_ON_TICKS */
+	pattern_start(RUNNING_CH, running_pattern);
+	now_ticks = 1;
+	TEST_CHECK(pattern_tick(1) == RUNNING_ON_TICKS);
+	/* record its next on edge */
+	on_edge_ticks[RUNNING_CH] = NO_EDGE;
+
+	/* the blink starts in the last tick of a batch */
+	now_ticks += BATCH_TICKS;
+	pattern_start(STARTED_CH, blink_pattern);
+	(void)pattern_tick(BATCH_TICKS);
+	TEST_CHECK(on_edge_ticks[STARTED_CH] == now_ticks);
+
+	for (tick_index = 0; tick_index < SINGLE_TICKS; tick_index++) {
+		now_ticks++;
+		(void)pattern_tick(1);
+	}
+
+	/* first edge of the blink: a whole wait after its start */
+	TEST_CHECK(off_edge_ticks[STARTED_CH] == (1 + BATCH_TICKS + BLINK_TICKS));
+	test_report("blink_on_ticks", (double)(off_edge_ticks[STARTED_CH] - (1 + BATCH_TICKS)));
+
+	/* the running channel is on again on its own schedule */
+	TEST_CHECK(on_edge_ticks[RUNNING_CH] == (1 + RUNNING_ON_TICKS + RUNNING_OFF_TICKS));
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Record the tick of the first on and off edges of each channel */
+static void record_output(uint8_t ch_index, uint8_t opcode, uint8_t level, uint8_t ticks)
+{
+	(void)level;
+	(void)ticks;
+
+	if (ch_index < PATTERN_CHANNELS_NUM) {
+		if ((PATTERN_OP_ON == opcode)
+		&& (NO_EDGE == on_edge_ticks[ch_index])) {
+			on_edge_ticks[ch_index] = now_ticks;
+		} else if ((PATTERN_OP_OFF == opcode)
+			   && (NO_EDGE == off_edge_ticks[ch_index])) {
+			off_edge_ticks[ch_index] = now_ticks;
+		}
+	}
+}
+
+
+
+
+/* End of file */
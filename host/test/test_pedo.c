@@ -0,0 +1,253 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Pedometer validation on walking traces. No recording is shipped with the
+ * sources, so the traces are synthesized: a vertical impact at each step,
+ * with cadence and amplitude varying from step to step, sensor noise and
+ * the board held in any orientation. Walks at several cadences alternate
+ * with rests and isolated movements: the counted steps of each segment are
+ * checked against the labelled ones */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pedo.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Convert a time in ms into a number of samples */
+#define MS_TO_SAMPLES(ms)				((uint32_t)((ms) / ACCEL_SAMPLE_PERIOD_MS))
+
+/* Sensor noise of each axis: +/- this value [mg] */
+#define NOISE_MG						30
+
+/* Cadence and amplitude variation from step to step: +/- this fraction [permille] */
+#define STEP_JITTER_PERMILLE			80
+
+/* Steps a walk may miss while the adaptive threshold learns its amplitude */
+#define MISSED_STEPS_MAX				6
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Trace segment: a walk, or a rest with some isolated movements if no step.
+ * Movements are spread evenly: more than 2 s apart, they are not a walk */
+typedef struct {
+	uint32_t steps;						/* labelled steps */
+	uint32_t step_period_ms;			/* walk: mean period of a step */
+	uint32_t amplitude_mg;				/* walk: mean peak of a step impact */
+	uint32_t duration_ms;				/* rest: length */
+	uint32_t movements;					/* rest: isolated movements */
+	int16_t gravity_mg[3];				/* orientation of the board */
+} segment_t;
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Trace: slow and fast walks, a run, rests with movements */
+static const segment_t segments[] = {
+	{0, 0, 0, 5000, 0, {0, 0, 1000}},
+	{120, 550, 350, 0, 0, {0, 0, 1000}},
+	{0, 0, 0, 7500, 2, {0, 0, 1000}},
+	{80, 700, 250, 0, 0, {0, 1000, 0}},
+	{0, 0, 0, 10000, 3, {0, 1000, 0}},
+	{200, 350, 800, 0, 0, {600, 0, 800}},
+	{0, 0, 0, 6000, 0, {600, 0, 800}},
+	{100, 480, 400, 0, 0, {-1000, 0, 0}},
+	{0, 0, 0, 5000, 1, {-1000, 0, 0}}
+};
+
+/* Random generator state */
+static uint64_t random_state = 1;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void feed(const int16_t *, int32_t);
+static void play_walk(const segment_t *);
+static void play_rest(const segment_t *);
+static int32_t get_random(int32_t, int32_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Play each segment and check its counted steps */
+void test_pedo_walks(void)
+{
+	uint8_t segment_index;
+	uint32_t start_steps;
+	uint32_t counted;
+	uint32_t labelled_total = 0;
+	const segment_t *segment_ptr;
+
+	pedo_init();
+	pedo_reset_steps();
+
+	for (segment_index = 0; segment_index < (sizeof(segments) / sizeof(segments[0])); segment_index++) {
+		segment_ptr = &segments[segment_index];
+		start_steps = pedo_get_steps();
+		if (segment_ptr->steps > 0) {
+			play_walk(segment_ptr);
+		} else {
+			play_rest(segment_ptr);
+		}
+		counted = pedo_get_steps() - start_steps;
+		labelled_total += segment_ptr->steps;
+
+		/* a walk may miss its first steps only, a rest counts none */
+		TEST_CHECK(counted <= segment_ptr->steps);
+		TEST_CHECK((counted + MISSED_STEPS_MAX) >= segment_ptr->steps);
+	}
+
+	test_report("labelled_steps", labelled_total);
+	test_report("counted_steps", pedo_get_steps());
+	test_report("error_permille", ((double)labelled_total - pedo_get_steps()) * 1000.0 / labelled_total);
+}
+
+
+/* The step count survives a re-init of the detector, as at a RTOS state change */
+void test_pedo_keep_count(void)
+{
+	uint32_t steps;
+
+	pedo_init();
+	pedo_reset_steps();
+	play_walk(&segments[1]);
+	steps = pedo_get_steps();
+	TEST_CHECK(steps > 0);
+
+	pedo_init();
+	TEST_CHECK(pedo_get_steps() == steps);
+
+	pedo_reset_steps();
+	TEST_CHECK(pedo_get_steps() == 0);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Feed a sample: gravity plus a vertical acceleration and noise */
+static void feed(const int16_t *gravity_mg, int32_t vertical_mg)
+{
+	int16_t values_mg[3];
+	uint8_t axis;
+
+	for (axis = 0; axis < 3; axis++) {
+		values_mg[axis] = (int16_t)(gravity_mg[axis] + ((gravity_mg[axis] * vertical_mg) / 1000)
+									+ get_random(-NOISE_MG, NOISE_MG));
+	}
+	pedo_process_sample(values_mg[0], values_mg[1], values_mg[2]);
+}
+
+
+/* Walk: each step is a triangular impact over the first half of its period,
+ * followed by a lighter rebound of opposite sign */
+static void play_walk(const segment_t *segment_ptr)
+{
+	uint32_t step;
+	uint32_t sample;
+	uint32_t period;
+	uint32_t half;
+	int32_t amplitude;
+	int32_t vertical_mg;
+
+	for (step = 0; step < segment_ptr->steps; step++) {
+		period = MS_TO_SAMPLES(segment_ptr->step_period_ms
+				 * (uint32_t)(1000 + get_random(-STEP_JITTER_PERMILLE, STEP_JITTER_PERMILLE)) / 1000);
+		amplitude = (int32_t)segment_ptr->amplitude_mg
+					* (1000 + get_random(-STEP_JITTER_PERMILLE, STEP_JITTER_PERMILLE)) / 1000;
+		half = period / 2;
+
+		for (sample = 0; sample < period; sample++) {
+			if (sample < half) {
+				/* impact: up to the peak at a quarter of the period, then down */
+				vertical_mg = (amplitude * (int32_t)((sample < (half / 2)) ? sample : (half - sample)))
+							  / (int32_t)(half / 2);
+			} else {
+				/* rebound */
+				vertical_mg = -((amplitude / 3) * (int32_t)(((sample - half) < (half / 2)) ? (sample - half) : (period - sample)))
+							  / (int32_t)(half / 2);
+			}
+			feed(segment_ptr->gravity_mg, vertical_mg);
+		}
+	}
+}
+
+
+/* Rest with isolated movements spread over it */
+static void play_rest(const segment_t *segment_ptr)
+{
+	uint32_t samples_num = MS_TO_SAMPLES(segment_ptr->duration_ms);
+	uint32_t spacing = samples_num / (segment_ptr->movements + 1);
+	uint32_t sample;
+	int32_t vertical_mg;
+
+	for (sample = 0; sample < samples_num; sample++) {
+		vertical_mg = 0;
+		/* a movement lasts 300 ms */
+		if ((segment_ptr->movements > 0)
+		&& (sample >= spacing)
+		&& ((sample % spacing) < MS_TO_SAMPLES(300))
+		&& ((sample / spacing) <= segment_ptr->movements)) {
+			vertical_mg = 500;
+		}
+		feed(segment_ptr->gravity_mg, vertical_mg);
+	}
+}
+
+
+/* Random value in [min, max] */
+static int32_t get_random(int32_t min, int32_t max)
+{
+	/* xorshift64* */
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return min + (int32_t)(((random_state * 0x2545F4914F6CDD1DULL) >> 11) % (uint64_t)(max - min + 1));
+}
+
+
+
+
+/* End of file */
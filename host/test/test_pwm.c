@@ -0,0 +1,391 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+
+/* PWM driver at register level on the simulated timers and DMA: the
+ * compare registers, the DMA burst transfers and the write statistics are
+ * checked against the requested duty cycles */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
+
+#include "clock.h"
+#include "pwm.h"
+#include "sim.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Group under test and its timer */
+#define TEST_GROUP						PWM_CFG_KE_GROUP_TIM4
+#define TEST_TIMER						(pwm_cfg_groups[TEST_GROUP].timer)
+
+/* PWM frequency of the tests [Hz] */
+#define TEST_FREQ_HZ					((uint32_t)1000)
+
+/* Output compare mode field value of PWM mode 1 (RM0090) */
+#define OCM_PWM1						((uint32_t)6)
+
+/* Accepted error of a group default frequency [permille] */
+#define MAX_FREQ_ERROR_PERMILLE			1
+
+/* Dithered duty cycle, below half scale: between two counts at the test frequency [1/65536] */
+#define DITHER_DUTY						((uint16_t)12345)
+
+/* Periods the dithered compare values are averaged over */
+#define DITHER_PERIODS					((uint32_t)1024)
+
+/* One PWM period [ps] */
+#define EXACT_PERIOD_PS					(SIM_PS_PER_S / TEST_FREQ_HZ)
+
+/* One PWM period and some margin [ps] */
+#define PERIOD_PS						((SIM_PS_PER_S / TEST_FREQ_HZ) + (SIM_PS_PER_US * 10))
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void start_pwm(void);
+static uint32_t get_compare(uint8_t);
+static uint32_t expected_compare(uint16_t);
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Frames of distinct values for each channel [1/65536] */
+static const uint16_t frames[2][PWM_CFG_KE_CH_MAX_NUM] = {
+	{1000, 20000, 40000, 60000},
+	{65000, 30000, 500, 12345}
+};
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* A frame is written into all the compare registers by one DMA burst at
+ * the update event: none of them changes before it */
+void test_pwm_burst(void)
+{
+	const sim_stats_t *stats_ptr = sim_get_stats();
+	uint64_t start_transfers;
+	uint8_t frame_index;
+	uint8_t ch_index;
+	bool before_update_ok;
+	bool after_update_ok;
+
+	start_pwm();
+
+	for (frame_index = 0; frame_index < (sizeof(frames) / sizeof(frames[0])); frame_index++) {
+		start_transfers = stats_ptr->dma_transfers;
+		pwm_set_frame(frames[frame_index], PWM_CFG_KE_CH_MAX_NUM);
+
+		before_update_ok = true;
+		for (ch_index = 0; ch_index < PWM_CFG_KE_CH_MAX_NUM; ch_index++) {
+			if (get_compare(ch_index) == expected_compare(frames[frame_index][ch_index])) {
+				before_update_ok = false;
+			}
+		}
+		TEST_CHECK(before_update_ok);
+
+		sim_advance(PERIOD_PS);
+
+		after_update_ok = true;
+		for (ch_index = 0; ch_index < PWM_CFG_KE_CH_MAX_NUM; ch_index++) {
+			if (get_compare(ch_index) != expected_compare(frames[frame_index][ch_index])) {
+				after_update_ok = false;
+			}
+		}
+		TEST_CHECK(after_update_ok);
+		/* one burst: one transfer for each compare register */
+		TEST_CHECK((stats_ptr->dma_transfers - start_transfers) == PWM_CFG_TIM_CCR_NUM);
+	}
+
+	/* a frame shorter than the channels changes only its own ones */
+	pwm_set_frame(frames[0], 1);
+	sim_advance(PERIOD_PS);
+	after_update_ok = (get_compare(0) == expected_compare(frames[0][0]));
+	for (ch_index = 1; ch_index < PWM_CFG_KE_CH_MAX_NUM; ch_index++) {
+		if (get_compare(ch_index) != expected_compare(frames[frame_index - 1][ch_index])) {
+			after_update_ok = false;
+		}
+	}
+	TEST_CHECK(after_update_ok);
+
+	test_report("dma_transfers", (double)stats_ptr->dma_transfers);
+}
+
+
+/* A value already in a compare register is not written again: a repeated
+ * frame starts no burst, and the statistics count each skipped write */
+void test_pwm_redundant_writes(void)
+{
+	const sim_stats_t *stats_ptr = sim_get_stats();
+	uint64_t start_transfers;
+	pwm_stats_t pwm_stats;
+	uint8_t ch_index;
+
+	start_pwm();
+	pwm_set_frame(frames[0], PWM_CFG_KE_CH_MAX_NUM);
+	sim_advance(PERIOD_PS);
+	pwm_reset_stats();
+	pwm_get_stats(&pwm_stats);
+	TEST_CHECK((0 == pwm_stats.written) && (0 == pwm_stats.suppressed));
+
+	/* same frame: no write, no burst */
+	start_transfers = stats_ptr->dma_transfers;
+	pwm_set_frame(frames[0], PWM_CFG_KE_CH_MAX_NUM);
+	sim_advance(PERIOD_PS);
+	pwm_get_stats(&pwm_stats);
+	TEST_CHECK(0 == pwm_stats.written);
+	TEST_CHECK(PWM_CFG_KE_CH_MAX_NUM == pwm_stats.suppressed);
+	TEST_CHECK(stats_ptr->dma_transfers == start_transfers);
+
+	/* same duty of each channel: no write */
+	for (ch_index = 0; ch_index < PWM_CFG_KE_CH_MAX_NUM; ch_index++) {
+		pwm_set_duty(ch_index, frames[0][ch_index]);
+	}
+	sim_advance(PERIOD_PS);
+	pwm_get_stats(&pwm_stats);
+	TEST_CHECK(0 == pwm_stats.written);
+	TEST_CHECK((2 * PWM_CFG_KE_CH_MAX_NUM) == pwm_stats.suppressed);
+	TEST_CHECK(stats_ptr->dma_transfers == start_transfers);
+
+	/* one channel changes: the burst writes all the registers of the group */
+	pwm_reset_stats();
+	pwm_set_duty(0, frames[1][0]);
+	pwm_get_stats(&pwm_stats);
+	TEST_CHECK(1 == pwm_stats.written);
+	TEST_CHECK(expected_compare(frames[1][0]) == get_compare(0));
+	TEST_CHECK(stats_ptr->dma_transfers == start_transfers);
+
+	start_transfers = stats_ptr->dma_transfers;
+	pwm_reset_stats();
+	pwm_set_frame(frames[1], PWM_CFG_KE_CH_MAX_NUM);
+	sim_advance(PERIOD_PS);
+	pwm_get_stats(&pwm_stats);
+	TEST_CHECK(PWM_CFG_TIM_CCR_NUM == pwm_stats.written);
+	TEST_CHECK(1 == pwm_stats.suppressed);
+	TEST_CHECK((stats_ptr->dma_transfers - start_transfers) == PWM_CFG_TIM_CCR_NUM);
+}
+
+
+
+
+/* Full scale is the whole period (compare value above the period), zero is
+ * no pulse, at any period */
+void test_pwm_full_scale(void)
+{
+	static const uint32_t freqs_hz[] = {100, 1000, 1283, 20000, 100000};
+	uint8_t freq_index;
+	uint8_t ch_index;
+
+	start_pwm();
+
+	for (freq_index = 0; freq_index < (sizeof(freqs_hz) / sizeof(freqs_hz[0])); freq_index++) {
+		pwm_set_frequency(freqs_hz[freq_index]);
+		for (ch_index = 0; ch_index < PWM_CFG_KE_CH_MAX_NUM; ch_index++) {
+			pwm_set_dc(ch_index, ((ch_index & 1) == 0) ? 1000 : 0);
+		}
+		sim_advance(SIM_PS_PER_S / 50);
+
+		for (ch_index = 0; ch_index < PWM_CFG_KE_CH_MAX_NUM; ch_index++) {
+			TEST_CHECK(get_compare(ch_index) == (((ch_index & 1) == 0) ? (TIM_ARR(TEST_TIMER) + 1) : 0));
+		}
+	}
+}
+
+
+/* A dithered channel averages its fractional compare value over the
+ * periods, also when frames of the other channels are bursted meanwhile */
+void test_pwm_dithering(void)
+{
+	uint16_t frame[PWM_CFG_KE_CH_MAX_NUM];
+	uint64_t counts;
+	uint64_t sum = 0;
+	uint64_t expected_q16;
+	uint32_t period_index;
+	uint32_t compare;
+	uint32_t min_compare = UINT32_MAX;
+	uint32_t max_compare = 0;
+	uint8_t ch_index;
+
+	start_pwm();
+	counts = (uint64_t)TIM_ARR(TEST_TIMER) + 1;
+	expected_q16 = (uint64_t)DITHER_DUTY * counts;
+
+	pwm_set_duty(0, DITHER_DUTY);
+	pwm_set_dithering(0, true);
+	TEST_CHECK((TIM_DIER(TEST_TIMER) & TIM_DIER_UIE) != 0);
+	/* first period loads the first dithered value */
+	sim_advance(EXACT_PERIOD_PS / 2);
+	sim_advance(EXACT_PERIOD_PS);
+
+	for (period_index = 0; period_index < DITHER_PERIODS; period_index++) {
+		/* the other channels change at times */
+		if ((period_index % 64) == 0) {
+			for (ch_index = 0; ch_index < PWM_CFG_KE_CH_MAX_NUM; ch_index++) {
+				frame[ch_index] = (ch_index == 0) ? DITHER_DUTY : (uint16_t)(period_index * 61 * (ch_index + 1));
+			}
+			pwm_set_frame(frame, PWM_CFG_KE_CH_MAX_NUM);
+		}
+		compare = get_compare(0);
+		sum += compare;
+		min_compare = (compare < min_compare) ? compare : min_compare;
+		max_compare = (compare > max_compare) ? compare : max_compare;
+		sim_advance(EXACT_PERIOD_PS);
+	}
+
+	/* two nearest counts only, average within a count over all the periods */
+	TEST_CHECK((max_compare - min_compare) == 1);
+	TEST_CHECK(((sum << 16) + (DITHER_PERIODS << 16)) >= (expected_q16 * DITHER_PERIODS));
+	TEST_CHECK((sum << 16) <= ((expected_q16 * DITHER_PERIODS) + (DITHER_PERIODS << 16)));
+
+	pwm_set_dithering(0, false);
+	TEST_CHECK((TIM_DIER(TEST_TIMER) & TIM_DIER_UIE) == 0);
+
+	test_report("expected_counts", (double)expected_q16 / 65536.0);
+	test_report("mean_counts", (double)sum / DITHER_PERIODS);
+}
+
+
+/* Each group and channel of the configuration tables is set up: timer
+ * period at the default frequency, DMA burst, compare mode and output pin */
+void test_pwm_init_table(void)
+{
+	const pwm_cfg_group_t *group_ptr;
+	const pwm_cfg_channel_t *ch_ptr;
+	uint8_t group_index;
+	uint8_t ch_index;
+	uint8_t ccr_index;
+	uint8_t pin;
+	uint32_t ccmr;
+	uint64_t counts;
+	uint64_t freq_mhz;
+	uint64_t max_error_mhz;
+
+	clock_setup();
+	pwm_init();
+	pwm_start();
+
+	for (group_index = 0; group_index < PWM_CFG_KE_GROUP_MAX_NUM; group_index++) {
+		group_ptr = &pwm_cfg_groups[group_index];
+
+		/* counter running with preloaded period at the default frequency */
+		TEST_CHECK((TIM_CR1(group_ptr->timer) & (TIM_CR1_CEN | TIM_CR1_ARPE)) == (TIM_CR1_CEN | TIM_CR1_ARPE));
+		counts = ((uint64_t)TIM_PSC(group_ptr->timer) + 1) * ((uint64_t)TIM_ARR(group_ptr->timer) + 1);
+		freq_mhz = ((uint64_t)sim_get_timer_clock(group_ptr->timer) * 1000) / counts;
+		max_error_mhz = (uint64_t)group_ptr->default_freq_hz * MAX_FREQ_ERROR_PERMILLE;
+		TEST_CHECK((freq_mhz + max_error_mhz) >= ((uint64_t)group_ptr->default_freq_hz * 1000));
+		TEST_CHECK(freq_mhz <= (((uint64_t)group_ptr->default_freq_hz * 1000) + max_error_mhz));
+		if (group_ptr->advanced) {
+			TEST_CHECK((TIM_BDTR(group_ptr->timer) & TIM_BDTR_MOE) != 0);
+		}
+
+		/* update DMA request on the configured stream and channel, burst through DMAR */
+		if (group_ptr->dma != 0) {
+			TEST_CHECK((TIM_DIER(group_ptr->timer) & TIM_DIER_UDE) != 0);
+			TEST_CHECK((DMA_SCR(group_ptr->dma, group_ptr->dma_stream) & DMA_SxCR_CHSEL_MASK) == group_ptr->dma_channel);
+			TEST_CHECK(DMA_SPAR(group_ptr->dma, group_ptr->dma_stream) == (uint32_t)(uintptr_t)&TIM_DMAR(group_ptr->timer));
+			TEST_CHECK(((TIM_DCR(group_ptr->timer) >> 8) & 0x1F) == (PWM_CFG_TIM_CCR_NUM - 1));
+		}
+	}
+
+	for (ch_index = 0; ch_index < PWM_CFG_KE_CH_MAX_NUM; ch_index++) {
+		ch_ptr = &pwm_cfg_channels[ch_index];
+		group_ptr = &pwm_cfg_groups[ch_ptr->group];
+		ccr_index = ch_ptr->ccr_index;
+
+		/* compare register of the output, PWM mode 1 with preload, output enabled */
+		TEST_CHECK(((uint8_t)ch_ptr->oc >> 1) == ccr_index);
+		ccmr = (ccr_index < 2) ? TIM_CCMR1(group_ptr->timer) : TIM_CCMR2(group_ptr->timer);
+		ccmr >>= (ccr_index & 1) * 8;
+		TEST_CHECK(((ccmr >> 4) & 0x7) == OCM_PWM1);
+		TEST_CHECK((ccmr & ((uint32_t)1 << 3)) != 0);
+		TEST_CHECK((TIM_CCER(group_ptr->timer) & ((uint32_t)1 << (ccr_index * 4))) != 0);
+
+		/* pin in alternate function mode, with the configured function */
+		pin = (uint8_t)__builtin_ctz(ch_ptr->gpio_pin);
+		TEST_CHECK(((GPIO_MODER(ch_ptr->gpio_port) >> (pin * 2)) & 0x3) == GPIO_MODE_AF);
+		TEST_CHECK((((pin < 8) ? (GPIO_AFRL(ch_ptr->gpio_port) >> (pin * 4))
+							   : (GPIO_AFRH(ch_ptr->gpio_port) >> ((pin - 8) * 4))) & 0xF) == ch_ptr->gpio_af);
+	}
+
+	test_report("groups", PWM_CFG_KE_GROUP_MAX_NUM);
+	test_report("channels", PWM_CFG_KE_CH_MAX_NUM);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Init and start the PWM at the test frequency, with the clock of normal operation */
+static void start_pwm(void)
+{
+	clock_setup();
+	pwm_init();
+	pwm_set_frequency(TEST_FREQ_HZ);
+	pwm_start();
+	sim_advance(PERIOD_PS);
+}
+
+
+/* Get the compare register of a channel */
+static uint32_t get_compare(uint8_t ch_index)
+{
+	const pwm_cfg_channel_t *ch_ptr = &pwm_cfg_channels[ch_index];
+
+	return MMIO32(pwm_cfg_groups[ch_ptr->group].timer + 0x34 + (ch_ptr->ccr_index * sizeof(uint32_t)));
+}
+
+
+/* Compare value of a duty cycle [1/65536] in the actual period, rounded.
+ * Full scale is stretched to 0x10000: it gives the whole period */
+static uint32_t expected_compare(uint16_t duty)
+{
+	uint64_t counts = (uint64_t)TIM_ARR(TEST_TIMER) + 1;
+
+	return (uint32_t)(((((uint64_t)duty + (duty >> 15)) * counts) + 0x8000) >> 16);
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,185 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Tick period changes on the simulated TIM2. A change to a period shorter
+ * than the interrupt latency makes the tick overdue: it shall be served and
+ * the callback deadlines shall not move. A tick longer than the LED tick
+ * shall catch up the LED ticks in one composition, with fades on time */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/timer.h>
+
+#include "clock.h"
+#include "timebase.h"
+#include "rtos.h"
+#include "rtos_cfg.h"
+#include "led.h"
+#include "led_gamma.h"
+#include "fade.h"
+#include "sim.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Convert a time in ms into ps */
+#define MS_TO_PS(ms)					((uint64_t)(ms) * SIM_PS_PER_US * 1000)
+
+/* Tick periods switched between [us] */
+#define SHORT_PERIOD_US					((uint32_t)1000)
+#define LONG_PERIOD_US					((uint32_t)5000)
+
+/* Interrupt latency of the tick that applies the short period: longer than it [us] */
+#define HOLD_US							((uint64_t)1500)
+
+/* Switches to the short period */
+#define SWITCHES_NUM					20
+
+/* Time at each period [ms] */
+#define SETTLE_MS						20
+
+/* Callback of the deadline case and its period [ms] */
+#define TEST_CB_ID						RTOS_CB_ID_1
+#define TEST_CB_PERIOD_MS				((uint32_t)5)
+
+/* Tick period of the LED case: ten LED ticks [us] */
+#define LED_CASE_PERIOD_US				((uint32_t)100000)
+
+/* Fade of the LED case */
+#define FADE_MS							((uint16_t)1000)
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void empty_callback(void);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Serve the tick that applies a short period late, many times: the
+ * callback expiries shall keep their nominal schedule */
+void test_tick_switch_deadlines(void)
+{
+	const sim_trace_cb_t *trace_ptr;
+	uint64_t remaining_ps;
+	uint64_t expected;
+	int64_t lateness_ps;
+	uint8_t switch_index;
+
+	clock_setup();
+	timebase_setup();
+	rtos_set_tick_period(LONG_PERIOD_US);
+	rtos_start_operation(RTOS_CFG_KE_NORMAL_STATE);
+	rtos_set_callback(TEST_CB_ID, RTOS_CB_TYPE_PERIODIC, TEST_CB_PERIOD_MS, &empty_callback);
+
+	for (switch_index = 0; switch_index < SWITCHES_NUM; switch_index++) {
+		rtos_set_tick_period(LONG_PERIOD_US);
+		sim_advance(MS_TO_PS(SETTLE_MS));
+
+		/* the next tick applies the short period: hold the interrupts across its update event */
+		rtos_set_tick_period(SHORT_PERIOD_US);
+		remaining_ps = (((uint64_t)TIM_ARR(TIM2) + 1 - timer_get_counter(TIM2)) * SIM_PS_PER_S)
+					   / clock_get_timer_frequency(TIM2);
+		cm_disable_interrupts();
+		sim_advance(remaining_ps + (HOLD_US * SIM_PS_PER_US));
+		cm_enable_interrupts();
+
+		sim_advance(MS_TO_PS(SETTLE_MS));
+	}
+
+	/* last expiry against the nominal schedule: no later than a tick and the latency */
+	trace_ptr = sim_trace_get_callback(TEST_CB_ID);
+	lateness_ps = (int64_t)(trace_ptr->expired_ps - (trace_ptr->set_ps + (trace_ptr->activations * trace_ptr->period_ps)));
+	TEST_CHECK(lateness_ps >= 0);
+	TEST_CHECK(lateness_ps <= (int64_t)((LONG_PERIOD_US + HOLD_US) * SIM_PS_PER_US));
+
+	/* no expiry is missing */
+	expected = (sim_get_time_ps() - trace_ptr->set_ps) / trace_ptr->period_ps;
+	TEST_CHECK((trace_ptr->activations + 1) >= expected);
+	TEST_CHECK(trace_ptr->activations <= expected);
+	TEST_CHECK(sim_get_stats()->irq_lost == 0);
+
+	test_report("activations", (double)trace_ptr->activations);
+	test_report("expected", (double)expected);
+	test_report("lateness_us", (double)lateness_ps / SIM_PS_PER_US);
+}
+
+
+/* Fade a LED with a tick of ten LED ticks: one composition per tick, and
+ * the fade ends on time */
+void test_tick_led_catch_up(void)
+{
+	uint32_t start_refreshes;
+	uint32_t refreshes;
+
+	clock_setup();
+	timebase_setup();
+	led_init();
+	rtos_set_tick_period(LED_CASE_PERIOD_US);
+	rtos_start_operation(RTOS_CFG_KE_NORMAL_STATE);
+
+	start_refreshes = led_get_refresh_count();
+	led_fade_brightness(LED_KE_CHANNEL_1, LED_GAMMA_LEVELS - 1, FADE_MS, FADE_KE_LINEAR);
+
+	/* running up to the last tick before the end, over by the next one */
+	sim_advance(MS_TO_PS(FADE_MS) - (LED_CASE_PERIOD_US * SIM_PS_PER_US));
+	TEST_CHECK(fade_is_active(LED_KE_CHANNEL_1));
+	sim_advance(2 * LED_CASE_PERIOD_US * SIM_PS_PER_US);
+	TEST_CHECK(!fade_is_active(LED_KE_CHANNEL_1));
+	TEST_CHECK(fade_get_level(LED_KE_CHANNEL_1) == (LED_GAMMA_LEVELS - 1));
+
+	/* one composition per tick at most */
+	refreshes = led_get_refresh_count() - start_refreshes;
+	TEST_CHECK(refreshes <= ((FADE_MS * 1000 / LED_CASE_PERIOD_US) + 1));
+
+	test_report("refreshes", refreshes);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Callback with no work: its expiries are traced */
+static void empty_callback(void)
+{
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,171 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Timebase across the half period (TIM5 compare 1) and wrap (update) edges
+ * of the simulated TIM5. The counter is written just before each edge, then
+ * the clock is stepped over it 1 us at a time, with the interrupt served at
+ * once or held pending for up to a quarter of the counter period: every read
+ * shall give the exact time of the edge plus the elapsed time */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/timer.h>
+
+#include "clock.h"
+#include "timebase.h"
+#include "sim.h"
+#include "test.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Virtual time of a timebase count [ps] */
+#define PS_PER_US						(SIM_PS_PER_S / TIMEBASE_FREQUENCY_HZ)
+
+/* Half period of the counter [us] */
+#define HALF_PERIOD_US					((uint64_t)1 << 31)
+
+/* Edges crossed: compare 1 and update in turn, over 4 counter periods */
+#define EDGES_NUM						8
+
+/* Reads before and after each edge, 1 us apart */
+#define EDGE_MARGIN_US					4
+
+/* Longest interrupt hold after an edge [us]: a quarter of the counter period */
+#define MAX_HOLD_US						((int32_t)1 << 30)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Random generator state */
+static uint64_t random_state = 1;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static bool check_read(uint64_t);
+static int32_t get_random(int32_t, int32_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Cross each edge with the interrupt served at once, then held pending */
+void test_timebase_wrap(void)
+{
+	uint8_t edge;
+	int32_t offset;
+	int32_t hold_us;
+	uint64_t edge_us;
+	bool held;
+	uint32_t reads = 0;
+	uint32_t errors = 0;
+
+	clock_setup();
+	timebase_setup();
+	TEST_CHECK(timebase_get_us() == 0);
+
+	for (edge = 1; edge <= EDGES_NUM; edge++) {
+		edge_us = edge * HALF_PERIOD_US;
+		/* every other pair of edges, a compare 1 and an update, is crossed with the interrupt held */
+		held = ((((edge - 1) >> 1) & 1) != 0);
+
+		/* skip to the edge: the counter stays in the same half period */
+		timer_set_counter(TIM5, (uint32_t)(edge_us - EDGE_MARGIN_US));
+
+		if (held) {
+			cm_disable_interrupts();
+		}
+		for (offset = -EDGE_MARGIN_US; offset <= EDGE_MARGIN_US; offset++) {
+			errors += check_read(edge_us + (uint64_t)(int64_t)offset) ? 0 : 1;
+			reads++;
+			sim_advance(PS_PER_US);
+		}
+
+		if (held) {
+			/* the flag stays set while the interrupt waits */
+			TEST_CHECK(timer_get_flag(TIM5, ((edge % 2) != 0) ? TIM_SR_CC1IF : TIM_SR_UIF));
+			hold_us = get_random(1, MAX_HOLD_US);
+			sim_advance((uint64_t)hold_us * PS_PER_US);
+			errors += check_read(edge_us + EDGE_MARGIN_US + 1 + (uint64_t)hold_us) ? 0 : 1;
+			reads++;
+
+			cm_enable_interrupts();
+			errors += check_read(edge_us + EDGE_MARGIN_US + 1 + (uint64_t)hold_us) ? 0 : 1;
+			reads++;
+		}
+	}
+
+	TEST_CHECK(errors == 0);
+	TEST_CHECK(sim_get_stats()->irq_lost == 0);
+	test_report("edges", EDGES_NUM);
+	test_report("reads", reads);
+	test_report("errors", errors);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Check a read of the timebase and of its low 32 bits against the expected time */
+static bool check_read(uint64_t expected_us)
+{
+	uint64_t time_us = timebase_get_us();
+	uint32_t time_us32 = timebase_get_us32();
+
+	TEST_CHECK(time_us == expected_us);
+	TEST_CHECK(time_us32 == (uint32_t)expected_us);
+
+	return (time_us == expected_us) && (time_us32 == (uint32_t)expected_us);
+}
+
+
+/* Get a random value in [min, max]: xorshift64* */
+static int32_t get_random(int32_t min, int32_t max)
+{
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return min + (int32_t)(((random_state * 0x2545F4914F6CDD1DULL) >> 11) % (uint64_t)(max - min + 1));
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,269 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* One-shot timers with microsecond resolution. Deadlines are kept on the
+ * timebase (timebase.c) in a queue sorted by deadline, and the earliest one
+ * is programmed on the compare channel 1 of TIM2, which counts the RTOS
+ * tick at the timer clock. A deadline beyond the actual tick period is
+ * programmed at the update event of its period.
+ * A callback runs in the TIM2 interrupt, never before its deadline, late by
+ * the interrupt latency plus less than 1 us.
+ * The queue is changed with the interrupts masked: timers can be started
+ * and stopped from any context, also from a callback */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/timer.h>
+
+#include "timebase.h"
+#include "hrtimer.h"
+#include "clock.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* TIM2 counter clock: it follows the clock speed */
+#define TIM2_COUNTER_HZ					clock_get_timer_frequency(TIM2)
+
+/* End of the queue */
+#define NO_TIMER						((uint8_t)0xFF)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Deadline of each timer [us of the timebase] */
+static uint64_t deadlines_us[HRTIMER_ID_MAX_NUM];
+
+/* Callback of each timer */
+static hrtimer_callback_t callbacks[HRTIMER_ID_MAX_NUM];
+
+/* Next timer in the queue for each queued timer */
+static uint8_t next_ids[HRTIMER_ID_MAX_NUM];
+
+/* Queued flag of each timer */
+static bool queued[HRTIMER_ID_MAX_NUM];
+
+/* Timer with the earliest deadline */
+static uint8_t queue_head = NO_TIMER;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void insert_timer(uint8_t);
+static void remove_timer(uint8_t);
+static void program_compare(void);
+static bool arm_compare(void);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Start a timer: call a callback once after a delay [us]. A running timer
+ * restarts with the new delay */
+void hrtimer_start(uint8_t timer_id, uint32_t delay_us, hrtimer_callback_t callback)
+{
+	uint32_t primask;
+
+	if ((timer_id < HRTIMER_ID_MAX_NUM) && (callback != NULL)) {
+		primask = cm_mask_interrupts(1);
+
+		remove_timer(timer_id);
+		deadlines_us[timer_id] = timebase_get_us() + delay_us;
+		callbacks[timer_id] = callback;
+		insert_timer(timer_id);
+
+		/* a new earliest deadline moves the compare value */
+		if (queue_head == timer_id) {
+			program_compare();
+		}
+
+		(void)cm_mask_interrupts(primask);
+	} else {
+		/* invalid parameters */
+	}
+}
+
+
+/* Stop a timer. Its callback is not called */
+void hrtimer_stop(uint8_t timer_id)
+{
+	uint32_t primask;
+
+	if (timer_id < HRTIMER_ID_MAX_NUM) {
+		primask = cm_mask_interrupts(1);
+
+		if (queue_head == timer_id) {
+			remove_timer(timer_id);
+			program_compare();
+		} else {
+			remove_timer(timer_id);
+		}
+
+		(void)cm_mask_interrupts(primask);
+	} else {
+		/* invalid parameter */
+	}
+}
+
+
+/* Check if a timer is running */
+bool hrtimer_is_running(uint8_t timer_id)
+{
+	return (timer_id < HRTIMER_ID_MAX_NUM) && queued[timer_id];
+}
+
+
+/* Program the earliest deadline again after a TIM2 setup or a change of
+ * its clock. The deadlines elapsed while TIM2 was stopped expire at once */
+void hrtimer_resume(void)
+{
+	uint32_t primask = cm_mask_interrupts(1);
+
+	program_compare();
+
+	(void)cm_mask_interrupts(primask);
+}
+
+
+/* Call the callbacks of the expired timers in deadline order and program
+ * the next deadline. To be called by the TIM2 interrupt at the compare
+ * channel 1 and at the update events */
+void hrtimer_manage(void)
+{
+	uint32_t primask = cm_mask_interrupts(1);
+	uint8_t timer_id;
+
+	/* a deadline passed while it is programmed expires in the same loop */
+	do {
+		while ((queue_head != NO_TIMER) && (deadlines_us[queue_head] <= timebase_get_us())) {
+			timer_id = queue_head;
+			remove_timer(timer_id);
+
+			/* the callback can start timers */
+			(void)cm_mask_interrupts(primask);
+			(*callbacks[timer_id])(timer_id);
+			primask = cm_mask_interrupts(1);
+		}
+	} while (!arm_compare());
+
+	(void)cm_mask_interrupts(primask);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Insert a timer in the queue after the timers with the same or an earlier deadline */
+static void insert_timer(uint8_t timer_id)
+{
+	uint8_t *link_ptr = &queue_head;
+
+	while ((*link_ptr != NO_TIMER) && (deadlines_us[*link_ptr] <= deadlines_us[timer_id])) {
+		link_ptr = &next_ids[*link_ptr];
+	}
+	next_ids[timer_id] = *link_ptr;
+	*link_ptr = timer_id;
+	queued[timer_id] = true;
+}
+
+
+/* Remove a timer from the queue, if queued */
+static void remove_timer(uint8_t timer_id)
+{
+	uint8_t *link_ptr = &queue_head;
+
+	if (queued[timer_id]) {
+		while (*link_ptr != timer_id) {
+			link_ptr = &next_ids[*link_ptr];
+		}
+		*link_ptr = next_ids[timer_id];
+		queued[timer_id] = false;
+	}
+}
+
+
+/* Program the earliest deadline out of the interrupt. If it passed
+ * already, a software compare event lets the interrupt call it */
+static void program_compare(void)
+{
+	if (!arm_compare()) {
+		timer_generate_event(TIM2, TIM_EGR_CC1G);
+	}
+}
+
+
+/* Program the earliest deadline on the compare channel 1 if it is in the
+ * actual tick period. Return false if it passed already */
+static bool arm_compare(void)
+{
+	uint64_t now_us;
+	uint64_t compare_value;
+	bool armed = true;
+
+	if (queue_head == NO_TIMER) {
+		timer_disable_irq(TIM2, TIM_DIER_CC1IE);
+	} else {
+		now_us = timebase_get_us();
+		if (deadlines_us[queue_head] <= now_us) {
+			armed = false;
+		} else {
+			/* the timebase is truncated to the us: the compare never matches early */
+			compare_value = timer_get_counter(TIM2)
+						  + ((deadlines_us[queue_head] - now_us) * (TIM2_COUNTER_HZ / TIMEBASE_FREQUENCY_HZ));
+			if (compare_value > TIM_ARR(TIM2)) {
+				/* beyond the actual tick period: programmed at the update event */
+				timer_disable_irq(TIM2, TIM_DIER_CC1IE);
+			} else {
+				timer_set_oc_value(TIM2, TIM_OC1, (uint32_t)compare_value);
+				timer_clear_flag(TIM2, TIM_SR_CC1IF);
+				timer_enable_irq(TIM2, TIM_DIER_CC1IE);
+				/* the counter can pass the value while it is written */
+				armed = (timer_get_counter(TIM2) < compare_value);
+			}
+		}
+	}
+
+	return armed;
+}
+
+
+
+
+/* End of file */
@@ -0,0 +1,76 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#ifndef _HRTIMER_INCLUDED_         /* switch to read the header file once */
+#define _HRTIMER_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* One-shot timers IDs */
+enum {
+	HRTIMER_ID_1,
+	HRTIMER_ID_2,
+	HRTIMER_ID_3,
+	HRTIMER_ID_4,
+	HRTIMER_ID_5,
+	HRTIMER_ID_6,
+	HRTIMER_ID_7,
+	HRTIMER_ID_8,
+	HRTIMER_ID_MAX_NUM,
+	HRTIMER_ID_CHECK = HRTIMER_ID_MAX_NUM
+};
+
+/* Pointer to callback function. It gets the ID of the expired timer and runs
+ * in the TIM2 interrupt: it shall be short */
+typedef void (*hrtimer_callback_t)(uint8_t);
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void hrtimer_start(uint8_t, uint32_t, hrtimer_callback_t);
+extern void hrtimer_stop(uint8_t);
+extern bool hrtimer_is_running(uint8_t);
+extern void hrtimer_resume(void);
+extern void hrtimer_manage(void);
+
+
+
+
+#endif
+
+/* End of file */
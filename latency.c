@@ -0,0 +1,166 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* Interrupt latency and jitter statistics of a periodic timer interrupt.
+ * The service routine records the timer counter read at its entry: as the
+ * counter restarts from 0 at the update event, it is the time elapsed since
+ * the event. The jitter is the change of latency between two interrupts,
+ * i.e. the error of the period seen by the service routine.
+ * Both are converted into ns and collected in log-linear histograms:
+ * recording is O(1), and the counter clock can change meanwhile */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "histogram.h"
+#include "latency.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Nanoseconds in a second */
+#define NS_PER_S						((uint64_t)1000000000)
+
+/* Percentiles of the report [per mille] */
+#define PERMILLE_P50					((uint32_t)500)
+#define PERMILLE_P90					((uint32_t)900)
+#define PERMILLE_P99					((uint32_t)990)
+#define PERMILLE_P999					((uint32_t)999)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Timer counter period [ns] in Q16 */
+static uint64_t ns_per_count_q16;
+
+/* Latency and jitter histograms [ns] */
+static histogram_t latency_histogram;
+static histogram_t jitter_histogram;
+
+/* Recorded interrupts */
+static uint32_t recorded_samples;
+
+/* Latency of the previous interrupt [ns] */
+static uint32_t prev_ns;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void fill_statistics(const histogram_t *, uint32_t *);
+static uint32_t counts_to_ns(uint32_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Clear the statistics of a timer counting at a frequency [Hz] */
+void latency_init(uint32_t frequency)
+{
+	latency_set_frequency(frequency);
+	histogram_reset(&latency_histogram);
+	histogram_reset(&jitter_histogram);
+	recorded_samples = 0;
+	prev_ns = 0;
+}
+
+
+/* Change the frequency of the timer [Hz]. The statistics are kept */
+void latency_set_frequency(uint32_t frequency)
+{
+	ns_per_count_q16 = (frequency > 0) ? ((NS_PER_S << 16) / frequency) : 0;
+}
+
+
+/* Record the timer counter read at the entry of the service routine */
+void latency_record(uint32_t counts)
+{
+	uint32_t ns = counts_to_ns(counts);
+
+	histogram_record(&latency_histogram, ns);
+
+	/* the first interrupt has no previous one */
+	if (recorded_samples > 0) {
+		histogram_record(&jitter_histogram, (ns > prev_ns) ? (ns - prev_ns) : (prev_ns - ns));
+	}
+	prev_ns = ns;
+	recorded_samples++;
+}
+
+
+/* Get percentiles and max of latency and jitter. To be called out of the
+ * service routine: an interrupt recorded meanwhile may be partially counted */
+void latency_get_report(latency_report_t *report_ptr)
+{
+	report_ptr->samples = recorded_samples;
+	fill_statistics(&latency_histogram, report_ptr->latency_ns);
+	fill_statistics(&jitter_histogram, report_ptr->jitter_ns);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Percentiles and max of a histogram */
+static void fill_statistics(const histogram_t *histogram_ptr, uint32_t *stats_ns)
+{
+	static const uint32_t permilles[LATENCY_ST_MAX] = {
+		PERMILLE_P50,
+		PERMILLE_P90,
+		PERMILLE_P99,
+		PERMILLE_P999
+	};
+	uint8_t stat;
+
+	for (stat = 0; stat < LATENCY_ST_MAX; stat++) {
+		stats_ns[stat] = histogram_get_percentile(histogram_ptr, permilles[stat]);
+	}
+	stats_ns[LATENCY_ST_MAX] = histogram_get_max(histogram_ptr);
+}
+
+
+/* Convert timer counts into ns: no division in the service routine */
+static uint32_t counts_to_ns(uint32_t counts)
+{
+	uint64_t ns = (counts * ns_per_count_q16) >> 16;
+
+	return (ns < UINT32_MAX) ? (uint32_t)ns : UINT32_MAX;
+}
+
+
+
+
+/* End of file */
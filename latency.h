@@ -0,0 +1,73 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#ifndef _LATENCY_INCLUDED_         /* switch to read the header file once */
+#define _LATENCY_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Reported statistics enum */
+enum {
+	LATENCY_ST_P50,
+	LATENCY_ST_P90,
+	LATENCY_ST_P99,
+	LATENCY_ST_P999,
+	LATENCY_ST_MAX,
+	LATENCY_ST_MAX_NUM
+};
+
+/* Latency and jitter report [ns]. Percentiles are rounded up by less than 1 / HISTOGRAM_SUB_BINS_NUM */
+typedef struct {
+	uint32_t samples;
+	uint32_t latency_ns[LATENCY_ST_MAX_NUM];
+	uint32_t jitter_ns[LATENCY_ST_MAX_NUM];
+} latency_report_t;
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void latency_init(uint32_t);
+extern void latency_set_frequency(uint32_t);
+extern void latency_record(uint32_t);
+extern void latency_get_report(latency_report_t *);
+
+
+
+
+#endif
+
+/* End of file */
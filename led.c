@@ -32,8 +32,9 @@
 */
 
 
-//TODO: Modify the timer tick define dependency
-//TODO: decide if blinking period and DC should be dynamically configured or not. They are constant now.
+/* LED ticks last RTOS_UL_TICK_PERIOD_US whatever the RTOS tick period:
+ * tmr.c calls led_manage_blinking() at each RTOS tick that ends LED ticks,
+ * with their number, so a long RTOS tick costs a single composition */
 
 
 /* ---------------- Inclusions ------------------------ */
@@ -43,18 +44,30 @@
 #include "tmr.h"                /* component TMR header file */
 #include "pwm.h"                /* component PWM header file */
 #include "rtos.h"               /* component RTOS header file */
+#include "fade.h"               /* component FADE header file */
+#include "pattern.h"            /* component PATTERN header file */
 #include "led.h"              	/* component header file */
+#include "led_gamma.h"          /* generated dimming table */
 
 
 
 
 /* ----------------- Local defines ----------------- */
 
-/* Blinking period counter value */
-#define US_BLINK_PERIOD_COUNTER_VALUE   ((uint16_t)((uint32_t)(LED_BLINK_PERIOD_VALUE_MS * 1000) / RTOS_UL_TICK_PERIOD_US))
+/* Blinking ON time in ms */
+#define US_BLINK_TON_VALUE_MS           ((uint16_t)((LED_BLINK_PERIOD_VALUE_MS * LED_BLINK_DC_VALUE_PERCENT) / 100))
 
-/* Blinking duty cycle counter value */
-#define US_BLINK_DC_COUNTER_VALUE       ((uint16_t)((US_BLINK_PERIOD_COUNTER_VALUE * LED_BLINK_DC_VALUE_PERCENT) / 100))
+/* Blinking OFF time in ms */
+#define US_BLINK_TOFF_VALUE_MS          ((uint16_t)(LED_BLINK_PERIOD_VALUE_MS - US_BLINK_TON_VALUE_MS))
+
+/* Perceptual level of an illumination level: evenly spread over the dimming table */
+#define ILL_LEVEL_TO_GAMMA_LEVEL(i)     ((uint16_t)((((uint32_t)(i) + 1) * (LED_GAMMA_LEVELS - 1)) / LED_KE_ILL_LEVEL_CHECK))
+
+/* Convert a fade duration in ms into a number of ticks */
+#define MS_TO_TICKS(ms)                 ((uint32_t)(((uint32_t)(ms) * 1000) / RTOS_UL_TICK_PERIOD_US))
+
+/* Perceptual level of a pattern level argument 0 - 255 */
+#define PATTERN_LEVEL_TO_GAMMA_LEVEL(l) ((uint16_t)(((uint32_t)(l) * (LED_GAMMA_LEVELS - 1) + 127) / 255))
 
 
 
@@ -74,70 +87,98 @@
 #define CLEAR_BLINKING_REQ(i)          (ui8BlinkingReqChs &= ~(1 << (i)))
 /* Macro to check blinking LED request */
 #define CHECK_BLINKING_REQ(i)          ((ui8BlinkingReqChs & (1 << (i))) != 0)
-/* Macro to check blinking enable */
-#define CHECK_BLINKING_ENABLED()       (ui8BlinkingReqChs != 0)
-/* Macro to set blinking status ON */
-#define SET_BLINKING_STATUS_ON()       (blinking_status_flag = true)
-/* Macro to set blinking status OFF */
-#define SET_BLINKING_STATUS_OFF()      (blinking_status_flag = false)
-/* Macro to check blinking status */
-#define CHECK_BLINKING_STATUS_ON()     (blinking_status_flag == true)
 
+/* Macro to set alert overlay */
+#define SET_ALERT_REQ(i)               (u8AlertReqChs |= (1 << (i)))
+/* Macro to clear alert overlay */
+#define CLEAR_ALERT_REQ(i)             (u8AlertReqChs &= ~(1 << (i)))
+/* Macro to check alert overlay */
+#define CHECK_ALERT_REQ(i)             ((u8AlertReqChs & (1 << (i))) != 0)
 
+/* Macro to request a frame composition at next tick. It also wakes up the tick function */
+#define SET_FRAME_DIRTY()              (frame_dirty_flag = true)
 
+/* Macro to set pattern output ON. Written from the tick only */
+#define SET_PATTERN_OUT_ON(i)          (u8PatternStateChs |= (1 << (i)))
+/* Macro to set pattern output OFF. Written from the tick only */
+#define SET_PATTERN_OUT_OFF(i)         (u8PatternStateChs &= ~(1 << (i)))
+/* Macro to check pattern output */
+#define CHECK_PATTERN_OUT_ON(i)        ((u8PatternStateChs & (1 << (i))) != 0)
 
-/* ----------------- Local Variables ----------------------- */
 
-/* Module info flags register */
-static bool blinking_status_flag;
 
-/* Channels blinking request bits order as ILL_ke_Channels enum: 1 required - 0 not required. 8 channels */
+
+/* ----------------- Local Variables ----------------------- */
+
+/* Channels blinking (pattern driven) request bits order as ILL_ke_Channels enum: 1 required - 0 not required. 8 channels */
 static uint8_t ui8BlinkingReqChs;
 
 /* Channels state to apply bits order as ILL_ke_ChState enum: 1 ON - 0 OFF. 8 channels*/
 static uint8_t u8StatusReqStateChs;
 
-/* Blinking period timeout */
-static uint16_t ui16BlinkPeriodCounter;
+/* Channels pattern output bits order as ILL_ke_Channels enum: 1 ON - 0 OFF. 8 channels */
+static volatile uint8_t u8PatternStateChs;
 
-/* Blinking TON timeout */
-static uint16_t ui16BlinkTONCounter;
+/* Channels alert overlay bits order as ILL_ke_Channels enum: 1 active - 0 not active. 8 channels */
+static volatile uint8_t u8AlertReqChs;
 
-/* Blinking counter */
-static uint16_t ui16BlinkingCounter;
+/* Back buffer changed since last composition: set by any layer writer, cleared by the tick */
+static volatile bool frame_dirty_flag;
 
-/* Permillage PWM to ill level association array */
-static uint16_t ill_levels_pwm_values[LED_KE_ILL_LEVEL_CHECK] =
+/* Ticks to the next pattern or fade event since last run, PATTERN_NO_EVENT if none. Tick only */
+static uint8_t ticks_to_event;
+
+/* Ticks elapsed since last run. Tick only */
+static uint8_t elapsed_ticks;
+
+/* Number of ticks that did some work */
+static uint32_t refresh_counter;
+
+/* Default blinking pattern */
+static const uint8_t blink_pattern[] =
 {
-	50,
-    100,
-    200,
-    300,
-    400,
-    500,
-	600,
-	700,
-	800,
-	900,
-	950
+	PATTERN_LOOP(0),
+		PATTERN_ON,
+		PATTERN_WAIT(US_BLINK_TON_VALUE_MS),
+		PATTERN_OFF,
+		PATTERN_WAIT(US_BLINK_TOFF_VALUE_MS),
+	PATTERN_END_LOOP
 };
 
-/* Permillage PWM to apply for each channel. Set an average value as default */
-static uint16_t channels_pwm_values[LED_KE_CH_CHECK] =
+/* Perceptual level to ill level association array */
+static const uint16_t ill_levels_gamma_levels[LED_KE_ILL_LEVEL_CHECK] =
 {
-   500,
-   500,
-   500,
-   500
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_1),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_2),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_3),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_4),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_5),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_6),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_7),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_8),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_9),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_10),
+	ILL_LEVEL_TO_GAMMA_LEVEL(LED_KE_ILL_LEVEL_11)
 };
 
+/* PWM duty cycle [1/65536] to apply for each channel. A middle perceptual level is set as default.
+ * This is the level of base and blink layers, driven by fades */
+static volatile uint16_t channels_pwm_values[LED_KE_CH_CHECK];
+
+/* PWM duty cycle [1/65536] of the alert overlay layer */
+static volatile uint16_t alert_pwm_values[LED_KE_CH_CHECK];
+
+/* PWM duty cycle [1/65536] committed to the PWM for each channel: front buffer */
+static uint16_t front_pwm_values[LED_KE_CH_CHECK];
+
 
 
 
 /* ---------------- Local Functions Prototypes ------------------ */
 
-static void set_channel_output(led_ke_channels);
-static void reset_channel_output(led_ke_channels);
+static void compose_frame(void);
+static void fade_output(uint8_t, uint16_t);
+static void pattern_output(uint8_t, uint8_t, uint8_t, uint8_t);
 
 
 
@@ -147,17 +188,31 @@ static void reset_channel_output(led_ke_channels);
 /* Init LED module */
 void led_init(void)
 {
-    /* init module info flags */
-    SET_BLINKING_STATUS_OFF();
-
-    /* init blinking counter */
-    ui16BlinkingCounter = 0;
-
-    /* init blinking period counter value */
-    ui16BlinkPeriodCounter = US_BLINK_PERIOD_COUNTER_VALUE;
-      
-    /* init blinking TON counter value */
-    ui16BlinkTONCounter = US_BLINK_DC_COUNTER_VALUE;
+    uint8_t ch_index;
+
+    /* init layers: all channels off */
+    u8StatusReqStateChs = 0;
+    ui8BlinkingReqChs = 0;
+    u8AlertReqChs = 0;
+    frame_dirty_flag = false;
+    ticks_to_event = PATTERN_NO_EVENT;
+    elapsed_ticks = 0;
+    refresh_counter = 0;
+
+    /* init pattern sequencer */
+    u8PatternStateChs = 0;
+    pattern_init(&pattern_output);
+
+    /* init fade engine */
+    fade_init(&fade_output);
+
+    /* init channels to a middle perceptual level */
+    for (ch_index = LED_KE_FIRST_CH; ch_index <= LED_KE_LAST_CH; ch_index++) {
+        channels_pwm_values[ch_index] = led_gamma_table[LED_GAMMA_LEVELS / 2];
+        fade_set_level(ch_index, LED_GAMMA_LEVELS / 2);
+        alert_pwm_values[ch_index] = 0;
+        front_pwm_values[ch_index] = 0;
+    }
 
     /* init PWM module and channels */
     pwm_init();
@@ -173,6 +228,9 @@ void led_init(void)
 /* Set LED channel status */
 void led_set_channel_status(led_ke_channels ch_index, led_ke_ch_state required_state)
 {
+   uint8_t old_status = u8StatusReqStateChs;
+   uint8_t old_blinking = ui8BlinkingReqChs;
+
    /* check parameters */
    if ((ch_index < LED_KE_CH_CHECK)
    && (required_state < LED_KE_CH_STATE_CHECK)) {
@@ -184,35 +242,30 @@ void led_set_channel_status(led_ke_channels ch_index, led_ke_ch_state required_s
          {
             /* blinking is not required */
             CLEAR_BLINKING_REQ((uint8_t)ch_index);
+            pattern_stop((uint8_t)ch_index);
             /* set to ON */
             SET_TURN_ON_REQ((uint8_t)ch_index);
-            /* set channel immediately */
-            set_channel_output(ch_index);
             break;
          }
          /* blinking */
          case LED_KE_CH_BLINKING:
          {
-            /* blinking is required */
-            SET_BLINKING_REQ((uint8_t)ch_index);
-            /* blinking status is set synchronously to other blinking LEDs */
+            /* blinking is required: run default pattern */
+            led_set_pattern(ch_index, blink_pattern);
             break;
          }
          /* toggle */
          case LED_KE_CH_TOGGLE:
          {
+            /* a toggle stops any pattern */
+            CLEAR_BLINKING_REQ((uint8_t)ch_index);
+            pattern_stop((uint8_t)ch_index);
             /* toggle status */
             if (CHECK_TURN_ON_REQ((uint8_t)ch_index)) {
                 SET_TURN_OFF_REQ((uint8_t)ch_index);
-                /* reset channel immediately */
-                reset_channel_output(ch_index);
             } else {
                 SET_TURN_ON_REQ((uint8_t)ch_index);
-                /* set channel immediately */
-                set_channel_output(ch_index);
             }
-            /* ATTENTION: evaluate if it is necessary to update the
-             * required channel immediately or at the next task run */
             break;
          }
          /* turn OFF and default */
@@ -220,16 +273,9 @@ void led_set_channel_status(led_ke_channels ch_index, led_ke_ch_state required_s
          {
             /* set to OFF */
             SET_TURN_OFF_REQ((uint8_t)ch_index);
-            /* LED is turned off immediately if it is not blinking only.
-               If LED is blinking the turn off status shall be updated
-               with other blinking LEDs */
-            if (CHECK_BLINKING_REQ((uint8_t)ch_index)) {
-               /* clear blinking request */
-               CLEAR_BLINKING_REQ((uint8_t)ch_index);
-            } else {
-                /* reset channel immediately */
-                reset_channel_output(ch_index);
-            }
+            /* stop any pattern */
+            CLEAR_BLINKING_REQ((uint8_t)ch_index);
+            pattern_stop((uint8_t)ch_index);
             break;
          }
          default:
@@ -237,90 +283,164 @@ void led_set_channel_status(led_ke_channels ch_index, led_ke_ch_state required_s
             /* invalid status: do nothing */
          }
       }
+      /* output is updated at next tick together with other channels. A request that
+       * changes nothing does not wake up the tick. A new pattern wakes it up by itself */
+      if ((old_status != u8StatusReqStateChs)
+      || (old_blinking != ui8BlinkingReqChs)) {
+          SET_FRAME_DIRTY();
+      }
    } else {
       /* invalid LED index: do nothing */
    }
 }
 
 
+/* Run a pattern on a channel. Pattern shall be a static array */
+void led_set_pattern(led_ke_channels ch_index, const uint8_t *pattern_ptr)
+{
+    if ((ch_index < LED_KE_CH_CHECK)
+    && (pattern_ptr != NULL)) {
+        /* channel output follows the pattern from next tick */
+        SET_BLINKING_REQ((uint8_t)ch_index);
+        pattern_start((uint8_t)ch_index, pattern_ptr);
+        SET_FRAME_DIRTY();
+    } else {
+        /* invalid parameters: do nothing */
+    }
+}
+
+
+/* Set alert overlay: it hides base and blink layers of the channel */
+void led_set_alert(led_ke_channels channel_id, uint16_t level)
+{
+    if ((level < LED_GAMMA_LEVELS)
+    && (channel_id < LED_KE_CH_CHECK)) {
+        alert_pwm_values[(uint8_t)channel_id] = led_gamma_table[level];
+        SET_ALERT_REQ((uint8_t)channel_id);
+        SET_FRAME_DIRTY();
+    } else {
+        /* do nothing - discard request */
+    }
+}
+
+
+/* Clear alert overlay: base and blink layers show again */
+void led_clear_alert(led_ke_channels channel_id)
+{
+    if (channel_id < LED_KE_CH_CHECK) {
+        CLEAR_ALERT_REQ((uint8_t)channel_id);
+        SET_FRAME_DIRTY();
+    } else {
+        /* do nothing - discard request */
+    }
+}
+
+
 /* Set illumination level - for ill channels only */
 void led_set_illumination_level(led_ke_channels channel_id, led_ke_ill_level ill_level)
 {
     /* check required level */
     if ((ill_level < LED_KE_ILL_LEVEL_CHECK)
     && (channel_id < LED_KE_CH_CHECK)) {
+        /* stop any running fade */
+        fade_set_level((uint8_t)channel_id, ill_levels_gamma_levels[(uint8_t)ill_level]);
         /* set required PWM value for required channel */
-    	channels_pwm_values[(uint8_t)channel_id] = ill_levels_pwm_values[(uint8_t)ill_level];
+        if (channels_pwm_values[(uint8_t)channel_id] != led_gamma_table[ill_levels_gamma_levels[(uint8_t)ill_level]]) {
+            channels_pwm_values[(uint8_t)channel_id] = led_gamma_table[ill_levels_gamma_levels[(uint8_t)ill_level]];
+            SET_FRAME_DIRTY();
+        }
     } else {
         /* do nothing - discard request */
     }
 }
 
 
-/* Manage blinking */
-void led_manage_blinking(void)
+/* Set perceptual brightness level: 0 to LED_GAMMA_LEVELS - 1 */
+void led_set_brightness(led_ke_channels channel_id, uint16_t level)
 {
-    /* if almost one LED is required to blink */
-    if (CHECK_BLINKING_ENABLED()) {
-        /* increment blinking counter */
-        ui16BlinkingCounter++;
-
-        /* check if TOFF is elapsed. The >= is to avoid uncorrect overflow conditions */
-        if (ui16BlinkingCounter >= ui16BlinkPeriodCounter) {
-            /* TOFF is elapsed: turn ON */
-            SET_BLINKING_STATUS_ON();
-
-            /* New period and TON values are constants value.
-            Do not update at every period. */
-
-            /* reset blinking counter */
-            ui16BlinkingCounter = 0;
-        } else if (ui16BlinkingCounter == ui16BlinkTONCounter) {
-            /* TON is elapsed: turn OFF */
-            SET_BLINKING_STATUS_OFF();
-        } else {
-            /* leave counter to reach TON or TOFF */
+    /* check required level */
+    if ((level < LED_GAMMA_LEVELS)
+    && (channel_id < LED_KE_CH_CHECK)) {
+        /* stop any running fade */
+        fade_set_level((uint8_t)channel_id, level);
+        /* gamma corrected PWM value: a single table read */
+        if (channels_pwm_values[(uint8_t)channel_id] != led_gamma_table[level]) {
+            channels_pwm_values[(uint8_t)channel_id] = led_gamma_table[level];
+            SET_FRAME_DIRTY();
+        }
+    } else {
+        /* do nothing - discard request */
+    }
+}
+
+
+/* Fade perceptual brightness level from actual one to required one in the given time */
+void led_fade_brightness(led_ke_channels channel_id, uint16_t level, uint16_t duration_ms, uint8_t curve)
+{
+    uint32_t ticks;
+
+    /* check required level */
+    if ((level < LED_GAMMA_LEVELS)
+    && (channel_id < LED_KE_CH_CHECK)) {
+        /* the only division is here: fade steps are additions and shifts */
+        ticks = MS_TO_TICKS(duration_ms);
+        if (ticks > UINT16_MAX) {
+            ticks = UINT16_MAX;
         }
+        fade_start((uint8_t)channel_id, level, (uint16_t)ticks, curve);
+        /* wake up the tick */
+        SET_FRAME_DIRTY();
     } else {
-        /* reset blinking counter */
-        ui16BlinkingCounter = 0;
+        /* do nothing - discard request */
     }
 }
 
 
-/* ILL periodic task */
-void led_periodic_task(void)
+/* Manage patterns and fades and commit the frame. Called with the LED ticks elapsed
+ * since the previous call, it works only when a request is pending or the next
+ * pattern edge or fade step is due. Many ticks are caught up in one composition */
+void led_manage_blinking(uint8_t ticks)
 {
-	uint8_t ch_index;
-
-	/* toggle blinking channels status if required and apply it */
-	for (ch_index = LED_KE_FIRST_CH; ch_index <= LED_KE_LAST_CH; ch_index++) {
-		/* if blink channel required */
-		if (CHECK_BLINKING_REQ(ch_index)) {
-			/* update channel status info and apply it */
-			if (CHECK_BLINKING_STATUS_ON()) {
-				SET_TURN_ON_REQ(ch_index);
-				/* ATTENTION: this operation should be done after for loop
-				 * in order to update all channels simultaneously */
-				/* set channel output */
-				set_channel_output(ch_index);
-			} else {
-				SET_TURN_OFF_REQ(ch_index);
-				/* ATTENTION: this operation should be done after for loop
-				 * in order to update all channels simultaneously */
-				/* reset channel output */
-				reset_channel_output(ch_index);
-			}
-		} else {
-			/* update eventual illumination level */
-			if (CHECK_TURN_ON_REQ(ch_index)) {
-				/* set channel output */
-				set_channel_output(ch_index);
-			} else {
-				/* do nothing */
-			}
-		}
-	}
+    bool fade_running;
+
+    /* all LEDs static: no work */
+    if ((!frame_dirty_flag)
+    && (ticks_to_event == PATTERN_NO_EVENT)) {
+        return;
+    }
+
+    /* wait for next edge. No event is more than UINT8_MAX ticks away */
+    elapsed_ticks = (elapsed_ticks > (UINT8_MAX - ticks)) ? UINT8_MAX : (uint8_t)(elapsed_ticks + ticks);
+    if ((!frame_dirty_flag)
+    && (elapsed_ticks < ticks_to_event)) {
+        return;
+    }
+
+    refresh_counter++;
+
+    /* run patterns first: they can start fades */
+    ticks_to_event = pattern_tick(elapsed_ticks);
+    elapsed_ticks = 0;
+
+    /* advance running fades: a running fade has a step at each tick */
+    fade_running = fade_tick(ticks);
+    if (fade_running) {
+        ticks_to_event = 1;
+    }
+
+    /* merge layers and commit only if something has changed */
+    if (frame_dirty_flag) {
+        /* clear first: a change made during the composition is caught at next tick */
+        frame_dirty_flag = false;
+        compose_frame();
+    }
+}
+
+
+/* Get the number of ticks that did some work: compared with elapsed ticks it gives the LED load */
+uint32_t led_get_refresh_count(void)
+{
+    return refresh_counter;
 }
 
 
@@ -328,26 +448,95 @@ void led_periodic_task(void)
 
 /* ---------------- Local Functions ------------------ */
 
-/* set a channel output status according to its channel number */
-static void set_channel_output( led_ke_channels channel_id )
+/* merge layers by priority (alert, blink, base) and commit changed channels */
+static void compose_frame(void)
 {
-    /* set channel status */
-    if (channel_id < LED_KE_CH_CHECK) {
-        /* update related PWM channel */
-    	pwm_set_dc(channel_id, channels_pwm_values[(uint8_t)channel_id]);
+    uint8_t ch_index;
+    uint8_t changed_num = 0;
+    uint8_t changed_ch = 0;
+    uint16_t frame_pwm_values[LED_KE_CH_CHECK];
+
+    for (ch_index = LED_KE_FIRST_CH; ch_index <= LED_KE_LAST_CH; ch_index++) {
+        if (CHECK_ALERT_REQ(ch_index)) {
+            /* alert overlay has the highest priority */
+            frame_pwm_values[ch_index] = alert_pwm_values[ch_index];
+        } else if (CHECK_BLINKING_REQ(ch_index)) {
+            /* blink layer: pattern output at the fade level */
+            frame_pwm_values[ch_index] = CHECK_PATTERN_OUT_ON(ch_index) ? channels_pwm_values[ch_index] : 0;
+        } else {
+            /* base layer: required state at the fade level */
+            frame_pwm_values[ch_index] = CHECK_TURN_ON_REQ(ch_index) ? channels_pwm_values[ch_index] : 0;
+        }
+
+        if (frame_pwm_values[ch_index] != front_pwm_values[ch_index]) {
+            front_pwm_values[ch_index] = frame_pwm_values[ch_index];
+            changed_ch = ch_index;
+            changed_num++;
+        }
+    }
+
+    if (changed_num == 1) {
+        /* a single compare register to write */
+        pwm_set_duty(changed_ch, front_pwm_values[changed_ch]);
+    } else if (changed_num > 1) {
+        /* update all channels simultaneously with one DMA burst */
+        pwm_set_frame(front_pwm_values, LED_KE_CH_CHECK);
+    } else {
+        /* nothing changed: no register write */
+    }
+}
+
+
+/* fade output: called from the tick only when the perceptual level has changed */
+static void fade_output(uint8_t ch_index, uint16_t level)
+{
+    if (ch_index < LED_KE_CH_CHECK) {
+        /* levels are gamma table indexes: clamp anything beyond the table */
+        if (level >= LED_GAMMA_LEVELS) {
+            level = LED_GAMMA_LEVELS - 1;
+        }
+        channels_pwm_values[ch_index] = led_gamma_table[level];
+        SET_FRAME_DIRTY();
     } else {
     	/* discard the request, do nothing */
     }
 }
 
 
-/* set a channel output status according to its channel number */
-static void reset_channel_output( led_ke_channels channel_id )
+/* pattern output: called from the tick */
+static void pattern_output(uint8_t ch_index, uint8_t opcode, uint8_t level, uint8_t ticks)
 {
-    /* reset channel status */
-    if (channel_id < LED_KE_CH_CHECK) {
-        /* update related PWM channel */
-    	pwm_set_dc(channel_id, 0);
+    if (ch_index < LED_KE_CH_CHECK) {
+        switch (opcode) {
+        case PATTERN_OP_ON:
+        {
+            SET_PATTERN_OUT_ON(ch_index);
+            SET_FRAME_DIRTY();
+            break;
+        }
+        case PATTERN_OP_OFF:
+        {
+            SET_PATTERN_OUT_OFF(ch_index);
+            SET_FRAME_DIRTY();
+            break;
+        }
+        case PATTERN_OP_LEVEL:
+        {
+            /* fade in 1 tick: output is updated at once by the following fade tick */
+            fade_start(ch_index, PATTERN_LEVEL_TO_GAMMA_LEVEL(level), 1, FADE_KE_LINEAR);
+            break;
+        }
+        case PATTERN_OP_FADE:
+        {
+            fade_start(ch_index, PATTERN_LEVEL_TO_GAMMA_LEVEL(level), ticks, FADE_KE_EASE_IN_OUT);
+            break;
+        }
+        default:
+        {
+            /* not an output instruction: do nothing */
+            break;
+        }
+        }
     } else {
     	/* discard the request, do nothing */
     }
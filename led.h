@@ -40,6 +40,10 @@
 /* ------------ Inclusions ----------------- */
 
 #include <stdint.h>
+/* This inclusion is for other modules that include this component: fade curves */
+#include "fade.h"
+/* This inclusion is for other modules that include this component: pattern macros */
+#include "pattern.h"
 
 
 
@@ -109,9 +113,14 @@ typedef enum
 
 extern void led_init(void);
 extern void led_set_channel_status(led_ke_channels, led_ke_ch_state);
+extern void led_set_pattern(led_ke_channels, const uint8_t *);
 extern void led_set_illumination_level(led_ke_channels, led_ke_ill_level);
-extern void led_manage_blinking(void);
-extern void led_periodic_task(void);
+extern void led_set_brightness(led_ke_channels, uint16_t);
+extern void led_set_alert(led_ke_channels, uint16_t);
+extern void led_clear_alert(led_ke_channels);
+extern void led_fade_brightness(led_ke_channels, uint16_t, uint16_t, uint8_t);
+extern void led_manage_blinking(uint8_t);
+extern uint32_t led_get_refresh_count(void);
 
 
 
@@ -56,8 +56,14 @@
 /* ADD_REG_CTRL_4 register configuration value: X,Y,Z axis enabled and 400Hz of output data rate */
 #define UC_ADD_REG_CTRL_4_CFG_VALUE		0x77
 
-/* Sensitivity for 2G range [mg/digit] */
-#define SENS_2G_RANGE_MG_PER_DIGIT		((float)0.06)
+/* Rounding constant of Q16 values */
+#define Q16_ROUNDING					((int32_t)1 << 15)
+
+/* Max SPI clock [Hz]: the 84MHz APB2 clock divided by 64 */
+#define SPI_MAX_CLOCK_HZ				((uint32_t)1312500)
+
+/* Max SPI baud rate prescaler value: clock divided by 256 */
+#define SPI_MAX_BAUDRATE				((uint8_t)7)
 
 
 
@@ -89,11 +95,32 @@ static const uint8_t axis_reg_addr_array[NUM_OF_AXIS][2] = {
 
 
 
+/* Conversion scale of each axis [mg/digit] in Q16 */
+static int32_t axis_scale_q16[NUM_OF_AXIS] = {
+	LIS3DSH_SENS_2G_MG_PER_DIGIT_Q16,
+	LIS3DSH_SENS_2G_MG_PER_DIGIT_Q16,
+	LIS3DSH_SENS_2G_MG_PER_DIGIT_Q16
+};
+
+/* APB2 clock the SPI prescaler is computed with [Hz]. 0 until setup */
+static uint32_t spi_pclk_hz = 0;
+
+/* Conversion offset of each axis [mg] in Q16 */
+static int32_t axis_offset_q16[NUM_OF_AXIS] = {
+	Q16_ROUNDING,
+	Q16_ROUNDING,
+	Q16_ROUNDING
+};
+
+
+
+
 /* ----------- Local functions prototypes ------------- */
 
 static void write_reg(uint8_t, uint8_t);
 static uint8_t read_reg(uint8_t);
 static void	spi_setup(void);
+static void set_spi_clock(void);
 static void gpio_setup(void);
 static inline int16_t two_compl_to_int16(uint16_t);
 
@@ -147,8 +174,9 @@ int16_t lis3dsh_readAxis(uint8_t req_axis)
 		/* transform X value from two's complement to 16-bit int */
 		int_value_mg = two_compl_to_int16(int_value_mg);
 
-		/* convert X absolute value to mg value */
-		int_value_mg = int_value_mg * SENS_2G_RANGE_MG_PER_DIGIT;
+		/* convert X absolute value to calibrated mg value: one multiply-add */
+		int_value_mg = (int16_t)(((int32_t)int_value_mg * axis_scale_q16[req_axis]
+								+ axis_offset_q16[req_axis]) >> 16);
 	} else {
 		/* invalid axis: do nothing */
 	}
@@ -157,6 +185,32 @@ int16_t lis3dsh_readAxis(uint8_t req_axis)
 }
 
 
+/* Function to set the conversion coefficients of an axis:
+ * mg = digit * scale + offset, both in Q16 */
+void lis3dsh_set_calibration(uint8_t req_axis, int32_t scale_q16, int32_t offset_q16)
+{
+	if (req_axis < NUM_OF_AXIS) {
+		axis_scale_q16[req_axis] = scale_q16;
+		/* rounding is folded into the offset */
+		axis_offset_q16[req_axis] = offset_q16 + Q16_ROUNDING;
+	} else {
+		/* invalid axis: do nothing */
+	}
+}
+
+
+/* Function to keep the SPI clock after a clock speed change.
+ * No transfer shall be in progress */
+void lis3dsh_update_clock(void)
+{
+	if ((spi_pclk_hz != 0) && (spi_pclk_hz != rcc_apb2_frequency)) {
+		spi_disable(SPI1);
+		set_spi_clock();
+		spi_enable(SPI1);
+	}
+}
+
+
 
 
 /* ------------ Local functions implementation -------------- */
@@ -199,16 +253,32 @@ static void spi_setup(void)
 	spi_reset(SPI1);
 	/* init SPI1 master */
 	spi_init_master(SPI1,
-					SPI_CR1_BAUDRATE_FPCLK_DIV_64,
+					SPI_CR1_BAUDRATE_FPCLK_DIV_256,
 					SPI_CR1_CPOL_CLK_TO_0_WHEN_IDLE,
 					SPI_CR1_CPHA_CLK_TRANSITION_1,
 					SPI_CR1_DFF_8BIT,
 					SPI_CR1_MSBFIRST);
+	/* the slowest clock until the prescaler of the actual APB2 clock is set */
+	set_spi_clock();
 	/* enable SPI1 first */
 	spi_enable(SPI1);
 }
 
 
+/* Function to set the SPI1 prescaler: the fastest clock up to SPI_MAX_CLOCK_HZ */
+static void set_spi_clock(void)
+{
+	uint8_t baudrate = 0;
+
+	spi_pclk_hz = rcc_apb2_frequency;
+	while (((spi_pclk_hz >> (baudrate + 1)) > SPI_MAX_CLOCK_HZ)
+		&& (baudrate < SPI_MAX_BAUDRATE)) {
+		baudrate++;
+	}
+	spi_set_baudrate_prescaler(SPI1, baudrate);
+}
+
+
 /* Function to setup the used GPIO */
 static void gpio_setup(void)
 {
@@ -42,10 +42,20 @@ enum {
 
 
 
+/* ----------- Exported defines ------------- */
+
+/* Nominal sensitivity for 2G range [mg/digit] in Q16: 0.06 * 65536 */
+#define LIS3DSH_SENS_2G_MG_PER_DIGIT_Q16	((int32_t)3932)
+
+
+
+
 /* ----------- Exported functions prototypes ------------- */
 
 extern void	lis3dsh_init(void);
 extern int16_t lis3dsh_readAxis(uint8_t);
+extern void lis3dsh_set_calibration(uint8_t, int32_t, int32_t);
+extern void lis3dsh_update_clock(void);
 
 
 
@@ -28,34 +28,33 @@
 #include <stdint.h>
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/gpio.h>
+/* Clock module */
+#include "clock.h"
 /* RTOS module */
 #include "rtos.h"
-
-
-
-
-/* ------------- Local functions prototypes --------------- */
-
-static void clock_setup(void);
+/* Timebase module */
+#include "timebase.h"
+/* Port layer */
+#include "port.h"
+/* Accelerometer calibration */
+#include "calib.h"
 
 
 
 
 /* ------------ Local functions implementation ----------- */
 
-/* Function to setup the clock device */
-static void clock_setup(void)
-{
-	rcc_clock_setup_hse_3v3(&hse_8mhz_3v3[CLOCK_3V3_168MHZ]);
-}
-
-
 /* Main function */
 int main(void)
 {
+	uint8_t state;
+
 	/* setup clock */
 	clock_setup();
 
+	/* start the timebase */
+	timebase_setup();
+
 	/* init and start RTOS */
 	rtos_start_operation(RTOS_CFG_KE_FIRST_STATE);
 
@@ -63,6 +62,17 @@ int main(void)
 	while (1) {
 		/* call RTOS */
 		rtos_execute_task();
+
+		/* store a new calibration with the RTOS stopped: the flash erase stalls the CPU */
+		if (CALIB_KE_SAVE_PENDING == calib_get_status()) {
+			state = rtos_get_state();
+			rtos_stop_operation();
+			calib_save();
+			rtos_start_operation(state);
+		}
+
+		/* let the port run idle */
+		port_idle();
 	}
 
 	return 0;
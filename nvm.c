@@ -0,0 +1,87 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <libopencm3/stm32/flash.h>
+
+#include "nvm.h"
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Get a pointer to the reserved sector content */
+const uint32_t *nvm_get_data(void)
+{
+	return (const uint32_t *)NVM_BASE_ADDRESS;
+}
+
+
+/* Erase the reserved sector and write data in it. Return true if data
+ * is verified. ATTENTION: the CPU stalls while the sector is erased
+ * (up to some seconds for a 128KB sector), call it out of normal operation */
+bool nvm_write(const uint32_t *data_ptr, uint16_t words_num)
+{
+	const uint32_t *nvm_ptr = nvm_get_data();
+	uint16_t word_index;
+	bool result = false;
+
+	if ((data_ptr != NULL)
+	&& ((uint32_t)words_num * sizeof(uint32_t) <= NVM_SIZE_BYTES)) {
+		flash_unlock();
+
+		/* 2.7V - 3.6V supply: 32-bit parallelism */
+		flash_erase_sector(NVM_SECTOR, FLASH_CR_PROGRAM_X32);
+		for (word_index = 0; word_index < words_num; word_index++) {
+			flash_program_word(NVM_BASE_ADDRESS + (word_index * sizeof(uint32_t)),
+							   data_ptr[word_index]);
+		}
+
+		flash_lock();
+
+		/* verify written data */
+		result = true;
+		for (word_index = 0; word_index < words_num; word_index++) {
+			if (nvm_ptr[word_index] != data_ptr[word_index]) {
+				result = false;
+			}
+		}
+	} else {
+		/* invalid parameters */
+	}
+
+	return result;
+}
+
+
+
+
+/* End of file */
+
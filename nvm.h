@@ -0,0 +1,65 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _NVM_INCLUDED_             /* switch to read the header file once */
+#define _NVM_INCLUDED_             /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Flash sector reserved for non volatile data. It is excluded from the
+ * rom region in the linker script */
+#define NVM_SECTOR						11
+
+/* Start address of the reserved sector */
+#define NVM_BASE_ADDRESS				((uint32_t)0x080E0000)
+
+/* Size of the reserved sector [bytes] */
+#define NVM_SIZE_BYTES					((uint32_t)0x20000)	/* 128KB */
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern const uint32_t *nvm_get_data(void);
+extern bool nvm_write(const uint32_t *, uint16_t);
+
+
+
+
+#endif
+
+/* End of file */
+
@@ -0,0 +1,309 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libopencm3/cm3/cortex.h>
+
+#include "pattern.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Maximum instructions executed for a channel in one tick: protects against
+ * loops without waits */
+#define MAX_OPS_PER_TICK				((uint8_t)16)
+
+
+
+
+/* ----------- Local macros ------------- */
+
+/* Channel mask bit */
+#define CH_MASK(ch)						((uint32_t)1 << (ch))
+
+
+
+
+/* ------------- Local typedef definitions ------------- */
+
+/* Channel sequencer state: constant size whatever the pattern */
+typedef struct {
+	const uint8_t *pattern_ptr;	/* pattern start */
+	uint16_t pc;				/* next instruction index */
+	uint16_t loop_pc;			/* first instruction index of the loop */
+	uint8_t loop_counter;		/* loops left, 0 forever */
+	uint8_t due_ticks;			/* ticks to the next run since last call */
+	bool started;				/* started since last call: not late at its first run */
+} pattern_channel_t;
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Output function pointer */
+static pattern_output_t output_function_ptr = NULL;
+
+/* Channels state */
+static pattern_channel_t channels[PATTERN_CHANNELS_NUM];
+
+/* Running channels mask: bit set as last operation of a start, so that
+ * the tick interrupt never sees a partially configured channel. The tick
+ * clears bits at pattern end: other contexts update it with interrupts masked */
+static volatile uint32_t running_mask;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static bool run_channel(uint8_t, pattern_channel_t *, uint8_t);
+static void emit_output(uint8_t, uint8_t, uint8_t, uint8_t);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init pattern sequencer */
+void pattern_init(pattern_output_t output_ptr)
+{
+	running_mask = 0;
+	output_function_ptr = output_ptr;
+}
+
+
+/* Start a pattern on a channel. First instruction is executed at next tick */
+void pattern_start(uint8_t ch_index, const uint8_t *pattern_ptr)
+{
+	pattern_channel_t *ch_ptr;
+	uint32_t primask;
+
+	if ((ch_index < PATTERN_CHANNELS_NUM)
+	&& (pattern_ptr != NULL)) {
+		ch_ptr = &channels[ch_index];
+
+		/* stop the channel first: the tick skips it while it is configured */
+		primask = cm_mask_interrupts(1);
+		running_mask &= ~CH_MASK(ch_index);
+		(void)cm_mask_interrupts(primask);
+
+		ch_ptr->pattern_ptr = pattern_ptr;
+		ch_ptr->pc = 0;
+		ch_ptr->loop_pc = 0;
+		ch_ptr->loop_counter = 0;
+		ch_ptr->due_ticks = 0;
+		ch_ptr->started = true;
+
+		/* start pattern as last operation */
+		primask = cm_mask_interrupts(1);
+		running_mask |= CH_MASK(ch_index);
+		(void)cm_mask_interrupts(primask);
+	} else {
+		/* invalid parameters */
+	}
+}
+
+
+/* Stop the pattern of a channel keeping last output */
+void pattern_stop(uint8_t ch_index)
+{
+	uint32_t primask;
+
+	if (ch_index < PATTERN_CHANNELS_NUM) {
+		primask = cm_mask_interrupts(1);
+		running_mask &= ~CH_MASK(ch_index);
+		(void)cm_mask_interrupts(primask);
+	}
+}
+
+
+/* Check if a pattern is running on a channel */
+bool pattern_is_running(uint8_t ch_index)
+{
+	return ((ch_index < PATTERN_CHANNELS_NUM)
+		 && ((running_mask & CH_MASK(ch_index)) != 0));
+}
+
+
+/* Pattern tick: run due channels after the given elapsed ticks. Return ticks
+ * to the next due channel, PATTERN_NO_EVENT if no pattern is running.
+ * It has not to be called at each tick: idle channels cost nothing */
+uint8_t pattern_tick(uint8_t elapsed_ticks)
+{
+	uint32_t pending_mask = running_mask;
+	uint8_t ch_index;
+	uint8_t next_due = PATTERN_NO_EVENT;
+	pattern_channel_t *ch_ptr;
+
+	while (pending_mask != 0) {
+		ch_index = (uint8_t)__builtin_ctz(pending_mask);
+		pending_mask &= ~CH_MASK(ch_index);
+		ch_ptr = &channels[ch_index];
+
+		if (run_channel(ch_index, ch_ptr, elapsed_ticks)) {
+			running_mask &= ~CH_MASK(ch_index);
+		} else if ((next_due == PATTERN_NO_EVENT)
+			   || (ch_ptr->due_ticks < next_due)) {
+			next_due = ch_ptr->due_ticks;
+		}
+	}
+
+	return next_due;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Interpret a channel pattern up to the next wait if it is due. Return true at pattern end */
+static bool run_channel(uint8_t ch_index, pattern_channel_t *ch_ptr, uint8_t elapsed_ticks)
+{
+	const uint8_t *code_ptr = ch_ptr->pattern_ptr;
+	uint8_t ops_counter = 0;
+	bool pattern_end = false;
+	bool tick_done = false;
+	uint8_t late_ticks = 0;
+	uint8_t opcode;
+
+	/* the ticks of the call can be elapsed before the start: the first
+	 * instruction runs now, and only a channel already running is late */
+	if (ch_ptr->started) {
+		ch_ptr->started = false;
+		elapsed_ticks = 0;
+	}
+
+	/* a running wait consumes the whole call */
+	if (ch_ptr->due_ticks > elapsed_ticks) {
+		ch_ptr->due_ticks -= elapsed_ticks;
+		tick_done = true;
+	} else {
+		/* ticks elapsed since the channel was due: the waits are shortened by them */
+		late_ticks = elapsed_ticks - ch_ptr->due_ticks;
+		/* run again at next tick if no wait is found */
+		ch_ptr->due_ticks = 1;
+	}
+
+	while ((!tick_done)
+	&& (!pattern_end)) {
+		opcode = code_ptr[ch_ptr->pc];
+
+		switch (opcode) {
+		case PATTERN_OP_ON:
+		case PATTERN_OP_OFF:
+		{
+			emit_output(ch_index, opcode, 0, 0);
+			ch_ptr->pc += 1;
+			break;
+		}
+		case PATTERN_OP_LEVEL:
+		{
+			emit_output(ch_index, opcode, code_ptr[ch_ptr->pc + 1], 0);
+			ch_ptr->pc += 2;
+			break;
+		}
+		case PATTERN_OP_FADE:
+		{
+			emit_output(ch_index, opcode, code_ptr[ch_ptr->pc + 1], code_ptr[ch_ptr->pc + 2]);
+			ch_ptr->pc += 3;
+			break;
+		}
+		case PATTERN_OP_WAIT:
+		{
+			/* this tick counts as the first one of the wait. A wait already
+			 * elapsed in a call of many ticks is a tick boundary passed */
+			if (code_ptr[ch_ptr->pc + 1] > late_ticks) {
+				ch_ptr->due_ticks = code_ptr[ch_ptr->pc + 1] - late_ticks;
+				tick_done = true;
+			} else if (code_ptr[ch_ptr->pc + 1] > 0) {
+				late_ticks -= code_ptr[ch_ptr->pc + 1];
+				ops_counter = 0;
+			}
+			ch_ptr->pc += 2;
+			break;
+		}
+		case PATTERN_OP_LOOP:
+		{
+			ch_ptr->loop_counter = code_ptr[ch_ptr->pc + 1];
+			ch_ptr->pc += 2;
+			ch_ptr->loop_pc = ch_ptr->pc;
+			break;
+		}
+		case PATTERN_OP_END_LOOP:
+		{
+			if (ch_ptr->loop_counter == 0) {
+				/* endless loop */
+				ch_ptr->pc = ch_ptr->loop_pc;
+			} else if (--ch_ptr->loop_counter > 0) {
+				ch_ptr->pc = ch_ptr->loop_pc;
+			} else {
+				/* loops done */
+				ch_ptr->pc += 1;
+			}
+			break;
+		}
+		case PATTERN_OP_END:
+		default:
+		{
+			/* end of pattern or unknown instruction */
+			pattern_end = true;
+			break;
+		}
+		}
+
+		/* a loop without waits ends the tick anyway */
+		ops_counter++;
+		if (ops_counter >= MAX_OPS_PER_TICK) {
+			tick_done = true;
+		}
+	}
+
+	return pattern_end;
+}
+
+
+/* Call output function if valid */
+static void emit_output(uint8_t ch_index, uint8_t opcode, uint8_t arg_1, uint8_t arg_2)
+{
+	if (output_function_ptr != NULL) {
+		(*output_function_ptr)(ch_index, opcode, arg_1, arg_2);
+	} else {
+		/* no output function: discard */
+	}
+}
+
+
+
+
+/* End of file */
+
@@ -0,0 +1,106 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _PATTERN_INCLUDED_         /* switch to read the header file once */
+#define _PATTERN_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rtos.h"
+
+
+
+
+/* ----------- Exported defines ------------- */
+
+/* Number of pattern channels: 32 at most */
+#define PATTERN_CHANNELS_NUM			4
+
+/* Value returned by the tick when no pattern is running */
+#define PATTERN_NO_EVENT				((uint8_t)0)
+
+/* Convert a time in ms into a wait argument [ticks]: 2.55 s at most */
+#define PATTERN_MS_TO_TICKS(ms)			((uint8_t)(((uint32_t)(ms) * 1000) / RTOS_UL_TICK_PERIOD_US))
+
+
+
+
+/* ----------- Exported macros ------------- */
+
+/* Pattern instructions: a pattern is a const uint8_t array built with these macros */
+#define PATTERN_ON						PATTERN_OP_ON
+#define PATTERN_OFF						PATTERN_OP_OFF
+#define PATTERN_LEVEL(level)			PATTERN_OP_LEVEL, (uint8_t)(level)
+#define PATTERN_FADE(level, ms)			PATTERN_OP_FADE, (uint8_t)(level), PATTERN_MS_TO_TICKS(ms)
+#define PATTERN_WAIT(ms)				PATTERN_OP_WAIT, PATTERN_MS_TO_TICKS(ms)
+#define PATTERN_LOOP(count)				PATTERN_OP_LOOP, (uint8_t)(count)	/* 0 loops forever */
+#define PATTERN_END_LOOP				PATTERN_OP_END_LOOP
+#define PATTERN_END						PATTERN_OP_END
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Pattern opcodes enum */
+enum {
+	PATTERN_OP_END,			/* stop the pattern keeping last output */
+	PATTERN_OP_ON,			/* turn output on */
+	PATTERN_OP_OFF,			/* turn output off */
+	PATTERN_OP_LEVEL,		/* arg: level 0 - 255 */
+	PATTERN_OP_FADE,		/* args: level 0 - 255, duration [ticks] */
+	PATTERN_OP_WAIT,		/* arg: duration [ticks] */
+	PATTERN_OP_LOOP,		/* arg: loops number, 0 forever. One nesting level */
+	PATTERN_OP_END_LOOP,	/* jump back to the instruction following the loop */
+	PATTERN_OP_CHECK
+};
+
+/* Pointer to output function: called with channel index, opcode and its two arguments.
+ * Output opcodes are ON, OFF, LEVEL and FADE */
+typedef void (*pattern_output_t)(uint8_t, uint8_t, uint8_t, uint8_t);
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+extern void pattern_init(pattern_output_t);
+extern void pattern_start(uint8_t, const uint8_t *);
+extern void pattern_stop(uint8_t);
+extern bool pattern_is_running(uint8_t);
+extern uint8_t pattern_tick(uint8_t);
+
+
+
+
+#endif
+
+/* End of file */
+
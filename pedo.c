@@ -0,0 +1,228 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "accel.h"
+#include "pedo.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* Convert a time in ms into a number of samples */
+#define MS_TO_SAMPLES(ms)				((uint16_t)((ms) / ACCEL_SAMPLE_PERIOD_MS))
+
+/* Smoothing filter time constant as power of 2 [samples] */
+#define SMOOTH_FILTER_SHIFT				2
+
+/* Period of the adaptive threshold update [samples] */
+#define THRESHOLD_BLOCK					MS_TO_SAMPLES(1000)
+
+/* Minimum peak to peak magnitude to consider the board moving [mg] */
+#define MIN_DYNAMIC_MG					((uint16_t)150)
+
+/* Refractory period after a step: no faster than 4 steps/s [samples] */
+#define STEP_REFRACTORY					MS_TO_SAMPLES(250)
+
+/* Maximum interval between steps of the same walk [samples] */
+#define STEP_MAX_INTERVAL				MS_TO_SAMPLES(2000)
+
+/* Consecutive steps required before counting: filters isolated movements */
+#define STEPS_TO_CONFIRM				((uint8_t)4)
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Total counted steps. It is cleared on request only so that it
+ * survives re-init of the detector and RTOS state changes */
+static uint32_t step_count = 0;
+
+/* Smoothed magnitude, Q(SMOOTH_FILTER_SHIFT) */
+static uint32_t smooth_magnitude;
+
+/* Last two smoothed magnitude values [mg] */
+static uint16_t prev_value;
+static uint16_t prev_prev_value;
+
+/* Min and max of the actual threshold block [mg] */
+static uint16_t block_min;
+static uint16_t block_max;
+
+/* Samples of the actual threshold block */
+static uint16_t block_samples;
+
+/* Threshold and hysteresis computed from the previous block [mg] */
+static uint16_t step_threshold;
+static uint16_t step_hysteresis;
+
+/* Board is moving enough to detect steps */
+static bool dynamic_valid;
+
+/* Samples since last detected step */
+static uint16_t samples_since_step;
+
+/* Steps detected but not yet confirmed */
+static uint8_t pending_steps;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void update_threshold(uint16_t);
+static void manage_peak(void);
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Init pedometer detector. Step count is not affected */
+void pedo_init(void)
+{
+	smooth_magnitude = (uint32_t)1000 << SMOOTH_FILTER_SHIFT;
+	prev_value = 1000;
+	prev_prev_value = 1000;
+	block_min = UINT16_MAX;
+	block_max = 0;
+	block_samples = 0;
+	step_threshold = UINT16_MAX;
+	step_hysteresis = 0;
+	dynamic_valid = false;
+	samples_since_step = STEP_MAX_INTERVAL;
+	pending_steps = 0;
+}
+
+
+/* Process a new sample [mg]. Constant time and memory */
+void pedo_process_sample(int16_t x_mg, int16_t y_mg, int16_t z_mg)
+{
+	uint16_t value;
+
+	/* low pass filter of the magnitude */
+	smooth_magnitude += accel_magnitude_approx(x_mg, y_mg, z_mg)
+						- (smooth_magnitude >> SMOOTH_FILTER_SHIFT);
+	value = (uint16_t)(smooth_magnitude >> SMOOTH_FILTER_SHIFT);
+
+	update_threshold(value);
+
+	if (samples_since_step < UINT16_MAX) {
+		samples_since_step++;
+	}
+
+	/* a walk is over: discard not confirmed steps */
+	if (samples_since_step > STEP_MAX_INTERVAL) {
+		pending_steps = 0;
+	}
+
+	/* previous value is a local maximum */
+	if ((prev_value > prev_prev_value) && (prev_value >= value)) {
+		manage_peak();
+	}
+
+	prev_prev_value = prev_value;
+	prev_value = value;
+}
+
+
+/* Get total number of steps */
+uint32_t pedo_get_steps(void)
+{
+	return step_count;
+}
+
+
+/* Clear total number of steps */
+void pedo_reset_steps(void)
+{
+	step_count = 0;
+	pending_steps = 0;
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* Track min and max in blocks and update threshold at the end of each one */
+static void update_threshold(uint16_t value)
+{
+	uint16_t dynamic;
+
+	if (value < block_min) {
+		block_min = value;
+	}
+	if (value > block_max) {
+		block_max = value;
+	}
+
+	block_samples++;
+	if (block_samples >= THRESHOLD_BLOCK) {
+		dynamic = block_max - block_min;
+		dynamic_valid = (dynamic >= MIN_DYNAMIC_MG);
+		/* threshold in the middle, hysteresis at a quarter of the dynamic */
+		step_threshold = block_min + (dynamic >> 1);
+		step_hysteresis = dynamic >> 2;
+
+		block_min = UINT16_MAX;
+		block_max = 0;
+		block_samples = 0;
+	}
+}
+
+
+/* Validate a peak of the smoothed magnitude as a step */
+static void manage_peak(void)
+{
+	if (dynamic_valid
+	&& (prev_value > (step_threshold + step_hysteresis))
+	&& (samples_since_step >= STEP_REFRACTORY)) {
+		samples_since_step = 0;
+
+		if (pending_steps < STEPS_TO_CONFIRM) {
+			pending_steps++;
+			/* rhythm confirmed: count also the pending steps */
+			if (pending_steps == STEPS_TO_CONFIRM) {
+				step_count += STEPS_TO_CONFIRM;
+			}
+		} else {
+			step_count++;
+		}
+	}
+}
+
+
+
+
+/* End of file */
+
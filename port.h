@@ -0,0 +1,61 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _PORT_INCLUDED_            /* switch to read the header file once */
+#define _PORT_INCLUDED_            /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdint.h>
+
+
+
+
+/* ----------- Exported functions prototypes ------------- */
+
+#ifdef PORT_HOST
+/* Host simulation: a main loop turn lets the virtual clock run */
+extern void port_idle(void);
+/* Host simulation: RTOS callbacks schedule is traced to measure lateness */
+extern void port_trace_callback_set(uint8_t, uint32_t);
+extern void port_trace_callback_expired(uint8_t);
+extern void port_trace_callback_run(uint8_t);
+#else
+/* Target: the main loop keeps polling */
+#define port_idle()
+/* Target: no trace */
+#define port_trace_callback_set(id, period_ms)
+#define port_trace_callback_expired(id)
+#define port_trace_callback_run(id)
+#endif
+
+
+
+
+#endif
+
+/* End of file */
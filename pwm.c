@@ -24,13 +24,17 @@
 
 
 /* ---------------- Inclusions ----------------- */
+#include <stddef.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <libopencm3/stm32/rcc.h>
 #include <libopencm3/stm32/gpio.h>
 #include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
 #include <libopencm3/stm32/f4/nvic.h>
 
+#include "clock.h"
 #include "pwm.h"
 
 
@@ -38,19 +42,95 @@
 
 /* ----------- Exported functions ------------- */
 
-/* Timer clock frequency [Hz] */
-#define TIM_CLOCK_FREQ_HZ					1000000	/* 1MHz */
+/* Maximum timer auto-reload value: TIM2 and TIM5 are 32-bit but all timers are used as 16-bit.
+ * The compare value of 100% is period + 1, so it shall fit the 16-bit compare registers too */
+#define TIM_MAX_ARR_VALUE					((uint32_t)0xFFFE)
 
-/* Default PWM frequency */
-#define TIM_DEFAULT_PWM_FREQ_HZ				100	/* 100Hz */
+/* Permillage to 1/65536 units conversion factor in Q16 */
+#define PERMILLE_TO_DUTY_Q16				((uint32_t)(((uint64_t)PWM_DUTY_FULL_SCALE << 16) / 1000))
+
+/* Number of PWM channels */
+#define PWM_CH_NUM							PWM_CFG_KE_CH_MAX_NUM
+
+/* Number of frequency groups */
+#define PWM_GROUP_NUM						PWM_CFG_KE_GROUP_MAX_NUM
+
+/* DMA burst: DBA is CCR1 offset in words, DBL is 4 transfers */
+#define TIM_DCR_CCR1_BURST_VALUE			((uint32_t)(((PWM_CFG_TIM_CCR_NUM - 1) << 8) | (0x34 >> 2)))
+
+
+
+
+/* ----------- Local macros ------------- */
+
+/* Convert a permillage DC value into 1/65536 units */
+#define PERMILLE_TO_DUTY(dc)				((uint16_t)((((uint32_t)(dc) * PERMILLE_TO_DUTY_Q16) + 0x8000) >> 16))
+
+/* Convert a DC value in 1/65536 units into a timer compare value in Q16. The DC value is
+ * stretched to 0x10000 at full scale, so 0xFFFF gives period + 1 (100%) exactly: the code
+ * at half scale is skipped. Period + 1 is 0xFFFF at most, so the product fits in 32 bits */
+#define DUTY_TO_TMR_VALUE_Q16(g, duty)		(((uint32_t)(duty) + ((uint32_t)(duty) >> 15)) \
+											 * (timer_cnt_periods[(g)] + 1))
+
+/* Convert a DC value in 1/65536 units into a timer compare value */
+#define DUTY_TO_TMR_VALUE(g, duty)			((DUTY_TO_TMR_VALUE_Q16((g), (duty)) + 0x8000) >> 16)
+
+/* Channel mask bit */
+#define CH_MASK(ch)							((uint32_t)1 << (ch))
+
+/* Group mask bit */
+#define GROUP_MASK(g)						((uint32_t)1 << (g))
+
+/* Groups whose update interrupt is served below: only they can be dithered */
+#define DITHER_GROUPS_MASK					GROUP_MASK(PWM_CFG_KE_GROUP_TIM4)
 
 
 
 
 /* ----------- Local variables declaration ------------- */
 
-/* Store current PWM frequency */
-static uint32_t current_timer_cnt_period;
+/* Timer input clock each group period is computed with [Hz] */
+static uint32_t timer_clocks_hz[PWM_GROUP_NUM];
+
+/* Required frequency of each group [Hz]: re-applied at each clock speed change */
+static uint32_t group_freqs_hz[PWM_GROUP_NUM];
+
+/* Store current period of each group */
+static uint32_t timer_cnt_periods[PWM_GROUP_NUM];
+
+/* Required DC value of each channel in 1/65536 units: re-applied at each frequency change */
+static uint16_t duty_values[PWM_CH_NUM];
+
+/* Dithered channels mask */
+static uint32_t dither_mask;
+
+/* Compare value of dithered channels in Q16: integer part in the upper half word.
+ * A single word, so the update interrupt always reads a consistent value */
+static volatile uint32_t dither_values_q16[PWM_CH_NUM];
+
+/* Sigma-delta accumulators of dithered channels */
+static uint16_t dither_accumulators[PWM_CH_NUM];
+
+/* Compare values of each group transferred by DMA burst into CCR1-CCR4. It is also the
+ * shadow copy of the compare registers: a value equal to the shadow one is not written */
+static uint32_t frame_buffer[PWM_GROUP_NUM][PWM_CFG_TIM_CCR_NUM];
+
+/* Compare register writes issued and suppressed */
+static pwm_stats_t write_stats;
+
+
+
+
+/* ----------- Local functions prototypes ------------- */
+
+static void init_group(uint8_t);
+static void init_channel(uint8_t);
+static void set_period(uint8_t, uint32_t, uint32_t);
+static void apply_duty(uint8_t);
+static void dither_period(uint8_t);
+static void dma_setup(uint8_t);
+static void dma_start_burst(uint8_t);
+static bool update_shadow(const pwm_cfg_channel_t *, uint32_t);
 
 
 
@@ -60,147 +140,454 @@ static uint32_t current_timer_cnt_period;
 /* init PWM */
 void pwm_init(void)
 {
-	/* Init timer */
+	uint8_t index;
+
+	dither_mask = 0;
+
+	/* Init timers */
+	for (index = 0; index < PWM_GROUP_NUM; index++) {
+		init_group(index);
+	}
+
+	/* Init output channels */
+	for (index = 0; index < PWM_CH_NUM; index++) {
+		init_channel(index);
+	}
+
+	pwm_reset_stats();
+}
+
+
+/* set PWM frequency of all groups */
+void pwm_set_frequency(uint32_t pwm_freq_hz)
+{
+	uint8_t group_index;
+
+	for (group_index = 0; group_index < PWM_GROUP_NUM; group_index++) {
+		pwm_set_group_frequency(group_index, pwm_freq_hz);
+	}
+}
+
+
+/* set PWM frequency of a group. The lowest prescaler that lets the period fit
+ * the auto-reload register is chosen: it gives the highest DC resolution */
+void pwm_set_group_frequency(uint8_t group_index, uint32_t pwm_freq_hz)
+{
+	uint32_t cnt_total;
+	uint32_t prescaler;
+	uint8_t ch_index;
+
+	/* if requested frequency is lower than
+	 * timer clock frequency */
+	if ((group_index < PWM_GROUP_NUM)
+	&& (pwm_freq_hz > 0)
+	&& (pwm_freq_hz <= PWM_MAX_FREQ_HZ)) {
+		group_freqs_hz[group_index] = pwm_freq_hz;
+		timer_clocks_hz[group_index] = clock_get_timer_frequency(pwm_cfg_groups[group_index].timer);
+
+		/* timer counts of a period at prescaler 1 */
+		cnt_total = timer_clocks_hz[group_index] / pwm_freq_hz;
+		prescaler = (cnt_total - 1) / (TIM_MAX_ARR_VALUE + 1);
+
+		/* set prescaler and period and store them */
+		set_period(group_index, prescaler, (cnt_total / (prescaler + 1)) - 1);
+
+		/* re-apply DC values of the group: the new period, prescaler and
+		 * compare values are loaded together at next update event */
+		for (ch_index = 0; ch_index < PWM_CH_NUM; ch_index++) {
+			if (pwm_cfg_channels[ch_index].group == group_index) {
+				apply_duty(ch_index);
+			}
+		}
+	}
+}
+
+
+/* re-apply the frequency of each group after a clock speed change. Prescaler,
+ * period and compare values are preloaded: the transitional period lasts the
+ * old counts at the new clock, then the group runs at the required frequency */
+void pwm_update_clock(void)
+{
+	uint8_t group_index;
+
+	for (group_index = 0; group_index < PWM_GROUP_NUM; group_index++) {
+		if ((group_freqs_hz[group_index] > 0)
+		&& (timer_clocks_hz[group_index] != clock_get_timer_frequency(pwm_cfg_groups[group_index].timer))) {
+			pwm_set_group_frequency(group_index, group_freqs_hz[group_index]);
+		}
+	}
+}
+
+
+/* set DC value for a channel */
+void pwm_set_dc(uint8_t ch_index, uint16_t dc_value_permillage)
+{
+	if (dc_value_permillage <= 1000) {
+		pwm_set_duty(ch_index, PERMILLE_TO_DUTY(dc_value_permillage));
+	}
+}
+
+
+/* set DC value for a channel in 1/65536 units */
+void pwm_set_duty(uint8_t ch_index, uint16_t duty_value)
+{
+	if (ch_index < PWM_CH_NUM) {
+		duty_values[ch_index] = duty_value;
+		apply_duty(ch_index);
+	}
+}
+
+
+/* enable or disable sigma-delta dithering of a channel. The compare value toggles
+ * between the two nearest counts at each period, so that the average DC has
+ * the full 1/65536 resolution. A channel of a group whose update interrupt
+ * is not served cannot be dithered: the request is discarded */
+void pwm_set_dithering(uint8_t ch_index, bool enable)
+{
+	const pwm_cfg_channel_t *ch_ptr;
+	const pwm_cfg_group_t *group_ptr;
+	uint8_t index;
+	bool group_dithered = false;
+
+	if ((ch_index < PWM_CH_NUM)
+	&& ((!enable) || ((DITHER_GROUPS_MASK & GROUP_MASK(pwm_cfg_channels[ch_index].group)) != 0))) {
+		ch_ptr = &pwm_cfg_channels[ch_index];
+		group_ptr = &pwm_cfg_groups[ch_ptr->group];
+
+		dither_accumulators[ch_index] = 0;
+		if (enable) {
+			dither_mask |= CH_MASK(ch_index);
+		} else {
+			dither_mask &= ~CH_MASK(ch_index);
+		}
+		apply_duty(ch_index);
+
+		/* the update interrupt is enabled while a channel of the group is dithered */
+		for (index = 0; index < PWM_CH_NUM; index++) {
+			if (((dither_mask & CH_MASK(index)) != 0)
+			&& (pwm_cfg_channels[index].group == ch_ptr->group)) {
+				group_dithered = true;
+			}
+		}
+		if (group_dithered) {
+			timer_enable_irq(group_ptr->timer, TIM_DIER_UIE);
+		} else {
+			timer_disable_irq(group_ptr->timer, TIM_DIER_UIE);
+		}
+	}
+}
+
+
+/* set DC values in 1/65536 units of the first values_num channels at once:
+ * the other channels keep their value. Values of a group with a DMA are
+ * transferred into CCR1-CCR4 by a burst at next update event, so all of
+ * them are applied in the same PWM period */
+void pwm_set_frame(const uint16_t *frame_values, uint8_t values_num)
+{
+	uint8_t ch_index;
+	uint8_t ch_num = (values_num < PWM_CH_NUM) ? values_num : PWM_CH_NUM;
+	uint8_t group_index;
+	uint32_t tmr_value;
+	uint32_t changed_groups_mask = 0;
+	const pwm_cfg_channel_t *ch_ptr;
+
+	if (frame_values != NULL) {
+		/* ATTENTION: if a frame is still pending it is updated in place.
+		 * The burst takes a few bus cycles only, so this can tear only
+		 * if it runs right at the update event */
+		for (ch_index = 0; ch_index < ch_num; ch_index++) {
+			ch_ptr = &pwm_cfg_channels[ch_index];
+			duty_values[ch_index] = frame_values[ch_index];
+			dither_values_q16[ch_index] = DUTY_TO_TMR_VALUE_Q16(ch_ptr->group, frame_values[ch_index]);
+			tmr_value = DUTY_TO_TMR_VALUE(ch_ptr->group, frame_values[ch_index]);
+			if (frame_buffer[ch_ptr->group][ch_ptr->ccr_index] != tmr_value) {
+				frame_buffer[ch_ptr->group][ch_ptr->ccr_index] = tmr_value;
+				changed_groups_mask |= GROUP_MASK(ch_ptr->group);
+				if (pwm_cfg_groups[ch_ptr->group].dma == 0) {
+					/* no DMA for this group: write the register now */
+					write_stats.written++;
+					timer_set_oc_value(pwm_cfg_groups[ch_ptr->group].timer, ch_ptr->oc, tmr_value);
+				}
+			} else {
+				write_stats.suppressed++;
+			}
+		}
+
+		/* one burst for each changed group with a DMA */
+		for (group_index = 0; group_index < PWM_GROUP_NUM; group_index++) {
+			if (((changed_groups_mask & GROUP_MASK(group_index)) != 0)
+			&& (pwm_cfg_groups[group_index].dma != 0)) {
+				dma_start_burst(group_index);
+			}
+		}
+	}
+}
+
+
+/* get compare register writes statistics */
+void pwm_get_stats(pwm_stats_t *stats_ptr)
+{
+	if (stats_ptr != NULL) {
+		*stats_ptr = write_stats;
+	}
+}
+
+
+/* reset compare register writes statistics */
+void pwm_reset_stats(void)
+{
+	write_stats.written = 0;
+	write_stats.suppressed = 0;
+}
+
+
+/* start all groups */
+void pwm_start(void)
+{
+	uint8_t group_index;
+	uint32_t timer;
+
+	for (group_index = 0; group_index < PWM_GROUP_NUM; group_index++) {
+		timer = pwm_cfg_groups[group_index].timer;
+
+		timer_generate_event(timer, TIM_EGR_UG);
+
+		/* advanced timers outputs are enabled by MOE only */
+		if (pwm_cfg_groups[group_index].advanced) {
+			timer_enable_break_main_output(timer);
+		}
+
+		timer_enable_counter(timer);
+	}
+}
+
+
+
+
+/* ----------- Local functions ------------- */
+
+/* init the timer of a group */
+static void init_group(uint8_t group_index)
+{
+	const pwm_cfg_group_t *group_ptr = &pwm_cfg_groups[group_index];
+	uint8_t ccr_index;
 
-	/* Enable Timer4 clock. */
-	rcc_periph_clock_enable(RCC_TIM4);
+	/* Enable timer clock. */
+	rcc_periph_clock_enable(group_ptr->timer_rcc);
 
-	/* Reset TIM4 peripheral */
-	timer_reset(TIM4);
+	/* Reset timer peripheral */
+	timer_reset(group_ptr->timer);
 
 	/* Set the timers global mode to:
 	 * - use no divider
 	 * - alignment edge
 	 * - count direction up
 	 * */
-	timer_set_mode(TIM4,
+	timer_set_mode(group_ptr->timer,
 					TIM_CR1_CKD_CK_INT,
 					TIM_CR1_CMS_EDGE,
 					TIM_CR1_DIR_UP);
 
-	/* set prescaler */
-	timer_set_prescaler(TIM4, ((rcc_apb1_frequency * 2) / TIM_CLOCK_FREQ_HZ));
 	/* enable preload */
-	timer_enable_preload(TIM4);
+	timer_enable_preload(group_ptr->timer);
 	/* set continuous mode */
-	timer_continuous_mode(TIM4);
+	timer_continuous_mode(group_ptr->timer);
 	/* set repetition counter */
-	timer_set_repetition_counter(TIM4, 0);
-	/* set period */
-	current_timer_cnt_period = ((TIM_CLOCK_FREQ_HZ / TIM_DEFAULT_PWM_FREQ_HZ) - 1);
-	timer_set_period(TIM4, current_timer_cnt_period);
+	timer_set_repetition_counter(group_ptr->timer, 0);
+	/* shadow copy is aligned to reset values */
+	for (ccr_index = 0; ccr_index < PWM_CFG_TIM_CCR_NUM; ccr_index++) {
+		frame_buffer[group_index][ccr_index] = 0;
+	}
 
-	/* Init output channels */
+	/* set prescaler and period */
+	pwm_set_group_frequency(group_index, group_ptr->default_freq_hz);
+
+	/* init DMA burst of compare values */
+	if (group_ptr->dma != 0) {
+		dma_setup(group_index);
+	}
+
+	/* update interrupt is used by dithering only */
+	nvic_enable_irq(group_ptr->irq);
+}
+
+
+/* init output compare and pin of a channel */
+static void init_channel(uint8_t ch_index)
+{
+	const pwm_cfg_channel_t *ch_ptr = &pwm_cfg_channels[ch_index];
+	uint32_t timer = pwm_cfg_groups[ch_ptr->group].timer;
 
-	/* Enable GPIOD clock */
-	rcc_periph_clock_enable(RCC_GPIOD);
+	/* Enable GPIO clock */
+	rcc_periph_clock_enable(ch_ptr->gpio_rcc);
 
-	/* Set GPIO12, GPIO13, GPIO14, GPIO15 (in GPIO port D) to Alternate Function */
-	gpio_mode_setup(GPIOD,
+	/* Set pin to Alternate Function */
+	gpio_mode_setup(ch_ptr->gpio_port,
 					GPIO_MODE_AF,
 					GPIO_PUPD_NONE,
-					GPIO12 | GPIO13 | GPIO14 | GPIO15);
+					ch_ptr->gpio_pin);
 
 	/* Push Pull, Speed 50 MHz */
-	gpio_set_output_options(GPIOD,
+	gpio_set_output_options(ch_ptr->gpio_port,
 							GPIO_OTYPE_PP,
 							GPIO_OSPEED_50MHZ,
-							GPIO12 | GPIO13 | GPIO14 | GPIO15);
+							ch_ptr->gpio_pin);
 
-	/* Alternate Function: TIM4 CH1/2/3/4 */
-	gpio_set_af(GPIOD,
-				GPIO_AF2,
-				GPIO12 | GPIO13 | GPIO14 | GPIO15);
+	/* Alternate Function: timer channel */
+	gpio_set_af(ch_ptr->gpio_port,
+				ch_ptr->gpio_af,
+				ch_ptr->gpio_pin);
 
-	/* disable TIM4 channels */
-	timer_disable_oc_output(TIM4, TIM_OC1);
-	timer_disable_oc_output(TIM4, TIM_OC2);
-	timer_disable_oc_output(TIM4, TIM_OC3);
-	timer_disable_oc_output(TIM4, TIM_OC4);
+	/* disable channel */
+	timer_disable_oc_output(timer, ch_ptr->oc);
 
-	/* set OC mode for each channel */
-	timer_set_oc_mode(TIM4, TIM_OC1, TIM_OCM_PWM1);
-	timer_set_oc_mode(TIM4, TIM_OC2, TIM_OCM_PWM1);
-	timer_set_oc_mode(TIM4, TIM_OC3, TIM_OCM_PWM1);
-	timer_set_oc_mode(TIM4, TIM_OC4, TIM_OCM_PWM1);
+	/* set OC mode */
+	timer_set_oc_mode(timer, ch_ptr->oc, TIM_OCM_PWM1);
 
-	timer_enable_oc_preload(TIM4, TIM_OC1);
-	timer_enable_oc_preload(TIM4, TIM_OC2);
-	timer_enable_oc_preload(TIM4, TIM_OC3);
-	timer_enable_oc_preload(TIM4, TIM_OC4);
+	timer_enable_oc_preload(timer, ch_ptr->oc);
 
-	/* reset OC value for each channel */
-	timer_set_oc_value(TIM4, TIM_OC1, 0);
-	timer_set_oc_value(TIM4, TIM_OC2, 0);
-	timer_set_oc_value(TIM4, TIM_OC3, 0);
-	timer_set_oc_value(TIM4, TIM_OC4, 0);
+	/* reset OC value */
+	timer_set_oc_value(timer, ch_ptr->oc, 0);
 
-	/* enable OC output for each channel */
-	timer_enable_oc_output(TIM4, TIM_OC1);
-	timer_enable_oc_output(TIM4, TIM_OC2);
-	timer_enable_oc_output(TIM4, TIM_OC3);
-	timer_enable_oc_output(TIM4, TIM_OC4);
+	/* enable OC output */
+	timer_enable_oc_output(timer, ch_ptr->oc);
 }
 
 
-void pwm_set_frequency(uint32_t pwm_freq_hz)
+/* set timer prescaler and period of a group */
+static void set_period(uint8_t group_index, uint32_t prescaler, uint32_t timer_cnt_period)
 {
-	/* if requested frequency is lower than
-	 * timer clock frequency */
-	if (pwm_freq_hz <= PWM_MAX_FREQ_HZ) {
-		/* set period and store it */
-		current_timer_cnt_period = ((TIM_CLOCK_FREQ_HZ / pwm_freq_hz) - 1);
-		timer_set_period(TIM4, current_timer_cnt_period);
-	}
+	timer_cnt_periods[group_index] = timer_cnt_period;
+	timer_set_prescaler(pwm_cfg_groups[group_index].timer, prescaler);
+	timer_set_period(pwm_cfg_groups[group_index].timer, timer_cnt_period);
 }
 
 
-/* set DC value for a channel */
-void pwm_set_dc(uint8_t ch_index, uint16_t dc_value_permillage)
+/* convert the DC value of a channel into its compare value and apply it */
+static void apply_duty(uint8_t ch_index)
 {
-	uint32_t dc_tmr_reg_value;
+	const pwm_cfg_channel_t *ch_ptr = &pwm_cfg_channels[ch_index];
+	const pwm_cfg_group_t *group_ptr = &pwm_cfg_groups[ch_ptr->group];
 
-	if (dc_value_permillage <= 1000) {
-		/* calculate DC timer register value */
-		dc_tmr_reg_value = (uint32_t)(((uint64_t)current_timer_cnt_period * dc_value_permillage) / 1000);
-		/* update the required channel */
-		switch(ch_index)
-		{
-		case 0:
-		{
-			timer_set_oc_value(TIM4, TIM_OC1, dc_tmr_reg_value);
-			break;
-		}
-		case 1:
-		{
-			timer_set_oc_value(TIM4, TIM_OC2, dc_tmr_reg_value);
-			break;
-		}
-		case 2:
-		{
-			timer_set_oc_value(TIM4, TIM_OC3, dc_tmr_reg_value);
-			break;
-		}
-		case 3:
-		{
-			timer_set_oc_value(TIM4, TIM_OC4, dc_tmr_reg_value);
-			break;
-		}
-		default:
-		{
-			/* wrong channel index: do nothing */
-		}
+	/* dithered channels read the fractional part at each period */
+	dither_values_q16[ch_index] = DUTY_TO_TMR_VALUE_Q16(ch_ptr->group, duty_values[ch_index]);
+
+	/* compare registers are preloaded: after a period change the new compare
+	 * value is loaded at the same update event of the new period */
+	if (update_shadow(ch_ptr, DUTY_TO_TMR_VALUE(ch_ptr->group, duty_values[ch_index]))) {
+		timer_set_oc_value(group_ptr->timer, ch_ptr->oc,
+						   frame_buffer[ch_ptr->group][ch_ptr->ccr_index]);
+	}
+}
+
+
+/* sigma-delta step of the dithered channels of a group: one per PWM period */
+static void dither_period(uint8_t group_index)
+{
+	uint32_t pending_mask = dither_mask;
+	uint32_t value_q16;
+	uint32_t accumulator;
+	uint8_t ch_index;
+	const pwm_cfg_channel_t *ch_ptr;
+
+	while (pending_mask != 0) {
+		ch_index = (uint8_t)__builtin_ctz(pending_mask);
+		pending_mask &= ~CH_MASK(ch_index);
+		ch_ptr = &pwm_cfg_channels[ch_index];
+
+		if (ch_ptr->group == group_index) {
+			/* first order: the carry of the fraction accumulator adds one count */
+			value_q16 = dither_values_q16[ch_index];
+			accumulator = (uint32_t)dither_accumulators[ch_index] + (value_q16 & 0xFFFF);
+			dither_accumulators[ch_index] = (uint16_t)accumulator;
+			/* through the shadow: a frame burst does not restore a stale value */
+			if (update_shadow(ch_ptr, (value_q16 >> 16) + (accumulator >> 16))) {
+				timer_set_oc_value(pwm_cfg_groups[group_index].timer, ch_ptr->oc,
+								   frame_buffer[group_index][ch_ptr->ccr_index]);
+			}
 		}
 	}
 }
 
 
-/* set OC value for a channel */
-void pwm_start(void)
+/* setup DMA stream for CCR1-CCR4 burst on update event of a group */
+static void dma_setup(uint8_t group_index)
 {
-	timer_generate_event(TIM4, TIM_EGR_UG);
+	const pwm_cfg_group_t *group_ptr = &pwm_cfg_groups[group_index];
 
-	timer_enable_counter(TIM4);
+	if (group_ptr->dma == DMA1) {
+		rcc_periph_clock_enable(RCC_DMA1);
+	} else {
+		rcc_periph_clock_enable(RCC_DMA2);
+	}
+
+	dma_stream_reset(group_ptr->dma, group_ptr->dma_stream);
+	dma_channel_select(group_ptr->dma, group_ptr->dma_stream, group_ptr->dma_channel);
+	dma_set_priority(group_ptr->dma, group_ptr->dma_stream, DMA_SxCR_PL_HIGH);
+	dma_set_transfer_mode(group_ptr->dma, group_ptr->dma_stream, DMA_SxCR_DIR_MEM_TO_PERIPHERAL);
+	dma_set_memory_size(group_ptr->dma, group_ptr->dma_stream, DMA_SxCR_MSIZE_32BIT);
+	dma_set_peripheral_size(group_ptr->dma, group_ptr->dma_stream, DMA_SxCR_PSIZE_32BIT);
+	dma_enable_memory_increment_mode(group_ptr->dma, group_ptr->dma_stream);
+	dma_set_peripheral_address(group_ptr->dma, group_ptr->dma_stream, (uint32_t)&TIM_DMAR(group_ptr->timer));
+	dma_set_memory_address(group_ptr->dma, group_ptr->dma_stream, (uint32_t)frame_buffer[group_index]);
+
+	/* each update event requests a burst of 4 words written through DMAR */
+	TIM_DCR(group_ptr->timer) = TIM_DCR_CCR1_BURST_VALUE;
+	timer_enable_irq(group_ptr->timer, TIM_DIER_UDE);
+}
+
+
+/* arm a new burst of a group if previous one is complete */
+static void dma_start_burst(uint8_t group_index)
+{
+	const pwm_cfg_group_t *group_ptr = &pwm_cfg_groups[group_index];
+
+	/* the burst writes all registers of the group */
+	write_stats.written += PWM_CFG_TIM_CCR_NUM;
+
+	if ((DMA_SCR(group_ptr->dma, group_ptr->dma_stream) & DMA_SxCR_EN) == 0) {
+		dma_clear_interrupt_flags(group_ptr->dma, group_ptr->dma_stream,
+								  DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF | DMA_FEIF);
+		dma_set_number_of_data(group_ptr->dma, group_ptr->dma_stream, PWM_CFG_TIM_CCR_NUM);
+		dma_enable_stream(group_ptr->dma, group_ptr->dma_stream);
+	} else {
+		/* pending burst transfers the updated frame */
+	}
+}
+
+
+/* update shadow value of a channel. Return true if the register shall be written */
+static bool update_shadow(const pwm_cfg_channel_t *ch_ptr, uint32_t tmr_value)
+{
+	bool write_required = false;
+
+	if (frame_buffer[ch_ptr->group][ch_ptr->ccr_index] != tmr_value) {
+		frame_buffer[ch_ptr->group][ch_ptr->ccr_index] = tmr_value;
+		write_stats.written++;
+		write_required = true;
+	} else {
+		write_stats.suppressed++;
+	}
+
+	return write_required;
+}
+
+
+
+
+/* TIM4 interrupt service routine */
+void tim4_isr(void)
+{
+	/* manage update interrupt */
+	if (timer_get_flag(TIM4, TIM_SR_UIF)) {
+		/* Clear update interrupt flag. */
+		timer_clear_flag(TIM4, TIM_SR_UIF);
+
+		/* compare values written now are loaded at next update event */
+		dither_period(PWM_CFG_KE_GROUP_TIM4);
+	} else {
+		/* do nothing */
+	}
 }
 
 
@@ -25,16 +25,41 @@
 
 
 
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+/* This inclusion is for other modules that include this component */
+#include "pwm_cfg.h"
+
+
+
+
 /* ----------- Exported defines ------------- */
 
 /* Maximum PWM frequency */
 #define PWM_MAX_FREQ_HZ					100000	/* 100kHz */
 
+/* DC value for 100% in 1/65536 units */
+#define PWM_DUTY_FULL_SCALE				0xFFFF
+
 /* Channels indexes defines */
-#define PWM_CH1							0
-#define PWM_CH2							1
-#define PWM_CH3							2
-#define PWM_CH4							3
+#define PWM_CH1							PWM_CFG_KE_CH_GREEN
+#define PWM_CH2							PWM_CFG_KE_CH_ORANGE
+#define PWM_CH3							PWM_CFG_KE_CH_RED
+#define PWM_CH4							PWM_CFG_KE_CH_BLUE
+
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Compare register writes statistics */
+typedef struct {
+	uint32_t written;		/* register writes issued */
+	uint32_t suppressed;	/* register writes skipped: value already in register */
+} pwm_stats_t;
 
 
 
@@ -43,8 +68,15 @@
 
 extern void pwm_init(void);
 extern void pwm_set_frequency(uint32_t);
+extern void pwm_set_group_frequency(uint8_t, uint32_t);
+extern void pwm_update_clock(void);
 extern void pwm_set_dc(uint8_t, uint16_t);
+extern void pwm_set_duty(uint8_t, uint16_t);
+extern void pwm_set_frame(const uint16_t *, uint8_t);
+extern void pwm_set_dithering(uint8_t, bool);
 extern void pwm_start(void);
+extern void pwm_get_stats(pwm_stats_t *);
+extern void pwm_reset_stats(void);
 
 
 
@@ -0,0 +1,67 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/f4/nvic.h>
+
+#include "pwm_cfg.h"
+
+
+
+
+/* ------------ Exported Variables ----------------- */
+
+/* Frequency groups: this order shall be the same of groups enum.
+ * Update DMA requests (RM0090 DMA request mapping):
+ * TIM1 DMA2 S5 C6, TIM2 DMA1 S1 C3, TIM3 DMA1 S2 C5,
+ * TIM4 DMA1 S6 C2, TIM5 DMA1 S0 C6, TIM8 DMA2 S1 C7.
+ * Update interrupts are used by dithering: only tim4_isr is served in pwm.c,
+ * so only the TIM4 group can be dithered (DITHER_GROUPS_MASK) */
+const pwm_cfg_group_t pwm_cfg_groups[PWM_CFG_KE_GROUP_MAX_NUM] = {
+	{TIM4, RCC_TIM4, false, 100, DMA1, DMA_STREAM6, DMA_SxCR_CHSEL_2, NVIC_TIM4_IRQ}
+};
+
+
+/* Logical channels: this order shall be the same of channels enum */
+const pwm_cfg_channel_t pwm_cfg_channels[PWM_CFG_KE_CH_MAX_NUM] = {
+	{PWM_CFG_KE_GROUP_TIM4, TIM_OC1, 0, GPIOD, GPIO12, GPIO_AF2, RCC_GPIOD},
+	{PWM_CFG_KE_GROUP_TIM4, TIM_OC2, 1, GPIOD, GPIO13, GPIO_AF2, RCC_GPIOD},
+	{PWM_CFG_KE_GROUP_TIM4, TIM_OC3, 2, GPIOD, GPIO14, GPIO_AF2, RCC_GPIOD},
+	{PWM_CFG_KE_GROUP_TIM4, TIM_OC4, 3, GPIOD, GPIO15, GPIO_AF2, RCC_GPIOD}
+};
+
+
+
+
+/* End of file */
+
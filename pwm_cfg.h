@@ -0,0 +1,108 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _PWM_CFG_INCLUDED_         /* switch to read the header file once */
+#define _PWM_CFG_INCLUDED_         /* one time */
+
+
+
+
+/* ----------- Inclusions ------------- */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/timer.h>
+
+
+
+
+/* ----------- Exported constants ------------- */
+
+/* Frequency groups enum: one group for each timer in use.
+ * ATTENTION: these timers are owned by other drivers, do not use them here:
+ * TIM1 is the BAM timer, TIM2 is the RTOS tick timer and TIM5 is the
+ * free-running timebase */
+enum {
+	PWM_CFG_KE_GROUP_TIM4,
+	PWM_CFG_KE_GROUP_MAX_NUM
+};
+
+/* Logical channels enum: this order shall be the same of LED channels enum */
+enum {
+	PWM_CFG_KE_CH_GREEN,
+	PWM_CFG_KE_CH_ORANGE,
+	PWM_CFG_KE_CH_RED,
+	PWM_CFG_KE_CH_BLUE,
+	PWM_CFG_KE_CH_MAX_NUM
+};
+
+/* Number of compare registers of a timer */
+#define PWM_CFG_TIM_CCR_NUM				4
+
+
+
+
+/* ----------- Exported typedefs ------------- */
+
+/* Frequency group descriptor: a general purpose (TIM2/3/4/5) or an
+ * advanced control (TIM1/8) timer. All its channels share the frequency */
+typedef struct {
+	uint32_t timer;					/* timer peripheral */
+	enum rcc_periph_clken timer_rcc;	/* timer clock enable */
+	bool advanced;					/* TIM1/TIM8: APB2 clock and main output enable */
+	uint32_t default_freq_hz;		/* PWM frequency at init */
+	uint32_t dma;					/* DMA of the update request for frame bursts, 0 if none */
+	uint8_t dma_stream;				/* DMA stream of the update request */
+	uint32_t dma_channel;			/* DMA channel selection of the update request */
+	uint8_t irq;					/* update interrupt: used by dithering */
+} pwm_cfg_group_t;
+
+/* Logical channel descriptor */
+typedef struct {
+	uint8_t group;					/* frequency group index */
+	enum tim_oc_id oc;				/* timer output compare */
+	uint8_t ccr_index;				/* compare register index: 0 is CCR1 */
+	uint32_t gpio_port;				/* output pin port */
+	uint16_t gpio_pin;				/* output pin */
+	uint8_t gpio_af;				/* output pin alternate function */
+	enum rcc_periph_clken gpio_rcc;	/* output pin port clock enable */
+} pwm_cfg_channel_t;
+
+
+
+
+/* ----------- Exported variables ------------- */
+
+extern const pwm_cfg_group_t pwm_cfg_groups[PWM_CFG_KE_GROUP_MAX_NUM];
+extern const pwm_cfg_channel_t pwm_cfg_channels[PWM_CFG_KE_CH_MAX_NUM];
+
+
+
+
+#endif
+
+/* End of file */
+
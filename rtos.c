@@ -42,6 +42,9 @@ TODO: state switch function shall return a valid value. Do not check it in the e
 #include <stdbool.h>
 #include <stdint.h>
 #include "tmr.h"            /* component timer header file */
+#include "port.h"           /* port layer header file */
+#include "clock.h"          /* clock speed header file */
+#include "timebase.h"       /* timebase header file */
 
 #include "rtos_cfg.h"       /* component config header file */
 #include "rtos.h"           /* component header file */
@@ -51,8 +54,8 @@ TODO: state switch function shall return a valid value. Do not check it in the e
 
 /* ----------- Local constants definitions -------------- */
 
-/* Tasks call counter timeout value */
-#define UL_TASK_COUNTER_TIMEOUT         ((uint32_t)((RTOS_UL_TASKS_PERIOD_MS * 1000) / RTOS_UL_TICK_PERIOD_US))
+/* Tasks call counter timeout value [us] */
+#define UL_TASK_COUNTER_TIMEOUT         ((int32_t)(RTOS_UL_TASKS_PERIOD_MS * 1000))
 
 /* Max callback time value in ms */
 #define U32_CALLBACK_MAX_VALUE_MS       ((uint32_t)10000)     /* 10 s */
@@ -60,6 +63,9 @@ TODO: state switch function shall return a valid value. Do not check it in the e
 /* First task index */
 #define U8_FIRST_TASK_INDEX_VALUE       0
 
+/* Full load value [per mille] */
+#define U16_FULL_LOAD_PERMILLE          ((uint16_t)1000)
+
 
 
 
@@ -82,8 +88,14 @@ static uint8_t rtos_actual_state;
 /* store actual tick timer status */
 static uint8_t tick_timer_status;
 
-/* store counters value of tasks call */
-static uint32_t task_counters;
+/* store time to the next tasks call [us] */
+static int32_t task_counters;
+
+/* store period of the tick in progress [us] */
+static uint32_t tick_period_us = RTOS_UL_TICK_PERIOD_US;
+
+/* store tick period requested for the next ticks [us] */
+static volatile uint32_t required_tick_period_us = RTOS_UL_TICK_PERIOD_US;
 
 /* store expired flag of all callbacks */
 static bool callback_expired_array[RTOS_CB_ID_MAX_NUM] = {
@@ -103,11 +115,17 @@ static bool callback_enabled_array[RTOS_CB_ID_MAX_NUM] = {
 	false
 };
 
-/* store counters value of all callbacks */
-static uint32_t callback_counters_array[RTOS_CB_ID_MAX_NUM];
+/* store time to the next expiry of all callbacks [us] */
+static int32_t callback_counters_array[RTOS_CB_ID_MAX_NUM];
+
+/* store timeout value of all callbacks [us] */
+static int32_t callback_timeout_array[RTOS_CB_ID_MAX_NUM];
 
-/* store timeout value of all callbacks */
-static uint32_t callback_timeout_array[RTOS_CB_ID_MAX_NUM];
+/* store time spent in callbacks and tasks since the start of the load period [us] */
+static uint32_t busy_us;
+
+/* store start of the load period: the tasks period [us] */
+static uint32_t load_period_start_us;
 
 /* store callback function pointers */
 static callback_ptr_t callback_functions_ptr_array[RTOS_CB_ID_MAX_NUM] = {
@@ -124,6 +142,7 @@ static callback_ptr_t callback_functions_ptr_array[RTOS_CB_ID_MAX_NUM] = {
 /* ------------- Local functions prototypes ------------- */
 
 static uint8_t get_new_state_to_switch(uint8_t);
+static void manage_load(uint32_t);
 
 
 
@@ -140,13 +159,13 @@ void rtos_set_callback(uint8_t callback_id,
      * variable because an eventual tick interrupt can decrement counter value
      * during this operation. Because the timeout value is updated only
      * in periodic mode, this temp variable is necessary */
-	uint32_t temp_counter;
+	int32_t temp_counter;
 	if ((callback_id < RTOS_CB_ID_CHECK)
 	&& (callback_type < RTOS_CB_TYPE_CHECK)
 	&& (timer_period_ms <= U32_CALLBACK_MAX_VALUE_MS)
 	&& (callback_function_ptr != NULL)) {
-		/* calculate counter value */
-		temp_counter = (uint32_t)((timer_period_ms * 1000) / RTOS_UL_TICK_PERIOD_US);
+		/* calculate counter value: time does not depend on the tick period */
+		temp_counter = (int32_t)(timer_period_ms * 1000);
 		/* if periodic callback request */
 		if (RTOS_CB_TYPE_PERIODIC == callback_type) {
 			/* store timeout counter value */
@@ -158,6 +177,8 @@ void rtos_set_callback(uint8_t callback_id,
 		callback_functions_ptr_array[callback_id] = callback_function_ptr;
 		/* callback enabled. do it as last operation */
 		callback_enabled_array[callback_id] = true;
+		/* trace the new schedule */
+		port_trace_callback_set(callback_id, timer_period_ms);
 	} else {
 		/* invalid parameters */
 	}
@@ -186,23 +207,39 @@ void rtos_stop_callback(uint8_t callback_id)
 void rtos_tick_timer_callback(void)
 {
 	uint8_t callback_index;
+	/* time elapsed since the previous tick */
+	int32_t elapsed_us = (int32_t)tick_period_us;
+
+	/* apply a new tick period from the tick just started */
+	if (required_tick_period_us != tick_period_us) {
+		tick_period_us = required_tick_period_us;
+		timer_set_tick_period(tick_period_us);
+	}
 
 	/* decrement callback counter for each enabled callback */
 	for (callback_index = 0; callback_index < RTOS_CB_ID_CHECK; callback_index++) {
 		/* manage enabled callbacks only */
 		if (callback_enabled_array[callback_index] == true) {
-			/* if counter is not yet expired */
+			/* decrement counter by the elapsed time. Expire on the tick that
+			 * reaches the deadline */
+			callback_counters_array[callback_index] -= elapsed_us;
 			if (callback_counters_array[callback_index] > 0) {
-				/* decrement counter */
-				callback_counters_array[callback_index]--;
+				/* not yet expired */
 			} else {
-				/* set the flag to call the related callback function */
+				/* trace the expiry, then set the flag to call the related callback function */
+				port_trace_callback_expired(callback_index);
 				callback_expired_array[callback_index] = true;
 
 				/* if timeout value is valid than re-arm the counter */
 				if (callback_timeout_array[callback_index] > 0) {
-					/* callback is still enabled: re-arm counter */
-					callback_counters_array[callback_index] = callback_timeout_array[callback_index];
+					/* callback is still enabled: re-arm counter from the deadline, so
+					 * the schedule does not drift. Periods shorter than the tick
+					 * expire once per tick: the others are overrun */
+					callback_counters_array[callback_index] += callback_timeout_array[callback_index];
+					while (callback_counters_array[callback_index] <= 0) {
+						port_trace_callback_expired(callback_index);
+						callback_counters_array[callback_index] += callback_timeout_array[callback_index];
+					}
 				} else {
 					/* it was a single callback: the callback is disabled now */
 					callback_enabled_array[callback_index] = false;
@@ -213,13 +250,16 @@ void rtos_tick_timer_callback(void)
 		}
 	}
 
-	/* if tasks counter is elapsed set timeout flag */
+	/* decrement tasks call counter. If elapsed set timeout flag */
+	task_counters -= elapsed_us;
 	if (task_counters > 0) {
-		/* decrement tasks call counter */
-		task_counters--;
+		/* not yet elapsed */
 	} else {
-		/* re-arm tasks call counter value */
-		task_counters = UL_TASK_COUNTER_TIMEOUT;
+		/* re-arm tasks call counter value from the deadline. Tasks run at
+		 * most once per tick */
+		do {
+			task_counters += UL_TASK_COUNTER_TIMEOUT;
+		} while (task_counters <= 0);
 
 		/* indicate time base over */
 		tick_timer_status = KE_TICK_TIMER_ELAPSED;
@@ -227,6 +267,33 @@ void rtos_tick_timer_callback(void)
 }
 
 
+/* Request a new tick period [us]. It applies from the next tick on: the
+ * callbacks and tasks deadlines do not move. Any context */
+void rtos_set_tick_period(uint32_t period_us)
+{
+	if ((period_us >= RTOS_UL_TICK_PERIOD_MIN_US)
+	&& (period_us <= RTOS_UL_TICK_PERIOD_MAX_US)) {
+		required_tick_period_us = period_us;
+	} else {
+		/* invalid parameter */
+	}
+}
+
+
+/* Get the period of the tick in progress [us] */
+uint32_t rtos_get_tick_period(void)
+{
+	return tick_period_us;
+}
+
+
+/* Get the actual RTOS state */
+uint8_t rtos_get_state(void)
+{
+	return rtos_actual_state;
+}
+
+
 /* Stop RTOS operation */
 void rtos_stop_operation(void)
 {
@@ -246,6 +313,14 @@ void rtos_start_operation(uint8_t required_state)
 		/* select the requested RTOS state */
 		rtos_actual_state = (uint8_t)required_state;
 
+		/* start with the last requested tick period */
+		tick_period_us = required_tick_period_us;
+
+		/* run at the clock speed of the state */
+		clock_set_speed(rtos_cfg_states_speed_array[rtos_actual_state]);
+		busy_us = 0;
+		load_period_start_us = timebase_get_us32();
+
 		/* Start tick timer */
 		timer_setup();
 	} else {
@@ -260,6 +335,8 @@ void rtos_execute_task(void)
 	uint8_t task_index;
 	uint8_t rtos_required_state;
 	uint8_t callback_index;
+	uint32_t start_us;
+	uint32_t end_us;
 
 	/* manage callback functions */
 	for (callback_index = 0; callback_index < RTOS_CB_ID_CHECK; callback_index++) {
@@ -268,7 +345,10 @@ void rtos_execute_task(void)
 			/* call callback function if pointer is valid (so, single callbacks are called once) */
 			if (callback_functions_ptr_array[callback_index] != NULL) {
 				/* call callback function */
+				start_us = timebase_get_us32();
+				port_trace_callback_run(callback_index);
 				(*callback_functions_ptr_array[callback_index])();
+				busy_us += timebase_get_us32() - start_us;
 
 				/* after function call clear the function pointer if the callback is now disabled */
 				if (callback_enabled_array[callback_index] == false) {
@@ -292,12 +372,18 @@ void rtos_execute_task(void)
 		tick_timer_status = KE_TICK_TIMER_NOT_ELAPSED;
 
 		/* execute all tasks in actual selected RTOS state */
+		start_us = timebase_get_us32();
 		for (task_index = U8_FIRST_TASK_INDEX_VALUE;
 			rtos_cfg_states_array[rtos_actual_state][task_index] != NULL;
 			task_index++) {
 			/* call actual selected task of actual RTOS state */
 			(*rtos_cfg_states_array[rtos_actual_state][task_index])();
 		}
+		end_us = timebase_get_us32();
+		busy_us += end_us - start_us;
+
+		/* let the load of the tasks period choose the clock speed */
+		manage_load(end_us);
 
 		/* load new system state */
 		rtos_required_state =
@@ -305,7 +391,10 @@ void rtos_execute_task(void)
 
 		/* new system state supported? */
 		if (rtos_required_state < RTOS_CFG_KE_STATE_MAX_NUM) {
-			/* enter new system state */
+			/* enter new system state at its clock speed */
+			if (rtos_required_state != rtos_actual_state) {
+				clock_set_speed(rtos_cfg_states_speed_array[rtos_required_state]);
+			}
 			rtos_actual_state = rtos_required_state;
 		} else {
 			/* remain in actual system state */
@@ -320,6 +409,23 @@ void rtos_execute_task(void)
 
 /* -------------- Local functions implementation ----------------- */
 
+/* This function computes the load of the tasks period ending now [us]
+ * and passes it to the clock speed governor */
+static void manage_load(uint32_t now_us)
+{
+	uint32_t elapsed_us = now_us - load_period_start_us;
+	uint32_t load_permille = U16_FULL_LOAD_PERMILLE;
+
+	if (busy_us < elapsed_us) {
+		load_permille = (uint32_t)(((uint64_t)busy_us * U16_FULL_LOAD_PERMILLE) / elapsed_us);
+	}
+	clock_manage_load((uint16_t)load_permille);
+
+	busy_us = 0;
+	load_period_start_us = now_us;
+}
+
+
 /* This function determines the next RTOS mode */
 static uint8_t get_new_state_to_switch(uint8_t actual_state)
 {
@@ -64,9 +64,13 @@ enum {
 
 /* ------------- Exported Defines ------------------- */
 
-/* Tick timer period */
+/* Tick timer period at start. It is also the period of the LED ticks */
 #define RTOS_UL_TICK_PERIOD_US          ((uint32_t)10000)	/* 10 ms */
 
+/* Range of the tick timer period set at runtime */
+#define RTOS_UL_TICK_PERIOD_MIN_US      ((uint32_t)1000)	/* 1 ms */
+#define RTOS_UL_TICK_PERIOD_MAX_US      ((uint32_t)100000)	/* 100 ms */
+
 /* Tick timer period */
 #define RTOS_UL_TASKS_PERIOD_MS         ((uint32_t)50)		/* 50 ms */
 
@@ -84,6 +88,9 @@ extern void rtos_tick_timer_callback(void);
 extern void rtos_stop_operation(void);
 extern void rtos_start_operation(uint8_t);
 extern void rtos_execute_task(void);
+extern void rtos_set_tick_period(uint32_t);
+extern uint32_t rtos_get_tick_period(void);
+extern uint8_t rtos_get_state(void);
 
 
 
@@ -40,7 +40,9 @@
 #include "rtos_cfg.h"		/* component RTOS configuration header file */
 #include "led.h"			/* LED module */
 #include "lis3dsh.h"		/* LIS3DSH module */
+#include "calib.h"			/* Calibration module */
 #include "app.h"			/* APP module */
+#include "clock.h"			/* Clock module */
 
 
 
@@ -51,6 +53,7 @@
 static void (*init_state_ptr_array[])(void) = {
 	&led_init,
 	&lis3dsh_init,
+	&calib_init,
 	&app_init,
 	NULL
 };
@@ -58,7 +61,6 @@ static void (*init_state_ptr_array[])(void) = {
 
 /* NORMAL state tasks */
 static void (*normal_state_ptr_array[])(void) = {
-	&led_periodic_task,
 	&app_main_demo,
 	NULL
 };
@@ -82,6 +84,15 @@ rtos_state_t * const rtos_cfg_states_array[RTOS_CFG_KE_STATE_MAX_NUM] = {
 };
 
 
+/* Clock speed of each RTOS state: This order shall be the same of RTOS_CFG_ke_states enum.
+ * CLOCK_SPEED_AUTO lets the load choose it */
+const uint8_t rtos_cfg_states_speed_array[RTOS_CFG_KE_STATE_MAX_NUM] = {
+	CLOCK_CFG_KE_SPEED_168MHZ,
+	CLOCK_SPEED_AUTO,
+	CLOCK_CFG_KE_SPEED_16MHZ
+};
+
+
 
 
 /* End of file */
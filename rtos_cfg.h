@@ -65,6 +65,7 @@ typedef task_ptr_t const rtos_state_t;
     Exported Variables
 ==============================================================================*/
 extern rtos_state_t *const rtos_cfg_states_array[RTOS_CFG_KE_STATE_MAX_NUM];
+extern const uint8_t rtos_cfg_states_speed_array[RTOS_CFG_KE_STATE_MAX_NUM];
 
 
 
@@ -0,0 +1,172 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+
+/* Monotonic microsecond timebase on the free running 32-bit TIM5.
+ * The counter wraps every 2^32 us (71.6 minutes): it is extended to 64 bits
+ * by a count of half periods, incremented by the interrupt at the half
+ * (compare channel 1) and at the end (update) of each period.
+ * A reader takes the count of half periods, then the counter. If an
+ * interrupt is pending, or served between the two reads, the parity of the
+ * count differs from the top bit of the counter, and the missing half
+ * period is added. So reading takes no lock, no retry and no interrupt
+ * masking, and is valid from any context, also of higher priority than
+ * TIM5, as long as its interrupt is served within half a period.
+ * The prescaler follows the clock speed changes (see clock.c): the counter
+ * is saved and restored around the prescaler reload, so the timebase loses
+ * less than 1 us at each change */
+
+
+/* ---------------- Inclusions ----------------- */
+
+#include <stdint.h>
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/f4/nvic.h>
+
+#include "clock.h"
+#include "timebase.h"
+
+
+
+
+/* ---------------- Local Defines ----------------- */
+
+/* TIM5 counter clock [Hz] */
+#define TIM5_CLOCK_HZ					clock_get_timer_frequency(TIM5)
+
+/* TIM5 prescaler value for the timebase resolution */
+#define TIM5_PRESCALER					((TIM5_CLOCK_HZ / TIMEBASE_FREQUENCY_HZ) - 1)
+
+/* Counter value at half period */
+#define HALF_PERIOD_COUNTS				((uint32_t)0x80000000)
+
+/* Position of the top bit of the counter */
+#define COUNTER_TOP_BIT					31
+
+
+
+
+/* ----------- Local variables declaration ------------- */
+
+/* Half periods of the counter elapsed since setup */
+static volatile uint32_t half_periods;
+
+/* Prescaler value in use. 0 until setup */
+static uint32_t actual_prescaler;
+
+
+
+
+/* ------------- Exported functions implementation --------------- */
+
+/* Start the timebase from 0. To be called once, after the clock setup */
+void timebase_setup(void)
+{
+	rcc_periph_clock_enable(RCC_TIM5);
+	nvic_enable_irq(NVIC_TIM5_IRQ);
+	timer_reset(TIM5);
+
+	timer_set_mode(TIM5, TIM_CR1_CKD_CK_INT, TIM_CR1_CMS_EDGE, TIM_CR1_DIR_UP);
+	timer_continuous_mode(TIM5);
+	timer_set_period(TIM5, UINT32_MAX);
+	timer_set_oc_value(TIM5, TIM_OC1, HALF_PERIOD_COUNTS);
+
+	/* the prescaler is buffered: load it now with an update event,
+	 * which does not count as an overflow */
+	actual_prescaler = TIM5_PRESCALER;
+	timer_set_prescaler(TIM5, actual_prescaler);
+	timer_update_on_overflow(TIM5);
+	timer_generate_event(TIM5, TIM_EGR_UG);
+
+	half_periods = 0;
+
+	timer_enable_counter(TIM5);
+	timer_enable_irq(TIM5, TIM_DIER_UIE | TIM_DIER_CC1IE);
+}
+
+
+/* Reload the prescaler after a clock speed change. Called with interrupts masked */
+void timebase_update_clock(void)
+{
+	uint32_t prescaler = TIM5_PRESCALER;
+	uint32_t counter;
+
+	if ((actual_prescaler != 0) && (prescaler != actual_prescaler)) {
+		actual_prescaler = prescaler;
+		/* the update event clears the counter: restore it */
+		counter = timer_get_counter(TIM5);
+		timer_set_prescaler(TIM5, prescaler);
+		timer_generate_event(TIM5, TIM_EGR_UG);
+		timer_set_counter(TIM5, counter);
+	}
+}
+
+
+/* Get the time elapsed since setup [us] */
+uint64_t timebase_get_us(void)
+{
+	/* the count of half periods shall be read first */
+	uint32_t halves = half_periods;
+	uint32_t counter = timer_get_counter(TIM5);
+
+	/* add the half period not counted yet */
+	halves += (halves ^ (counter >> COUNTER_TOP_BIT)) & 1;
+
+	return ((uint64_t)(halves >> 1) << 32) | counter;
+}
+
+
+/* Get the low 32 bits of the timebase [us]. Cheapest read, for intervals
+ * shorter than 71 minutes computed with unsigned subtraction */
+uint32_t timebase_get_us32(void)
+{
+	return timer_get_counter(TIM5);
+}
+
+
+
+
+/* ------------ Local functions implementation -------------- */
+
+/* TIM5 interrupt service routine: count half periods */
+void tim5_isr(void)
+{
+	if (timer_get_flag(TIM5, TIM_SR_CC1IF)) {
+		timer_clear_flag(TIM5, TIM_SR_CC1IF);
+		half_periods++;
+	}
+
+	if (timer_get_flag(TIM5, TIM_SR_UIF)) {
+		timer_clear_flag(TIM5, TIM_SR_UIF);
+		half_periods++;
+	}
+}
+
+
+
+
+/* End of file */
@@ -42,12 +42,33 @@
 #include "tmr.h"
 #include "rtos.h"
 #include "led.h"
+#include "latency.h"
+#include "hrtimer.h"
+#include "clock.h"
 
 
 
 
 /* --------------- Definitions ------------------ */
 
+/* TIM2 counts at the timer clock: the counter read at the interrupt entry
+ * measures the latency with a resolution of one clock period */
+#define TIM2_COUNTER_HZ					clock_get_timer_frequency(TIM2)
+
+/* TIM2 counts in a us */
+#define TIM2_COUNTS_PER_US				(TIM2_COUNTER_HZ / 1000000)
+
+
+
+
+/* --------------- Local variables ------------------ */
+
+/* Time elapsed since the last LED tick [us] */
+static uint32_t led_elapsed_us;
+
+/* TIM2 counts in a us at the last setup or clock change. 0 before setup */
+static uint32_t tim2_counts_per_us;
+
 
 
 
@@ -73,8 +94,7 @@ void timer_setup(void)
 	timer_set_mode(TIM2, TIM_CR1_CKD_CK_INT,
 					TIM_CR1_CMS_EDGE, TIM_CR1_DIR_UP);
 
-	/* Reset prescaler value.
-	 * Running the clock at 5kHz.
+	/* No prescaler: the counter runs at the timer clock.
 	 */
 	/*
 	 * On STM32F4 the timers are not running directly from pure APB1 or
@@ -94,7 +114,7 @@ void timer_setup(void)
 	 * For additional information see reference manual for the stm32f4
 	 * familiy of chips. Page 204 and 213
 	 */
-	timer_set_prescaler(TIM2, ((rcc_apb1_frequency * 2) / 10000));
+	timer_set_prescaler(TIM2, 0);
 
 	/* Disable preload. */
 	timer_disable_preload(TIM2);
@@ -102,8 +122,12 @@ void timer_setup(void)
 	/* Continous mode. */
 	timer_continuous_mode(TIM2);
 
-	/* Period (36kHz). */
-	timer_set_period(TIM2, 100);
+	/* Period: one RTOS tick. TIM2 is 32-bit */
+	tim2_counts_per_us = TIM2_COUNTS_PER_US;
+	timer_set_period(TIM2, (tim2_counts_per_us * rtos_get_tick_period()) - 1);
+
+	/* Clear interrupt latency statistics */
+	latency_init(TIM2_COUNTER_HZ);
 
 	/* Counter enable. */
 	timer_enable_counter(TIM2);
@@ -111,6 +135,59 @@ void timer_setup(void)
 	/* Enable update interrupt. */
 	timer_enable_irq(TIM2, TIM_DIER_UIE);
 
+	/* Program the one-shot timers on compare channel 1. */
+	hrtimer_resume();
+
+}
+
+
+/* Function to change the tick period [us]. To be called by the tick
+ * interrupt, after the update flag is cleared: the period in progress,
+ * just started, gets the new length */
+void timer_set_tick_period(uint32_t period_us)
+{
+	uint32_t period_counts = TIM2_COUNTS_PER_US * period_us;
+	uint32_t counter;
+
+	/* preload is disabled: new period applies at once */
+	timer_set_period(TIM2, period_counts - 1);
+
+	/* counter is beyond the new period: the end of the period in progress
+	 * is past. The update event sets the update flag, so the tick is served
+	 * again at the interrupt exit, then the counter is restored less the
+	 * elapsed periods, so the next ticks keep their timing */
+	counter = timer_get_counter(TIM2);
+	if (counter >= period_counts) {
+		timer_generate_event(TIM2, TIM_EGR_UG);
+		timer_set_counter(TIM2, counter % period_counts);
+	}
+}
+
+
+/* Function to follow a change of the timer clock. To be called with the
+ * interrupts masked: the counter is rescaled, so that the tick in progress
+ * and the one-shot timers keep their timing */
+void timer_update_clock(void)
+{
+	uint32_t counts_per_us = TIM2_COUNTS_PER_US;
+	uint32_t counter;
+
+	if ((tim2_counts_per_us > 0) && (counts_per_us != tim2_counts_per_us)) {
+		counter = timer_get_counter(TIM2);
+
+		/* preload is disabled: new period applies at once */
+		timer_set_period(TIM2, (counts_per_us * rtos_get_tick_period()) - 1);
+		timer_set_counter(TIM2, (uint32_t)(((uint64_t)counter * counts_per_us) / tim2_counts_per_us));
+		tim2_counts_per_us = counts_per_us;
+
+		/* latency statistics are kept */
+		latency_set_frequency(TIM2_COUNTER_HZ);
+
+		/* program the one-shot timers at the new counter clock */
+		hrtimer_resume();
+	} else {
+		/* timer not set up or same counter clock */
+	}
 }
 
 
@@ -132,19 +209,46 @@ void timer_stop(void)
 /* TIM2 interrupt service routine */
 void tim2_isr(void)
 {
+	/* counter at the entry: time elapsed since the update event */
+	uint32_t entry_counts = timer_get_counter(TIM2);
+	uint32_t led_ticks;
+
+	/* manage one-shot timers compare interrupt */
+	if (timer_get_flag(TIM2, TIM_SR_CC1IF)) {
+
+		/* Clear compare interrupt flag. */
+		timer_clear_flag(TIM2, TIM_SR_CC1IF);
+
+		/* call expired one-shot timers */
+		hrtimer_manage();
+	}
+
 	/* manage update interrupt */
 	if (timer_get_flag(TIM2, TIM_SR_UIF)) {
 
+		/* Clear update interrupt flag first: a period change can set it again */
+		timer_clear_flag(TIM2, TIM_SR_UIF);
+
+		/* record the interrupt latency */
+		latency_record(entry_counts);
+
+		/* period of the elapsed tick: the TICK timer callback can change it */
+		led_elapsed_us += rtos_get_tick_period();
+
 		/* call TICK timer callback */
 		rtos_tick_timer_callback();
 
 		/*gpio_toggle(GPIOD, GPIO12);*/
 
-		/* call LED blinking tick function */
-		led_manage_blinking();
+		/* call LED blinking tick function with the LED ticks ended, whatever the tick period */
+		led_ticks = led_elapsed_us / RTOS_UL_TICK_PERIOD_US;
+		if (led_ticks > 0) {
+			led_elapsed_us -= led_ticks * RTOS_UL_TICK_PERIOD_US;
+			led_manage_blinking((uint8_t)led_ticks);
+		}
 
-		/* Clear compare interrupt flag. */
-		timer_clear_flag(TIM2, TIM_SR_UIF);
+		/* program one-shot timers due in the new period */
+		hrtimer_manage();
 	} else {
 		/* do nothing. ATTENTION: it could be better to clear all interrupts flags */
 	}
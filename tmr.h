@@ -50,6 +50,8 @@
 /* ------------ Exported functions prototypes -------------- */
 
 extern void timer_setup(void);
+extern void timer_set_tick_period(uint32_t);
+extern void timer_update_clock(void);
 extern void timer_stop(void);
 
 
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2015 Marco Russi
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""Export a decision tree forest into activity_cfg.c.
+
+The input is a JSON file with a list of trees in the same layout as the
+scikit-learn tree_ attributes, trained on the int8 features computed by
+activity.c (same order as the ACTIVITY_FT_* enum):
+
+    {
+      "trees": [
+        {
+          "children_left":  [...],
+          "children_right": [...],
+          "feature":        [...],
+          "threshold":      [...],
+          "value":          [[[count_class_0, count_class_1, ...]], ...]
+        }
+      ]
+    }
+
+A leaf has children_left == -1. Nodes are renumbered breadth first so that
+the two children of a split node are adjacent, as activity_classify()
+expects. A float threshold t is exported as floor(t): for integer features
+"x <= t" and "x <= floor(t)" are the same test.
+
+Usage: activity_export.py model.json [activity_cfg.c]
+"""
+
+import json
+import math
+import sys
+
+LEAF = -1
+
+
+def argmax(values):
+    return max(range(len(values)), key=lambda i: values[i])
+
+
+def flatten_tree(tree, nodes):
+    """Append the nodes of a tree to nodes, return the root index."""
+    left = tree["children_left"]
+    right = tree["children_right"]
+    root = len(nodes)
+    nodes.append(None)
+    # queue of (source node, destination index)
+    queue = [(0, root)]
+    while queue:
+        src, dst = queue.pop(0)
+        if left[src] == LEAF:
+            counts = tree["value"][src]
+            while isinstance(counts[0], list):
+                counts = counts[0]
+            nodes[dst] = (LEAF, argmax(counts), 0)
+        else:
+            threshold = min(127, max(-128, math.floor(tree["threshold"][src])))
+            child = len(nodes)
+            nodes.extend([None, None])
+            nodes[dst] = (tree["feature"][src], threshold, child)
+            queue.append((left[src], child))
+            queue.append((right[src], child + 1))
+    return root
+
+
+def export(model, out):
+    nodes = []
+    roots = [flatten_tree(tree, nodes) for tree in model["trees"]]
+    if len(nodes) > 0xFFFF or len(roots) > 0xFF:
+        raise ValueError("model too large")
+
+    out.write(HEADER)
+    out.write("/* Forest nodes: {feature, threshold or class, first child} */\n")
+    out.write("const activity_cfg_node_t activity_cfg_nodes[] = {\n")
+    lines = []
+    for feature, threshold, child in nodes:
+        if feature == LEAF:
+            lines.append("\t{ACTIVITY_CFG_LEAF, %d, 0}" % threshold)
+        else:
+            lines.append("\t{%d, %d, %d}" % (feature, threshold, child))
+    out.write(",\n".join(lines))
+    out.write("\n};\n\n\n")
+    out.write("/* Root node of each tree */\n")
+    out.write("const uint16_t activity_cfg_tree_roots[] = {\n")
+    out.write(",\n".join("\t%d" % r for r in roots))
+    out.write("\n};\n\n\n")
+    out.write("/* Number of trees */\n")
+    out.write("const uint8_t activity_cfg_trees_num = %d;\n" % len(roots))
+    out.write(FOOTER)
+
+
+HEADER = """/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* This file is generated by tools/activity_export.py: do not edit it by hand */
+
+
+/* ------------- Inclusions ---------------- */
+
+#include <stdint.h>
+#include "activity_cfg.h"
+
+
+
+
+/* ------------ Exported Variables ----------------- */
+
+"""
+
+FOOTER = """
+
+
+
+/* End of file */
+
+"""
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+    with open(argv[1]) as f:
+        model = json.load(f)
+    if len(argv) == 3:
+        with open(argv[2], "w") as out:
+            export(model, out)
+    else:
+        export(model, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2015 Marco Russi
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+"""Generate the LED dimming table header.
+
+Each perceptual level is mapped to a PWM duty cycle in 1/65536 units, the
+full resolution of the 16-bit TIM4 counter. The curve is either CIE 1931
+lightness (default) or a plain power law.
+
+Usage: gen_gamma.py [--levels N] [--curve cie1931|gamma] [--gamma G] OUT.h
+"""
+
+import argparse
+import sys
+
+FULL_SCALE = 0xFFFF
+
+
+def cie1931(lightness):
+    """Relative luminance for a lightness in 0..100."""
+    if lightness <= 8.0:
+        return lightness / 903.3
+    return ((lightness + 16.0) / 116.0) ** 3
+
+
+def build_table(levels, curve, gamma):
+    table = []
+    for i in range(levels):
+        x = i / (levels - 1)
+        if curve == "cie1931":
+            y = cie1931(x * 100.0)
+        else:
+            y = x ** gamma
+        table.append(int(round(y * FULL_SCALE)))
+    return table
+
+
+HEADER = """/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 Marco Russi
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+/* This file is generated by tools/gen_gamma.py at build time: do not edit it */
+/* Curve: %(curve)s */
+
+#ifndef _LED_GAMMA_INCLUDED_       /* switch to read the header file once */
+#define _LED_GAMMA_INCLUDED_       /* one time */
+
+
+#include <stdint.h>
+
+
+/* Number of perceptual levels */
+#define LED_GAMMA_LEVELS				((uint16_t)%(levels)d)
+
+
+/* PWM duty cycle [1/65536] of each perceptual level */
+static const uint16_t led_gamma_table[%(levels)d] = {
+%(values)s
+};
+
+
+#endif
+
+/* End of file */
+"""
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--levels", type=int, default=256)
+    parser.add_argument("--curve", choices=("cie1931", "gamma"), default="cie1931")
+    parser.add_argument("--gamma", type=float, default=2.2)
+    parser.add_argument("out")
+    args = parser.parse_args(argv[1:])
+
+    if not 2 <= args.levels <= 0xFFFF:
+        parser.error("levels shall be in 2..65535")
+
+    table = build_table(args.levels, args.curve, args.gamma)
+    rows = []
+    for i in range(0, len(table), 8):
+        rows.append("\t" + ", ".join("%5d" % v for v in table[i:i + 8]))
+    curve = args.curve if args.curve == "cie1931" else "gamma %.2f" % args.gamma
+
+    with open(args.out, "w") as out:
+        out.write(HEADER % {"curve": curve,
+                            "levels": args.levels,
+                            "values": ",\n".join(rows)})
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))